@@ -0,0 +1,112 @@
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+
+#include "Arena.h"
+#include "Error.h"
+
+
+/**
+ * Moves to the next chunk that can fit the given amount of bytes, creating one if none.
+ * @param arena The arena
+ * @param bytes The amount of bytes that needs to fit
+ */
+static void nextChunk(Arena* arena, size_t bytes) {
+  ArenaChunk* next = arena->current ? arena->current->next : NULL;
+
+  // After a reset, reuse the chunks that are already there
+  while (next) {
+    arena->current = next;
+    if (next->cap >= bytes) return;
+
+    next = next->next;
+  }
+
+  size_t cap = (bytes > arena->chunkSize) ? bytes : arena->chunkSize;
+
+  next = (ArenaChunk*) malloc(sizeof(ArenaChunk) + cap);
+  if (!next) handleError(ERR_MEM, FATAL, "Could not allocate space for arena chunk!\n");
+
+  next->cap = cap;
+  next->next = NULL;
+
+  if (arena->current) arena->current->next = next;
+  arena->current = next;
+}
+
+Arena* initArena(size_t chunkSize) {
+  Arena* arena = (Arena*) malloc(sizeof(Arena));
+  if (!arena) handleError(ERR_MEM, FATAL, "Could not allocate space for arena!\n");
+
+  arena->current = NULL;
+  arena->offset = 0;
+  arena->chunkSize = chunkSize;
+
+  nextChunk(arena, chunkSize);
+  arena->root = arena->current;
+
+  return arena;
+}
+
+void* arenaAlloc(Arena* arena, size_t size) {
+  if (!arena) return calloc(1, size);
+
+  size_t mask = ARENA_ALIGNMENT - 1;
+
+  // Pad the offset so the allocation is aligned
+  uintptr_t pos = (uintptr_t) (arena->current->buffer + arena->offset);
+  size_t padding = (ARENA_ALIGNMENT - (pos & mask)) & mask;
+
+  if (arena->offset + padding + size > arena->current->cap) {
+    // Chunk buffers are aligned by malloc, so a fresh chunk needs no padding
+    nextChunk(arena, size);
+    arena->offset = 0;
+    padding = 0;
+  }
+
+  void* mem = arena->current->buffer + arena->offset + padding;
+  arena->offset += padding + size;
+
+  memset(mem, 0, size);
+
+  return mem;
+}
+
+str arenaString(Arena* arena, const char* s) {
+  size_t len = strlen(s) + 1;
+
+  str copy = (str) arenaAlloc(arena, len);
+  if (!copy) handleError(ERR_MEM, FATAL, "Could not allocate space for string!\n");
+  memcpy(copy, s, len);
+
+  return copy;
+}
+
+void resetArena(Arena* arena) {
+  arena->current = arena->root;
+  arena->offset = 0;
+}
+
+void adoptArena(Arena* arena, Arena* other) {
+  ArenaChunk* last = other->root;
+  while (last->next) last = last->next;
+
+  // In front, since the chunks after current are reused once the arena is reset
+  last->next = arena->root;
+  arena->root = other->root;
+
+  free(other);
+}
+
+void deleteArena(Arena* arena) {
+  if (!arena) return;
+
+  ArenaChunk* chunk = arena->root;
+  while (chunk) {
+    ArenaChunk* next = chunk->next;
+    free(chunk);
+    chunk = next;
+  }
+
+  free(arena);
+}
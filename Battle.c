@@ -2,16 +2,18 @@
 #include <stdio.h>
 #include <stdbool.h>
 #include <ctype.h>
-#include <time.h>
 
 #ifdef _WIN64
   #include <Windows.h>
-#else
-  #include <pthread.h>
 #endif
 
 #include "Battle.h"
+#include "BattleLog.h"
+#include "Damage.h"
 #include "Error.h"
+#include "Pace.h"
+#include "Random.h"
+#include "Screen.h"
 
 
 typedef enum {
@@ -22,15 +24,6 @@ typedef enum {
 } DIRECTION;
 
 
-void ssleep(int ms) {
-  #ifdef _WIN64
-    Sleep(ms);
-  #else
-    usleep(ms * 1000);
-  #endif
-}
-
-
 /**
  * When defeated, find the direction that the player came from and set that as the new room.
  */
@@ -56,126 +49,7 @@ static void returnRoom() {
       break;
   }
 
-  player->room = player->room->exits[idx];
-}
-
-/**
- * Calculates how much HP lost based on attacker and target stats.
- * Also take into account the skill used for the attack, if any.
- * @param attacker The stats of the attacker
- * @param target The stats of the target
- * @param skill The skill used
- * @return How much damage taken
- */
-static ushort getTotalDmg(Stats* attacker, Stats* target, Skill* skill) {
-  ushort totalAtk = attacker->ATK;
-  ushort totalAcc = attacker->ACC;
-  float totalCrit = attacker->ATK_CRIT;
-  ushort totalCritDmg = attacker->ATK_CRIT_DMG;
-  ushort totalDef = target->DEF; // Total defense of the target
-
-  if (attacker == player->stats) {
-    if (player->gear.sw) {
-      totalAtk += player->gear.sw->atk;
-      totalAcc += player->gear.sw->acc;
-      totalCrit += player->gear.sw->atk_crit;
-      totalCritDmg += player->gear.sw->atk_crit_dmg;
-    }
-
-    if (player->gear.helmet) {
-      totalAcc += player->gear.helmet->acc;
-    }
-
-    if (player->gear.guard) {
-      totalAcc += player->gear.guard->acc;
-    }
-
-    if (player->gear.chestplate) {
-      totalAcc += player->gear.chestplate->acc;
-    }
-
-    if (player->gear.boots) {
-      totalAcc += player->gear.boots->acc;
-    }
-  }
-
-  // Take into account the player's defense from armor
-  // It is the case when the target stats is the player's stats
-  // so the enemy can take that defense into account
-  if (target == player->stats) {
-    if (player->gear.helmet) {
-      totalDef += player->gear.helmet->def;
-    }
-
-    if (player->gear.guard) {
-      totalDef += player->gear.guard->def;
-    }
-
-    if (player->gear.chestplate) {
-      totalDef += player->gear.chestplate->def;
-    }
-
-    if (player->gear.boots) {
-      totalDef += player->gear.boots->def;
-    }
-  }
-
-  if (skill) {
-    totalAtk += (skill->activeEffect1 == ATK) ? skill->effect1.atk : 0;
-    totalAcc += (skill->activeEffect2 == ACC) ? skill->effect2.acc : 0;
-    totalCrit += (skill->activeEffect2 == ATK_CRIT) ? skill->effect2.atk_crit : 0.0;
-    totalCritDmg += (skill->activeEffect1 == ATK_CRIT_DMG) ? skill->effect1.atk_crit_dmg : 0;
-    totalDef += (skill->activeEffect2 == DEF) ? skill->effect2.def : 0;
-  }
-
-  printf("%d\n", RAND_MAX);
-  float hitRoll = (float) rand() / RAND_MAX * (player->lvl * 3);
-  // printf("hitroll: %3.2f\n", hitRoll);
-  if (hitRoll > totalAcc) return 0;
-
-  short baseDamage = 1 + (totalAtk - totalDef);
-  // printf("baseDamage: %d\n", baseDamage);
-  if (baseDamage < 1) baseDamage = 1;
-
-  float critRoll = (float) rand() / RAND_MAX;
-  // printf("critroll: %3.2f\n", critRoll);
-  if (critRoll <= totalCrit) {
-    baseDamage += ((ushort) baseDamage * totalCritDmg) / 100;
-  }
-
-  if (skill) skill->cdTimer = skill->cooldown + 1;
-
-  return (ushort) baseDamage;
-}
-
-/**
- * Chooses a skill for the boss to use from its
- * array of possible skills. It can also choose its basic.
- * @param skills The array of possible boss skills
- * @return The skill to use
- */
-static Skill* chooseBossSkill(Skill* skills) {
-  srand(time(NULL));
-
-  int r = rand() % 2;
-
-  // printf("Random is %d\n", r);
-
-  Skill* choosenSkill;
-
-  if (r == 1) {
-    // printf("Choosing a skill\n");
-    do {
-      choosenSkill = &skills[rand() % BOSS_SKILL_COUNT];
-      // printf("Chosen skill is %s, CD: %d\n", choosenSkill->name, choosenSkill->cdTimer);
-    } while (choosenSkill->cdTimer != 0);
-    // printf("Skill choosen\n");
-
-    return choosenSkill;
-  }
-  // printf("Basic attack chosen\n");
-
-  return NULL;
+  player->room = maze->rooms.exits[player->room][idx];
 }
 
 /**
@@ -184,24 +58,34 @@ static Skill* chooseBossSkill(Skill* skills) {
  */
 static void fight(Enemy* enemy) {
   ushort playerAtk, enemyAtk;
+  EnemyTemplate* tmpl = getEnemyTemplate(maze, enemy);
 
   bool defeat = false; // Player defeat
   uint enemyMaxHP = enemy->hp;
+  uint turn = 0;
+
+  logBegin(false);
+  logSide(SIDE_PLAYER, &player->totalStats, player->hp, player->lvl);
+  logSide(SIDE_ENEMY, &enemy->stats, enemy->hp, tmpl->lvl);
 
   while (true) {
-    playerAtk = getTotalDmg(player->stats, enemy->stats, NULL);
+    uint64_t rng = getRandomState(RNG_BATTLE);
+    playerAtk = rollDamage(&player->totalStats, &enemy->stats, NULL, player->lvl, NULL);
+    logRound(SIDE_PLAYER, NO_SKILL, turn, rng, playerAtk, (playerAtk >= enemy->hp) ? 0 : enemy->hp - playerAtk);
     // printf("%s attacks for %d dmg!\n", player->name, playerAtk);
 
-    if (playerAtk >= enemy->hp) { printf("%s defeated!\n", enemy->name); break; }
+    if (playerAtk >= enemy->hp) { printf("%s defeated!\n", tmpl->name); break; }
 
     enemy->hp -= playerAtk;
 
-    // printf("%s: %d/%d\n", enemy->name, enemy->hp, enemyMaxHP);
+    // printf("%s: %d/%d\n", tmpl->name, enemy->hp, enemyMaxHP);
 
-    ssleep(500);
+    pace(PACE_BATTLE, 500);
 
-    enemyAtk = getTotalDmg(enemy->stats, player->stats, NULL);
-    // printf("%s attacks for %d dmg!\n", enemy->name, enemyAtk);
+    rng = getRandomState(RNG_BATTLE);
+    enemyAtk = rollDamage(&enemy->stats, &player->totalStats, NULL, player->lvl, NULL);
+    logRound(SIDE_ENEMY, NO_SKILL, turn, rng, enemyAtk, (enemyAtk >= player->hp) ? 0 : player->hp - enemyAtk);
+    // printf("%s attacks for %d dmg!\n", tmpl->name, enemyAtk);
 
     if (enemyAtk >= player->hp) { printf("Player defeated!\n"); defeat = true; break; }
 
@@ -209,25 +93,30 @@ static void fight(Enemy* enemy) {
 
     // printf("%s: %d/%d\n", player->name, player->hp, player->maxHP);
 
-    ssleep(500);
+    pace(PACE_BATTLE, 500);
+    turn++;
   }
 
+  logEnd(!defeat);
+
   if (defeat) {
     enemy->hp = enemyMaxHP;
     printf("Respawning to entrance...\n");
     player->room = maze->entry;
     player->hp = player->maxHP;
   } else {
-    updateXP(player, enemy->xpPoints);
+    updateXP(player, tmpl->xpPoints);
     player->skills->totalSkillPoints += 1;
     // player->dzenai +=
-    deleteEnemyFromMap(player->room, false);
+    deleteEnemyFromMap(maze, player->room);
   }
 }
 
 void battleEnemy(Enemy* enemy) {
-  printf("You encountered %s!\n", enemy->name);
-  displayEnemyStats(enemy);
+  EnemyTemplate* tmpl = getEnemyTemplate(maze, enemy);
+
+  printf("You encountered %s!\n", tmpl->name);
+  displayEnemyStats(tmpl, enemy);
   printf("Do you want to fight or retreat? [f|r] ");
 
   char decision = getchar();
@@ -250,7 +139,7 @@ void battleEnemy(Enemy* enemy) {
 
     returnRoom();
 
-    printf("You are back in %s...\n", player->room->info);
+    printf("You are back in %s...\n", maze->rooms.info[player->room]);
 
     return;
   }  
@@ -260,30 +149,71 @@ void battleEnemy(Enemy* enemy) {
  * Displays the possible options for the player to use.
  * It includes at the very least the basic attack and up to 5 skills (equipped),
  * as well as quick healing.
+ * @param cd The cooldowns of the battle
  */
-static void displayOptions() {
-  printf("[h] Heal\n");
-  printf("[0] Basic attack\n");
+static void displayOptions(const Cooldowns* cd) {
+  screenPrintf("[h] Heal\n");
+  screenPrintf("[0] Basic attack\n");
 
   Skill** equipped = player->skills->equippedSkills;
 
   for (int i = 0; i < EQUIPPED_SKILL_COUNT; i++) {
     if (equipped[i]) {
-      printf("[%d] %s; CD: %d\n", i + 1, equipped[i]->name, equipped[i]->cdTimer);
+      screenPrintf("[%d] %s; CD: %d\n", i + 1, equipped[i]->name, cd->timers[PLAYER_CD + i]);
     }
   }
 }
 
+/**
+ * Shows the boss battle as a frame of the screen: both sides' HP, what the last turn did and the options.
+ * From turn to turn, only what changed is sent.
+ * @param tmpl The template of the boss
+ * @param boss The boss
+ * @param bossMaxHP The max HP of the boss
+ * @param skill The name of the skill the player used last, NULL before the first turn
+ * @param dealt The damage the player dealt last, -1 before the first turn
+ * @param received The damage the player received last, -1 if the boss has not attacked since
+ * @param cd The cooldowns of the battle
+ */
+static void showBossStatus(EnemyTemplate* tmpl, Boss* boss, uint bossMaxHP, const str skill, int dealt, int received, const Cooldowns* cd) {
+  Stats* stats = &boss->base.stats;
+
+  beginScreen();
+
+  screenPrintf("%sBOSS ENCOUNTERED!! Retreat is not an option!%s\n", RED, RESET);
+  screenPrintf("%s, LVL %d; HP %s%d%s/%d\n", tmpl->name, tmpl->lvl,
+      (boss->base.hp <= bossMaxHP / 2) ? RED : GREEN, boss->base.hp, RESET, bossMaxHP);
+  screenPrintf("ATK: %d; DEF: %d; ACC: %d; ATK CRIT DMG: %d; ATK CRIT: %3.2f\n",
+      stats->ATK, stats->DEF, stats->ACC, stats->ATK_CRIT_DMG, stats->ATK_CRIT);
+  screenPrintf("%s: %s%d%s/%d\n\n", player->name,
+      (player->hp <= player->maxHP / 2) ? RED : GREEN, player->hp, RESET, player->maxHP);
+
+  // The rows stay where they are, so a turn only changes the numbers
+  if (skill) screenPrintf("Skill activated is %s", skill);
+  screenPrintf("\n");
+  if (dealt >= 0) screenPrintf("You dealt %d DMG!", dealt);
+  screenPrintf("\n");
+  if (received >= 0) screenPrintf("You received %d DMG!", received);
+  screenPrintf("\n");
+
+  screenPrintf("\nWhat are you going to do?\n");
+  displayOptions(cd);
+
+  presentScreen();
+}
+
 /**
  * Checks whether the given attack is an equipped skill,
  * storing the attack in skillActivated if it is and setting whether
  * the basic attack was used. Includes if the 'attack' is simply using the set HP kit.
  * @param attack The attack to check
  * @param skillActivated Where to store the activated skill, if valid
+ * @param slot Where to store the slot of the activated skill, if valid
  * @param basicUsed.
+ * @param cd The cooldowns of the battle
  * @return True if valid skill, false otherwise
  */
-static bool validOptions(char attack, Skill** skillActivated, bool* basicUsed) {
+static bool validOptions(char attack, Skill** skillActivated, int* slot, bool* basicUsed, const Cooldowns* cd) {
   if (attack == 'h') {
     if (!player->hpSlot) printf("HP kit quick slot not set!\n");
     else heal(player, player->hpSlot);
@@ -299,14 +229,15 @@ static bool validOptions(char attack, Skill** skillActivated, bool* basicUsed) {
   for (int i = 0; i < EQUIPPED_SKILL_COUNT; i++) {
     if ((player->skills->equippedSkills[i]) && ((attack - 0x30) == i + 1)) {
       // Found the skill that attack matches
-      if (player->skills->equippedSkills[i]->cdTimer != 0) {
+      if (cd->timers[PLAYER_CD + i] != 0) {
         // The cooldown is still in effect
-        printf("Cannot use this skill yet! Cooldown of %d\n", player->skills->equippedSkills[i]->cdTimer);
+        printf("Cannot use this skill yet! Cooldown of %d\n", cd->timers[PLAYER_CD + i]);
         return false;
       }
 
       *basicUsed = false;
       *skillActivated = player->skills->equippedSkills[i];
+      *slot = i;
 
       return true;
     }
@@ -316,117 +247,92 @@ static bool validOptions(char attack, Skill** skillActivated, bool* basicUsed) {
   return false;
 }
 
-#ifdef _WIN64
-  #define _THREAD_RETURN DWORD WINAPI
-#else
-  #define _THREAD_RETURN void*
-#endif
-
-/**
- * Goes through all the skills and decreases its cooldown timer.
- * @param _skills The skill array
- * @return NULL
- */
-static _THREAD_RETURN decreaseCD(void* _skills) {
-  if (!_skills) {
-    // Decrease player's skills' CD
-    for (int i = 0; i < EQUIPPED_SKILL_COUNT; i++) {
-      if (player->skills->equippedSkills[i]) {
-        if (player->skills->equippedSkills[i]->cdTimer > 0) player->skills->equippedSkills[i]->cdTimer--;
-      }
-    }
-  } else {
-    Skill* skills = (Skill*) _skills;
-
-    // Decrease boss's skills' CD
-    for (int i = 0; i < BOSS_SKILL_COUNT; i++) {
-      if (skills[i].cdTimer > 0) skills[i].cdTimer--;
-    }
-  }
-
-#ifdef _WIN64
-  return 0;
-#else
-  return NULL;
-#endif
-}
-
 bool bossBattle(Boss* boss) {
   ushort playerAtk, enemyAtk;
 
   bool defeat = false; // Player defeat
   uint bossMaxHP = boss->base.hp;
 
-  printf("%sBOSS ENCOUNTERED!!%s\n", RED, RESET);
-  displayEnemyStats(&(boss->base));
-  printf("%sRetreat is not an option!%s\n", RED, RESET);
+  // The boss only keeps its rolls and cooldowns, the rest is shared through its template
+  EnemyTemplate* tmpl = getEnemyTemplate(maze, &boss->base);
+  BossTemplate* bossData = tmpl->boss;
 
   Skill* skillActivated = NULL;
+  int slot = -1;
   bool basicUsed = false;
 
+  // Both sides' cooldowns, packed for the battle so a turn ticks them in one step
+  Cooldowns cd;
+  loadCooldowns(&cd, player->skills->equippedSkills, boss->cdTimers);
+
+  uint turn = 0;
+
+  logBegin(true);
+  logSide(SIDE_PLAYER, &player->totalStats, player->hp, player->lvl);
+  logSide(SIDE_ENEMY, &boss->base.stats, boss->base.hp, tmpl->lvl);
+  for (int i = 0; i < EQUIPPED_SKILL_COUNT; i++) {
+    if (player->skills->equippedSkills[i]) logSkill(PLAYER_CD + i, player->skills->equippedSkills[i]);
+  }
+  for (int i = 0; i < BOSS_SKILL_COUNT; i++) logSkill(BOSS_CD + i, &bossData->skills[i]);
+
+  // What the last turn did
+  str lastSkill = NULL;
+  int dealt = -1, received = -1;
+
   while (true) {
-    printf("What are you going to do?\n");
-    displayOptions();
+    showBossStatus(tmpl, boss, bossMaxHP, lastSkill, dealt, received, &cd);
+
     printf(": ");
     uchar attack = getchar();
     FLUSH()
-    while (!validOptions(attack, &skillActivated, &basicUsed)) {
+    while (!validOptions(attack, &skillActivated, &slot, &basicUsed, &cd)) {
       printf(": ");
       attack = getchar();
       FLUSH()
     }
 
     if (basicUsed) skillActivated = NULL;
-    printf("Skill activated is %s\n", (!skillActivated) ? "none" : skillActivated->name);
+    lastSkill = (!skillActivated) ? "none" : skillActivated->name;
 
-    playerAtk = getTotalDmg(player->stats, boss->base.stats, skillActivated);
-    printf("You dealt %d DMG!\n", playerAtk);
+    uint64_t rng = getRandomState(RNG_BATTLE);
+    bool hit;
+    playerAtk = rollDamage(&player->totalStats, &boss->base.stats, skillActivated, player->lvl, &hit);
+    logRound(SIDE_PLAYER, skillActivated ? PLAYER_CD + slot : NO_SKILL, turn, rng, playerAtk,
+        (playerAtk >= boss->base.hp) ? 0 : boss->base.hp - playerAtk);
+    // A miss does not use up the skill
+    if (skillActivated && hit) startCooldown(&cd, PLAYER_CD + slot, skillActivated->cooldown);
+    dealt = playerAtk;
+    received = -1;
 
-    if (playerAtk >= boss->base.hp) { printf("%s defeated!\n", boss->base.name); break; }
+    if (playerAtk >= boss->base.hp) { closeScreen(); printf("%s defeated!\n", tmpl->name); break; }
 
     boss->base.hp -= playerAtk;
-    printf("%s: %d/%d\n", boss->base.name, boss->base.hp, bossMaxHP);
+    showBossStatus(tmpl, boss, bossMaxHP, lastSkill, dealt, received, &cd);
 
-    ssleep(500);
+    pace(PACE_BATTLE, 500);
 
-    skillActivated = chooseBossSkill(boss->skills);
+    int bossSkill = chooseBossSkill(cd.timers + BOSS_CD);
+    skillActivated = (bossSkill == -1) ? NULL : &bossData->skills[bossSkill];
 
-    enemyAtk = getTotalDmg(boss->base.stats, player->stats, skillActivated);
-    printf("You received %d DMG!\n", enemyAtk);
+    rng = getRandomState(RNG_BATTLE);
+    enemyAtk = rollDamage(&boss->base.stats, &player->totalStats, skillActivated, player->lvl, &hit);
+    logRound(SIDE_ENEMY, (bossSkill == -1) ? NO_SKILL : BOSS_CD + bossSkill, turn, rng, enemyAtk,
+        (enemyAtk >= player->hp) ? 0 : player->hp - enemyAtk);
+    if (skillActivated && hit) startCooldown(&cd, BOSS_CD + bossSkill, skillActivated->cooldown);
+    received = enemyAtk;
 
-    if (enemyAtk >= player->hp) { printf("Player defeated!\n"); defeat = true; break; }
+    if (enemyAtk >= player->hp) { closeScreen(); printf("Player defeated!\n"); defeat = true; break; }
 
     player->hp -= enemyAtk;
-    printf("%s: %d/%d\n", player->name, player->hp, player->maxHP);
 
     // Decrease all skills' CD
-#ifdef _WIN64
-    HANDLE playerCDThread, bossCDThread;
-    DWORD thread1D, thread2D;
-
-    playerCDThread = CreateThread(NULL, 0, decreaseCD, NULL, 0, &thread1D);
-    if (!playerCDThread) handleError(ERR_MEM, FATAL, "Could not create thread!\n");
-    bossCDThread = CreateThread(NULL, 0, decreaseCD, (void*) boss->skills, 0, &thread2D);
-    if (!bossCDThread) handleError(ERR_MEM, FATAL, "Could not create thread!\n");
-
-    WaitForSingleObject(playerCDThread, INFINITE);
-    WaitForSingleObject(bossCDThread, INFINITE);
-
-    CloseHandle(playerCDThread);
-    CloseHandle(bossCDThread);
-#else
-    pthread_t playerCDThread, bossCDThread;
+    tickCooldowns(&cd);
+    turn++;
+  }
 
-    int threadRet = pthread_create(&playerCDThread, NULL, decreaseCD, NULL);
-    if (threadRet != 0) handleError(ERR_MEM, FATAL, "Could not create thread!\n");
-    
-    threadRet = pthread_create(&bossCDThread, NULL, decreaseCD, (void*) boss->skills);
-    if (threadRet != 0) handleError(ERR_MEM, FATAL, "Could not create thread!\n");
+  logEnd(!defeat);
 
-    pthread_join(playerCDThread, NULL);
-    pthread_join(bossCDThread, NULL);
-#endif
-  }
+  storeCooldowns(&cd, player->skills->equippedSkills, boss->cdTimers);
 
   if (defeat) {
     boss->base.hp = bossMaxHP;
@@ -436,7 +342,7 @@ bool bossBattle(Boss* boss) {
 
     return false;
   } else {
-    updateXP(player, boss->base.xpPoints);
+    updateXP(player, tmpl->xpPoints);
     player->skills->totalSkillPoints += 3;
 
     // Need to create Item* in order to use addToInv
@@ -456,39 +362,45 @@ bool bossBattle(Boss* boss) {
      */
 
     gearItem->type = SOULWEAPON_T;
-    gearItem->_item = (void*) boss->gearDrop.sw;
+    gearItem->_item = promoteItemData(bossData->gearDrop.sw, gearItem->type);
     if (addToInv(player, gearItem)) printf("SoulWeapon added!\n");
     else { printf("Could not add SoulWeapon!\n"); goto end; }
 
     gearItem->type = HELMET_T;
-    gearItem->_item = (void*) boss->gearDrop.helmet;
+    gearItem->_item = promoteItemData(bossData->gearDrop.helmet, gearItem->type);
     if (addToInv(player, gearItem)) printf("Helmet added!\n");
     else { printf("Could not add helmet!\n"); goto end; }
 
     gearItem->type = SHOULDER_GUARD_T;
-    gearItem->_item = (void*) boss->gearDrop.guard;
+    gearItem->_item = promoteItemData(bossData->gearDrop.guard, gearItem->type);
     if (addToInv(player, gearItem)) printf("Shoulder guard added!\n");
     else { printf("Could not add shoulder guard!\n"); goto end; }
 
     gearItem->type = CHESTPLATE_T;
-    gearItem->_item = (void*) boss->gearDrop.chestplate;
+    gearItem->_item = promoteItemData(bossData->gearDrop.chestplate, gearItem->type);
     if (addToInv(player, gearItem)) printf("Chestplate added!\n");
     else { printf("Could not add chestplate!\n"); goto end; }
 
     gearItem->type = BOOTS_T;
-    gearItem->_item = (void*) boss->gearDrop.boots;
+    gearItem->_item = promoteItemData(bossData->gearDrop.boots, gearItem->type);
     if (addToInv(player, gearItem)) printf("Boots added!\n");
     else { printf("Could not add boots!\n"); goto end; }
 
+    // Every piece was added, the player inv owns all the copies
+    free(gearItem);
+    gearItem = NULL;
+
+    deleteEnemyFromMap(maze, player->room);
+
+    return true;
+
     end:
-    // No longer need gearItem, free it
-    // Do not free gearItem->_item since it points to boss->gearDrop.boots
-    // which the player inv owns the pointer (thus the struct) now
+    // The gear is copied out of the maze arena, so the piece that did not fit is deleted along with gearItem
     // NOTE: see prior big comment
-    free(gearItem);
+    deleteItem(gearItem);
     gearItem = NULL;
 
-    deleteEnemyFromMap(player->room, false);
+    deleteEnemyFromMap(maze, player->room);
 
     return true;
   }
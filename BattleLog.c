@@ -0,0 +1,177 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <signal.h>
+#include <fcntl.h>
+
+#ifdef _WIN64
+  #include <io.h>
+  #include <sys/stat.h>
+#else
+  #include <unistd.h>
+  #include <sys/uio.h>
+#endif
+
+#include "BattleLog.h"
+#include "Damage.h"
+#include "Error.h"
+
+
+#define MAX_LOG_PATH 256
+
+#if (BATTLE_LOG_EVENTS & (BATTLE_LOG_EVENTS - 1)) != 0
+  #error "BATTLE_LOG_EVENTS has to be a power of 2"
+#endif
+
+// The signals that end the game without running atexit
+static const int fatalSignals[] = {
+  SIGINT, SIGTERM, SIGSEGV, SIGABRT, SIGFPE, SIGILL,
+#ifdef SIGBUS
+  SIGBUS,
+#endif
+};
+
+// The log lives in one static block, so it is there to write even when the heap is not
+static struct {
+  BattleEvent events[BATTLE_LOG_EVENTS]; // The ring, events[count % BATTLE_LOG_EVENTS] is the next
+  uint64_t count; // Every event logged, written over or not
+  uint64_t seed; // The seed of the game
+  char path[MAX_LOG_PATH]; // Where to write, empty until the log is opened
+  volatile sig_atomic_t flushed; // The log is only written once
+} battleLog;
+
+
+/**
+ * Gets the next slot of the ring, writing over the oldest event once it is full.
+ * @return The slot
+ */
+static inline BattleEvent* nextEvent() {
+  return &battleLog.events[battleLog.count++ & (BATTLE_LOG_EVENTS - 1)];
+}
+
+/**
+ * Writes the log before the signal ends the game, then lets it.
+ * @param sig The signal
+ */
+static void onFatalSignal(int sig) {
+  flushBattleLog();
+
+  signal(sig, SIG_DFL);
+  raise(sig);
+}
+
+void openBattleLog(const char* path, uint64_t seed) {
+  if (strlen(path) >= MAX_LOG_PATH) {
+    handleError(ERR_IO, WARNING, "The battle log path is too long, battles will not be logged!\n");
+    return;
+  }
+
+  bool opened = battleLog.path[0] != '\0';
+
+  strcpy(battleLog.path, path);
+  battleLog.seed = seed;
+
+  // Anything logged before belongs to no log, or to the one before
+  battleLog.count = 0;
+
+  if (opened) return;
+
+  atexit(flushBattleLog);
+  for (size_t i = 0; i < sizeof(fatalSignals) / sizeof(fatalSignals[0]); i++) signal(fatalSignals[i], onFatalSignal);
+}
+
+void logBegin(bool boss) {
+  BattleEvent* e = nextEvent();
+
+  e->type = LOG_BEGIN;
+  e->side = SIDE_PLAYER;
+  e->skill = NO_SKILL;
+  e->value = boss;
+}
+
+void logSide(side_t side, const Stats* stats, uint hp, uint lvl) {
+  BattleEvent* e = nextEvent();
+
+  e->type = LOG_SIDE;
+  e->side = side;
+  e->skill = NO_SKILL;
+  e->value = lvl;
+  e->start.stats = *stats;
+  e->start.hp = hp;
+}
+
+void logSkill(uint slot, const Skill* skill) {
+  BattleEvent* e = nextEvent();
+
+  e->type = LOG_SKILL;
+  e->side = (slot < BOSS_CD) ? SIDE_PLAYER : SIDE_ENEMY;
+  e->skill = slot;
+  e->value = skill->id;
+  memcpy(e->effects, &skill->effect1, SKILL_EFFECTS_SIZE);
+}
+
+void logRound(side_t side, uint skill, uint turn, uint64_t rng, ushort dmg, uint hpAfter) {
+  BattleEvent* e = nextEvent();
+
+  e->type = LOG_ROUND;
+  e->side = side;
+  e->skill = skill;
+  e->value = turn;
+  e->round.rng = rng;
+  e->round.hpAfter = hpAfter;
+  e->round.dmg = dmg;
+}
+
+void logEnd(bool won) {
+  BattleEvent* e = nextEvent();
+
+  e->type = LOG_END;
+  e->side = SIDE_PLAYER;
+  e->skill = NO_SKILL;
+  e->value = won;
+}
+
+void flushBattleLog() {
+  // Nothing to keep, so an older log is not written over
+  if (battleLog.flushed || battleLog.path[0] == '\0' || battleLog.count == 0) return;
+  battleLog.flushed = 1;
+
+  uint64_t count = battleLog.count;
+  uint kept = (count < BATTLE_LOG_EVENTS) ? (uint) count : BATTLE_LOG_EVENTS;
+  uint oldest = (count < BATTLE_LOG_EVENTS) ? 0 : (uint) (count & (BATTLE_LOG_EVENTS - 1));
+
+  BattleLogHeader header;
+  memset(&header, 0, sizeof(header));
+  memcpy(header.magic, BATTLE_LOG_MAGIC, sizeof(header.magic));
+  header.version = BATTLE_LOG_VERSION;
+  header.count = kept;
+  header.seed = battleLog.seed;
+  header.dropped = count - kept;
+
+  // The ring wraps, so the oldest events are at the back of it
+  size_t backBytes = (size_t) (kept - oldest) * sizeof(BattleEvent);
+  size_t frontBytes = (size_t) oldest * sizeof(BattleEvent);
+
+  // Only calls that are safe in a signal handler from here on
+#ifdef _WIN64
+  int fd = _open(battleLog.path, _O_WRONLY | _O_CREAT | _O_TRUNC | _O_BINARY, _S_IREAD | _S_IWRITE);
+  if (fd == -1) return;
+
+  _write(fd, &header, sizeof(header));
+  _write(fd, &battleLog.events[oldest], (unsigned int) backBytes);
+  _write(fd, battleLog.events, (unsigned int) frontBytes);
+  _close(fd);
+#else
+  int fd = open(battleLog.path, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+  if (fd == -1) return;
+
+  struct iovec iov[3] = {
+    { &header, sizeof(header) },
+    { &battleLog.events[oldest], backBytes },
+    { battleLog.events, frontBytes }
+  };
+
+  writev(fd, iov, 3);
+  close(fd);
+#endif
+}
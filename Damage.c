@@ -0,0 +1,288 @@
+#include <stdlib.h>
+#include <stddef.h>
+#include <string.h>
+
+// Build with -DNO_SIMD to leave the vector kernels out
+#if !defined(NO_SIMD) && defined(__GNUC__) && defined(__x86_64__)
+  #define DAMAGE_AVX2
+  #include <immintrin.h>
+#elif !defined(NO_SIMD) && defined(__aarch64__)
+  #define DAMAGE_NEON
+  #include <arm_neon.h>
+#endif
+
+#include "Damage.h"
+#include "Random.h"
+#include "SoulWorker.h"
+
+
+#if BOSS_CD != PLAYER_CD + EQUIPPED_SKILL_COUNT || BOSS_CD + BOSS_SKILL_COUNT > 16
+  #error "The cooldowns of the player and the boss do not fit in Cooldowns"
+#endif
+
+// The batch kernels read Stats as 3 little endian words: ATK and DEF, ACC and ATK_CRIT_DMG, then ATK_CRIT
+_Static_assert(sizeof(Stats) == 12 && offsetof(Stats, DEF) == 2 && offsetof(Stats, ACC) == 4 &&
+               offsetof(Stats, ATK_CRIT_DMG) == 6 && offsetof(Stats, ATK_CRIT) == 8, "Stats is not laid out as the batch kernels read it");
+
+/**
+ * Works out the damage of an attack that hit. The batch kernels follow this step for step.
+ * @param atk The ATK of the attacker
+ * @param def The DEF of the target
+ * @param critDmg The ATK_CRIT_DMG of the attacker
+ * @param crit Whether the attack crit
+ * @return How much damage taken
+ */
+static inline ushort hitDamage(ushort atk, ushort def, ushort critDmg, bool crit) {
+  short baseDamage = 1 + (atk - def);
+  if (baseDamage < 1) baseDamage = 1;
+
+  if (crit) {
+    baseDamage += ((ushort) baseDamage * critDmg) / 100;
+  }
+
+  return (ushort) baseDamage;
+}
+
+Stats gearStats(const Stats* stats, const Gear* gear) {
+  Stats total = *stats;
+
+  if (gear->sw) {
+    total.ATK += gear->sw->atk;
+    total.ACC += gear->sw->acc;
+    total.ATK_CRIT += gear->sw->atk_crit;
+    total.ATK_CRIT_DMG += gear->sw->atk_crit_dmg;
+  }
+
+  Armor* armor[4] = { gear->helmet, gear->guard, gear->chestplate, gear->boots };
+
+  for (int i = 0; i < 4; i++) {
+    if (!armor[i]) continue;
+
+    total.ACC += armor[i]->acc;
+    total.DEF += armor[i]->def;
+  }
+
+  return total;
+}
+
+void applySkill(const Skill* skill, Stats* attacker, Stats* target) {
+  if (!skill) return;
+
+  attacker->ATK += (skill->activeEffect1 == ATK) ? skill->effect1.atk : 0;
+  attacker->ACC += (skill->activeEffect2 == ACC) ? skill->effect2.acc : 0;
+  attacker->ATK_CRIT += (skill->activeEffect2 == ATK_CRIT) ? skill->effect2.atk_crit : 0.0;
+  attacker->ATK_CRIT_DMG += (skill->activeEffect1 == ATK_CRIT_DMG) ? skill->effect1.atk_crit_dmg : 0;
+  target->DEF += (skill->activeEffect2 == DEF) ? skill->effect2.def : 0;
+}
+
+ushort rollDamage(const Stats* attacker, const Stats* target, const Skill* skill, uint playerLvl, bool* hit) {
+  Stats total = *attacker;
+  Stats totalTarget = *target;
+  applySkill(skill, &total, &totalTarget);
+
+  float hitRoll = randomFloat(RNG_BATTLE) * (playerLvl * 3);
+  bool hits = !(hitRoll > total.ACC);
+  if (hit) *hit = hits;
+  if (!hits) return 0;
+
+  // The crit is only rolled on a hit
+  return hitDamage(total.ATK, totalTarget.DEF, total.ATK_CRIT_DMG, randomFloat(RNG_BATTLE) <= total.ATK_CRIT);
+}
+
+/**
+ * Rolls out a batch one attack at a time, for the attacks the kernels leave over and when there are none.
+ */
+static void batchDamageScalar(const Stats* attackers, const Stats* targets, const float* hitRolls, const float* critRolls,
+                              float hitScale, ushort* out, uint n) {
+  for (uint i = 0; i < n; i++) {
+    const Stats* attacker = &attackers[i];
+
+    if (hitRolls[i] * hitScale > attacker->ACC) out[i] = 0;
+    else out[i] = hitDamage(attacker->ATK, targets[i].DEF, attacker->ATK_CRIT_DMG, critRolls[i] <= attacker->ATK_CRIT);
+  }
+}
+
+#ifdef DAMAGE_AVX2
+/**
+ * Rolls out 8 attacks at a time with AVX2. Each lane follows hitDamage: the short the damage is
+ * kept in wraps the same, and the division by 100 is a multiply and shift that is exact for 32 bits.
+ * @return How many attacks were rolled out, a multiple of 8
+ */
+__attribute__((target("avx2")))
+static uint batchDamageAvx2(const Stats* attackers, const Stats* targets, const float* hitRolls, const float* critRolls,
+                            float hitScale, ushort* out, uint n) {
+  const __m256i strides = _mm256_setr_epi32(0, 12, 24, 36, 48, 60, 72, 84);
+  const __m256i low = _mm256_set1_epi32(0xFFFF);
+  const __m256i one = _mm256_set1_epi32(1);
+  const __m256i magic = _mm256_set1_epi32(0x51EB851F); // 2^37 / 100, rounded up
+  const __m256 scale = _mm256_set1_ps(hitScale);
+
+  uint i = 0;
+
+  for (; i + 8 <= n; i += 8) {
+    const char* a = (const char*) &attackers[i];
+
+    __m256i atkDef = _mm256_i32gather_epi32((const int*) a, strides, 1);
+    __m256i accCritDmg = _mm256_i32gather_epi32((const int*) (a + 4), strides, 1);
+    __m256 crit = _mm256_i32gather_ps((const float*) (a + 8), strides, 1);
+    __m256i def = _mm256_srli_epi32(_mm256_i32gather_epi32((const int*) &targets[i], strides, 1), 16);
+
+    __m256i atk = _mm256_and_si256(atkDef, low);
+    __m256i acc = _mm256_and_si256(accCritDmg, low);
+    __m256i critDmg = _mm256_srli_epi32(accCritDmg, 16);
+
+    // Not greater, so a hit is anything the scalar check would not call a miss
+    __m256 hitRoll = _mm256_mul_ps(_mm256_loadu_ps(hitRolls + i), scale);
+    __m256i hit = _mm256_castps_si256(_mm256_cmp_ps(hitRoll, _mm256_cvtepi32_ps(acc), _CMP_NGT_UQ));
+    __m256i crits = _mm256_castps_si256(_mm256_cmp_ps(_mm256_loadu_ps(critRolls + i), crit, _CMP_LE_OQ));
+
+    // Into a short and back, then at least 1
+    __m256i dmg = _mm256_sub_epi32(_mm256_add_epi32(one, atk), def);
+    dmg = _mm256_srai_epi32(_mm256_slli_epi32(dmg, 16), 16);
+    dmg = _mm256_max_epi32(dmg, one);
+
+    // At most 32767 * 65535, so the product fits and the shift divides it exactly
+    __m256i product = _mm256_mullo_epi32(dmg, critDmg);
+    __m256i even = _mm256_srli_epi64(_mm256_mul_epu32(product, magic), 37);
+    __m256i odd = _mm256_srli_epi64(_mm256_mul_epu32(_mm256_srli_epi64(product, 32), magic), 37);
+    __m256i bonus = _mm256_blend_epi32(even, _mm256_slli_epi64(odd, 32), 0xAA);
+
+    dmg = _mm256_add_epi32(dmg, _mm256_and_si256(bonus, crits));
+    dmg = _mm256_and_si256(_mm256_and_si256(dmg, low), hit);
+
+    // Packing works within each half, so the halves are put back in order after
+    __m256i packed = _mm256_permute4x64_epi64(_mm256_packus_epi32(dmg, dmg), 0x08);
+    _mm_storeu_si128((__m128i*) (out + i), _mm256_castsi256_si128(packed));
+  }
+
+  return i;
+}
+#endif
+
+#ifdef DAMAGE_NEON
+/**
+ * Rolls out 8 attacks at a time with NEON, as two runs of 4. Each lane follows hitDamage, see batchDamageAvx2.
+ * @return How many attacks were rolled out, a multiple of 8
+ */
+static uint batchDamageNeon(const Stats* attackers, const Stats* targets, const float* hitRolls, const float* critRolls,
+                            float hitScale, ushort* out, uint n) {
+  const uint32x4_t low = vdupq_n_u32(0xFFFF);
+  const int32x4_t one = vdupq_n_s32(1);
+  const uint32x2_t magic = vdup_n_u32(0x51EB851F);
+
+  uint i = 0;
+
+  for (; i + 8 <= n; i += 8) {
+    for (uint j = i; j < i + 8; j += 4) {
+      // Stats is 3 words, so loading them 3 apart splits the fields out
+      uint32x4x3_t a = vld3q_u32((const uint32_t*) &attackers[j]);
+      uint32x4x3_t t = vld3q_u32((const uint32_t*) &targets[j]);
+
+      int32x4_t atk = vreinterpretq_s32_u32(vandq_u32(a.val[0], low));
+      int32x4_t def = vreinterpretq_s32_u32(vshrq_n_u32(t.val[0], 16));
+      uint32x4_t acc = vandq_u32(a.val[1], low);
+      uint32x4_t critDmg = vshrq_n_u32(a.val[1], 16);
+      float32x4_t crit = vreinterpretq_f32_u32(a.val[2]);
+
+      float32x4_t hitRoll = vmulq_n_f32(vld1q_f32(hitRolls + j), hitScale);
+      uint32x4_t miss = vcgtq_f32(hitRoll, vcvtq_f32_u32(acc));
+      uint32x4_t crits = vcleq_f32(vld1q_f32(critRolls + j), crit);
+
+      int32x4_t dmg = vsubq_s32(vaddq_s32(one, atk), def);
+      dmg = vshrq_n_s32(vshlq_n_s32(dmg, 16), 16);
+      dmg = vmaxq_s32(dmg, one);
+
+      uint32x4_t product = vmulq_u32(vreinterpretq_u32_s32(dmg), critDmg);
+      uint32x2_t lo = vmovn_u64(vshrq_n_u64(vmull_u32(vget_low_u32(product), magic), 37));
+      uint32x2_t hi = vmovn_u64(vshrq_n_u64(vmull_u32(vget_high_u32(product), magic), 37));
+      uint32x4_t bonus = vcombine_u32(lo, hi);
+
+      uint32x4_t total = vaddq_u32(vreinterpretq_u32_s32(dmg), vandq_u32(bonus, crits));
+      total = vbicq_u32(vandq_u32(total, low), miss);
+
+      vst1_u16(out + j, vmovn_u32(total));
+    }
+  }
+
+  return i;
+}
+#endif
+
+void batchDamage(const Stats* attackers, const Stats* targets, const float* hitRolls, const float* critRolls,
+                 uint playerLvl, ushort* out, uint n) {
+  // The same scale rollDamage multiplies by
+  float hitScale = playerLvl * 3;
+  uint done = 0;
+
+#if defined(DAMAGE_AVX2)
+  if (__builtin_cpu_supports("avx2")) done = batchDamageAvx2(attackers, targets, hitRolls, critRolls, hitScale, out, n);
+#elif defined(DAMAGE_NEON)
+  done = batchDamageNeon(attackers, targets, hitRolls, critRolls, hitScale, out, n);
+#endif
+
+  batchDamageScalar(attackers + done, targets + done, hitRolls + done, critRolls + done, hitScale, out + done, n - done);
+}
+
+const char* batchDamageKernel() {
+#if defined(DAMAGE_AVX2)
+  if (__builtin_cpu_supports("avx2")) return "avx2";
+#elif defined(DAMAGE_NEON)
+  return "neon";
+#endif
+
+  return "scalar";
+}
+
+int chooseBossSkill(const char* cdTimers) {
+  int r = randomBelow(RNG_BOSS, 2);
+
+  if (r == 1) {
+    // Rerolling would never end if nothing is ready, so the boss falls back to its basic
+    bool ready = false;
+    for (int i = 0; i < BOSS_SKILL_COUNT; i++) {
+      if (cdTimers[i] == 0) { ready = true; break; }
+    }
+    if (!ready) return -1;
+
+    int choosenSkill;
+
+    do {
+      choosenSkill = randomBelow(RNG_BOSS, BOSS_SKILL_COUNT);
+    } while (cdTimers[choosenSkill] != 0);
+
+    return choosenSkill;
+  }
+
+  return -1;
+}
+
+void startCooldown(Cooldowns* cd, uint slot, byte cooldown) {
+  cd->timers[slot] = (cooldown < MAX_CD) ? cooldown + 1 : MAX_CD;
+}
+
+void tickCooldowns(Cooldowns* cd) {
+  // Timers stay below 0x80, so adding 0x7F sets the top bit of a byte only when it is not 0,
+  // without carrying into the next byte. Shifted down, that is the 1 to take off each running timer.
+  for (int i = 0; i < 2; i++) {
+    uint64_t w = cd->words[i];
+    cd->words[i] = w - (((w + 0x7F7F7F7F7F7F7F7FULL) & 0x8080808080808080ULL) >> 7);
+  }
+}
+
+void loadCooldowns(Cooldowns* cd, Skill** equipped, const char* bossTimers) {
+  memset(cd, 0, sizeof(Cooldowns));
+
+  for (int i = 0; i < EQUIPPED_SKILL_COUNT; i++) {
+    if (equipped[i]) cd->timers[PLAYER_CD + i] = equipped[i]->cdTimer;
+  }
+
+  if (bossTimers) memcpy(cd->timers + BOSS_CD, bossTimers, BOSS_SKILL_COUNT);
+}
+
+void storeCooldowns(const Cooldowns* cd, Skill** equipped, char* bossTimers) {
+  for (int i = 0; i < EQUIPPED_SKILL_COUNT; i++) {
+    if (equipped[i]) equipped[i]->cdTimer = cd->timers[PLAYER_CD + i];
+  }
+
+  if (bossTimers) memcpy(bossTimers, cd->timers + BOSS_CD, BOSS_SKILL_COUNT);
+}
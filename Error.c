@@ -7,7 +7,7 @@
 
 #define str char*
 
-static char buffer[150]; // Maybe increase size depending on future error text
+#define ERROR_BUFFER_SIZE 150 // Maybe increase size depending on future error text
 
 static str errnames[ERR_IO+1] = {
   "DATA FORMAT ERROR",
@@ -17,18 +17,21 @@ static str errnames[ERR_IO+1] = {
 
 /**
  * Includes the arguments passed to handleError into the format string fmsg
+ * @param buffer Where to write the message, ERROR_BUFFER_SIZE long
  * @param fmsg The format string
  * @param args The variable arguments
  */
-static void formatMessage(const str fmsg, va_list args) {
-  vsnprintf(buffer, 150, fmsg, args);
+static void formatMessage(str buffer, const str fmsg, va_list args) {
+  vsnprintf(buffer, ERROR_BUFFER_SIZE, fmsg, args);
 }
 
 void handleError(errType err, sevType sev, const str fmsg, ...) {
+  // On the stack, since map workers can report at the same time
+  char buffer[ERROR_BUFFER_SIZE];
   va_list args;
   va_start(args, fmsg);
 
-  formatMessage(fmsg, args);
+  formatMessage(buffer, fmsg, args);
 
   if (sev == FATAL) {
     fprintf(stdout, RED "%s: %s" RESET, errnames[err], buffer);
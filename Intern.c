@@ -0,0 +1,164 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+
+#ifdef _WIN64
+  #include <windows.h>
+#else
+  #include <pthread.h>
+#endif
+
+#include "Error.h"
+#include "Arena.h"
+#include "Intern.h"
+
+
+// An open addressing hash set of strings
+typedef struct InternTable {
+  str* slots; // The strings, NULL when the slot is empty
+  uint32_t* hashes; // The hash of each slot, to skip most string compares
+  uint cap; // Number of slots, a power of two
+  uint len; // Number of strings
+  Arena* arena; // Holds the strings themselves
+  size_t rawBytes; // Bytes asked to be interned
+  size_t internedBytes; // Bytes stored
+} InternTable;
+
+static InternTable table = { NULL, NULL, 0, 0, NULL, 0, 0 };
+
+// Mazes can be loaded on the prefetch thread while the main thread interns
+#ifdef _WIN64
+  static SRWLOCK tableLock = SRWLOCK_INIT;
+  #define LOCK() AcquireSRWLockExclusive(&tableLock)
+  #define UNLOCK() ReleaseSRWLockExclusive(&tableLock)
+#else
+  static pthread_mutex_t tableLock = PTHREAD_MUTEX_INITIALIZER;
+  #define LOCK() pthread_mutex_lock(&tableLock)
+  #define UNLOCK() pthread_mutex_unlock(&tableLock)
+#endif
+
+
+/**
+ * FNV-1a hash of the string.
+ * @param s The string
+ * @param len Where to store the length of the string
+ * @return The hash
+ */
+static uint32_t hashString(const char* s, size_t* len) {
+  uint32_t hash = 2166136261u;
+  const char* c = s;
+
+  for (; *c; c++) {
+    hash ^= (unsigned char) *c;
+    hash *= 16777619u;
+  }
+
+  *len = c - s;
+
+  return hash;
+}
+
+/**
+ * Allocates the slots of the table.
+ * @param cap The number of slots
+ */
+static void allocSlots(uint cap) {
+  table.slots = (str*) calloc(cap, sizeof(str));
+  table.hashes = (uint32_t*) calloc(cap, sizeof(uint32_t));
+  if (!table.slots || !table.hashes) handleError(ERR_MEM, FATAL, "Could not allocate space for the intern table!\n");
+
+  table.cap = cap;
+}
+
+/**
+ * Doubles the number of slots, rehashing the strings.
+ */
+static void growTable() {
+  str* slots = table.slots;
+  uint32_t* hashes = table.hashes;
+  uint cap = table.cap;
+
+  allocSlots(cap * 2);
+
+  for (uint i = 0; i < cap; i++) {
+    if (!slots[i]) continue;
+
+    uint j = hashes[i] & (table.cap - 1);
+    while (table.slots[j]) j = (j + 1) & (table.cap - 1);
+
+    table.slots[j] = slots[i];
+    table.hashes[j] = hashes[i];
+  }
+
+  free(slots);
+  free(hashes);
+}
+
+str intern(const char* s) {
+  if (!s) return NULL;
+
+  size_t len;
+  uint32_t hash = hashString(s, &len);
+
+  LOCK();
+
+  if (!table.slots) {
+    allocSlots(INTERN_INIT_CAP);
+    table.arena = initArena(ARENA_CHUNK_SIZE);
+  }
+
+  table.rawBytes += len + 1;
+
+  uint i = hash & (table.cap - 1);
+  while (table.slots[i]) {
+    if (table.hashes[i] == hash && strcmp(table.slots[i], s) == 0) {
+      str found = table.slots[i];
+      UNLOCK();
+
+      return found;
+    }
+
+    i = (i + 1) & (table.cap - 1);
+  }
+
+  // Keep the load under 3/4
+  if ((table.len + 1) * 4 > table.cap * 3) {
+    growTable();
+
+    i = hash & (table.cap - 1);
+    while (table.slots[i]) i = (i + 1) & (table.cap - 1);
+  }
+
+  str copy = arenaString(table.arena, s);
+
+  table.slots[i] = copy;
+  table.hashes[i] = hash;
+  table.len++;
+  table.internedBytes += len + 1;
+
+  UNLOCK();
+
+  return copy;
+}
+
+InternStats getInternStats() {
+  InternStats stats;
+
+  LOCK();
+  stats.rawBytes = table.rawBytes;
+  stats.internedBytes = table.internedBytes;
+  stats.count = table.len;
+  UNLOCK();
+
+  return stats;
+}
+
+void printInternStats() {
+  InternStats stats = getInternStats();
+
+  double saved = (stats.rawBytes == 0) ? 0 : 100.0 * (stats.rawBytes - stats.internedBytes) / stats.rawBytes;
+
+  printf("(Strings: %u distinct, %zu bytes interned for %zu bytes raw, %.1f%% saved)\n",
+      stats.count, stats.internedBytes, stats.rawBytes, saved);
+}
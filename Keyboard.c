@@ -5,6 +5,8 @@
 #include "Keyboard.h"
 #include "Error.h"
 #include "SaveLoad.h"
+#include "Random.h"
+#include "Screen.h"
 
 
 #define CHAR_TO_INDEX(c) \
@@ -65,14 +67,16 @@ uchar from; // Find much better naming. Basically, where the player headed to up
 /**
  * Valides the given exit direction. That is, whether the direction points to a closed exit.
  * @param dir The direction exit to validate
- * @param room The current room
+ * @param room The slot of the current room
  * @return True if valid, false otherwise
  */
-static bool validExit(Movement dir, Room* room) {
-  if ((dir == MOVE_NORTH && room->exits[0] == (void*) ((long long)NO_EXIT)) ||
-      (dir == MOVE_EAST && room->exits[1] == (void*) ((long long)NO_EXIT)) ||
-      (dir == MOVE_SOUTH && room->exits[2] == (void*) ((long long)NO_EXIT)) ||
-      (dir == MOVE_WEST && room->exits[3] == (void*) ((long long)NO_EXIT))) {
+static bool validExit(Movement dir, uint room) {
+  uint* exits = maze->rooms.exits[room];
+
+  if ((dir == MOVE_NORTH && exits[0] == NO_ROOM) ||
+      (dir == MOVE_EAST && exits[1] == NO_ROOM) ||
+      (dir == MOVE_SOUTH && exits[2] == NO_ROOM) ||
+      (dir == MOVE_WEST && exits[3] == NO_ROOM)) {
 
     return false;
   }
@@ -116,7 +120,7 @@ static uint getPrice(byte lvl, item_t type) {
   minPrice = (uint) (baseMinPrice * weight);
   maxPrice = (uint) (baseMaxPrice * weight);
 
-  price = minPrice + rand() % (maxPrice - minPrice + 1);
+  price = randomRange(RNG_SHOP, minPrice, maxPrice);
 
   return price;
 }
@@ -178,10 +182,10 @@ static Item* validItem(byte itemI) {
 /**
  * Validates the given direction. That is, whether the direction is a direction at all.
  * @param dir The direction to validate
- * @param room The current room
+ * @param room The slot of the current room
  * @return True if valid, false otherwise
  */
-static bool validMove(Movement* dir, Room* room) {
+static bool validMove(Movement* dir, uint room) {
   if (*dir == MOVE_NORTH || *dir == MOVE_EAST || *dir == MOVE_SOUTH || *dir == MOVE_WEST) {
     while (!validExit(*dir, room)) {
       printf("That direction is closed. Try another direction! ");
@@ -284,6 +288,66 @@ static void displayHelp(HELP_T type) {
 }
 
 
+/**
+ * Shows a drawn map as a frame of the screen.
+ * @param bytes The map, drawn by renderMap or renderMapView
+ * @param len The bytes of the map
+ */
+static void showMapFrame(const char* bytes, size_t len) {
+  beginScreen();
+  screenWrite(bytes, len);
+  presentScreen();
+}
+
+/**
+ * Shows the map. A map too big for the terminal is shown a window at a time around the player,
+ * which can be scrolled until closed.
+ */
+static void viewMap() {
+  uint cols, rows;
+  getTerminalSize(&cols, &rows);
+
+  // A row for the title and one for the prompt
+  rows = (rows > 2) ? rows - 2 : 1;
+
+  if (mapFits(maze, cols, rows)) {
+    showMapFrame(maze->frame.bytes, renderMap(maze, player->room));
+    closeScreen();
+    return;
+  }
+
+  MapView view;
+  initMapView(maze, &view, cols, rows);
+  centerMapView(maze, &view, player->room);
+
+  int opt = 'c';
+
+  while (opt != 'q') {
+    showMapFrame(view.bytes, renderMapView(maze, &view, player->room));
+    printf("Scroll north ('n'), east ('e'), south ('s'), or west ('w'), recenter ('c'), or close the map ('q'). ");
+
+    // Closed input closes the map. An int, so no byte read can be taken for EOF
+    opt = getchar();
+    if (opt == EOF) break;
+
+    opt = tolower(opt);
+    if (opt != '\n') FLUSH()
+
+    switch (opt) {
+      case MOVE_NORTH: scrollMapView(maze, &view, 0, -1); break;
+      case MOVE_EAST: scrollMapView(maze, &view, 1, 0); break;
+      case MOVE_SOUTH: scrollMapView(maze, &view, 0, 1); break;
+      case MOVE_WEST: scrollMapView(maze, &view, -1, 0); break;
+      case 'c': centerMapView(maze, &view, player->room); break;
+      default: break;
+    }
+  }
+
+  closeScreen();
+  deleteMapView(&view);
+}
+
+
 static void useItem() {
   displayHelp(ITEM_H);
 
@@ -436,11 +500,11 @@ bool performAction(Commands action) {
 
     printf("Entering room...\n");
 
-    player->room = player->room->exits[CHAR_TO_INDEX(dir)];
+    player->room = maze->rooms.exits[player->room][CHAR_TO_INDEX(dir)];
 
-    printf("You are in %s...\n", player->room->info);
+    if (player->room == NO_ROOM) handleError(ERR_MEM, FATAL, "Cannot access exit!\n");
 
-    if (player->room == (void*)(long long)(NO_EXIT)) handleError(ERR_MEM, FATAL, "Cannot access exit!\n");
+    printf("You are in %s...\n", maze->rooms.info[player->room]);
 
     // printf("You are in %s...\n", currRoom->info);
   } else if (action == OPEN_INVENTORY) {
@@ -512,6 +576,8 @@ bool performAction(Commands action) {
       inv = tolower(inv);
       FLUSH()
     } 
+
+    closeScreen();
   } else if (action == OPEN_SKILLS) {
     viewSkills(player->skills);
 
@@ -595,12 +661,14 @@ bool performAction(Commands action) {
       action = tolower(action);
       FLUSH()
     }
+
+    closeScreen();
   } else if (action == HELP) displayHelp(ACTIONS_H);
     else if (action == SAVE) saveGame();
     else if (action == QUIT) quitGame();
-    else if (action == INFO) viewSelf(player);
+    else if (action == INFO) { viewSelf(player); closeScreen(); }
     else if (action == UNEQUIP) unequipGear(player);
-    else if (action == MAP) showMap(maze, player->room);
+    else if (action == MAP) viewMap();
     else return false;
 
   return true;
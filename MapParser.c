@@ -0,0 +1,1057 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <limits.h>
+#include <stdint.h>
+
+#include "Error.h"
+#include "Setup.h"
+#include "Intern.h"
+#include "MapParser.h"
+#include "Workers.h"
+
+
+#define STREAM_BUFFER_SIZE 4096 // How much of the file is read at a time
+#define MAX_NESTING 128 // How deep objects and arrays can be nested
+#define SPLIT_BUFFER_SIZE 65536 // How much of the file is read at a time when splitting it
+#define SPLIT_MIN_BYTES (256 * 1024) // The least of the map worth a worker of its own
+
+// The state of the tokenizer
+typedef struct JSONStream {
+  FILE* file; // The file being read
+  const char* filename; // For errors
+  char buffer[STREAM_BUFFER_SIZE]; // The read buffer
+  size_t len; // Amount of bytes in the buffer
+  size_t pos; // The current position in the buffer
+  size_t left; // Bytes of the file left to read
+  uint line; // The current line, for errors
+  str token; // The current string or number
+  size_t tokenLen; // The length of the token
+  size_t tokenCap; // The capacity of the token
+} JSONStream;
+
+// A range of members of the root object, parsed by a single worker
+typedef struct MapRange {
+  long start; // The offset of the first member
+  long end; // The offset right after the last member
+  uint line; // The line of start, for errors
+} MapRange;
+
+// The room fields that the map builder knows about
+typedef enum {
+  FIELD_NONE, // Any other key, which is ignored
+  FIELD_IS_ENTRY,
+  FIELD_STORYFILE,
+  FIELD_INFO,
+  FIELD_HAS_BOSS,
+  FIELD_EXITS,
+  FIELD_LOOT,
+  FIELD_ENEMY,
+  FIELD_POS, // Only saves have it, like every field from here on, so a room can do without them
+  FIELD_VISITED,
+  FIELD_COUNT
+} field_t;
+
+// The keys of the fields, in the order of field_t
+static const str fieldKeys[FIELD_COUNT] = {
+  NULL, "isEntry", "storyfile", "info", "hasBoss", "exits", "loot", "enemy", "pos", "visited"
+};
+
+// The state of the maze being built from the events
+typedef struct MapBuilder {
+  const char* filename; // For errors
+  Arena* arena; // The arena of the maze
+  Table* table; // The slot of every room id built so far, NULL for a worker
+  RoomStore rooms; // The rooms built so far
+  EnemyCatalog catalog; // The enemy templates of every room
+  str name; // The maze name
+  int depth; // The current nesting, the root object is 1
+  str key; // The last key
+  size_t keyCap; // The capacity of key
+
+  // The room being built
+  bool inRoom; // Whether a room is being built
+  uint roomId; // The room id
+  str info; // The description, interned
+  str storyFile; // The story text file, interned, NULL if none
+  bool isEntryRoom; // Whether the room key is "0"
+  field_t field; // The field whose value is being read
+  uint seen; // Bit n is set once field n has been read
+  int isEntry;
+  int hasBoss;
+  int exits[4];
+  int exitCount;
+  int pos[2]; // Where the room is drawn, see layoutMaze
+  int posCount;
+  int visited; // Whether the player has been in the room
+  cJSON* loot; // The loot table, the only part of the room read as JSON
+  cJSON* enemy; // The enemy table
+  cJSON* stack[MAX_NESTING]; // The open containers of the table being read
+  int top; // Number of open containers
+} MapBuilder;
+
+#define NO_TEMPLATE 0xFFFF // A template of a part that is not in the maze catalog yet, see mergePart
+
+// The map split across workers, each building the rooms of its range
+typedef struct MapJob {
+  const char* filename; // The map
+  MapRange ranges[MAX_WORKERS]; // The range of each worker
+  MapBuilder parts[MAX_WORKERS]; // The rooms built by each worker
+} MapJob;
+
+
+/**
+ * Exits on a syntax error, pointing to the line.
+ * @param stream The stream
+ * @param msg The error
+ */
+static void streamError(JSONStream* stream, const char* msg) {
+  handleError(ERR_DATA, FATAL, "%s:%u: %s\n", stream->filename, stream->line, msg);
+}
+
+/**
+ * Gets the next character without consuming it, refilling the buffer when needed.
+ * @param stream The stream
+ * @return The character or EOF
+ */
+static int peekChar(JSONStream* stream) {
+  if (stream->pos == stream->len) {
+    size_t want = (stream->left < STREAM_BUFFER_SIZE) ? stream->left : STREAM_BUFFER_SIZE;
+
+    stream->len = fread(stream->buffer, 1, want, stream->file);
+    stream->left -= stream->len;
+    stream->pos = 0;
+
+    if (stream->len == 0) return EOF;
+  }
+
+  return (unsigned char) stream->buffer[stream->pos];
+}
+
+/**
+ * Consumes the next character.
+ * @param stream The stream
+ * @return The character or EOF
+ */
+static int nextChar(JSONStream* stream) {
+  int c = peekChar(stream);
+
+  if (c != EOF) {
+    stream->pos++;
+    if (c == '\n') stream->line++;
+  }
+
+  return c;
+}
+
+/**
+ * Skips any whitespace.
+ * @param stream The stream
+ */
+static void skipSpace(JSONStream* stream) {
+  int c = peekChar(stream);
+
+  while (c == ' ' || c == '\t' || c == '\n' || c == '\r') {
+    nextChar(stream);
+    c = peekChar(stream);
+  }
+}
+
+/**
+ * Consumes the expected character.
+ * @param stream The stream
+ * @param expected The character
+ * @param msg The error if it is not there
+ */
+static void expectChar(JSONStream* stream, char expected, const char* msg) {
+  if (nextChar(stream) != expected) streamError(stream, msg);
+}
+
+/**
+ * Appends a character to the token.
+ * @param stream The stream
+ * @param c The character
+ */
+static void pushToken(JSONStream* stream, char c) {
+  if (stream->tokenLen + 1 >= stream->tokenCap) {
+    size_t cap = (stream->tokenCap == 0) ? 64 : stream->tokenCap * 2;
+
+    str token = (str) realloc(stream->token, cap);
+    if (!token) handleError(ERR_MEM, FATAL, "Could not allocate space for JSON token!\n");
+
+    stream->token = token;
+    stream->tokenCap = cap;
+  }
+
+  stream->token[stream->tokenLen++] = c;
+  stream->token[stream->tokenLen] = '\0';
+}
+
+/**
+ * Reads the 4 hex digits of a \u escape.
+ * @param stream The stream
+ * @return The code unit
+ */
+static uint readHex4(JSONStream* stream) {
+  uint code = 0;
+
+  for (int i = 0; i < 4; i++) {
+    int c = nextChar(stream);
+    code <<= 4;
+
+    if (c >= '0' && c <= '9') code |= c - '0';
+    else if (c >= 'a' && c <= 'f') code |= c - 'a' + 10;
+    else if (c >= 'A' && c <= 'F') code |= c - 'A' + 10;
+    else streamError(stream, "Invalid unicode escape!");
+  }
+
+  return code;
+}
+
+/**
+ * Appends the code point to the token as UTF-8.
+ * @param stream The stream
+ * @param code The code point
+ */
+static void pushUTF8(JSONStream* stream, uint code) {
+  if (code < 0x80) {
+    pushToken(stream, (char) code);
+  } else if (code < 0x800) {
+    pushToken(stream, (char) (0xC0 | (code >> 6)));
+    pushToken(stream, (char) (0x80 | (code & 0x3F)));
+  } else if (code < 0x10000) {
+    pushToken(stream, (char) (0xE0 | (code >> 12)));
+    pushToken(stream, (char) (0x80 | ((code >> 6) & 0x3F)));
+    pushToken(stream, (char) (0x80 | (code & 0x3F)));
+  } else {
+    pushToken(stream, (char) (0xF0 | (code >> 18)));
+    pushToken(stream, (char) (0x80 | ((code >> 12) & 0x3F)));
+    pushToken(stream, (char) (0x80 | ((code >> 6) & 0x3F)));
+    pushToken(stream, (char) (0x80 | (code & 0x3F)));
+  }
+}
+
+/**
+ * Reads a string into the token. The opening quote must already be consumed.
+ * @param stream The stream
+ */
+static void readString(JSONStream* stream) {
+  stream->tokenLen = 0;
+  pushToken(stream, '\0');
+  stream->tokenLen = 0;
+
+  while (true) {
+    int c = nextChar(stream);
+
+    if (c == EOF) streamError(stream, "Unterminated string!");
+    if (c == '"') return;
+
+    if (c != '\\') { pushToken(stream, (char) c); continue; }
+
+    c = nextChar(stream);
+    switch (c) {
+      case '"': pushToken(stream, '"'); break;
+      case '\\': pushToken(stream, '\\'); break;
+      case '/': pushToken(stream, '/'); break;
+      case 'b': pushToken(stream, '\b'); break;
+      case 'f': pushToken(stream, '\f'); break;
+      case 'n': pushToken(stream, '\n'); break;
+      case 'r': pushToken(stream, '\r'); break;
+      case 't': pushToken(stream, '\t'); break;
+      case 'u': {
+        uint code = readHex4(stream);
+
+        // A high surrogate must be followed by a low one
+        if (code >= 0xD800 && code <= 0xDBFF) {
+          expectChar(stream, '\\', "Missing low surrogate!");
+          expectChar(stream, 'u', "Missing low surrogate!");
+
+          uint low = readHex4(stream);
+          if (low < 0xDC00 || low > 0xDFFF) streamError(stream, "Invalid low surrogate!");
+
+          code = 0x10000 + ((code - 0xD800) << 10) + (low - 0xDC00);
+        } else if (code >= 0xDC00 && code <= 0xDFFF) {
+          streamError(stream, "Unexpected low surrogate!");
+        }
+
+        pushUTF8(stream, code);
+        break;
+      }
+      default:
+        streamError(stream, "Invalid escape!");
+    }
+  }
+}
+
+/**
+ * Reads a number.
+ * @param stream The stream
+ * @return The number
+ */
+static double readNumber(JSONStream* stream) {
+  stream->tokenLen = 0;
+
+  int c = peekChar(stream);
+  while ((c >= '0' && c <= '9') || c == '-' || c == '+' || c == '.' || c == 'e' || c == 'E') {
+    pushToken(stream, (char) nextChar(stream));
+    c = peekChar(stream);
+  }
+
+  if (stream->tokenLen == 0) streamError(stream, "Unexpected character!");
+
+  str end = NULL;
+  double number = strtod(stream->token, &end);
+  if (*end != '\0') streamError(stream, "Invalid number!");
+
+  return number;
+}
+
+/**
+ * Consumes the rest of a literal (true, false, null).
+ * @param stream The stream
+ * @param literal The literal
+ */
+static void readLiteral(JSONStream* stream, const char* literal) {
+  for (const char* c = literal; *c; c++) {
+    if (nextChar(stream) != *c) streamError(stream, "Invalid literal!");
+  }
+}
+
+static void parseValue(JSONStream* stream, JSONHandler handler, void* ctx, int depth);
+
+/**
+ * Parses the members of an object, emitting their events, up to the first character that is not a ','.
+ * The opening brace must already be consumed.
+ * @param stream The stream
+ * @param handler The event handler
+ * @param ctx The handler context
+ * @param depth The nesting of the object
+ * @return The character that ended the members, consumed
+ */
+static int parseMembers(JSONStream* stream, JSONHandler handler, void* ctx, int depth) {
+  while (true) {
+    skipSpace(stream);
+    expectChar(stream, '"', "Expected a key!");
+    readString(stream);
+    handler(ctx, JSON_KEY, stream->token, 0);
+
+    skipSpace(stream);
+    expectChar(stream, ':', "Expected ':' after key!");
+
+    parseValue(stream, handler, ctx, depth + 1);
+
+    skipSpace(stream);
+    int c = nextChar(stream);
+    if (c != ',') return c;
+  }
+}
+
+/**
+ * Parses a value, emitting its events.
+ * @param stream The stream
+ * @param handler The event handler
+ * @param ctx The handler context
+ * @param depth The nesting of the value
+ */
+static void parseValue(JSONStream* stream, JSONHandler handler, void* ctx, int depth) {
+  if (depth > MAX_NESTING) streamError(stream, "Nested too deep!");
+
+  skipSpace(stream);
+  int c = peekChar(stream);
+
+  switch (c) {
+    case '{':
+      nextChar(stream);
+      handler(ctx, JSON_OBJECT_START, NULL, 0);
+
+      skipSpace(stream);
+      if (peekChar(stream) == '}') { nextChar(stream); handler(ctx, JSON_OBJECT_END, NULL, 0); return; }
+
+      if (parseMembers(stream, handler, ctx, depth) != '}') streamError(stream, "Expected ',' or '}'!");
+
+      handler(ctx, JSON_OBJECT_END, NULL, 0);
+      break;
+    case '[':
+      nextChar(stream);
+      handler(ctx, JSON_ARRAY_START, NULL, 0);
+
+      skipSpace(stream);
+      if (peekChar(stream) == ']') { nextChar(stream); handler(ctx, JSON_ARRAY_END, NULL, 0); return; }
+
+      while (true) {
+        parseValue(stream, handler, ctx, depth + 1);
+
+        skipSpace(stream);
+        c = nextChar(stream);
+        if (c == ']') break;
+        if (c != ',') streamError(stream, "Expected ',' or ']'!");
+      }
+
+      handler(ctx, JSON_ARRAY_END, NULL, 0);
+      break;
+    case '"':
+      nextChar(stream);
+      readString(stream);
+      handler(ctx, JSON_STRING, stream->token, 0);
+      break;
+    case 't':
+      readLiteral(stream, "true");
+      handler(ctx, JSON_TRUE, NULL, 0);
+      break;
+    case 'f':
+      readLiteral(stream, "false");
+      handler(ctx, JSON_FALSE, NULL, 0);
+      break;
+    case 'n':
+      readLiteral(stream, "null");
+      handler(ctx, JSON_NULL, NULL, 0);
+      break;
+    case EOF:
+      streamError(stream, "Unexpected end of file!");
+      break;
+    default:
+      handler(ctx, JSON_NUMBER, NULL, readNumber(stream));
+      break;
+  }
+}
+
+/**
+ * Starts a stream at the current position of the file.
+ * @param stream The stream
+ * @param file The JSON file
+ * @param filename The file name, for errors
+ * @param left How many bytes of the file to read
+ * @param line The line the stream starts at
+ */
+static void initStream(JSONStream* stream, FILE* file, const char* filename, size_t left, uint line) {
+  stream->file = file;
+  stream->filename = filename;
+  stream->len = 0;
+  stream->pos = 0;
+  stream->left = left;
+  stream->line = line;
+  stream->token = NULL;
+  stream->tokenLen = 0;
+  stream->tokenCap = 0;
+}
+
+void parseJSONStream(FILE* file, const char* filename, JSONHandler handler, void* ctx) {
+  JSONStream stream;
+  initStream(&stream, file, filename, SIZE_MAX, 1);
+
+  parseValue(&stream, handler, ctx, 1);
+
+  skipSpace(&stream);
+  if (peekChar(&stream) != EOF) streamError(&stream, "Unexpected data after the end!");
+
+  free(stream.token);
+}
+
+/**
+ * Tokenizes a range of members of the root object, as if they were the whole object.
+ * @param file The JSON file
+ * @param filename The file name, for errors
+ * @param range The members
+ * @param handler The event handler
+ * @param ctx The context passed to the handler
+ */
+static void parseJSONRange(FILE* file, const char* filename, const MapRange* range, JSONHandler handler, void* ctx) {
+  if (fseek(file, range->start, SEEK_SET) != 0) handleError(ERR_IO, FATAL, "Could not read file!\n");
+
+  JSONStream stream;
+  initStream(&stream, file, filename, (size_t) (range->end - range->start), range->line);
+
+  handler(ctx, JSON_OBJECT_START, NULL, 0);
+
+  // The range ends right before the ',' or '}' after its last member
+  if (parseMembers(&stream, handler, ctx, 1) != EOF) streamError(&stream, "Expected ',' or '}'!");
+
+  handler(ctx, JSON_OBJECT_END, NULL, 0);
+
+  free(stream.token);
+}
+
+// The characters the split has to look at inside the root and inside strings, see splitMap
+static const bool splitChars[256] = {
+  ['"'] = true, ['\n'] = true, ['{'] = true, ['}'] = true, ['['] = true, [']'] = true, [','] = true
+};
+static const bool stringChars[256] = { ['"'] = true, ['\\'] = true, ['\n'] = true };
+
+/**
+ * Splits the members of the root object into ranges of about the same size.
+ * Only strings and nesting are followed, so syntax errors are left for the tokenizer to report.
+ * The file is rewound after.
+ * @param file The JSON file
+ * @param parts The most ranges to split into, up to MAX_WORKERS
+ * @param ranges Where to store the ranges
+ * @return The number of ranges, 0 if the map is too small to split or the root is not a single object
+ */
+static uint splitMap(FILE* file, uint parts, MapRange* ranges) {
+  char buffer[SPLIT_BUFFER_SIZE];
+
+  if (fseek(file, 0, SEEK_END) != 0) return 0;
+  long size = ftell(file);
+  rewind(file);
+
+  if (size < 0 || (size / SPLIT_MIN_BYTES) < 2) return 0;
+  if ((long) parts > size / SPLIT_MIN_BYTES) parts = (uint) (size / SPLIT_MIN_BYTES);
+
+  uint count = 0, line = 1;
+  int depth = 0;
+  bool inString = false, escaped = false, closed = false;
+  long base = 0;
+  size_t len;
+
+  while ((len = fread(buffer, 1, SPLIT_BUFFER_SIZE, file)) > 0) {
+    for (size_t i = 0; i < len; i++) {
+      char c = buffer[i];
+
+      if (escaped) {
+        escaped = false;
+        if (c == '\n') line++;
+        continue;
+      }
+
+      if (inString) {
+        // Strings are most of the map, so skip right to where one could end
+        while (!stringChars[(uchar) c] && ++i < len) c = buffer[i];
+        if (i == len) break;
+
+        if (c == '\n') line++;
+        else if (c == '\\') escaped = true;
+        else inString = false;
+
+        continue;
+      }
+
+      // Inside the root, the rest of the map is numbers and separators that change nothing
+      if (depth > 0 && !splitChars[(uchar) c]) continue;
+      if (c == '\n') line++;
+
+      long offset = base + (long) i;
+
+      if (c == ' ' || c == '\t' || c == '\n' || c == '\r') continue;
+
+      // Anything after the root is an error
+      if (closed || (depth == 0 && c != '{')) { rewind(file); return 0; }
+
+      switch (c) {
+        case '"':
+          inString = true;
+          break;
+        case '{':
+        case '[':
+          if (depth++ == 0) {
+            ranges[0].start = offset + 1;
+            ranges[0].line = line;
+          }
+          break;
+        case '}':
+        case ']':
+          if (--depth == 0) {
+            ranges[count++].end = offset;
+            closed = true;
+          }
+          break;
+        case ',':
+          // Cut at the first member past an even share of the file
+          if (depth == 1 && count + 1 < parts && offset >= size / parts * (count + 1)) {
+            ranges[count++].end = offset;
+            ranges[count].start = offset + 1;
+            ranges[count].line = line;
+          }
+          break;
+        default:
+          break;
+      }
+    }
+
+    base += (long) len;
+  }
+
+  rewind(file);
+
+  return (closed && count > 1) ? count : 0;
+}
+
+
+/**
+ * Same as cJSON's valueint, so both parsers agree on the numbers.
+ * @param number The number
+ * @return The number as an int
+ */
+static int toInt(double number) {
+  if (number >= INT_MAX) return INT_MAX;
+  if (number <= (double) INT_MIN) return INT_MIN;
+
+  return (int) number;
+}
+
+/**
+ * Keeps a copy of the key, since the token is reused for the value.
+ * @param builder The map builder
+ * @param key The key
+ */
+static void setKey(MapBuilder* builder, const char* key) {
+  size_t len = strlen(key) + 1;
+
+  if (len > builder->keyCap) {
+    str _key = (str) realloc(builder->key, len);
+    if (!_key) handleError(ERR_MEM, FATAL, "Could not allocate space for JSON key!\n");
+
+    builder->key = _key;
+    builder->keyCap = len;
+  }
+
+  memcpy(builder->key, key, len);
+}
+
+/**
+ * Starts a new room, the current key being its id.
+ * @param builder The map builder
+ */
+static void beginRoom(MapBuilder* builder) {
+  builder->inRoom = true;
+  builder->roomId = parseRoomId(builder->key);
+  builder->info = NULL;
+  builder->storyFile = NULL;
+  builder->isEntryRoom = strcmp(builder->key, "0") == 0;
+  builder->field = FIELD_NONE;
+  builder->seen = 0;
+  builder->isEntry = 0;
+  builder->hasBoss = 0;
+  builder->exitCount = 0;
+  builder->posCount = 0;
+  builder->visited = 0;
+  builder->loot = NULL;
+  builder->enemy = NULL;
+  builder->top = 0;
+}
+
+/**
+ * Validates the room once its object ends, keeps its loot and enemy tables, and adds it to the store.
+ * The checks are the same as validateRoom.
+ * @param builder The map builder
+ */
+static void finishRoom(MapBuilder* builder) {
+  const str dataErr = "Room %u: No %s data found!\n";
+
+  uint roomId = builder->roomId;
+
+  for (int i = FIELD_IS_ENTRY; i < FIELD_POS; i++) {
+    if (!(builder->seen & (1 << i))) handleError(ERR_DATA, FATAL, dataErr, roomId, fieldKeys[i]);
+  }
+
+  if (builder->isEntryRoom && builder->isEntry != 1) {
+    handleError(ERR_DATA, FATAL, "Room %u: No matching isEntry data and room id!\n", roomId);
+  }
+  if (builder->exitCount != 4) handleError(ERR_DATA, FATAL, "Room %u: Exits must only be 4!\n", roomId);
+  if ((builder->seen & (1 << FIELD_POS)) && builder->posCount != 2) handleError(ERR_DATA, FATAL, "Room %u: pos must be [x, y]!\n", roomId);
+
+  validateTables(roomId, builder->hasBoss == 1, builder->loot, builder->enemy);
+
+  builder->inRoom = false;
+
+  // A room with a repeated id is dropped, the first one is kept
+  // Workers have no table, mergePart drops them instead
+  if (builder->table && !putRoom(builder->table, roomId, builder->rooms.len, true)) {
+    cJSON_Delete(builder->loot);
+    cJSON_Delete(builder->enemy);
+    builder->loot = NULL;
+    builder->enemy = NULL;
+
+    return;
+  }
+
+  bool hasBoss = (bool) builder->hasBoss;
+  uint room = addRoom(&builder->rooms, roomId, builder->info, builder->storyFile, hasBoss ? ROOM_BOSS : 0);
+
+  // The tables are kept as records until the room is entered
+  builder->rooms.tables[room] = deferRoom(builder->arena, &builder->catalog, hasBoss, builder->loot, builder->enemy);
+  builder->loot = NULL;
+  builder->enemy = NULL;
+
+  // Left as ids until every room is built, see connectRooms
+  for (int i = 0; i < 4; i++) builder->rooms.exits[room][i] = (builder->exits[i] == -1) ? NO_ROOM : (uint) builder->exits[i];
+
+  if (builder->posCount == 2) builder->rooms.pos[room] = (RoomPos) { builder->pos[0], builder->pos[1] };
+  if (builder->visited == 1) setRoomSeen(&builder->rooms, room);
+}
+
+/**
+ * Reads the value of a room field.
+ * @param builder The map builder
+ * @param event The value event
+ * @param text The string, if any
+ * @param number The number, if any
+ */
+static void setField(MapBuilder* builder, jsonevent_t event, const char* text, double number) {
+  const char* key = fieldKeys[builder->field];
+
+  switch (builder->field) {
+    case FIELD_IS_ENTRY:
+      builder->isEntry = (event == JSON_NUMBER) ? toInt(number) : 0;
+      break;
+    case FIELD_HAS_BOSS:
+      builder->hasBoss = (event == JSON_NUMBER) ? toInt(number) : 0;
+      break;
+    case FIELD_VISITED:
+      builder->visited = (event == JSON_NUMBER) ? toInt(number) : 0;
+      break;
+    case FIELD_STORYFILE:
+      if (event != JSON_STRING) handleError(ERR_DATA, FATAL, "Room %u: %s must be a string!\n", builder->roomId, key);
+
+      // A room w/o storyfile stores an empty string
+      builder->storyFile = (*text != '\0') ? intern(text) : NULL;
+      break;
+    case FIELD_INFO:
+      if (event != JSON_STRING) handleError(ERR_DATA, FATAL, "Room %u: %s must be a string!\n", builder->roomId, key);
+
+      builder->info = intern(text);
+      break;
+    case FIELD_EXITS:
+    case FIELD_POS:
+      if (event != JSON_ARRAY_START) handleError(ERR_DATA, FATAL, "Room %u: %s must be an array!\n", builder->roomId, key);
+      break;
+    case FIELD_LOOT:
+    case FIELD_ENEMY:
+      if (event != JSON_ARRAY_START) handleError(ERR_DATA, FATAL, "Room %u: %s must be an array!\n", builder->roomId, key);
+
+      cJSON* table = cJSON_CreateArray();
+      if (!table) handleError(ERR_MEM, FATAL, "Could not allocate space for room %s!\n", key);
+
+      if (builder->field == FIELD_LOOT) builder->loot = table;
+      else builder->enemy = table;
+
+      builder->stack[0] = table;
+      builder->top = 1;
+      break;
+    default:
+      break;
+  }
+}
+
+/**
+ * Adds the event to the loot or enemy table being read.
+ * @param builder The map builder
+ * @param event The event
+ * @param text The key or string, if any
+ * @param number The number, if any
+ */
+static void addToTable(MapBuilder* builder, jsonevent_t event, const char* text, double number) {
+  cJSON* item = NULL;
+
+  switch (event) {
+    case JSON_KEY:
+      setKey(builder, text);
+      return;
+    case JSON_OBJECT_START:
+      item = cJSON_CreateObject();
+      break;
+    case JSON_ARRAY_START:
+      item = cJSON_CreateArray();
+      break;
+    case JSON_STRING:
+      item = cJSON_CreateString(text);
+      break;
+    case JSON_NUMBER:
+      item = cJSON_CreateNumber(number);
+      break;
+    case JSON_TRUE:
+      item = cJSON_CreateTrue();
+      break;
+    case JSON_FALSE:
+      item = cJSON_CreateFalse();
+      break;
+    case JSON_NULL:
+      item = cJSON_CreateNull();
+      break;
+    default:
+      return;
+  }
+
+  if (!item) handleError(ERR_MEM, FATAL, "Could not allocate space for room table!\n");
+
+  cJSON* parent = builder->stack[builder->top - 1];
+
+  if (cJSON_IsObject(parent)) cJSON_AddItemToObject(parent, builder->key, item);
+  else cJSON_AddItemToArray(parent, item);
+
+  if (event == JSON_OBJECT_START || event == JSON_ARRAY_START) builder->stack[builder->top++] = item;
+}
+
+/**
+ * Handles the events of the map, see JSONHandler.
+ * The root object is level 1, rooms are level 2, their arrays level 3, and table entries level 4.
+ */
+static void onMapEvent(void* ctx, jsonevent_t event, const char* text, double number) {
+  MapBuilder* builder = (MapBuilder*) ctx;
+
+  if (event == JSON_OBJECT_END || event == JSON_ARRAY_END) {
+    int closing = builder->depth--;
+
+    // Closing the root or a value that is not part of a room
+    if (closing == 1 || !builder->inRoom) return;
+
+    if (closing == 2) finishRoom(builder);
+    else if (builder->field == FIELD_LOOT || builder->field == FIELD_ENEMY) builder->top--;
+
+    return;
+  }
+
+  // The level of the container holding this event
+  int level = builder->depth;
+  if (event == JSON_OBJECT_START || event == JSON_ARRAY_START) builder->depth++;
+
+  if (level == 0) {
+    if (event != JSON_OBJECT_START) handleError(ERR_DATA, FATAL, "%s: The map must be an object!\n", builder->filename);
+    return;
+  }
+
+  if (level == 1) {
+    if (event == JSON_KEY) { setKey(builder, text); return; }
+
+    if (strcmp(builder->key, "name") == 0) {
+      if (event != JSON_STRING) handleError(ERR_DATA, FATAL, "Maze name must be a string!\n");
+      builder->name = intern(text);
+    } else if (event == JSON_OBJECT_START && strcmp(builder->key, "$schema") != 0) {
+      beginRoom(builder);
+    }
+
+    // Anything else at the top, like the schema, is skipped
+    return;
+  }
+
+  // Inside a skipped value
+  if (!builder->inRoom) return;
+
+  if (level == 2) {
+    if (event == JSON_KEY) {
+      builder->field = FIELD_NONE;
+
+      for (int i = FIELD_IS_ENTRY; i < FIELD_COUNT; i++) {
+        if (strcmp(text, fieldKeys[i]) == 0) { builder->field = i; break; }
+      }
+
+      if (builder->field != FIELD_NONE) {
+        if (builder->seen & (1 << builder->field)) {
+          handleError(ERR_DATA, FATAL, "Room %u: Duplicate %s data!\n", builder->roomId, text);
+        }
+        builder->seen |= 1 << builder->field;
+      }
+
+      return;
+    }
+
+    setField(builder, event, text, number);
+    return;
+  }
+
+  switch (builder->field) {
+    case FIELD_EXITS:
+      if (level != 3) break;
+      if (event != JSON_NUMBER) handleError(ERR_DATA, FATAL, "Room %u: Exits must be numbers!\n", builder->roomId);
+
+      int exit = toInt(number);
+      if (exit < -1) handleError(ERR_DATA, FATAL, "Room %u: exit markers cannot be less than -1!\n", builder->roomId);
+
+      if (builder->exitCount == 4) handleError(ERR_DATA, FATAL, "Room %u: Exits must only be 4!\n", builder->roomId);
+      builder->exits[builder->exitCount++] = exit;
+      break;
+    case FIELD_POS:
+      if (level != 3) break;
+      if (event != JSON_NUMBER || number < -MAX_ROOM_ID || number > MAX_ROOM_ID || builder->posCount == 2) {
+        handleError(ERR_DATA, FATAL, "Room %u: pos must be [x, y]!\n", builder->roomId);
+      }
+
+      builder->pos[builder->posCount++] = toInt(number);
+      break;
+    case FIELD_LOOT:
+    case FIELD_ENEMY:
+      if (builder->top == MAX_NESTING && (event == JSON_OBJECT_START || event == JSON_ARRAY_START)) {
+        handleError(ERR_DATA, FATAL, "Room %u: Table nested too deep!\n", builder->roomId);
+      }
+      addToTable(builder, event, text, number);
+      break;
+    default:
+      break;
+  }
+}
+
+/**
+ * Starts building a maze.
+ * @param builder The map builder
+ * @param filename The map, for errors
+ * @param table The room table, NULL for a worker
+ * @param roomCap How many rooms to make space for, 0 if unknown
+ */
+static void initBuilder(MapBuilder* builder, const char* filename, Table* table, uint roomCap) {
+  memset(builder, 0, sizeof(MapBuilder));
+
+  builder->filename = filename;
+  builder->arena = initArena(ARENA_CHUNK_SIZE);
+  builder->table = table;
+
+  initRoomStore(&builder->rooms, roomCap);
+
+  // The key starts out empty so a value before any key matches nothing
+  setKey(builder, "");
+}
+
+/**
+ * Builds the rooms of a range of the map, see work_f.
+ * @param ctx The map job
+ * @param worker The range to build
+ */
+static void buildPart(void* ctx, uint worker) {
+  MapJob* job = (MapJob*) ctx;
+  MapBuilder* builder = &job->parts[worker];
+
+  initBuilder(builder, job->filename, NULL, 0);
+
+  // Every worker reads through its own handle
+  FILE* file = fopen(job->filename, "rb");
+  if (!file) handleError(ERR_IO, FATAL, "Could not open file!\n");
+
+  parseJSONRange(file, job->filename, &job->ranges[worker], onMapEvent, builder);
+  fclose(file);
+}
+
+/**
+ * Moves the rooms of a part into the maze, as if the maze builder had built them itself.
+ * Rooms with a repeated id are dropped, and templates are added to the catalog
+ * in the order they are first used, so the maze is the same no matter how the map was split.
+ * Note, the worker already read the boss of a dropped room, so errors in it are reported where a single pass skips them.
+ * @param builder The maze builder
+ * @param part The part, which is deleted
+ */
+static void mergePart(MapBuilder* builder, MapBuilder* part) {
+  RoomStore* rooms = &part->rooms;
+
+  // The catalog index of every template of the part, NO_TEMPLATE until it is used
+  ushort* templates = NULL;
+  if (part->catalog.len != 0) {
+    templates = (ushort*) malloc(part->catalog.len * sizeof(ushort));
+    if (!templates) handleError(ERR_MEM, FATAL, "Could not allocate space for the enemy templates!\n");
+
+    memset(templates, 0xFF, part->catalog.len * sizeof(ushort));
+  }
+
+  for (uint i = 0; i < rooms->len; i++) {
+    RoomTables* roomTables = rooms->tables[i];
+
+    // A room with a repeated id is dropped, the first one is kept
+    if (!putRoom(builder->table, rooms->ids[i], builder->rooms.len, true)) continue;
+
+    uint room = addRoom(&builder->rooms, rooms->ids[i], rooms->info[i], rooms->storyFiles[i], rooms->flags[i]);
+    memcpy(builder->rooms.exits[room], rooms->exits[i], sizeof(RoomExits));
+    builder->rooms.pos[room] = rooms->pos[i];
+    if (roomSeen(rooms, i)) setRoomSeen(&builder->rooms, room);
+    builder->rooms.tables[room] = roomTables;
+
+    for (uint e = 0; e < roomTables->enemyCount; e++) {
+      ushort t = roomTables->enemies[e];
+
+      if (templates[t] == NO_TEMPLATE) templates[t] = addEnemyTemplate(&builder->catalog, &part->catalog.templates[t]);
+      roomTables->enemies[e] = templates[t];
+    }
+  }
+
+  // Later names replace earlier ones, same as a single pass
+  if (part->name) builder->name = part->name;
+
+  adoptArena(builder->arena, part->arena);
+  deleteRoomStore(rooms);
+  deleteEnemyCatalog(&part->catalog);
+  free(part->key);
+  free(templates);
+}
+
+/**
+ * Builds the rooms of every range on its own worker, then merges them in file order.
+ * @param builder The maze builder to start
+ * @param filename The map
+ * @param ranges The ranges of the map
+ * @param count The number of ranges
+ */
+static void buildParallel(MapBuilder* builder, const char* filename, const MapRange* ranges, uint count) {
+  MapJob* job = (MapJob*) malloc(sizeof(MapJob));
+  if (!job) handleError(ERR_MEM, FATAL, "Could not allocate space for the map job!\n");
+
+  job->filename = filename;
+  memcpy(job->ranges, ranges, count * sizeof(MapRange));
+
+  runWorkers(count, buildPart, job);
+
+  // The parts are counted first, so the table and the store are allocated once
+  uint roomCount = 0, maxId = 0;
+  for (uint i = 0; i < count; i++) {
+    RoomStore* rooms = &job->parts[i].rooms;
+
+    roomCount += rooms->len;
+    for (uint j = 0; j < rooms->len; j++) {
+      if (rooms->ids[j] > maxId) maxId = rooms->ids[j];
+    }
+  }
+
+  Table* table = initTableL(roomCount, maxId);
+  if (!table) handleError(ERR_MEM, FATAL, "Could not allocate space for the table!\n");
+
+  initBuilder(builder, filename, table, roomCount);
+
+  for (uint i = 0; i < count; i++) mergePart(builder, &job->parts[i]);
+
+  free(job);
+}
+
+Maze* parseMaze(const char* filename) {
+  FILE* file = fopen(filename, "rb");
+  if (!file) handleError(ERR_IO, FATAL, "Could not open file!\n");
+
+  MapBuilder builder;
+  MapRange ranges[MAX_WORKERS];
+
+  // Big maps are split across workers, their rooms do not depend on each other until they are connected
+  uint workers = workerCount();
+  uint count = (workers > 1) ? splitMap(file, workers, ranges) : 0;
+
+  if (count > 1) {
+    fclose(file);
+    buildParallel(&builder, filename, ranges, count);
+  } else {
+    Table* table = initTable();
+    if (!table) handleError(ERR_MEM, FATAL, "Could not allocate space for the table!\n");
+
+    initBuilder(&builder, filename, table, 0);
+
+    parseJSONStream(file, filename, onMapEvent, &builder);
+    fclose(file);
+  }
+
+  free(builder.key);
+
+  if (!builder.name) handleError(ERR_DATA, FATAL, "Maze name could not be found!\n");
+  if (lookupRoom(builder.table, 0) == NO_ROOM) {
+    handleError(ERR_DATA, FATAL, "There does not exist a room with value of '0' for the entry!\n");
+  }
+
+  uint entry = connectRooms(&builder.rooms, builder.table);
+  if (entry == NO_ROOM) handleError(ERR_DATA, FATAL, "Entry is null!\n");
+
+  Maze* maze = (Maze*) malloc(sizeof(Maze));
+  if (!maze) handleError(ERR_MEM, FATAL, "Could not allocate space for maze!\n");
+
+  maze->entry = entry;
+  maze->rooms = builder.rooms;
+  maze->ids = builder.table;
+  maze->arena = builder.arena;
+  maze->tables = NULL;
+  maze->catalog = builder.catalog;
+  maze->tablesType = TABLES_JSON;
+  maze->name = builder.name;
+  maze->frame = (MapFrame) { 0 };
+
+  layoutMaze(maze);
+
+  return maze;
+}
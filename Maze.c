@@ -1,192 +1,632 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
-#include <math.h>
+#include <stdint.h>
+#include <limits.h>
 #include <ctype.h>
 
 #include "Maze.h"
+#include "Setup.h"
 #include "Error.h"
+#include "RoomWalk.h"
+#include "Screen.h"
 
 
-void removeItemFromMap(Room* room) {
-  if (!room && !room->loot) {
-    free(room->loot);
-    room->loot = NULL;
+void removeItemFromMap(Maze* maze, uint room) {
+  if (room >= maze->rooms.len) return;
 
-    return;
+  // The item stays in the arena until the maze is deleted
+  maze->rooms.loot[room] = NULL;
+}
+
+bool deleteEnemyFromMap(Maze* maze, uint room) {
+  if (room >= maze->rooms.len || !maze->rooms.enemies[room].enemy) return false;
+
+  // The enemy stays in the arena until the maze is deleted
+  maze->rooms.enemies[room].enemy = NULL;
+  maze->rooms.flags[room] &= ~ROOM_BOSS;
+
+  return true;
+}
+
+void materializeRoom(Maze* maze, uint room) {
+  if (room >= maze->rooms.len || !maze->rooms.tables[room]) return;
+
+  RoomTables* tables = maze->rooms.tables[room];
+  maze->rooms.tables[room] = NULL;
+
+  switch (maze->tablesType) {
+    case TABLES_JSON:
+      populateRoom(maze, room, tables);
+      break;
+    case TABLES_MZB:
+      materializeMazeBin(maze, room, tables);
+      break;
+    default:
+      break;
   }
+}
 
-  if (!room && room->loot) {
-    fprintf(stderr, "Could not remove item %p from map!\n", room->loot); // Add to error handling???
+void readRoomLoot(Maze* maze, RoomTables* tables, uint i, LootRecord* rec) {
+  switch (maze->tablesType) {
+    case TABLES_JSON:
+      *rec = ((LootRecord*) tables->loot)[i];
+      break;
+    case TABLES_MZB:
+      readMazeBinLoot(maze, tables, i, rec);
+      break;
+    default:
+      memset(rec, 0, sizeof(LootRecord));
+      break;
   }
+}
 
-  return;
+/**
+ * Compares two enemy templates field by field.
+ * @param a The first template
+ * @param b The second template
+ * @return True if they are the same
+ */
+static bool sameTemplate(const EnemyTemplate* a, const EnemyTemplate* b) {
+  // Names are interned, so comparing the pointers is enough
+  return a->name == b->name && a->boss == b->boss && a->xpPoints == b->xpPoints &&
+    a->hp[0] == b->hp[0] && a->hp[1] == b->hp[1] && a->atk[0] == b->atk[0] && a->atk[1] == b->atk[1] &&
+    a->def[0] == b->def[0] && a->def[1] == b->def[1] && a->acc[0] == b->acc[0] && a->acc[1] == b->acc[1] &&
+    a->atkCritDmg[0] == b->atkCritDmg[0] && a->atkCritDmg[1] == b->atkCritDmg[1] &&
+    a->atkCrit[0] == b->atkCrit[0] && a->atkCrit[1] == b->atkCrit[1] && a->lvl == b->lvl && a->ranged == b->ranged;
 }
 
-bool deleteEnemyFromMap(Room* room, bool deleteGear) {
-  if (!room || !room->enemy.enemy || !room->enemy.boss) return false;
+ushort addEnemyTemplate(EnemyCatalog* catalog, const EnemyTemplate* tmpl) {
+  // Maps reuse a handful of definitions, so a scan is cheap
+  for (uint i = 0; i < catalog->len; i++) {
+    if (sameTemplate(&catalog->templates[i], tmpl)) return (ushort) i;
+  }
+
+  if (catalog->len == MAX_ENEMY_TEMPLATES) handleError(ERR_DATA, FATAL, "More than %d enemy templates!\n", MAX_ENEMY_TEMPLATES);
 
-  bool del;
+  if (catalog->len == catalog->cap) {
+    uint cap = (catalog->cap == 0) ? 8 : catalog->cap * 2;
 
-  if (room->hasBoss) {
-    del = deleteBoss(room->enemy.boss, deleteGear);
-    room->enemy.boss = NULL;
-    room->hasBoss = false;
+    EnemyTemplate* templates = (EnemyTemplate*) realloc(catalog->templates, cap * sizeof(EnemyTemplate));
+    if (!templates) handleError(ERR_MEM, FATAL, "Could not allocate space for the enemy templates!\n");
 
-    return del;
+    catalog->templates = templates;
+    catalog->cap = cap;
   }
-  
-  del = deleteEnemy(room->enemy.enemy);
-  room->enemy.enemy = NULL;
 
-  return del;
+  catalog->templates[catalog->len] = *tmpl;
+
+  return (ushort) catalog->len++;
+}
+
+void deleteEnemyCatalog(EnemyCatalog* catalog) {
+  free(catalog->templates);
+
+  catalog->templates = NULL;
+  catalog->len = 0;
+  catalog->cap = 0;
+}
+
+uint getRoom(Maze* maze, uint id) {
+  return lookupRoom(maze->ids, id);
+}
+
+EnemyTemplate* getEnemyTemplate(Maze* maze, Enemy* enemy) {
+  return &maze->catalog.templates[enemy->templateId];
+}
+
+bool roomHasEnemy(Maze* maze, uint room) {
+  RoomTables* tables = maze->rooms.tables[room];
+  if (tables) return tables->enemyCount != 0;
+
+  return maze->rooms.enemies[room].enemy != NULL;
+}
+
+bool roomHasLoot(Maze* maze, uint room) {
+  RoomTables* tables = maze->rooms.tables[room];
+  if (tables) return tables->lootCount != 0;
+
+  return maze->rooms.loot[room] != NULL;
 }
 
 /**
- * Prints the cleaned-up version of the maze name
- * @param name The maze name to print
+ * Writes the cleaned-up version of the maze name, as the title of the map.
+ * @param name The maze name
+ * @param out Where to write it, with space for the name and MAP_TITLE_EXTRA bytes
+ * @return The bytes written
  */
-static void printMazeName(str name) {
-  int nameLen = strlen(name);
-
-  str _name = (str) malloc(nameLen + 1);
-  if (!_name) {
-    handleError(ERR_MEM, WARNING, "Could not allocate space for map name display! Defaulting to maze name.\n"); 
-    _name = name;
-  } else {
-    strcpy(_name, name);
-
-    str temp = _name;
-
-    // First non-null character will always get capitalized
-    if (*temp != '\0') *temp = toupper(*temp);
-    temp++;
-
-    while (*temp != '\0') {
-      // Change the current character of _ to space
-      if (*temp == '_') *temp = ' ';
-      // Uppercase characters that followed _ (now space)
-      // Guaranteed that *(temp - 1) will not be out of bounds by the increase prior to looping
-      if (*(temp - 1) == ' ') *temp = toupper(*temp);
-
-      temp++;
-    }
+static size_t renderMazeName(str name, char* out) {
+  char* start = out;
+
+  memcpy(out, PURPLE, sizeof(PURPLE) - 1);
+  out += sizeof(PURPLE) - 1;
+
+  for (str c = name; *c != '\0'; c++) {
+    // Underscores become spaces, and every word is capitalized
+    if (*c == '_') *out++ = ' ';
+    else if (c == name || *(c - 1) == '_') *out++ = toupper(*c);
+    else *out++ = *c;
   }
-    
-  printf("%s%s%s: ", PURPLE, _name, RESET);
 
-  // In the case that _name is not malloc'd, _name is assigned to name, thus they point to the same thing
-  if (_name != name) free(_name);
+  memcpy(out, RESET ": ", sizeof(RESET ": ") - 1);
+  out += sizeof(RESET ": ") - 1;
+
+  return out - start;
 }
 
-static void placeRoomOnGrid(Room* room, char** grid, int x, int y, bool** visited, uint gridSize, Room* playerRoom) {
-  if (room == ((void*) ((long long) NO_EXIT)) || visited[y][x]) return;
+#define MAP_TITLE_EXTRA (sizeof(PURPLE RESET ": ") - 1) // The bytes of the title besides the name
+#define COLOR_LEN (sizeof(GREEN) - 1) // Every color code is as long
+// The most bytes the cells can take, each with a color code, plus a reset at the end
+#define MAX_CELLS_BYTES(cols, rows) ((rows) * ((cols) * (COLOR_LEN + 1) + 1) + COLOR_LEN)
 
-  visited[y][x] = true;
+#define VIEW_CENTER_SIZE 32 // The room at the center of a window, after the title
 
-  if (room->hasBoss) grid[y][x] = '!';
-  else if (room->enemy.enemy) grid[y][x] = '%';
-  else if (room->loot) grid[y][x] = '$';
-  else if (room->id == 0) grid[y][x] = '@';
-  else grid[y][x] = '#';
+#define EMPTY_CELL 0x8000000080000000ULL // Both halves are NO_POS, where no room is ever placed
+#define CELL_HASH 0x9E3779B97F4A7C15ULL // Spreads the packed positions over the buckets
 
-  if (room == playerRoom) grid[y][x] = 'o';
+// The cells taken by the rooms placed so far, hashed with linear probing
+typedef struct MapCells {
+  uint64_t* cells; // The packed positions, EMPTY_CELL if none
+  size_t mask; // The capacity - 1, a power of two
+  int shift; // Keeps the top bits of the hash, as many as the capacity needs
+  Maze* maze; // The maze being laid out
+} MapCells;
 
+/**
+ * Takes the cell for a room, unless another room has it.
+ * @param map The cells
+ * @param x Where the room goes
+ * @param y Where the room goes
+ * @return Whether the cell was free
+ */
+static bool takeCell(MapCells* map, int x, int y) {
+  uint64_t cell = ((uint64_t) (uint32_t) x << 32) | (uint32_t) y;
+  size_t i = (size_t) ((cell * CELL_HASH) >> map->shift);
 
-  if (room->exits[0] != ((void*) ((long long) NO_EXIT)) && y > 1) {
-    grid[y-1][x] = '|';
-    placeRoomOnGrid(room->exits[0], grid, x, y-2, visited, gridSize, playerRoom);
+  while (map->cells[i] != EMPTY_CELL) {
+    if (map->cells[i] == cell) return false;
+    i = (i + 1) & map->mask;
   }
-  if (room->exits[1] != ((void*) ((long long) NO_EXIT)) && x < gridSize-2) {
-    grid[y][x+1] = '-';
-    placeRoomOnGrid(room->exits[1], grid, x+2, y, visited, gridSize, playerRoom);
+
+  map->cells[i] = cell;
+
+  return true;
+}
+
+/**
+ * Places the room of the step where its path from the entry leads, see walk_f.
+ * @param step The room reached
+ * @param _map The cells
+ * @return Whether to go through its exits
+ */
+static walk_action_t placeRoom(WalkStep* step, void* _map) {
+  MapCells* map = (MapCells*) _map;
+
+  // Rooms past a collision would only collide further, so they are reached through other rooms or not at all
+  if (!takeCell(map, step->x, step->y)) return WALK_SKIP;
+
+  map->maze->rooms.pos[step->room] = (RoomPos) { step->x, step->y };
+
+  return WALK_CONTINUE;
+}
+
+/**
+ * Places every room reachable from the entry, dropping any positions the rooms had.
+ * @param maze The maze
+ */
+static void placeRooms(Maze* maze) {
+  RoomStore* rooms = &maze->rooms;
+
+  for (uint i = 0; i < rooms->len; i++) rooms->pos[i] = (RoomPos) { NO_POS, NO_POS };
+
+  // At most half full, so probes stay short
+  size_t cap = 16;
+  int shift = 60;
+  while (cap < 2 * (size_t) rooms->len) { cap <<= 1; shift--; }
+
+  MapCells map = { NULL, cap - 1, shift, maze };
+
+  map.cells = (uint64_t*) malloc(cap * sizeof(uint64_t));
+  if (!map.cells) handleError(ERR_MEM, FATAL, "Could not allocate space for the map layout!\n");
+
+  for (size_t i = 0; i < cap; i++) map.cells[i] = EMPTY_CELL;
+
+  // Breadth first, so the rooms nearest the entry win their cells
+  walkRooms(maze, maze->entry, WALK_BFS, placeRoom, &map);
+
+  free(map.cells);
+}
+
+/**
+ * Works out the bounding box of the rooms on the map.
+ * @param maze The maze
+ * @return The number of rooms on the map
+ */
+static uint boundLayout(Maze* maze) {
+  RoomStore* rooms = &maze->rooms;
+  int minX = INT_MAX, minY = INT_MAX, maxX = INT_MIN, maxY = INT_MIN;
+  uint placed = 0;
+
+  for (uint i = 0; i < rooms->len; i++) {
+    RoomPos pos = rooms->pos[i];
+    if (pos.x == NO_POS || pos.y == NO_POS) continue;
+
+    if (pos.x < minX) minX = pos.x;
+    if (pos.x > maxX) maxX = pos.x;
+    if (pos.y < minY) minY = pos.y;
+    if (pos.y > maxY) maxY = pos.y;
+    placed++;
   }
-  if (room->exits[2] != ((void*) ((long long) NO_EXIT)) && y < gridSize-2) {
-    grid[y+1][x] = '|';
-    placeRoomOnGrid(room->exits[2], grid, x, y+2, visited, gridSize, playerRoom);
+
+  if (placed == 0) { maze->layout = (MapLayout) { 0, 0, 0, 0 }; return 0; }
+
+  maze->layout = (MapLayout) { minX, minY, (uint) ((long long) maxX - minX + 1), (uint) ((long long) maxY - minY + 1) };
+
+  return placed;
+}
+
+void layoutMaze(Maze* maze) {
+  RoomStore* rooms = &maze->rooms;
+
+  if (rooms->pos[maze->entry].x == NO_POS) placeRooms(maze);
+
+  uint placed = boundLayout(maze);
+
+  // Rooms an exit apart can never spread wider than their number, so a given layout that does is made up
+  if (maze->layout.width > placed || maze->layout.height > placed) {
+    handleError(ERR_DATA, WARNING, "The map layout does not fit its rooms, laying it out again!\n");
+
+    placeRooms(maze);
+    boundLayout(maze);
   }
-  if (room->exits[3] != ((void*) ((long long) NO_EXIT)) && x > 1) {
-    grid[y][x-1] = '-';
-    placeRoomOnGrid(room->exits[3], grid, x-2, y, visited, gridSize, playerRoom);
+}
+
+/**
+ * Gets the character a room is drawn with.
+ * @param maze The maze
+ * @param room The room
+ * @param playerRoom The slot of the room the player is in
+ * @return The character
+ */
+static char roomMarker(Maze* maze, uint room, uint playerRoom) {
+  if (room == playerRoom) return 'o';
+  if (maze->rooms.flags[room] & ROOM_BOSS) return '!';
+  if (roomHasEnemy(maze, room)) return '%';
+  if (roomHasLoot(maze, room)) return '$';
+  if (room == maze->entry) return '@';
+
+  return '#';
+}
+
+// The colors of the map, indexed by cellColor
+static const char* const mapColors[] = { RESET, GREEN, YELLOW, CYAN, PURPLE, RED };
+static const uchar mapColorLens[] = {
+  sizeof(RESET) - 1, sizeof(GREEN) - 1, sizeof(YELLOW) - 1, sizeof(CYAN) - 1, sizeof(PURPLE) - 1, sizeof(RED) - 1
+};
+
+/**
+ * Gets the color a cell is drawn in.
+ * @param cell The character of the cell
+ * @return The index of the color in mapColors, 0 (RESET) for connections and empty rooms
+ */
+static int cellColor(char cell) {
+  switch (cell) {
+    case 'o': return 1; // player
+    case '$': return 2; // loot
+    case '@': return 3; // entry
+    case '%': return 4; // enemy
+    case '!': return 5; // boss
+    default: return 0;
   }
 }
 
-void showMap(Maze* maze, Room* playerRoom) {
-  // TODO: Fix map size printing
-  uint gridSize = (int) (sqrt(maze->size) * 6);
+/**
+ * Paints the room and its connections into the cells, clipping what falls outside.
+ * @param maze The maze
+ * @param room The room
+ * @param playerRoom The slot of the room the player is in
+ * @param cells The cells
+ * @param cols The cells across
+ * @param rows The cells down
+ * @param x The cell of the room
+ * @param y The cell of the room
+ */
+static void paintRoom(Maze* maze, uint room, uint playerRoom, char* cells, size_t cols, size_t rows, size_t x, size_t y) {
+  uint* exits = maze->rooms.exits[room];
 
-  if (gridSize < 5) gridSize = 5;
+  cells[y * cols + x] = roomMarker(maze, room, playerRoom);
 
-  char** grid = malloc(gridSize * sizeof(char*));
-  if (!grid) handleError(ERR_MEM, FATAL, "Could not allocate memory for map grid!\n");
+  if (exits[0] != NO_ROOM && y > 0) cells[(y - 1) * cols + x] = '|';
+  if (exits[1] != NO_ROOM && x + 1 < cols) cells[y * cols + x + 1] = '-';
+  if (exits[2] != NO_ROOM && y + 1 < rows) cells[(y + 1) * cols + x] = '|';
+  if (exits[3] != NO_ROOM && x > 0) cells[y * cols + x - 1] = '-';
+}
 
-  bool** visited = malloc(gridSize * sizeof(bool*));
-  if (!visited) handleError(ERR_MEM, FATAL, "Could not allocate memory for visisted array!\n");
+/**
+ * Writes the cells with their colors, switching colors only where they change.
+ * @param cells The cells
+ * @param cols The cells across
+ * @param rows The cells down
+ * @param out Where to write, with space for MAX_CELLS_BYTES(cols, rows)
+ * @return The bytes written
+ */
+static size_t renderCells(const char* cells, size_t cols, size_t rows, char* out) {
+  char* start = out;
 
+  // What comes before ends reset, and a blank looks the same in any color
+  int color = 0;
 
-  for (uint i = 0; i < gridSize; i++) {
-    grid[i] = malloc(gridSize * sizeof(char));
-    if (!grid[i]) handleError(ERR_MEM, FATAL, "Could not allocatr memory for map grid i!\n");
+  for (size_t i = 0; i < rows; i++) {
+    const char* row = &cells[i * cols];
 
-    visited[i] = malloc(gridSize * sizeof(bool));
-    if (!visited[i]) handleError(ERR_MEM, FATAL, "Could not allocate memory for visited i!\n");
+    for (size_t j = 0; j < cols; j++) {
+      int cellCode = (row[j] != ' ') ? cellColor(row[j]) : color;
 
-    memset(grid[i], ' ', gridSize * sizeof(char));
-    memset(visited[i], false, gridSize * sizeof(bool));
-  }
-  
-  placeRoomOnGrid(maze->entry, grid, gridSize/2, gridSize/2, visited, gridSize, playerRoom);
-  
-  printMazeName(maze->name);
-
-  for (int i = 0; i < gridSize; i++) {
-    for (int j = 0; j < gridSize; j++) {
-      char room = grid[i][j];
-
-      if (room == 'o') { // player
-        printf("%s%c%s", GREEN, room, RESET);
-      } else if (room == '$') { // loot
-        printf("%s%c%s", YELLOW, room, RESET);
-      } else if (room == '@') { // entry
-        printf("%s%c%s", CYAN, room, RESET);
-      } else if (room == '%') { // enemy
-        printf("%s%c%s", PURPLE, room, RESET);
-      } else if (room == '!') { // boss
-        printf("%s%c%s", RED, room, RESET);
-      } else { // connections and empty rooms
-        printf("%s%c", RESET, room);
+      if (cellCode != color) {
+        memcpy(out, mapColors[cellCode], mapColorLens[cellCode]);
+        out += mapColorLens[cellCode];
+        color = cellCode;
       }
-      // else putchar(room);
+
+      *out++ = row[j];
     }
-    putchar('\n');
+
+    *out++ = '\n';
+  }
+
+  if (color != 0) {
+    memcpy(out, RESET, sizeof(RESET) - 1);
+    out += sizeof(RESET) - 1;
+  }
+
+  return out - start;
+}
+
+size_t renderMap(Maze* maze, uint playerRoom) {
+  RoomStore* rooms = &maze->rooms;
+  MapLayout* layout = &maze->layout;
+  MapFrame* frame = &maze->frame;
+
+  // Each room is 2 cells away from the next, with its connection in between
+  // The entry is always on the map, unless the maze was never laid out
+  size_t cols = (layout->width != 0) ? 2 * (size_t) layout->width - 1 : 0;
+  size_t rows = (layout->height != 0) ? 2 * (size_t) layout->height - 1 : 0;
+
+  // The layout never changes, so the frame is sized for the most colors it could need once
+  if (!frame->bytes) {
+    frame->cells = (char*) malloc(cols * rows + 1);
+    if (!frame->cells) handleError(ERR_MEM, FATAL, "Could not allocate memory for map grid!\n");
+
+    frame->bytes = (char*) malloc(strlen(maze->name) + MAP_TITLE_EXTRA + MAX_CELLS_BYTES(cols, rows));
+    if (!frame->bytes) handleError(ERR_MEM, FATAL, "Could not allocate memory for the map!\n");
+  }
+
+  char* cells = frame->cells;
+  memset(cells, ' ', cols * rows);
+
+  for (uint room = 0; room < rooms->len; room++) {
+    RoomPos pos = rooms->pos[room];
+    if (pos.x == NO_POS) continue;
+
+    size_t x = 2 * (size_t) ((long long) pos.x - layout->minX);
+    size_t y = 2 * (size_t) ((long long) pos.y - layout->minY);
+
+    paintRoom(maze, room, playerRoom, cells, cols, rows, x, y);
   }
+
+  char* out = frame->bytes;
+  out += renderMazeName(maze->name, out);
+  out += renderCells(cells, cols, rows, out);
+
+  frame->len = out - frame->bytes;
+
+  return frame->len;
 }
 
-void deleteRoom(Room* room) {
-  if (!room->loot) deleteItem(room->loot);
-  deleteEnemyFromMap(room, true);
-  free(room->info);
-  if (room->storyFile) free(room->storyFile);
-  if (room->file) fclose(room->file);
-  free(room);
+void showMap(Maze* maze, uint playerRoom) {
+  size_t len = renderMap(maze, playerRoom);
 
-  room = NULL;
+  writeTerminal(stdout, maze->frame.bytes, len);
 }
 
-void deleteMaze(Maze* maze) {
-  Table* table = initTableL(maze->size);
-  if (!table) handleError(ERR_MEM, FATAL, "Could not allocate space for the table!\n");
+bool mapFits(Maze* maze, uint cols, uint rows) {
+  // The title shares the first row, see renderMazeName
+  size_t titleLen = strlen(maze->name) + 2;
 
-  Room* room = maze->entry;
-  addAndRecurse(room, table);
-  room = NULL;
+  return 2 * (size_t) maze->layout.width - 1 + titleLen <= cols && 2 * (size_t) maze->layout.height - 1 <= rows;
+}
+
+/**
+ * Sorts the rooms by one of their coordinates, keeping the order of rooms that share it (counting sort).
+ * @param pos Where every room is
+ * @param in The slots to sort
+ * @param out Where to put the sorted slots
+ * @param n The number of slots
+ * @param starts Where to store where each coordinate starts in out, with space for span + 1
+ * @param span The number of coordinates
+ * @param min The smallest coordinate
+ * @param byY Whether to sort by row instead of column
+ */
+static void sortRooms(const RoomPos* pos, const uint* in, uint* out, uint n, uint* starts, uint span, int min, bool byY) {
+  memset(starts, 0, ((size_t) span + 1) * sizeof(uint));
+
+  for (uint i = 0; i < n; i++) starts[(byY ? pos[in[i]].y : pos[in[i]].x) - min + 1]++;
+  for (uint i = 0; i < span; i++) starts[i + 1] += starts[i];
 
-  for (int i = 0; i < table->len; i++) {
-    deleteRoom(table->rooms[i]);
+  // Each start moves on as its rooms are placed, ending up where the next one starts
+  for (uint i = 0; i < n; i++) out[starts[(byY ? pos[in[i]].y : pos[in[i]].x) - min]++] = in[i];
+
+  memmove(starts + 1, starts, (size_t) span * sizeof(uint));
+  starts[0] = 0;
+}
+
+/**
+ * Builds the spatial index of the map: the rooms on it by row, then by column within a row.
+ * Rows and columns never outnumber the rooms (see layoutMaze), so both sorts are linear.
+ * @param maze The maze
+ */
+static void indexRows(Maze* maze) {
+  RoomStore* rooms = &maze->rooms;
+  MapLayout* layout = &maze->layout;
+  MapFrame* frame = &maze->frame;
+
+  uint placed = 0;
+  for (uint i = 0; i < rooms->len; i++) placed += rooms->pos[i].x != NO_POS;
+
+  uint* byColumn = (uint*) malloc(((size_t) placed + 1) * sizeof(uint));
+  uint* columnStart = (uint*) malloc(((size_t) layout->width + 1) * sizeof(uint));
+  frame->byRow = (uint*) malloc(((size_t) placed + 1) * sizeof(uint));
+  frame->rowStart = (uint*) malloc(((size_t) layout->height + 1) * sizeof(uint));
+  if (!byColumn || !columnStart || !frame->byRow || !frame->rowStart) handleError(ERR_MEM, FATAL, "Could not allocate space for the map index!\n");
+
+  // The rooms in slot order, sorted by column, then by row
+  uint n = 0;
+  for (uint i = 0; i < rooms->len; i++) {
+    if (rooms->pos[i].x != NO_POS) frame->byRow[n++] = i;
   }
 
-  deleteTable(table);
+  sortRooms(rooms->pos, frame->byRow, byColumn, n, columnStart, layout->width, layout->minX, false);
+  sortRooms(rooms->pos, byColumn, frame->byRow, n, frame->rowStart, layout->height, layout->minY, true);
+
+  free(byColumn);
+  free(columnStart);
+}
+
+void initMapView(Maze* maze, MapView* view, uint cols, uint rows) {
+  view->cols = (cols != 0) ? cols : 1;
+  view->rows = (rows != 0) ? rows : 1;
+  view->x = 0;
+  view->y = 0;
+  view->len = 0;
+
+  view->cells = (char*) malloc((size_t) view->cols * view->rows);
+  view->bytes = (char*) malloc(strlen(maze->name) + MAP_TITLE_EXTRA + VIEW_CENTER_SIZE + MAX_CELLS_BYTES(view->cols, view->rows));
+  if (!view->cells || !view->bytes) handleError(ERR_MEM, FATAL, "Could not allocate memory for the map window!\n");
+}
+
+/**
+ * Keeps the center of the window on the map, so it never shows nothing but fog.
+ * @param maze The maze
+ * @param view The window
+ */
+static void clampMapView(Maze* maze, MapView* view) {
+  MapLayout* layout = &maze->layout;
+  if (layout->width == 0) return;
+
+  long long maxX = (long long) layout->minX + layout->width - 1;
+  long long maxY = (long long) layout->minY + layout->height - 1;
+
+  if (view->x < layout->minX) view->x = layout->minX;
+  if (view->x > maxX) view->x = (int) maxX;
+  if (view->y < layout->minY) view->y = layout->minY;
+  if (view->y > maxY) view->y = (int) maxY;
+}
+
+void centerMapView(Maze* maze, MapView* view, uint room) {
+  RoomPos pos = maze->rooms.pos[room];
+  if (pos.x == NO_POS) pos = maze->rooms.pos[maze->entry];
+  if (pos.x == NO_POS) pos = (RoomPos) { 0, 0 };
+
+  view->x = pos.x;
+  view->y = pos.y;
+}
+
+void scrollMapView(Maze* maze, MapView* view, int dx, int dy) {
+  // Half a window, in rooms
+  int stepX = (int) ((view->cols + 1) / 4) + 1;
+  int stepY = (int) ((view->rows + 1) / 4) + 1;
+
+  view->x = (int) ((long long) view->x + (long long) dx * stepX);
+  view->y = (int) ((long long) view->y + (long long) dy * stepY);
+
+  clampMapView(maze, view);
+}
+
+size_t renderMapView(Maze* maze, MapView* view, uint playerRoom) {
+  RoomStore* rooms = &maze->rooms;
+  MapLayout* layout = &maze->layout;
+  MapFrame* frame = &maze->frame;
+
+  if (!frame->byRow && layout->width != 0) indexRows(maze);
+
+  size_t cols = view->cols, rows = view->rows;
+
+  // The rooms that fit, the center one in the middle
+  long long roomsX = (cols + 1) / 2, roomsY = (rows + 1) / 2;
+  long long left = view->x - roomsX / 2, top = view->y - roomsY / 2;
+
+  memset(view->cells, ' ', cols * rows);
+
+  for (long long y = top; y < top + roomsY && layout->width != 0; y++) {
+    long long row = y - layout->minY;
+    if (row < 0 || row >= layout->height) continue;
+
+    // The first room of the row not left of the window
+    uint lo = frame->rowStart[row], hi = frame->rowStart[row + 1];
+    while (lo < hi) {
+      uint mid = lo + (hi - lo) / 2;
+
+      if (rooms->pos[frame->byRow[mid]].x < left) lo = mid + 1;
+      else hi = mid;
+    }
+
+    for (uint i = lo; i < frame->rowStart[row + 1]; i++) {
+      uint room = frame->byRow[i];
+      long long x = rooms->pos[room].x;
+      if (x >= left + roomsX) break;
+
+      // Only the rooms the player has been in come out of the fog
+      if (!roomSeen(rooms, room)) continue;
+
+      paintRoom(maze, room, playerRoom, view->cells, cols, rows, 2 * (size_t) (x - left), 2 * (size_t) (y - top));
+    }
+  }
+
+  char* out = view->bytes;
+  out += renderMazeName(maze->name, out);
+  out += snprintf(out, VIEW_CENTER_SIZE, "(%d, %d)\n", view->x, view->y);
+  out += renderCells(view->cells, cols, rows, out);
+
+  view->len = out - view->bytes;
+
+  return view->len;
+}
+
+void showMapView(Maze* maze, MapView* view, uint playerRoom) {
+  size_t len = renderMapView(maze, view, playerRoom);
+
+  writeTerminal(stdout, view->bytes, len);
+}
+
+void deleteMapView(MapView* view) {
+  free(view->cells);
+  free(view->bytes);
+
+  view->cells = NULL;
+  view->bytes = NULL;
+}
+
+void visitRoom(Maze* maze, uint room) {
+  materializeRoom(maze, room);
+  setRoomSeen(&maze->rooms, room);
+}
+
+void deleteMaze(Maze* maze) {
+  if (!maze) return;
+
+  // The tables of the rooms never entered, read from JSON they are in the arena
+  if (maze->tablesType == TABLES_MZB) closeMazeBin(maze->tables);
+
+  free(maze->frame.cells);
+  free(maze->frame.bytes);
+  free(maze->frame.byRow);
+  free(maze->frame.rowStart);
+
+  deleteEnemyCatalog(&maze->catalog);
+  deleteRoomStore(&maze->rooms);
+  deleteTable(maze->ids);
 
-  free(maze->name);
+  // Enemies and loot all live in the arena
+  deleteArena(maze->arena);
   free(maze);
 }
\ No newline at end of file
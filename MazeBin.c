@@ -0,0 +1,530 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+
+#ifdef _WIN64
+  #include <windows.h>
+#else
+  #include <fcntl.h>
+  #include <unistd.h>
+  #include <sys/mman.h>
+#endif
+
+#include "Error.h"
+#include "Setup.h"
+#include "MazeBin.h"
+#include "Intern.h"
+#include "Random.h"
+
+
+// A read-only view of a mapped .mzb file
+typedef struct MzbView {
+  const char* base; // Start of the mapping
+  size_t size; // Size of the mapping
+  const MzbHeader* header;
+  const MzbRoom* rooms;
+  const MzbItem* items;
+  const MzbEnemy* enemies;
+  const MzbSkill* skills;
+  const char* strs; // The string section
+  Arena* arena; // The arena of the maze being built
+#ifdef _WIN64
+  HANDLE file;
+  HANDLE mapping;
+#endif
+} MzbView;
+
+
+/**
+ * Maps the given file into memory.
+ * @param filename The .mzb file
+ * @param view The view to fill out
+ */
+static void mapFile(const str filename, MzbView* view) {
+#ifdef _WIN64
+  view->file = CreateFileA(filename, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+  if (view->file == INVALID_HANDLE_VALUE) handleError(ERR_IO, FATAL, "Could not open %s!\n", filename);
+
+  LARGE_INTEGER size;
+  if (!GetFileSizeEx(view->file, &size)) handleError(ERR_IO, FATAL, "Could not get size of %s!\n", filename);
+  view->size = (size_t) size.QuadPart;
+
+  // Mapping an empty file fails, so catch it before
+  if (view->size < sizeof(MzbHeader)) handleError(ERR_DATA, FATAL, "%s is too small to be a maze!\n", filename);
+
+  view->mapping = CreateFileMappingA(view->file, NULL, PAGE_READONLY, 0, 0, NULL);
+  if (!view->mapping) handleError(ERR_IO, FATAL, "Could not map %s!\n", filename);
+
+  view->base = (const char*) MapViewOfFile(view->mapping, FILE_MAP_READ, 0, 0, 0);
+  if (!view->base) handleError(ERR_IO, FATAL, "Could not map %s!\n", filename);
+#else
+  int fd = open(filename, O_RDONLY);
+  if (fd == -1) handleError(ERR_IO, FATAL, "Could not open %s!\n", filename);
+
+  struct stat st;
+  if (fstat(fd, &st) == -1) handleError(ERR_IO, FATAL, "Could not get size of %s!\n", filename);
+  view->size = (size_t) st.st_size;
+
+  // Mapping an empty file fails, so catch it before
+  if (view->size < sizeof(MzbHeader)) handleError(ERR_DATA, FATAL, "%s is too small to be a maze!\n", filename);
+
+  void* base = mmap(NULL, view->size, PROT_READ, MAP_PRIVATE, fd, 0);
+  if (base == MAP_FAILED) handleError(ERR_IO, FATAL, "Could not map %s!\n", filename);
+
+  // The mapping stays valid after the file is closed
+  close(fd);
+
+  view->base = (const char*) base;
+#endif
+}
+
+/**
+ * Unmaps the file.
+ * @param view The view to unmap
+ */
+static void unmapFile(MzbView* view) {
+#ifdef _WIN64
+  UnmapViewOfFile(view->base);
+  CloseHandle(view->mapping);
+  CloseHandle(view->file);
+#else
+  munmap((void*) view->base, view->size);
+#endif
+  view->base = NULL;
+}
+
+/**
+ * Checks that a table of count records of the given size starting at offset lies within the file.
+ * @param view The view
+ * @param offset The file offset of the table
+ * @param count The amount of records
+ * @param size The size of a record
+ * @return True if it fits, false otherwise
+ */
+static bool tableFits(MzbView* view, uint32_t offset, uint32_t count, size_t size) {
+  if (offset % 4 != 0 || offset > view->size) return false;
+
+  return ((size_t) count) * size <= view->size - offset;
+}
+
+/**
+ * Validates the header and section bounds, then sets the table pointers of the view.
+ * @param view The view to validate
+ * @param filename The file name, for errors
+ */
+static void validateView(MzbView* view, const str filename) {
+  const MzbHeader* header = (const MzbHeader*) view->base;
+
+  if (memcmp(header->magic, MZB_MAGIC, 4) != 0) handleError(ERR_DATA, FATAL, "%s is not a compiled maze!\n", filename);
+  if (header->version != MZB_VERSION) {
+    handleError(ERR_DATA, FATAL, "%s has version %u, expected %u!\n", filename, header->version, MZB_VERSION);
+  }
+  if (header->fileSize != view->size) handleError(ERR_DATA, FATAL, "%s is truncated!\n", filename);
+
+  if (!tableFits(view, header->roomOffset, header->roomCount, sizeof(MzbRoom)) ||
+      !tableFits(view, header->itemOffset, header->itemCount, sizeof(MzbItem)) ||
+      !tableFits(view, header->enemyOffset, header->enemyCount, sizeof(MzbEnemy)) ||
+      !tableFits(view, header->skillOffset, header->skillCount, sizeof(MzbSkill)) ||
+      !tableFits(view, header->strOffset, header->strSize, 1)) {
+    handleError(ERR_DATA, FATAL, "%s has a section out of bounds!\n", filename);
+  }
+
+  // Every string is NUL-terminated, so a terminated section keeps all lookups in bounds
+  if (header->strSize == 0 || view->base[header->strOffset + header->strSize - 1] != '\0') {
+    handleError(ERR_DATA, FATAL, "%s has an unterminated string section!\n", filename);
+  }
+
+  if (header->roomCount == 0 || header->entry >= header->roomCount) {
+    handleError(ERR_DATA, FATAL, "%s has no entry room!\n", filename);
+  }
+
+  view->header = header;
+  view->rooms = (const MzbRoom*) (view->base + header->roomOffset);
+  view->items = (const MzbItem*) (view->base + header->itemOffset);
+  view->enemies = (const MzbEnemy*) (view->base + header->enemyOffset);
+  view->skills = (const MzbSkill*) (view->base + header->skillOffset);
+  view->strs = view->base + header->strOffset;
+}
+
+/**
+ * Gets a string from the string section.
+ * @param view The view
+ * @param offset The string offset
+ * @return The string
+ */
+static const char* mzbString(MzbView* view, uint32_t offset) {
+  if (offset >= view->header->strSize) handleError(ERR_DATA, FATAL, "String offset %u out of bounds!\n", offset);
+
+  return view->strs + offset;
+}
+
+/**
+ * Interns a string from the string section.
+ * @param view The view
+ * @param offset The string offset
+ * @return The interned string
+ */
+static str internString(MzbView* view, uint32_t offset) {
+  return intern(mzbString(view, offset));
+}
+
+/**
+ * Creates a SoulWeapon from an item record.
+ * @param view The view
+ * @param rec The item record
+ * @return The SoulWeapon
+ */
+static SoulWeapon* mzbSoulWeapon(MzbView* view, const MzbItem* rec) {
+  SoulWeapon* sw = (SoulWeapon*) arenaAlloc(view->arena, sizeof(SoulWeapon));
+  if (!sw) handleError(ERR_MEM, FATAL, "Could not allocate space for SoulWeapon!\n");
+
+  sw->name = internString(view, rec->text);
+  sw->atk = rec->atk;
+  sw->acc = rec->acc;
+  sw->atk_crit = rec->atkCrit;
+  sw->atk_crit_dmg = rec->atkCritDmg;
+  sw->lvl = rec->lvl;
+  sw->upgrades = rec->upgrades;
+  sw->durability = rec->durability;
+
+  return sw;
+}
+
+/**
+ * Creates an armor piece from an item record.
+ * @param view The view
+ * @param rec The item record
+ * @return The armor
+ */
+static Armor* mzbArmor(MzbView* view, const MzbItem* rec) {
+  Armor* armor = (Armor*) arenaAlloc(view->arena, sizeof(Armor));
+  if (!armor) handleError(ERR_MEM, FATAL, "Could not allocate space for armor!\n");
+
+  armor->name = internString(view, rec->text);
+  armor->type = rec->kind;
+  armor->acc = rec->acc;
+  armor->def = rec->def;
+  armor->lvl = rec->lvl;
+
+  return armor;
+}
+
+/**
+ * Creates an item from an item record.
+ * @param view The view
+ * @param rec The item record
+ * @return The item
+ */
+static Item* mzbItem(MzbView* view, const MzbItem* rec) {
+  Item* item = (Item*) arenaAlloc(view->arena, sizeof(Item));
+  if (!item) handleError(ERR_MEM, FATAL, "Could not allocate space for item!\n");
+
+  item->type = rec->type;
+  item->count = rec->count;
+  item->_item = NULL;
+
+  switch (item->type) {
+    case SOULWEAPON_T:
+      item->_item = mzbSoulWeapon(view, rec);
+      break;
+    case HELMET_T:
+    case SHOULDER_GUARD_T:
+    case CHESTPLATE_T:
+    case BOOTS_T:
+      item->_item = mzbArmor(view, rec);
+      break;
+    case HP_KITS_T:
+      HPKit* hpKit = (HPKit*) arenaAlloc(view->arena, sizeof(HPKit));
+      if (!hpKit) handleError(ERR_MEM, FATAL, "Could not allocate for HP Kit!\n");
+      hpKit->type = rec->kind;
+      hpKit->desc = internString(view, rec->text);
+      item->_item = hpKit;
+      break;
+    case WEAPON_UPGRADE_MATERIALS_T:
+    case ARMOR_UPGRADE_MATERIALS_T:
+      Upgrade* upgrade = (Upgrade*) arenaAlloc(view->arena, sizeof(Upgrade));
+      if (!upgrade) handleError(ERR_MEM, FATAL, "Could not allocate space for upgrade material!\n");
+      upgrade->rank = rec->rank;
+      upgrade->type = rec->kind;
+      upgrade->desc = internString(view, rec->text);
+      item->_item = upgrade;
+      break;
+    case SLIME_T:
+      Slime* slime = (Slime*) arenaAlloc(view->arena, sizeof(Slime));
+      if (!slime) handleError(ERR_MEM, FATAL, "Could not allocate for slime!\n");
+      slime->desc = internString(view, rec->text);
+      item->_item = slime;
+      break;
+    default:
+      break;
+  }
+
+  return item;
+}
+
+/**
+ * Creates the gear and skills of a boss from its enemy record.
+ * @param view The view
+ * @param rec The enemy record
+ * @return The boss template
+ */
+static BossTemplate* mzbBossTemplate(MzbView* view, const MzbEnemy* rec) {
+  const MzbHeader* header = view->header;
+  const char* name = mzbString(view, rec->name);
+
+  BossTemplate* boss = (BossTemplate*) arenaAlloc(view->arena, sizeof(BossTemplate));
+  if (!boss) handleError(ERR_MEM, FATAL, "Could not allocate space for boss!\n");
+
+  if (rec->gear > header->itemCount || header->itemCount - rec->gear < 5) {
+    handleError(ERR_DATA, FATAL, "Boss %s has no gear!\n", name);
+  }
+
+  // Gear is stored in the order of the Gear structure
+  const MzbItem* gear = &view->items[rec->gear];
+  boss->gearDrop.sw = mzbSoulWeapon(view, &gear[0]);
+  boss->gearDrop.helmet = mzbArmor(view, &gear[1]);
+  boss->gearDrop.guard = mzbArmor(view, &gear[2]);
+  boss->gearDrop.chestplate = mzbArmor(view, &gear[3]);
+  boss->gearDrop.boots = mzbArmor(view, &gear[4]);
+
+  if (rec->skillCount != BOSS_SKILL_COUNT || rec->skillStart > header->skillCount ||
+      header->skillCount - rec->skillStart < BOSS_SKILL_COUNT) {
+    handleError(ERR_DATA, FATAL, "Boss %s must have %d skills!\n", name, BOSS_SKILL_COUNT);
+  }
+
+  for (int i = 0; i < BOSS_SKILL_COUNT; i++) {
+    const MzbSkill* skill = &view->skills[rec->skillStart + i];
+
+    boss->skills[i].name = internString(view, skill->name);
+    boss->skills[i].description = internString(view, skill->description);
+    boss->skills[i].lvl = skill->lvl;
+    boss->skills[i].cooldown = skill->cooldown;
+    boss->skills[i].cdTimer = 0;
+    boss->skills[i].id = skill->id;
+    boss->skills[i].activeEffect1 = skill->activeEffect1;
+    boss->skills[i].activeEffect2 = skill->activeEffect2;
+    // Since atk and atk_crit_dmg occupy the same space, it doesn't matter which is assigned to
+    boss->skills[i].effect1.atk = skill->effect1;
+    if (skill->activeEffect2 == ATK_CRIT) boss->skills[i].effect2.atk_crit = skill->effect2;
+    else boss->skills[i].effect2.acc = (ushort) skill->effect2;
+  }
+
+  return boss;
+}
+
+/**
+ * Adds every enemy record to the catalog. Records with gear are bosses.
+ * @param view The view
+ * @param catalog The catalog to fill out
+ * @return The catalog index of each record (to be freed), NULL if there are none
+ */
+static ushort* mzbCatalog(MzbView* view, EnemyCatalog* catalog) {
+  uint32_t enemyCount = view->header->enemyCount;
+  if (enemyCount == 0) return NULL;
+
+  ushort* ids = (ushort*) malloc(enemyCount * sizeof(ushort));
+  if (!ids) handleError(ERR_MEM, FATAL, "Could not allocate space for the enemy templates!\n");
+
+  for (uint32_t i = 0; i < enemyCount; i++) {
+    const MzbEnemy* rec = &view->enemies[i];
+    EnemyTemplate tmpl;
+
+    tmpl.name = internString(view, rec->name);
+    tmpl.xpPoints = rec->xpPoints;
+    tmpl.lvl = rec->lvl;
+    // MZB_RANGED_* are the same bits as RANGED_*
+    tmpl.ranged = rec->ranged;
+    memcpy(tmpl.hp, rec->hp, sizeof(tmpl.hp));
+    memcpy(tmpl.atk, rec->atk, sizeof(tmpl.atk));
+    memcpy(tmpl.def, rec->def, sizeof(tmpl.def));
+    memcpy(tmpl.acc, rec->acc, sizeof(tmpl.acc));
+    memcpy(tmpl.atkCritDmg, rec->atkCritDmg, sizeof(tmpl.atkCritDmg));
+    memcpy(tmpl.atkCrit, rec->atkCrit, sizeof(tmpl.atkCrit));
+    tmpl.boss = (rec->gear == MZB_NONE) ? NULL : mzbBossTemplate(view, rec);
+
+    ids[i] = addEnemyTemplate(catalog, &tmpl);
+  }
+
+  return ids;
+}
+
+/**
+ * Adds a room from a room record to the store. Its loot and enemy are rolled when it is first entered,
+ * see materializeMazeBin. Records are added in file order, so their exits are already slots.
+ * @param view The view
+ * @param rooms The room store of the maze
+ * @param rec The room record
+ * @param enemyIds The catalog index of each enemy record
+ * @return The slot of the room
+ */
+static uint mzbRoom(MzbView* view, RoomStore* rooms, const MzbRoom* rec, const ushort* enemyIds) {
+  const MzbHeader* header = view->header;
+
+  bool hasBoss = (bool) rec->hasBoss;
+
+  str info = internString(view, rec->info);
+  str storyFile = (rec->storyFile == MZB_NONE) ? NULL : internString(view, rec->storyFile);
+
+  if (rec->lootStart > header->itemCount || header->itemCount - rec->lootStart < rec->lootCount) {
+    handleError(ERR_DATA, FATAL, "Room %u: loot table out of bounds!\n", rec->id);
+  }
+  if (rec->enemyStart > header->enemyCount || header->enemyCount - rec->enemyStart < rec->enemyCount) {
+    handleError(ERR_DATA, FATAL, "Room %u: enemy table out of bounds!\n", rec->id);
+  }
+  if (hasBoss && rec->enemyCount == 0) handleError(ERR_DATA, FATAL, "Could not get boss data!\n");
+  if (hasBoss && view->enemies[rec->enemyStart].gear == MZB_NONE) {
+    handleError(ERR_DATA, FATAL, "Boss %s has no gear!\n", mzbString(view, view->enemies[rec->enemyStart].name));
+  }
+
+  RoomTables* tables = (RoomTables*) arenaAlloc(view->arena, sizeof(RoomTables));
+  if (!tables) handleError(ERR_MEM, FATAL, "Could not allocate space for room tables!\n");
+
+  // The records stay mapped for as long as the maze lives
+  tables->loot = (void*) &view->items[rec->lootStart];
+  tables->lootCount = rec->lootCount;
+
+  // Only the first enemy of a boss room is ever used
+  tables->enemyCount = hasBoss ? 1 : rec->enemyCount;
+  tables->enemies = NULL;
+
+  if (tables->enemyCount != 0) {
+    tables->enemies = (ushort*) arenaAlloc(view->arena, tables->enemyCount * sizeof(ushort));
+    if (!tables->enemies) handleError(ERR_MEM, FATAL, "Could not allocate space for room enemies!\n");
+
+    for (uint i = 0; i < tables->enemyCount; i++) tables->enemies[i] = enemyIds[rec->enemyStart + i];
+  }
+
+  uint room = addRoom(rooms, rec->id, info, storyFile, hasBoss ? ROOM_BOSS : 0);
+  rooms->tables[room] = tables;
+
+  return room;
+}
+
+void materializeMazeBin(Maze* maze, uint room, RoomTables* tables) {
+  MzbView* view = (MzbView*) maze->tables;
+
+  const MzbItem* items = (const MzbItem*) tables->loot;
+
+  // Same rolls as populateRoom
+  if (tables->lootCount != 0) maze->rooms.loot[room] = mzbItem(view, &items[randomBelow(RNG_LOOT, tables->lootCount)]);
+
+  populateEnemy(maze, room, tables);
+}
+
+void readMazeBinLoot(Maze* maze, RoomTables* tables, uint i, LootRecord* rec) {
+  MzbView* view = (MzbView*) maze->tables;
+  const MzbItem* item = &((const MzbItem*) tables->loot)[i];
+
+  rec->text = internString(view, item->text);
+  rec->count = item->count;
+  rec->kind = item->kind;
+  rec->atkCrit = item->atkCrit;
+  rec->atk = item->atk;
+  rec->acc = item->acc;
+  rec->def = item->def;
+  rec->atkCritDmg = item->atkCritDmg;
+  rec->type = item->type;
+  rec->lvl = item->lvl;
+  rec->upgrades = item->upgrades;
+  rec->durability = item->durability;
+  rec->rank = item->rank;
+}
+
+void closeMazeBin(void* view) {
+  unmapFile((MzbView*) view);
+  free(view);
+}
+
+Maze* loadMazeBin(const str filename) {
+  // The view outlives the load, the rooms roll from its records
+  MzbView* view = (MzbView*) malloc(sizeof(MzbView));
+  if (!view) handleError(ERR_MEM, FATAL, "Could not allocate space for compiled maze!\n");
+
+  mapFile(filename, view);
+  validateView(view, filename);
+
+  view->arena = initArena(ARENA_CHUNK_SIZE);
+
+  uint32_t roomCount = view->header->roomCount;
+
+  RoomStore rooms;
+  initRoomStore(&rooms, roomCount);
+
+  // The records are in file order, the index is by id
+  uint32_t maxId = 0;
+  for (uint32_t i = 0; i < roomCount; i++) {
+    uint32_t id = view->rooms[i].id;
+
+    if (id > MAX_ROOM_ID) handleError(ERR_DATA, FATAL, "Room %u: id is too big!\n", id);
+    if (id > maxId) maxId = id;
+  }
+
+  Table* index = initTableL(roomCount, maxId);
+  if (!index) handleError(ERR_MEM, FATAL, "Could not allocate space for the room index!\n");
+
+  // Enemy definitions are read once, rooms only keep their catalog indices
+  EnemyCatalog catalog = { NULL, 0, 0 };
+  ushort* enemyIds = mzbCatalog(view, &catalog);
+
+  for (uint32_t i = 0; i < roomCount; i++) {
+    uint room = mzbRoom(view, &rooms, &view->rooms[i], enemyIds);
+
+    // Exits point at records, so no record can be dropped
+    if (!putRoom(index, view->rooms[i].id, room, false)) handleError(ERR_DATA, FATAL, "Room %u: id is repeated!\n", view->rooms[i].id);
+  }
+
+  free(enemyIds);
+
+  // Exits are already room slots, so linking is a bounds check
+  for (uint32_t i = 0; i < roomCount; i++) {
+    for (int j = 0; j < 4; j++) {
+      uint32_t exit = view->rooms[i].exits[j];
+
+      if (exit == MZB_NONE) rooms.exits[i][j] = NO_ROOM;
+      else if (exit < roomCount) rooms.exits[i][j] = exit;
+      else handleError(ERR_DATA, FATAL, "Room %u: exit %u out of bounds!\n", view->rooms[i].id, exit);
+    }
+  }
+
+  Maze* maze = (Maze*) malloc(sizeof(Maze));
+  if (!maze) handleError(ERR_MEM, FATAL, "Could not allocate space for maze!\n");
+
+  maze->entry = view->header->entry;
+  maze->rooms = rooms;
+  maze->ids = index;
+  maze->arena = view->arena;
+  maze->tables = view;
+  maze->catalog = catalog;
+  maze->tablesType = TABLES_MZB;
+  maze->name = internString(view, view->header->name);
+  maze->frame = (MapFrame) { 0 };
+
+  // Compiled mazes have no positions, so they are laid out on every load
+  layoutMaze(maze);
+
+  return maze;
+}
+
+str mazeBinFor(const str filename) {
+  size_t len = strlen(filename);
+
+  if (len < 5 || strcmp(filename + len - 5, ".json") != 0) return NULL;
+
+  str binFile = (str) malloc(len);
+  if (!binFile) handleError(ERR_MEM, FATAL, "Could not allocate space for compiled maze filename!\n");
+
+  // "[name].json" -> "[name].mzb"
+  memcpy(binFile, filename, len - 4);
+  strcpy(binFile + len - 4, "mzb");
+
+  struct stat binSt, jsonSt;
+
+  // Only use it when it exists and is not older than the map it was compiled from
+  if (stat(binFile, &binSt) != 0 || (stat(filename, &jsonSt) == 0 && binSt.st_mtime < jsonSt.st_mtime)) {
+    free(binFile);
+    return NULL;
+  }
+
+  return binFile;
+}
@@ -31,7 +31,7 @@ static bool equalSoulWeapon(SoulWeapon* sw1, SoulWeapon* sw2) {
           (floateq(sw1->atk_crit, sw2->atk_crit)) &&
           (sw1->atk_crit_dmg == sw2->atk_crit_dmg) &&
           (sw1->lvl == sw2->lvl) &&
-          (strcmp(sw1->name, sw2->name) == 0));
+          (sw1->name == sw2->name)); // Names are interned
 }
 
 /**
@@ -45,7 +45,7 @@ static bool equalArmor(Armor* arm1, Armor* arm2) {
           (arm1->acc == arm2->acc) &&
           (arm1->def == arm2->def) &&
           (arm1->lvl == arm2->lvl) &&
-          (strcmp(arm1->name, arm2->name) == 0));
+          (arm1->name == arm2->name)); // Names are interned
 }
 
 /**
@@ -241,7 +241,7 @@ void displaySlime(Slime* slime) {
 void deleteSoulWeapon(SoulWeapon* sw) {
   if (!sw) return;
 
-  free(sw->name);
+  // The name is interned
   free(sw);
   sw = NULL;
 }
@@ -249,7 +249,7 @@ void deleteSoulWeapon(SoulWeapon* sw) {
 void deleteArmor(Armor* armor) {
   if (!armor) return;
 
-  free(armor->name);
+  // The name is interned
   free(armor);
   armor = NULL;
 }
@@ -257,7 +257,7 @@ void deleteArmor(Armor* armor) {
 void deleteOther(HPKit* item) {
   if (!item) return;
 
-  free(item->desc);
+  // The description is interned
   free(item);
   item = NULL;
 }
@@ -292,10 +292,66 @@ bool deleteItem(Item* item) {
   return true;
 }
 
-void displayEnemyStats(Enemy* enemy) {
+void* promoteItemData(void* _item, item_t type) {
+  if (!_item) return NULL;
+
+  switch (type) {
+    case SOULWEAPON_T: {
+      SoulWeapon* sw = (SoulWeapon*) malloc(sizeof(SoulWeapon));
+      if (!sw) handleError(ERR_MEM, FATAL, "Could not allocate space for SoulWeapon!\n");
+      *sw = *(SoulWeapon*) _item;
+      return sw;
+    }
+    case HELMET_T:
+    case SHOULDER_GUARD_T:
+    case CHESTPLATE_T:
+    case BOOTS_T: {
+      Armor* armor = (Armor*) malloc(sizeof(Armor));
+      if (!armor) handleError(ERR_MEM, FATAL, "Could not allocate space for armor!\n");
+      *armor = *(Armor*) _item;
+      return armor;
+    }
+    case HP_KITS_T: {
+      HPKit* hpKit = (HPKit*) malloc(sizeof(HPKit));
+      if (!hpKit) handleError(ERR_MEM, FATAL, "Could not allocate for HP Kit!\n");
+      *hpKit = *(HPKit*) _item;
+      return hpKit;
+    }
+    case WEAPON_UPGRADE_MATERIALS_T:
+    case ARMOR_UPGRADE_MATERIALS_T: {
+      Upgrade* upgrade = (Upgrade*) malloc(sizeof(Upgrade));
+      if (!upgrade) handleError(ERR_MEM, FATAL, "Could not allocate space for upgrade material!\n");
+      *upgrade = *(Upgrade*) _item;
+      return upgrade;
+    }
+    case SLIME_T: {
+      Slime* slime = (Slime*) malloc(sizeof(Slime));
+      if (!slime) handleError(ERR_MEM, FATAL, "Could not allocate for slime!\n");
+      *slime = *(Slime*) _item;
+      return slime;
+    }
+    default:
+      return NULL;
+  }
+}
+
+Item* promoteItem(Item* item) {
+  if (!item) return NULL;
+
+  Item* copy = (Item*) malloc(sizeof(Item));
+  if (!copy) handleError(ERR_MEM, FATAL, "Could not allocate space for item!\n");
+
+  copy->type = item->type;
+  copy->count = item->count;
+  copy->_item = promoteItemData(item->_item, item->type);
+
+  return copy;
+}
+
+void displayEnemyStats(EnemyTemplate* tmpl, Enemy* enemy) {
   printf("%s, LVL %d; HP %d\nATK: %d; DEF: %d; ACC: %d; ATK CRIT DMG: %d; ATK CRIT: %3.2f\n", 
-      enemy->name, enemy->lvl, enemy->hp,
-      enemy->stats->ATK, enemy->stats->DEF, enemy->stats->ACC, enemy->stats->ATK_CRIT_DMG, enemy->stats->ATK_CRIT);
+      tmpl->name, tmpl->lvl, enemy->hp,
+      enemy->stats.ATK, enemy->stats.DEF, enemy->stats.ACC, enemy->stats.ATK_CRIT_DMG, enemy->stats.ATK_CRIT);
 }
 
 void initSkill(Skill *skill, str name, str desc, byte lvl, byte cooldown, 
@@ -337,43 +393,3 @@ void initSkill(Skill *skill, str name, str desc, byte lvl, byte cooldown,
   skill->activeEffect1 = active1;
   skill->activeEffect2 = active2;
 }
-
-void deleteSkills(Skill skills[], int len) {
-  for (int i = 0; i < len; i++) {
-    free(skills[i].name);
-    free(skills[i].description);
-  }
-}
-
-bool deleteEnemy(Enemy *enemy) {
-  if (!enemy) return false;
-
-  free(enemy->name);
-  free(enemy->stats);
-  free(enemy);
-
-  return true;
-}
-
-bool deleteBoss(Boss* boss, bool deleteGear) {
-  if (!boss) return false;
-
-  free(boss->base.name);
-  free(boss->base.stats);
-  // Do not delete the gear. Transfer ownership (copy addresses) to player
-  // Default to not delete the gear so the ownership (addresses) are transferred to player
-  // But when ending the game, do delete the gear if boss is still present
-  if (deleteGear) {
-    deleteSoulWeapon(boss->gearDrop.sw);
-    deleteArmor(boss->gearDrop.helmet);
-    deleteArmor(boss->gearDrop.guard);
-    deleteArmor(boss->gearDrop.chestplate);
-    deleteArmor(boss->gearDrop.boots);
-  }
-
-  deleteSkills(boss->skills, BOSS_SKILL_COUNT);
-
-  free(boss);
-
-  return true;
-}
\ No newline at end of file
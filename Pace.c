@@ -0,0 +1,128 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifdef _WIN64
+  #include <windows.h>
+  #include <conio.h>
+  #include <io.h>
+#else
+  #include <time.h>
+  #include <sys/select.h>
+  #include <sys/stat.h>
+#endif
+
+#include "Pace.h"
+
+
+#define MAX_PACE 100.0 // The slowest pace, so a scaled delay always fits
+#define UNSET_PACE -1.0f // A category without its own pace follows the global one
+#define POLL_MS 10 // How often Windows checks for a key while waiting
+
+// The names of the categories in a pace spec, in the order of pace_t
+static const char* paceNames[PACE_CATEGORIES] = { "battle", "story", "splash" };
+
+static struct {
+  float scale; // The pace of every category without its own
+  float categories[PACE_CATEGORIES]; // The pace of each category, UNSET_PACE to follow scale
+} pacing = { 1.0f, { UNSET_PACE, UNSET_PACE, UNSET_PACE } };
+
+
+/**
+ * Reads the pace of one item of a spec.
+ * @param start Where the pace starts
+ * @param end Where the item ends
+ * @param out Where to store the pace
+ * @return Whether the whole item was a valid pace
+ */
+static bool parseScale(const char* start, const char* end, float* out) {
+  if (start == end) return false;
+
+  char* stop = NULL;
+  double scale = strtod(start, &stop);
+
+  // Also keeps out nan, which fails both
+  if (stop != end || !(scale >= 0.0 && scale <= MAX_PACE)) return false;
+
+  *out = (float) scale;
+
+  return true;
+}
+
+bool setPace(const char* spec) {
+  float scale = pacing.scale;
+  float categories[PACE_CATEGORIES];
+  memcpy(categories, pacing.categories, sizeof(categories));
+
+  const char* item = spec;
+
+  while (true) {
+    const char* end = item + strcspn(item, ",");
+    const char* eq = memchr(item, '=', end - item);
+
+    if (!eq) {
+      if (!parseScale(item, end, &scale)) return false;
+    } else {
+      int category = -1;
+      for (int i = 0; i < PACE_CATEGORIES; i++) {
+        if (strlen(paceNames[i]) == (size_t) (eq - item) && strncmp(item, paceNames[i], eq - item) == 0) category = i;
+      }
+
+      if (category == -1 || !parseScale(eq + 1, end, &categories[category])) return false;
+    }
+
+    if (*end == '\0') break;
+    item = end + 1;
+  }
+
+  pacing.scale = scale;
+  memcpy(pacing.categories, categories, sizeof(categories));
+
+  return true;
+}
+
+void pace(pace_t category, uint ms) {
+  float scale = (pacing.categories[category] != UNSET_PACE) ? pacing.categories[category] : pacing.scale;
+  uint wait = (uint) (ms * scale + 0.5f);
+
+  if (wait == 0) return;
+
+  // Anything printed has to show before the wait
+  fflush(stdout);
+
+#ifdef _WIN64
+  if (!_isatty(_fileno(stdin))) { Sleep(wait); return; }
+
+  for (uint waited = 0; waited < wait; waited += POLL_MS) {
+    if (_kbhit()) {
+      // Let go of the keys, so the next prompt does not read them
+      while (_kbhit()) _getch();
+      return;
+    }
+
+    Sleep((wait - waited < POLL_MS) ? wait - waited : POLL_MS);
+  }
+#else
+  struct stat in;
+  bool terminal = fstat(fileno(stdin), &in) == 0 && S_ISCHR(in.st_mode);
+
+  if (!terminal) {
+    struct timespec ts = { wait / 1000, (wait % 1000) * 1000000L };
+    nanosleep(&ts, NULL);
+    return;
+  }
+
+  // The terminal hands over whole lines, so stdin is only ready once enter is pressed,
+  // and the line can be let go without blocking
+  fd_set keys;
+  FD_ZERO(&keys);
+  FD_SET(fileno(stdin), &keys);
+
+  struct timeval tv = { wait / 1000, (wait % 1000) * 1000 };
+
+  if (select(fileno(stdin) + 1, &keys, NULL, NULL, &tv) > 0) {
+    int c;
+    while ((c = getchar()) != '\n' && c != EOF);
+  }
+#endif
+}
@@ -0,0 +1,99 @@
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+#include <time.h>
+
+#ifdef _WIN64
+  #include <windows.h>
+#endif
+
+#include "Error.h"
+#include "Setup.h"
+#include "Prefetch.h"
+#include "Workers.h"
+
+
+// The maze being loaded in the background. Only the main thread touches this,
+// the pool only writes maze, which is read after waiting for the task.
+typedef struct Prefetch {
+  str filename; // The map being loaded, NULL if there is none
+  Maze* maze; // The loaded maze, set by the task
+  TaskGroup task; // The task loading it
+} Prefetch;
+
+static Prefetch prefetch = { NULL, NULL, { 0 } };
+
+
+/**
+ * Loads the maze of the prefetch.
+ * @param _prefetch The prefetch
+ */
+static void loadMaze(void* _prefetch) {
+  Prefetch* job = (Prefetch*) _prefetch;
+
+  job->maze = initMaze(job->filename);
+}
+
+/**
+ * Deletes the given maze.
+ * @param _maze The maze
+ */
+static void releaseMaze(void* _maze) {
+  deleteMaze((Maze*) _maze);
+}
+
+void prefetchMaze(str filename) {
+  if (!filename) return;
+
+  if (prefetch.filename) {
+    free(filename);
+    return;
+  }
+
+  prefetch.filename = filename;
+  prefetch.maze = NULL;
+
+  submitTask(&prefetch.task, loadMaze, &prefetch);
+}
+
+Maze* takePrefetchedMaze(const str filename) {
+  if (!prefetch.filename) return NULL;
+
+  // Always wait for the task, even if it loaded some other map
+  waitTasks(&prefetch.task);
+
+  Maze* maze = prefetch.maze;
+  bool wanted = strcmp(prefetch.filename, filename) == 0;
+
+  free(prefetch.filename);
+  prefetch.filename = NULL;
+  prefetch.maze = NULL;
+
+  if (!wanted) {
+    deleteMazeAsync(maze);
+    return NULL;
+  }
+
+  return maze;
+}
+
+void deleteMazeAsync(Maze* maze) {
+  if (!maze) return;
+
+  submitTask(NULL, releaseMaze, maze);
+}
+
+double getTimeMs() {
+#ifdef _WIN64
+  LARGE_INTEGER freq, now;
+  QueryPerformanceFrequency(&freq);
+  QueryPerformanceCounter(&now);
+
+  return (double) now.QuadPart * 1000.0 / freq.QuadPart;
+#else
+  struct timespec now;
+  clock_gettime(CLOCK_MONOTONIC, &now);
+
+  return now.tv_sec * 1000.0 + now.tv_nsec / 1e6;
+#endif
+}
@@ -0,0 +1,163 @@
+#include <stdlib.h>
+#include <time.h>
+
+#include "Random.h"
+#include "Workers.h"
+
+
+#define PCG_MULT 6364136223846793005ULL // The multiplier of the PCG LCG step
+
+// A PCG32 generator. Streams that only differ by their increment are correlated,
+// so what keeps them apart is each starting from its own splitmix draw of the seed.
+typedef struct RandomStream {  // 16B
+  uint64_t state; // Where it is    8B
+  uint64_t inc; // Always odd        8B
+} RandomStream;
+
+// The names the streams are saved under, in the order of rng_t
+static const char* streamNames[RNG_STREAMS] = { "loot", "enemy", "battle", "boss", "shop", "level" };
+
+// Every thread rolls its own streams, so workers never race on them.
+// The game only rolls on its main thread; the simulator seeds each of its workers.
+static THREAD_LOCAL RandomStream streams[RNG_STREAMS];
+static THREAD_LOCAL bool seeded = false;
+
+
+/**
+ * Mixes the seed so close seeds start the streams far apart (splitmix64).
+ * @param x The value to mix, moved on to the next one
+ * @return The mixed value
+ */
+static uint64_t splitMix(uint64_t* x) {
+  uint64_t z = (*x += 0x9E3779B97F4A7C15ULL);
+  z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+  z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+
+  return z ^ (z >> 31);
+}
+
+/**
+ * Rolls the next 32 bits of the stream (PCG XSH RR).
+ * @param rng The stream
+ * @return The roll
+ */
+static inline uint nextU32(RandomStream* rng) {
+  uint64_t old = rng->state;
+  rng->state = old * PCG_MULT + rng->inc;
+
+  uint32_t xorShifted = (uint32_t) (((old >> 18) ^ old) >> 27);
+  uint32_t rot = (uint32_t) (old >> 59);
+
+  return (xorShifted >> rot) | (xorShifted << ((-rot) & 31));
+}
+
+/**
+ * Rolls below the bound, rejecting the few rolls that would favor the low numbers.
+ * @param rng The stream
+ * @param bound The bound, not 0
+ * @return The roll
+ */
+static inline uint nextBelow(RandomStream* rng, uint bound) {
+  uint threshold = (uint) (-bound) % bound;
+
+  while (true) {
+    uint r = nextU32(rng);
+    if (r >= threshold) return r % bound;
+  }
+}
+
+/**
+ * Gets the stream, seeding every stream from the clock if nothing was seeded yet.
+ * @param stream The stream
+ * @return The stream
+ */
+static inline RandomStream* getStream(rng_t stream) {
+  if (!seeded) seedRandom(clockSeed());
+
+  return &streams[stream];
+}
+
+void seedRandom(uint64_t seed) {
+  uint64_t x = seed;
+
+  for (int i = 0; i < RNG_STREAMS; i++) {
+    RandomStream* rng = &streams[i];
+
+    // Same as pcg32_srandom, with the stream picking the increment
+    rng->inc = ((uint64_t) i << 1) | 1;
+    rng->state = 0;
+    nextU32(rng);
+    rng->state += splitMix(&x);
+    nextU32(rng);
+  }
+
+  seeded = true;
+}
+
+uint64_t clockSeed() {
+  uint64_t x = (uint64_t) time(NULL);
+
+  // clock() tells apart games started within the same second
+  x ^= (uint64_t) clock() << 32;
+
+  return splitMix(&x);
+}
+
+uint randomU32(rng_t stream) {
+  return nextU32(getStream(stream));
+}
+
+uint randomBelow(rng_t stream, uint bound) {
+  RandomStream* rng = getStream(stream);
+
+  return (bound == 0) ? nextU32(rng) : nextBelow(rng, bound);
+}
+
+uint randomRange(rng_t stream, uint lo, uint hi) {
+  return lo + randomBelow(stream, hi - lo + 1);
+}
+
+float randomFloat(rng_t stream) {
+  // The top 24 bits fill the mantissa exactly
+  return (nextU32(getStream(stream)) >> 8) * (1.0f / 16777216.0f);
+}
+
+void randomFill(rng_t stream, uint* out, uint n) {
+  RandomStream rng = *getStream(stream);
+
+  // Kept local so the state stays in registers
+  for (uint i = 0; i < n; i++) out[i] = nextU32(&rng);
+
+  streams[stream] = rng;
+}
+
+void randomFillBelow(rng_t stream, uint* out, uint n, uint bound) {
+  if (bound == 0) { randomFill(stream, out, n); return; }
+
+  RandomStream rng = *getStream(stream);
+
+  for (uint i = 0; i < n; i++) out[i] = nextBelow(&rng, bound);
+
+  streams[stream] = rng;
+}
+
+void randomFillFloat(rng_t stream, float* out, uint n) {
+  RandomStream rng = *getStream(stream);
+
+  for (uint i = 0; i < n; i++) out[i] = (nextU32(&rng) >> 8) * (1.0f / 16777216.0f);
+
+  streams[stream] = rng;
+}
+
+const char* randomStreamName(rng_t stream) {
+  return streamNames[stream];
+}
+
+uint64_t getRandomState(rng_t stream) {
+  return getStream(stream)->state;
+}
+
+void setRandomState(rng_t stream, uint64_t state) {
+  // The increment only depends on the stream, so the state is all there is to restore
+  getStream(stream)->state = state;
+}
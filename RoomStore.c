@@ -0,0 +1,121 @@
+#include <stdlib.h>
+#include <string.h>
+
+#include "Maze.h"
+#include "Error.h"
+
+#define ROOM_STORE_INIT_CAP 64 // The capacity of a store with no size given
+
+
+/**
+ * Resizes one of the arrays of the store.
+ * @param array The array
+ * @param cap The new capacity
+ * @param size The size of an element
+ * @return The resized array
+ */
+static void* resizeArray(void* array, uint cap, size_t size) {
+  void* temp = realloc(array, (size_t) cap * size);
+  if (!temp) handleError(ERR_MEM, FATAL, "Could not allocate space for the rooms!\n");
+
+  return temp;
+}
+
+/**
+ * Resizes every array of the store to the given capacity.
+ * @param rooms The store
+ * @param cap The new capacity
+ */
+static void resizeRoomStore(RoomStore* rooms, uint cap) {
+  rooms->exits = (RoomExits*) resizeArray(rooms->exits, cap, sizeof(RoomExits));
+  rooms->flags = (uchar*) resizeArray(rooms->flags, cap, sizeof(uchar));
+  rooms->enemies = (EnemyU*) resizeArray(rooms->enemies, cap, sizeof(EnemyU));
+  rooms->loot = (Item**) resizeArray(rooms->loot, cap, sizeof(Item*));
+  rooms->tables = (RoomTables**) resizeArray(rooms->tables, cap, sizeof(RoomTables*));
+  rooms->ids = (uint*) resizeArray(rooms->ids, cap, sizeof(uint));
+  rooms->info = (str*) resizeArray(rooms->info, cap, sizeof(str));
+  rooms->storyFiles = (str*) resizeArray(rooms->storyFiles, cap, sizeof(str));
+  rooms->pos = (RoomPos*) resizeArray(rooms->pos, cap, sizeof(RoomPos));
+  rooms->seen = (uint64_t*) resizeArray(rooms->seen, (cap + 63) / 64, sizeof(uint64_t));
+
+  rooms->cap = cap;
+}
+
+void initRoomStore(RoomStore* rooms, uint cap) {
+  memset(rooms, 0, sizeof(RoomStore));
+
+  if (cap == 0) cap = ROOM_STORE_INIT_CAP;
+
+  resizeRoomStore(rooms, cap);
+}
+
+uint addRoom(RoomStore* rooms, uint id, str info, str storyFile, uchar flags) {
+  if (rooms->len == rooms->cap) {
+    // Slots are rooms, so there can never be more than MAX_ROOM_ID + 1 of them
+    if (rooms->cap > MAX_ROOM_ID) handleError(ERR_DATA, FATAL, "Too many rooms!\n");
+
+    uint cap = rooms->cap * 2;
+    if (cap > MAX_ROOM_ID + 1U) cap = MAX_ROOM_ID + 1U;
+
+    resizeRoomStore(rooms, cap);
+  }
+
+  uint slot = rooms->len++;
+
+  memset(rooms->exits[slot], 0xFF, sizeof(RoomExits));
+  rooms->flags[slot] = flags;
+  rooms->enemies[slot].enemy = NULL;
+  rooms->loot[slot] = NULL;
+  rooms->tables[slot] = NULL;
+  rooms->ids[slot] = id;
+  rooms->info[slot] = info;
+  rooms->storyFiles[slot] = storyFile;
+  rooms->pos[slot] = (RoomPos) { NO_POS, NO_POS };
+  rooms->seen[slot >> 6] &= ~(1ULL << (slot & 63));
+
+  return slot;
+}
+
+uint connectRooms(RoomStore* rooms, Table* ids) {
+  // For a given room, iterate through its exits to connect
+  for (uint i = 0; i < rooms->len; i++) {
+    uint* exits = rooms->exits[i];
+
+    for (int j = 0; j < 4; j++) {
+      // Skip the ones that have no exit, keep them at NO_ROOM
+      if (exits[j] == NO_ROOM) continue;
+
+      uint id = exits[j];
+      uint slot = lookupRoom(ids, id);
+
+      if (slot == NO_ROOM) handleError(ERR_DATA, FATAL, "Room %u: exit to room %u, which does not exist!\n", rooms->ids[i], id);
+
+      exits[j] = slot;
+    }
+  }
+
+  return lookupRoom(ids, 0);
+}
+
+void setRoomSeen(RoomStore* rooms, uint room) {
+  rooms->seen[room >> 6] |= 1ULL << (room & 63);
+}
+
+bool roomSeen(const RoomStore* rooms, uint room) {
+  return (rooms->seen[room >> 6] >> (room & 63)) & 1;
+}
+
+void deleteRoomStore(RoomStore* rooms) {
+  free(rooms->exits);
+  free(rooms->flags);
+  free(rooms->enemies);
+  free(rooms->loot);
+  free(rooms->tables);
+  free(rooms->ids);
+  free(rooms->info);
+  free(rooms->storyFiles);
+  free(rooms->pos);
+  free(rooms->seen);
+
+  memset(rooms, 0, sizeof(RoomStore));
+}
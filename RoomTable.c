@@ -1,67 +1,163 @@
 #include <stdlib.h>
 #include <stdio.h>
+#include <stdint.h>
 #include <string.h>
 
 #include "Maze.h"
 #include "Error.h"
 
 #define ROOM_MULT 5 // By how much should room count increase
+#define TABLE_SPARSE_MIN 1024 // Ids below this always fit a direct table
+#define TABLE_SPARSE_RATIO 4 // A direct table holds at most this many slots per room, sparser ids are hashed
+#define TABLE_HASH_MIN 8 // The smallest hashed table
+
+
+/**
+ * Allocates the arrays of the table, every bucket empty.
+ * @param table The table
+ * @param cap The capacity
+ * @param hashed Whether the table is hashed, and keeps the id of each bucket
+ * @return Whether it could be allocated
+ */
+static bool allocTable(Table* table, uint cap, bool hashed) {
+  table->slots = (uint*) malloc((size_t) cap * sizeof(uint));
+  table->ids = hashed ? (uint*) malloc((size_t) cap * sizeof(uint)) : NULL;
+
+  if (!table->slots || (hashed && !table->ids)) {
+    free(table->slots);
+    free(table->ids);
+    return false;
+  }
+
+  // Every byte 0xFF is NO_ROOM
+  memset(table->slots, 0xFF, (size_t) cap * sizeof(uint));
+
+  table->cap = cap;
+  table->len = 0;
+
+  return true;
+}
+
+/**
+ * Gets the capacity of a hashed table for the given amount of rooms, which keeps it at most half full.
+ * @param count The amount of rooms
+ * @return A power of two
+ */
+static uint hashCap(uint count) {
+  uint cap = TABLE_HASH_MIN;
+  while (cap / 2 < count) cap *= 2;
+
+  return cap;
+}
+
+/**
+ * Finds the bucket of the id in a hashed table, or the empty bucket it would go in.
+ * @param table The hashed table
+ * @param id The room id
+ * @return The bucket
+ */
+static uint findBucket(Table* table, uint id) {
+  uint mask = table->cap - 1;
+  // The high half of a Fibonacci hash mixes ids that are far apart by powers of two
+  uint i = (uint) (((uint64_t) id * 0x9E3779B97F4A7C15ULL) >> 32) & mask;
+
+  while (table->slots[i] != NO_ROOM && table->ids[i] != id) i = (i + 1) & mask;
+
+  return i;
+}
+
+/**
+ * Moves every room of the table into a hashed table with the given capacity.
+ * @param table The table, direct or hashed
+ * @param cap The new capacity, a power of two
+ */
+static void rehashTable(Table* table, uint cap) {
+  Table old = *table;
+
+  if (!allocTable(table, cap, true)) handleError(ERR_MEM, FATAL, "Could not reallocate space!\n");
+
+  for (uint i = 0; i < old.cap; i++) {
+    if (old.slots[i] == NO_ROOM) continue;
+
+    uint id = old.ids ? old.ids[i] : i;
+    uint bucket = findBucket(table, id);
+
+    table->ids[bucket] = id;
+    table->slots[bucket] = old.slots[i];
+    table->len++;
+  }
+
+  free(old.slots);
+  free(old.ids);
+}
+
+/**
+ * Grows a direct table to fit the id.
+ * @param table The direct table
+ * @param id The room id
+ */
+static void growTable(Table* table, uint id) {
+  // Doubling keeps loading n rooms to a handful of reallocs
+  uint cap = table->cap + ROOM_MULT;
+  if (cap < table->cap * 2) cap = table->cap * 2;
+  if (cap <= id || cap > MAX_ROOM_ID) cap = id + 1;
+
+  uint* temp = (uint*) realloc(table->slots, (size_t) cap * sizeof(uint));
+  if (!temp) handleError(ERR_MEM, FATAL, "Could not reallocate space!\n");
+  table->slots = temp;
+
+  void* startingPoint = (table->slots) + (table->cap);
+  memset(startingPoint, 0xFF, (size_t) (cap - table->cap) * sizeof(uint));
+
+  table->cap = cap;
+}
 
 Table* initTable() {
   Table* table = (Table*) malloc(sizeof(Table));
 
   if (!table) return NULL;
 
-  table->rooms = (Room**) calloc(ROOM_MULT, sizeof(Room*));
-  if (!table->rooms) {
+  if (!allocTable(table, ROOM_MULT, false)) {
     free(table);
     return NULL;
   }
 
-  table->cap = ROOM_MULT;
-  table->len = 0;
-
   return table;
 }
 
-Table* initTableL(int size) {
+Table* initTableL(uint count, uint maxId) {
   Table* table = (Table*) malloc(sizeof(Table));
 
   if (!table) return NULL;
 
-  table->rooms = (Room**) calloc(size, sizeof(Room*));
-  if (!table->rooms) {
+  // Ids mostly in use are indexed directly, otherwise only the rooms take up space
+  bool hashed = maxId >= TABLE_SPARSE_MIN && maxId / TABLE_SPARSE_RATIO >= count;
+  uint cap = hashed ? hashCap(count) : maxId + 1;
+
+  if (!allocTable(table, cap, hashed)) {
     free(table);
     return NULL;
   }
 
-  table->cap = size;
-  table->len = 0;
-
   return table;
 }
 
-bool putRoom(Table* table, Room* room, bool overwrite) {
-  // Once the length matches the capacity, increase the capacity
-  // Note that there might not be a reason to increase the size, if there are only current [cap] rooms in the maze
-  //   which it will increase the size no matter what (will add or no longer will add).
-  // However, it is only 40 bytes extra, plus some space and time overhead, and it will all get freed anyway
-  if (table->len == table->cap) {
-    Room** temp = (Room**) realloc(table->rooms, (table->cap+ROOM_MULT)*sizeof(Room*));
-    if (!temp) handleError(ERR_MEM, FATAL, "Could not reallocate space!\n");
-    table->rooms = temp;
+bool putRoom(Table* table, uint id, uint slot, bool overwrite) {
+  if (id > MAX_ROOM_ID) handleError(ERR_DATA, FATAL, "Room id %u is too big!\n", id);
 
-    void* startingPoint = (table->rooms) + (table->len);
-    memset(startingPoint, 0x0, ROOM_MULT*sizeof(Room*));
-
-    table->cap += ROOM_MULT;
+  if (!table->ids && id >= table->cap) {
+    // Growing to reach a far away id would leave the table mostly empty
+    if (id >= TABLE_SPARSE_MIN && id / TABLE_SPARSE_RATIO >= table->len + 1) rehashTable(table, hashCap(table->len + 1));
+    else growTable(table, id);
+  } else if (table->ids && (table->len + 1) > table->cap / 2) {
+    rehashTable(table, table->cap * 2);
   }
 
-  byte id = room->id;
-  Room* _room = table->rooms[(int) id];
+  uint i = table->ids ? findBucket(table, id) : id;
 
-  if (!_room) { // Room does not exist, add it
-    table->rooms[(int) id] = room;
+  if (table->slots[i] == NO_ROOM) { // Room does not exist, add it
+    if (table->ids) table->ids[i] = id;
+    table->slots[i] = slot;
     table->len++;
 
     return true;
@@ -70,34 +166,25 @@ bool putRoom(Table* table, Room* room, bool overwrite) {
     // Note that even though the rooms may have the same id, their contents (loot table, enemy table, etc) may be different.
     // This only happens when initializing the maze and there are two rooms in the json file with the same id (maybe be unlikely)
     // Current behaviour is just to not add it and keep the room
+    // The loaders check for this before adding the room to the store
 
-    deleteRoom(room);
     return false;
   }
 
   return false;
 }
 
+uint lookupRoom(Table* table, uint id) {
+  if (!table->ids) return (id < table->cap) ? table->slots[id] : NO_ROOM;
+
+  return table->slots[findBucket(table, id)];
+}
+
 void deleteTable(Table* table) {
   if (!table) return;
 
-  free(table->rooms);
+  free(table->slots);
+  free(table->ids);
   free(table);
   table = NULL;
 }
-
-void addAndRecurse(Room* room, Table* table) {
-  if (room != (void*) ((long long) NO_EXIT)) {
-    bool inTable = putRoom(table, room, false);
-
-    // Prevent stack overflow by not going to rooms that have been inserted to the table
-    //  although their exits may not be in table
-    //  they'll be check by other paths
-    // NOTE: Need to see behaviour for larger maps!!
-    if (inTable) {
-      for (int i = 0; i < 4; i++) {
-        addAndRecurse(room->exits[i], table);
-      }
-    }
-  }
-}
\ No newline at end of file
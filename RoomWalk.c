@@ -0,0 +1,91 @@
+#include <stdlib.h>
+#include <string.h>
+
+#include "Error.h"
+#include "RoomWalk.h"
+
+
+// The offset of the room behind each exit, in the order of RoomExits
+static const int exitX[4] = { 0, 1, 0, -1 };
+static const int exitY[4] = { -1, 0, 1, 0 };
+
+// The state of a walk
+typedef struct RoomWalk {
+  RoomExits* exits; // The exits of every room of the maze
+  WalkStep* work; // The queued rooms, BFS takes from head and DFS from the end
+  uint head; // The next room for BFS
+  uint len; // Number of queued rooms
+  uint cap; // Capacity of work
+  uint64_t* visited; // Bit n is set once the room in slot n was queued
+} RoomWalk;
+
+
+/**
+ * Queues the room if it was not queued before.
+ * @param walk The walk
+ * @param room The slot of the room, or NO_ROOM
+ * @param x Where the room is
+ * @param y Where the room is
+ */
+static void queueRoom(RoomWalk* walk, uint room, int x, int y) {
+  if (room == NO_ROOM) return;
+
+  uint64_t bit = (uint64_t) 1 << (room % 64);
+  if (walk->visited[room / 64] & bit) return;
+
+  walk->visited[room / 64] |= bit;
+
+  if (walk->len == walk->cap) {
+    WalkStep* temp = (WalkStep*) realloc(walk->work, walk->cap * 2 * sizeof(WalkStep));
+    if (!temp) handleError(ERR_MEM, FATAL, "Could not reallocate space for the walk!\n");
+
+    walk->work = temp;
+    walk->cap *= 2;
+  }
+
+  WalkStep* step = &walk->work[walk->len++];
+  step->room = room;
+  step->x = x;
+  step->y = y;
+}
+
+uint walkRooms(Maze* maze, uint start, walk_t order, walk_f visit, void* ctx) {
+  RoomWalk walk;
+  walk.exits = maze->rooms.exits;
+  walk.head = 0;
+  walk.len = 0;
+  walk.cap = WALK_INIT_CAP;
+
+  // Slots are dense, so the bitset is sized once
+  walk.work = (WalkStep*) malloc(walk.cap * sizeof(WalkStep));
+  walk.visited = (uint64_t*) calloc((maze->rooms.len / 64) + 1, sizeof(uint64_t));
+  if (!walk.work || !walk.visited) handleError(ERR_MEM, FATAL, "Could not allocate space for the walk!\n");
+
+  uint stoppedAt = NO_ROOM;
+
+  if (start < maze->rooms.len) queueRoom(&walk, start, 0, 0);
+
+  while (walk.head < walk.len) {
+    // Both orders copy the step out, since queueing may move the work queue
+    WalkStep step = (order == WALK_BFS) ? walk.work[walk.head++] : walk.work[--walk.len];
+
+    walk_action_t action = visit(&step, ctx);
+
+    if (action == WALK_STOP) { stoppedAt = step.room; break; }
+    if (action == WALK_SKIP) continue;
+
+    uint* exits = walk.exits[step.room];
+
+    if (order == WALK_BFS) {
+      for (int i = 0; i < 4; i++) queueRoom(&walk, exits[i], step.x + exitX[i], step.y + exitY[i]);
+    } else {
+      // Reversed so the first exit is on top, and walked first
+      for (int i = 3; i >= 0; i--) queueRoom(&walk, exits[i], step.x + exitX[i], step.y + exitY[i]);
+    }
+  }
+
+  free(walk.work);
+  free(walk.visited);
+
+  return stoppedAt;
+}
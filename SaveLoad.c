@@ -2,12 +2,13 @@
 #include <stdio.h>
 #include <string.h>
 #include <stdlib.h>
+#include <inttypes.h>
 
 #include "SaveLoad.h"
 #include "LoadJSON.h"
 #include "Error.h"
 #include "Setup.h"
-#include "DArray.h"
+#include "Random.h"
 
 
 #define NO_ITEM 0x0
@@ -35,6 +36,9 @@
 #define LOOT "loot"
 #define ENEMY "enemy"
 #define HAS_BOSS "hasBoss"
+#define POS "pos"
+#define VISITED "visited"
+#define RNG "rng"
 
 const str SAVE_DIR = "./data/saves";
 
@@ -63,29 +67,6 @@ static str createError(cJSON* obj, const str type) {
   return NULL;
 }
 
-/**
- * Finds a room with the given ID.
- * @param room The room to look at
- * @param id The target ID
- * @return Room with matching ID
- */
-static Room* findRoom(Room* room, byte id, DArray* visited) {
-  if (room != (void*) ((long long) NO_EXIT)) {
-    if (room->id == id) return room;
-
-    if (dArrayExists(visited, room->id)) return NULL;
-
-    dArrayAdd(visited, room->id);
-
-    for (int i = 0; i < 4; i++) {
-      Room* target = findRoom(room->exits[i], id, visited);
-      if (target != NULL) return target;
-    }
-  }
-
-  return NULL;
-}
-
 /**
  * 
  * @param parentObj 
@@ -287,6 +268,20 @@ static cJSON* saveLoot(Item* loot) {
   return _loot;
 }
 
+/**
+ * Writes a loot record the way the item it rolls into is written.
+ * @param rec The loot record
+ * @return The loot entry
+ */
+static cJSON* saveLootRecord(const LootRecord* rec) {
+  Item* item = createLootItem(NULL, rec);
+
+  cJSON* loot = saveLoot(item);
+  deleteItem(item);
+
+  return loot;
+}
+
 /**
  * 
  * @param parentObj 
@@ -422,55 +417,101 @@ static bool saveSkillTree(cJSON* parentObj, SkillTree* data) {
 }
 
 /**
- * 
- * @param _enemy 
- * @param hasBoss 
- * @return 
+ * Adds where every RNG stream is, so a loaded game continues the same rolls.
+ * The states are hex strings, since a JSON number cannot hold all 64 bits.
+ * @param parentObj The object to add to
+ * @return True if it was added, false otherwise
  */
-static cJSON* saveEnemy(EnemyU* _enemy, bool hasBoss) {
-  /**
-   * NOTE
-   * enemy union contains an address, either to Enemy or Boss,
-   * but an address nonetheless. Thus no matter which type,
-   * it'll still lead to the object.
-   * Considering Boss has the Enemy structure at the beginning,
-   * its data will be in the same relative order as a regular Enemy
-   * Thus, doing _enemy->enemy->[] will do the same pointer arithmetic
-   * as _enemy->boss->base->[].
-   * However, since Boss has 240B of data more than Enemy,
-   * that will need to be saved using the lens as Boss.
-   */
+static bool saveRandom(cJSON* parentObj) {
+  cJSON* rng = cJSON_AddObjectToObject(parentObj, RNG);
+  if (!rng) return false;
 
+  char state[17];
+  for (int i = 0; i < RNG_STREAMS; i++) {
+    snprintf(state, sizeof(state), "%016" PRIx64, getRandomState(i));
+
+    if (!cJSON_AddStringToObject(rng, randomStreamName(i), state)) return false;
+  }
 
+  return true;
+}
+
+/**
+ * Adds a stat of an enemy as a single value or a [min, max] range, the way maps store them.
+ * @param parentObj The object to add to
+ * @param key The stat key
+ * @param lo The lower limit, or the value
+ * @param hi The upper limit
+ * @param ranged Whether to save the range
+ * @return True if it was added, false otherwise
+ */
+static bool saveRange(cJSON* parentObj, const str key, double lo, double hi, bool ranged) {
+  cJSON* arr = cJSON_AddArrayToObject(parentObj, key);
+  if (!arr) { createError(parentObj, key); return false; }
+
+  cJSON* low = cJSON_CreateNumber(lo);
+  if (!low || !cJSON_AddItemToArray(arr, low)) { createError(parentObj, key); return false; }
+  if (!ranged) return true;
+
+  cJSON* high = cJSON_CreateNumber(hi);
+  if (!high || !cJSON_AddItemToArray(arr, high)) { createError(parentObj, key); return false; }
+
+  return true;
+}
+
+/**
+ * Adds the stat ranges of the enemy template.
+ * @param parentObj The enemy object
+ * @param tmpl The template
+ * @return True if they were added, false otherwise
+ */
+static bool saveStatRanges(cJSON* parentObj, EnemyTemplate* tmpl) {
+  cJSON* stats = cJSON_AddObjectToObject(parentObj, "stats");
+  if (!stats) { createError(parentObj, "stats"); return false; }
+
+  return saveRange(stats, "ATK", tmpl->atk[0], tmpl->atk[1], tmpl->ranged & RANGED_ATK) &&
+    saveRange(stats, "DEF", tmpl->def[0], tmpl->def[1], tmpl->ranged & RANGED_DEF) &&
+    saveRange(stats, "ACC", tmpl->acc[0], tmpl->acc[1], tmpl->ranged & RANGED_ACC) &&
+    saveRange(stats, "ATK_CRIT_DMG", tmpl->atkCritDmg[0], tmpl->atkCritDmg[1], tmpl->ranged & RANGED_CRIT_DMG) &&
+    saveRange(stats, "ATK_CRIT", tmpl->atkCrit[0], tmpl->atkCrit[1], tmpl->ranged & RANGED_CRIT);
+}
+
+/**
+ * Creates the enemy object, the same way maps define enemies.
+ * @param tmpl The template of the enemy
+ * @param rolled The rolled enemy, whose values get saved as single values.
+ *  NULL to save the ranges of the template instead
+ * @return The enemy object
+ */
+static cJSON* saveEnemy(EnemyTemplate* tmpl, Enemy* rolled) {
   cJSON* enemy = cJSON_CreateObject();
   if (!enemy) { createError(enemy, "enemy"); return NULL; }
 
-  cJSON* name = cJSON_AddStringToObject(enemy, NAME, _enemy->enemy->name);
+  cJSON* name = cJSON_AddStringToObject(enemy, NAME, tmpl->name);
   if (!name) { createError(enemy, "enemy name"); return NULL; }
 
-  cJSON* xpPoints = cJSON_AddNumberToObject(enemy, "xpPoints", _enemy->enemy->xpPoints);
+  cJSON* xpPoints = cJSON_AddNumberToObject(enemy, "xpPoints", tmpl->xpPoints);
   if (!xpPoints) { createError(enemy, "enemy xpPoints"); return NULL; }
 
-  cJSON* hpArr = cJSON_AddArrayToObject(enemy, HP);
-  if (!hpArr) { createError(enemy, "enemy hp container"); return NULL; }
-  cJSON* hp = cJSON_CreateNumber(_enemy->enemy->hp);
-  if (!hp) { createError(enemy, "enemy hp value"); return NULL; }
-  if (!cJSON_AddItemToArray(hpArr, hp)) { createError(enemy, "enemy hp"); return NULL; }
+  bool hp;
+  if (rolled) hp = saveRange(enemy, HP, rolled->hp, rolled->hp, false);
+  else hp = saveRange(enemy, HP, tmpl->hp[0], tmpl->hp[1], tmpl->ranged & RANGED_HP);
+  if (!hp) { createError(enemy, "enemy hp"); return NULL; }
 
-  cJSON* lvl = cJSON_AddNumberToObject(enemy, LVL, _enemy->enemy->lvl);
+  cJSON* lvl = cJSON_AddNumberToObject(enemy, LVL, tmpl->lvl);
   if (!lvl) { createError(enemy, "enemy lvl"); return NULL; }
 
-  bool stats = saveStats(enemy, _enemy->enemy->stats);
+  bool stats = (rolled) ? saveStats(enemy, &rolled->stats) : saveStatRanges(enemy, tmpl);
   if (!stats) { createError(enemy, "enemy stats"); return NULL; }
 
-  if (hasBoss) {
-    bool gear = saveGear(enemy, &_enemy->boss->gearDrop);
+  if (tmpl->boss) {
+    bool gear = saveGear(enemy, &tmpl->boss->gearDrop);
     if (!gear) return NULL;
 
     cJSON* skills = cJSON_AddArrayToObject(enemy, "skills");
     if (!skills) { createError(enemy, "boss skills"); return NULL; }
-    for (int i = 0; i < 5; i++) {
-      cJSON* skill = saveSkill(&_enemy->boss->skills[i]);
+    for (int i = 0; i < BOSS_SKILL_COUNT; i++) {
+      cJSON* skill = saveSkill(&tmpl->boss->skills[i]);
       if (!skill) return NULL;
 
       if (!cJSON_AddItemToArray(skills, skill)) { createError(enemy, "skill in boss skills"); return NULL; }
@@ -480,21 +521,10 @@ static cJSON* saveEnemy(EnemyU* _enemy, bool hasBoss) {
   return enemy;
 }
 
-/**
- * Creates the maze state for saving.
- * @return The maze as a JSON string
- */
-static str createMapState() {
-  Table* table = initTableL(maze->size);
-  if (!table) handleError(ERR_MEM, FATAL, "Could not allocate space for the table!\n");
+str createMapState(Maze* maze) {
+  // The store has every room, reachable or not
+  RoomStore* rooms = &maze->rooms;
 
-  Room* room = maze->entry;
-  addAndRecurse(room, table);
-  room = NULL;
-
-  if (table->len != maze->size) { handleError(ERR_DATA, WARNING, "Table size %d does not equal maze size! %d\n", table->len, maze->size); return NULL; }
-
-  // The table SHOULD have all of the rooms
   // Time to create the JSON object
   cJSON* mapObj = cJSON_CreateObject();
   if (!mapObj) return createError(mapObj, "map");
@@ -502,54 +532,96 @@ static str createMapState() {
   cJSON* mapName = cJSON_AddStringToObject(mapObj, "name", maze->name);
   if (!mapName) return createError(mapName, "map name");
 
-  for (int i = 0; i < table->len; i++) {
-    room = table->rooms[i];
+  // Rooms are written in the order they were loaded
+  for (uint room = 0; room < rooms->len; room++) {
     // Creating each room
+    uint id = rooms->ids[room];
 
-    char buffer[2];
-    str idAsChar = itoa(room->id, buffer, 10);
+    char idAsChar[11]; // Up to MAX_ROOM_ID
+    sprintf(idAsChar, "%u", id);
 
     cJSON* roomObj = cJSON_AddObjectToObject(mapObj, idAsChar);
     if (!roomObj) return createError(mapObj, idAsChar);
 
-    cJSON* storyfile = cJSON_AddStringToObject(roomObj, "storyfile", (room->storyFile != NULL) ? room->storyFile : "");
+    str storyFile = rooms->storyFiles[room];
+    cJSON* storyfile = cJSON_AddStringToObject(roomObj, "storyfile", (storyFile != NULL) ? storyFile : "");
     if (!storyfile) return createError(mapObj, "storyfile");
 
-    cJSON* isEntry = cJSON_AddNumberToObject(roomObj, IS_ENTRY, (room->id == 0) ? 1 : 0);
+    cJSON* isEntry = cJSON_AddNumberToObject(roomObj, IS_ENTRY, (id == 0) ? 1 : 0);
     if (!isEntry) return createError(mapObj, IS_ENTRY);
 
-    cJSON* info = cJSON_AddStringToObject(roomObj, INFO, room->info);
+    cJSON* info = cJSON_AddStringToObject(roomObj, INFO, rooms->info[room]);
     if (!info) return createError(mapObj, INFO);
 
-    cJSON* hasBoss = cJSON_AddNumberToObject(roomObj, HAS_BOSS, (room->hasBoss) ? 1 : 0);
+    cJSON* hasBoss = cJSON_AddNumberToObject(roomObj, HAS_BOSS, (rooms->flags[room] & ROOM_BOSS) ? 1 : 0);
     if (!hasBoss) return createError(mapObj, HAS_BOSS);
 
     cJSON* exits = cJSON_AddArrayToObject(roomObj, EXITS);
     if (!exits) return createError(mapObj, EXITS);
     for (int i = 0; i < 4; i++) {
-      Room* roomExit = room->exits[i];
+      uint roomExit = rooms->exits[room][i];
 
-      cJSON* exit = cJSON_CreateNumber((roomExit == (void*)((long long)NO_EXIT) ? -1 : roomExit->id));
+      cJSON* exit = cJSON_CreateNumber((roomExit == NO_ROOM) ? -1 : (double) rooms->ids[roomExit]);
       if (!exit) return createError(mapObj, "exit");
 
       if (!cJSON_AddItemToArray(exits, exit)) return createError(mapObj, "exit in exits");
     }
 
+    // Where the room is drawn, so the loaded map is not laid out again
+    RoomPos pos = rooms->pos[room];
+    if (pos.x != NO_POS) {
+      int xy[2] = { pos.x, pos.y };
+
+      cJSON* _pos = cJSON_CreateIntArray(xy, 2);
+      if (!_pos || !cJSON_AddItemToObject(roomObj, POS, _pos)) return createError(mapObj, POS);
+    }
+
+    // Only the rooms out of the fog are marked
+    if (roomSeen(rooms, room) && !cJSON_AddNumberToObject(roomObj, VISITED, 1)) return createError(mapObj, VISITED);
+
+    // A room not entered yet keeps its whole tables, so its loot and enemy get rolled after loading
+    // Nothing is rolled here, so saving leaves the RNG streams where they were
+    RoomTables* tables = rooms->tables[room];
+    if (tables) {
+      cJSON* loot = cJSON_AddArrayToObject(roomObj, LOOT);
+      if (!loot) return createError(mapObj, LOOT);
+      for (uint j = 0; j < tables->lootCount; j++) {
+        LootRecord rec;
+        readRoomLoot(maze, tables, j, &rec);
+
+        cJSON* _loot = saveLootRecord(&rec);
+        if (!_loot) return createError(mapObj, "item loot");
+        if (!cJSON_AddItemToArray(loot, _loot)) return createError(mapObj, "item loot in loot");
+      }
+
+      // The enemies were read into the catalog, so write their templates back
+      cJSON* enemy = cJSON_AddArrayToObject(roomObj, ENEMY);
+      if (!enemy) return createError(mapObj, ENEMY);
+      for (uint j = 0; j < tables->enemyCount; j++) {
+        cJSON* enemyEntity = saveEnemy(&maze->catalog.templates[tables->enemies[j]], NULL);
+        if (!enemyEntity) return createError(mapObj, "enemy entity");
+        if (!cJSON_AddItemToArray(enemy, enemyEntity)) return createError(mapObj, "enemy entity in enemy");
+      }
+
+      continue;
+    }
+
     // Create the arrays just to be in compliance to format
     // But no need to add when none are present
 
     cJSON* loot = cJSON_AddArrayToObject(roomObj, LOOT);
     if (!loot) return createError(mapObj, LOOT);
-    if (room->loot != NULL) {
-      cJSON* _loot = saveLoot(room->loot);
+    if (rooms->loot[room] != NULL) {
+      cJSON* _loot = saveLoot(rooms->loot[room]);
       if (!_loot) return createError(mapObj, "item loot");
       if (!cJSON_AddItemToArray(loot, _loot)) return createError(mapObj, "item loot in loot");
     }
 
     cJSON* enemy = cJSON_AddArrayToObject(roomObj, ENEMY);
     if (!enemy) return createError(mapObj, ENEMY);
-    if (room->enemy.enemy != NULL) {
-      cJSON* enemyEntity = saveEnemy(&(room->enemy), room->hasBoss);
+    Enemy* roomEnemy = rooms->enemies[room].enemy;
+    if (roomEnemy != NULL) {
+      cJSON* enemyEntity = saveEnemy(getEnemyTemplate(maze, roomEnemy), roomEnemy);
       if (!enemyEntity) return createError(mapObj, "enemy entity");
       if (!cJSON_AddItemToArray(enemy, enemyEntity)) return createError(mapObj, "enemy entity in enemy");
     }
@@ -558,7 +630,6 @@ static str createMapState() {
   str mapState = cJSON_Print(mapObj);
 
   cJSON_Delete(mapObj);
-  deleteTable(table);
 
   return mapState;
 }
@@ -568,7 +639,7 @@ static str createMapState() {
  * @return True if the map was saved, false otherwise
  */
 static bool saveMap() {
-  str mapState = createMapState();
+  str mapState = createMapState(maze);
   if (!mapState) handleError(ERR_DATA, WARNING, "Could not create map state!\n");
 
   if (mapState) {
@@ -626,7 +697,7 @@ static str createPlayerState() {
 
   cJSON* playerRoom = cJSON_AddObjectToObject(playerObj, ROOM);
   if (!playerRoom) return createError(playerObj, ROOM);
-  cJSON* roomId = cJSON_AddNumberToObject(playerRoom, ID, player->room->id);
+  cJSON* roomId = cJSON_AddNumberToObject(playerRoom, ID, maze->rooms.ids[player->room]);
   if (!roomId) return createError(playerObj, ID);
   // Look at comment of loading map stuff when loading player
   // // Create the map filename
@@ -691,6 +762,9 @@ static str createPlayerState() {
   bool skillTree = saveSkillTree(playerObj, player->skills);
   if (!skillTree) return createError(playerObj, "player skill tree");
 
+  bool rng = saveRandom(playerObj);
+  if (!rng) return createError(playerObj, RNG);
+
   str playerState = cJSON_Print(playerObj);
 
   cJSON_Delete(playerObj);
@@ -727,6 +801,26 @@ void saveGame() {
   else printf("The game could not be saved!\n");
 }
 
+/**
+ * Restores where every RNG stream was. Saves from before the streams keep them as seeded.
+ * @param root The player data
+ */
+static void loadRandom(cJSON* root) {
+  cJSON* rng = cJSON_GetObjectItemCaseSensitive(root, RNG);
+  if (!rng) return;
+
+  for (int i = 0; i < RNG_STREAMS; i++) {
+    cJSON* state = cJSON_GetObjectItemCaseSensitive(rng, randomStreamName(i));
+    if (!cJSON_IsString(state)) handleError(ERR_DATA, FATAL, "No %s rng data found!\n", randomStreamName(i));
+
+    str end = NULL;
+    uint64_t value = strtoull(state->valuestring, &end, 16);
+    if (*state->valuestring == '\0' || *end != '\0') handleError(ERR_DATA, FATAL, "Invalid %s rng data!\n", randomStreamName(i));
+
+    setRandomState(i, value);
+  }
+}
+
 /**
  * Loads the player data.
  * @return The player
@@ -793,16 +887,12 @@ static SoulWorker* loadPlayer() {
   player->dzenai = dzenai->valueint;
   player->lvl = lvl->valueint;
 
-  DArray* visited = initDArray(maze->size);
+  player->room = getRoom(maze, (uint) roomId->valueint);
 
-  player->room = findRoom(maze->entry, (char) roomId->valueint, visited);
-
-  dArrayFree(visited);
-
-  if (!player->room|| player->room == (void*)((long long) NO_EXIT)) handleError(ERR_DATA, FATAL, "Could not find room!\n");
+  if (player->room == NO_ROOM) handleError(ERR_DATA, FATAL, "Could not find room!\n");
 
   // Make sure room is the same
-  if (player->room->id != (byte)(roomId->valueint)) handleError(ERR_DATA, FATAL, "Room ID does not match!\n");
+  if (maze->rooms.ids[player->room] != (uint) roomId->valueint) handleError(ERR_DATA, FATAL, "Room ID does not match!\n");
 
 
   for (int i = 0; i < cJSON_GetArraySize(inv); i++) {
@@ -810,7 +900,7 @@ static SoulWorker* loadPlayer() {
 
     cJSON* itemType = cJSON_GetObjectItemCaseSensitive(invItem, TYPE);
 
-    Item* item = createItem(invItem, itemType->valueint);
+    Item* item = createItem(NULL, invItem, itemType->valueint);
     player->inv[i]._item = item->_item;
     player->inv[i].type = item->type;
     player->inv[i].count = item->count;
@@ -866,23 +956,25 @@ static SoulWorker* loadPlayer() {
 
   cJSON* sw = cJSON_GetObjectItemCaseSensitive(gear, "soulweapon");
   if (!sw) handleError(ERR_DATA, FATAL, "No SoulWeapon data found!\n");
-  if (!cJSON_IsNull(sw)) player->gear.sw = createSoulWeapon(sw);
+  if (!cJSON_IsNull(sw)) player->gear.sw = createSoulWeapon(NULL, sw);
 
   cJSON* helmet = cJSON_GetObjectItemCaseSensitive(gear, "helmet");
   if (!helmet) handleError(ERR_DATA, FATAL, "No helmet data found!\n");
-  if (!cJSON_IsNull(helmet)) player->gear.helmet = createArmor(helmet);
+  if (!cJSON_IsNull(helmet)) player->gear.helmet = createArmor(NULL, helmet);
 
   cJSON* guard = cJSON_GetObjectItemCaseSensitive(gear, "shoulder_guard");
   if (!guard) handleError(ERR_DATA, FATAL, "No  data found!\n");
-  if (!cJSON_IsNull(guard)) player->gear.guard = createArmor(guard);
+  if (!cJSON_IsNull(guard)) player->gear.guard = createArmor(NULL, guard);
 
   cJSON* chestplate = cJSON_GetObjectItemCaseSensitive(gear, "chestplate");
   if (!chestplate) handleError(ERR_DATA, FATAL, "No  data found!\n");
-  if (!cJSON_IsNull(chestplate)) player->gear.chestplate = createArmor(chestplate);
+  if (!cJSON_IsNull(chestplate)) player->gear.chestplate = createArmor(NULL, chestplate);
 
   cJSON* boots = cJSON_GetObjectItemCaseSensitive(gear, "boots");
   if (!boots) handleError(ERR_DATA, FATAL, "No  data found!\n");
-  if (!cJSON_IsNull(boots)) player->gear.boots = createArmor(boots);
+  if (!cJSON_IsNull(boots)) player->gear.boots = createArmor(NULL, boots);
+
+  updateStats(player);
 
   cJSON* skillTree = cJSON_GetObjectItemCaseSensitive(root, "skills");
   if (!skillTree) handleError(ERR_DATA, FATAL, "No skill tree data found!\n");
@@ -901,7 +993,7 @@ static SoulWorker* loadPlayer() {
   for (int i = 0; i < cJSON_GetArraySize(skills); i++) { // size should be TOTAL_SKILLS
     cJSON* _skill = cJSON_GetArrayItem(skills, i);
 
-    Skill* skill = createSkill(_skill);
+    Skill* skill = createSkill(NULL, _skill);
     
     // strcpy(player->skills->skills[i].name, skill->name);
     player->skills->skills[i].name = skill->name;
@@ -936,6 +1028,8 @@ static SoulWorker* loadPlayer() {
     }
   }
 
+  loadRandom(root);
+
   cJSON_Delete(root);
 
   return player;
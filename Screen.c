@@ -0,0 +1,548 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdarg.h>
+#include <stdint.h>
+#include <limits.h>
+#include <errno.h>
+
+#ifdef _WIN64
+  #include <windows.h>
+  #include <io.h>
+#else
+  #include <unistd.h>
+  #include <sys/ioctl.h>
+#endif
+
+#include "Screen.h"
+#include "Error.h"
+
+
+#define DEFAULT_TERM_COLS 80 // The terminal size when stdout is not a terminal
+#define DEFAULT_TERM_ROWS 24
+
+#define TAB_WIDTH 8
+#define PRINTF_SIZE 512 // Most text drawn at once fits, longer text is allocated for
+#define NO_CURSOR UINT_MAX // Where the cursor is when it is not known
+
+#define MAX_CELL_BYTES 32 // The most a changed cell can take: a move, a reset and a color, and its character
+#define MAX_ROW_BYTES 32 // The most a row can take besides its cells: the moves and erases around them
+#define FRAME_EXTRA 64 // The most a frame can take besides its rows: the clear, the scroll region and the last move
+#define MAX_SKIP 4 // Unchanged cells are written over rather than moved past when there are at most this many
+
+#define CLEAR_TERMINAL "\x1b[H\x1b[2J"
+#define ERASE_LINE "\x1b[2K"
+#define ERASE_LINE_END "\x1b[K"
+#define ERASE_BELOW "\x1b[J"
+// Saves the cursor, drops the scroll region, which moves the cursor home, then puts the cursor back
+#define UNPIN_FRAME "\x1b" "7" "\x1b[r" "\x1b" "8"
+
+// The styles text is drawn in, the codes of Colors.h
+static const char* const styles[] = { RESET, BLACK, RED, GREEN, YELLOW, BLUE, PURPLE, CYAN, WHITE, BLINK };
+#define STYLE_COUNT (sizeof(styles) / sizeof(styles[0]))
+#define STYLE_BLINK (STYLE_COUNT - 1) // The only style a color does not replace
+
+// A character on the screen and its style
+typedef struct Cell {  // 8B
+  uint32_t glyph; // The bytes of the character, UTF-8, the first in the lowest byte   4B
+  uchar style; // The index of its style in styles                                      1B
+} Cell;
+
+// The terminal as last drawn and the frame drawn next
+typedef struct Screen {                                                         // 72B
+  Cell* front; // What the terminal shows, rows by cols                            8B
+  Cell* back; // The frame being drawn, backRows by cols                           8B
+  char* bytes; // What is sent for a frame                                         8B
+  FILE* out; // Where frames go                                                    8B
+  uint cols, rows; // The size of the terminal                                     8B
+  uint backRows; // The rows the frame being drawn has room for                    4B
+  uint row, col; // Where text goes next in the frame                              8B
+  uint pinned; // The rows of the last frame kept at the top, 0 if none            4B
+  uint curRow, curCol; // Where the cursor is, curRow is NO_CURSOR if not known    8B
+  uchar style; // The style text is drawn in next                                  1B
+  uchar curStyle; // The style the terminal draws in                               1B
+  bool live; // Whether frames are drawn in place                                  1B
+  bool valid; // Whether front is what the terminal shows                          1B
+} Screen;
+
+static const Cell BLANK_CELL = { ' ', 0 };
+
+static Screen screen;
+
+
+bool getTerminalSize(uint* cols, uint* rows) {
+  *cols = DEFAULT_TERM_COLS;
+  *rows = DEFAULT_TERM_ROWS;
+
+#ifdef _WIN64
+  CONSOLE_SCREEN_BUFFER_INFO info;
+  if (GetConsoleScreenBufferInfo(GetStdHandle(STD_OUTPUT_HANDLE), &info)) {
+    *cols = (uint) (info.srWindow.Right - info.srWindow.Left + 1);
+    *rows = (uint) (info.srWindow.Bottom - info.srWindow.Top + 1);
+    return true;
+  }
+#else
+  struct winsize size;
+  if (ioctl(fileno(stdout), TIOCGWINSZ, &size) == 0 && size.ws_col != 0 && size.ws_row != 0) {
+    *cols = size.ws_col;
+    *rows = size.ws_row;
+    return true;
+  }
+#endif
+
+  return false;
+}
+
+void writeTerminal(FILE* out, const char* bytes, size_t len) {
+  fflush(out);
+
+#ifdef _WIN64
+  if (_write(_fileno(out), bytes, (unsigned int) len) < 0) handleError(ERR_IO, WARNING, "Could not write to the terminal!\n");
+#else
+  // A terminal can take less than all of it at once
+  while (len > 0) {
+    ssize_t written = write(fileno(out), bytes, len);
+    if (written < 0 && errno == EINTR) continue;
+    if (written <= 0) { handleError(ERR_IO, WARNING, "Could not write to the terminal!\n"); return; }
+
+    bytes += written;
+    len -= (size_t) written;
+  }
+#endif
+}
+
+/**
+ * Blanks the cells.
+ * @param cells The cells
+ * @param n The number of cells
+ */
+static void blankCells(Cell* cells, size_t n) {
+  for (size_t i = 0; i < n; i++) cells[i] = BLANK_CELL;
+}
+
+/**
+ * Gets the bytes needed to send a frame of the given rows.
+ * @param rows The rows
+ * @return The bytes
+ */
+static size_t frameBytes(uint rows) {
+  return (size_t) rows * ((size_t) screen.cols * MAX_CELL_BYTES + MAX_ROW_BYTES) + FRAME_EXTRA;
+}
+
+void initScreen(FILE* out, bool live) {
+  static bool registered = false;
+
+  if (screen.out) deleteScreen();
+
+  screen.out = out;
+  screen.live = live;
+  screen.valid = false;
+
+  // A fatal error exits from anywhere, and the terminal should not keep a frame pinned after
+  if (!registered) registered = atexit(deleteScreen) == 0;
+}
+
+/**
+ * Sets up the screen on stdout, if initScreen was never called.
+ */
+static void ensureScreen() {
+  uint cols, rows;
+
+  if (!screen.out) initScreen(stdout, getTerminalSize(&cols, &rows));
+}
+
+/**
+ * Sizes the frames to the terminal. A resized terminal reflows what it shows, so it is drawn again from clear.
+ */
+static void sizeScreen() {
+  uint cols, rows;
+  getTerminalSize(&cols, &rows);
+
+  if (screen.front && cols == screen.cols && rows == screen.rows) return;
+
+  // The scroll region was set for the old size
+  closeScreen();
+
+  free(screen.front);
+  free(screen.back);
+  free(screen.bytes);
+
+  screen.cols = cols;
+  screen.rows = rows;
+  screen.backRows = rows;
+
+  screen.front = (Cell*) malloc((size_t) cols * rows * sizeof(Cell));
+  screen.back = (Cell*) malloc((size_t) cols * rows * sizeof(Cell));
+  screen.bytes = (char*) malloc(frameBytes(rows));
+  if (!screen.front || !screen.back || !screen.bytes) handleError(ERR_MEM, FATAL, "Could not allocate space for the screen!\n");
+
+  blankCells(screen.front, (size_t) cols * rows);
+  blankCells(screen.back, (size_t) cols * rows);
+}
+
+/**
+ * Doubles the rows of the frame being drawn, for a frame taller than the terminal.
+ */
+static void growBack() {
+  uint rows = screen.backRows * 2;
+
+  Cell* back = (Cell*) realloc(screen.back, (size_t) screen.cols * rows * sizeof(Cell));
+  char* bytes = (char*) realloc(screen.bytes, frameBytes(rows));
+  if (!back || !bytes) handleError(ERR_MEM, FATAL, "Could not allocate space for the screen!\n");
+
+  blankCells(&back[(size_t) screen.cols * screen.backRows], (size_t) screen.cols * (rows - screen.backRows));
+
+  screen.back = back;
+  screen.bytes = bytes;
+  screen.backRows = rows;
+}
+
+void clearScreen() {
+  ensureScreen();
+  closeScreen();
+
+  if (screen.live) writeTerminal(screen.out, CLEAR_TERMINAL, sizeof(CLEAR_TERMINAL) - 1);
+}
+
+void beginScreen() {
+  ensureScreen();
+  sizeScreen();
+
+  blankCells(screen.back, (size_t) screen.cols * screen.backRows);
+
+  screen.row = 0;
+  screen.col = 0;
+  screen.style = 0;
+}
+
+/**
+ * Reads a code of Colors.h, setting the style text is drawn in next. Any other escape sequence is skipped.
+ * @param text The text
+ * @param len The bytes of the text
+ * @param i Where the sequence starts
+ * @return Where the sequence ends
+ */
+static size_t readStyle(const char* text, size_t len, size_t i) {
+  if (i + 1 >= len || text[i + 1] != '[') return i;
+
+  // The final byte of a sequence is a letter or one of @[\]^_`{|}~
+  size_t end = i + 2;
+  while (end < len && (text[end] < '@' || text[end] > '~')) end++;
+  if (end == len) return len - 1;
+
+  for (uint s = 0; s < STYLE_COUNT; s++) {
+    size_t styleLen = strlen(styles[s]);
+
+    if (styleLen == end - i + 1 && memcmp(&text[i], styles[s], styleLen) == 0) { screen.style = (uchar) s; break; }
+  }
+
+  return end;
+}
+
+/**
+ * Gets the bytes of a character.
+ * @param glyph The character
+ * @return The bytes, from 1 to 4
+ */
+static uint glyphLen(uint32_t glyph) {
+  if (glyph >> 24) return 4;
+  if (glyph >> 16) return 3;
+  if (glyph >> 8) return 2;
+
+  return 1;
+}
+
+void screenWrite(const char* text, size_t len) {
+  for (size_t i = 0; i < len; i++) {
+    uchar c = (uchar) text[i];
+
+    if (c == '\x1b') { i = readStyle(text, len, i); continue; }
+    if (c == '\n') { screen.row++; screen.col = 0; continue; }
+    if (c == '\r') { screen.col = 0; continue; }
+
+    if (c == '\t') {
+      screen.col = (screen.col / TAB_WIDTH + 1) * TAB_WIDTH;
+      if (screen.col >= screen.cols) screen.col = screen.cols - 1;
+      continue;
+    }
+
+    // The rest of a character of more than one byte goes with its first byte
+    if ((c & 0xC0) == 0x80) {
+      if (screen.col == 0) continue;
+
+      Cell* cell = &screen.back[(size_t) screen.row * screen.cols + screen.col - 1];
+      uint glyphBytes = glyphLen(cell->glyph);
+      if (glyphBytes < 4) cell->glyph |= (uint32_t) c << (8 * glyphBytes);
+
+      continue;
+    }
+
+    // Like the terminal, a full row wraps
+    if (screen.col == screen.cols) { screen.row++; screen.col = 0; }
+    while (screen.row >= screen.backRows) growBack();
+
+    // A blank looks the same in any color
+    Cell* cell = &screen.back[(size_t) screen.row * screen.cols + screen.col++];
+    cell->glyph = c;
+    cell->style = (c != ' ') ? screen.style : 0;
+  }
+}
+
+void screenPrintf(const char* format, ...) {
+  char buffer[PRINTF_SIZE];
+  va_list args;
+
+  va_start(args, format);
+  int len = vsnprintf(buffer, sizeof(buffer), format, args);
+  va_end(args);
+
+  if (len < 0) return;
+  if ((size_t) len < sizeof(buffer)) { screenWrite(buffer, (size_t) len); return; }
+
+  str text = (str) malloc((size_t) len + 1);
+  if (!text) handleError(ERR_MEM, FATAL, "Could not allocate space for the text!\n");
+
+  va_start(args, format);
+  vsnprintf(text, (size_t) len + 1, format, args);
+  va_end(args);
+
+  screenWrite(text, (size_t) len);
+  free(text);
+}
+
+/**
+ * Writes a character.
+ * @param out Where to write
+ * @param glyph The character
+ * @return Where to write next
+ */
+static char* putGlyph(char* out, uint32_t glyph) {
+  do {
+    *out++ = (char) (glyph & 0xFF);
+    glyph >>= 8;
+  } while (glyph);
+
+  return out;
+}
+
+/**
+ * Switches the terminal to the style, if it is not drawing in it already.
+ * @param out Where to write
+ * @param style The style
+ * @return Where to write next
+ */
+static char* setStyle(char* out, uchar style) {
+  if (style == screen.curStyle) return out;
+
+  if (screen.curStyle == STYLE_BLINK && style != 0) {
+    memcpy(out, RESET, sizeof(RESET) - 1);
+    out += sizeof(RESET) - 1;
+  }
+
+  size_t len = strlen(styles[style]);
+  memcpy(out, styles[style], len);
+  screen.curStyle = style;
+
+  return out + len;
+}
+
+/**
+ * Moves the cursor to the cell, the shortest way it knows.
+ * @param out Where to write
+ * @param row The row of the cell
+ * @param col The column of the cell
+ * @return Where to write next
+ */
+static char* moveCursor(char* out, uint row, uint col) {
+  if (screen.curRow == row && screen.curCol == col) return out;
+
+  if (screen.curRow == row && col > screen.curCol) {
+    Cell* skipped = &screen.front[(size_t) row * screen.cols + screen.curCol];
+    uint gap = col - screen.curCol;
+
+    // A few cells are shorter to write again than to move past, if they need no other style
+    bool rewrite = gap <= MAX_SKIP;
+    for (uint i = 0; i < gap && rewrite; i++) rewrite = skipped[i].glyph == ' ' || skipped[i].style == screen.curStyle;
+
+    if (rewrite) {
+      for (uint i = 0; i < gap; i++) out = putGlyph(out, skipped[i].glyph);
+    } else out += sprintf(out, "\x1b[%uC", gap);
+  } else if (col == 0) out += sprintf(out, "\x1b[%uH", row + 1);
+  else out += sprintf(out, "\x1b[%u;%uH", row + 1, col + 1);
+
+  screen.curRow = row;
+  screen.curCol = col;
+
+  return out;
+}
+
+/**
+ * Gets the end of what a row shows, past its last character that is not blank.
+ * @param cells The row
+ * @return The column after the last character, 0 if the row is blank
+ */
+static uint rowEnd(const Cell* cells) {
+  uint end = screen.cols;
+  while (end > 0 && cells[end - 1].glyph == ' ') end--;
+
+  return end;
+}
+
+/**
+ * Writes the frame as text, for anywhere that is not a terminal or a frame too tall for it.
+ * @param out Where to write
+ * @param used The rows of the frame
+ * @return Where to write next
+ */
+static char* printFrame(char* out, uint used) {
+  // What was kept at the top scrolls away with the rest
+  if (screen.live && screen.pinned) {
+    memcpy(out, UNPIN_FRAME, sizeof(UNPIN_FRAME) - 1);
+    out += sizeof(UNPIN_FRAME) - 1;
+    screen.pinned = 0;
+  }
+
+  screen.valid = false;
+  screen.curStyle = 0;
+
+  for (uint r = 0; r < used; r++) {
+    Cell* cells = &screen.back[(size_t) r * screen.cols];
+    uint end = rowEnd(cells);
+
+    // A blank looks the same in any style
+    for (uint c = 0; c < end; c++) {
+      if (cells[c].glyph != ' ') out = setStyle(out, cells[c].style);
+      out = putGlyph(out, cells[c].glyph);
+    }
+
+    // A frame can end in the middle of a row, the way a prompt does
+    if (r < screen.row) {
+      out = setStyle(out, 0);
+      *out++ = '\n';
+    }
+  }
+
+  return setStyle(out, 0);
+}
+
+/**
+ * Writes the changes from the last frame, then keeps the frame at the top of the terminal.
+ * @param out Where to write
+ * @param used The rows of the frame, fewer than the terminal has
+ * @return Where to write next
+ */
+static char* drawFrame(char* out, uint used) {
+  Cell* front = screen.front;
+  Cell* back = screen.back;
+  uint cols = screen.cols;
+
+  // The rows of the last frame are known, those below it have what was printed since
+  uint known = screen.pinned;
+
+  screen.curStyle = 0;
+  screen.curRow = NO_CURSOR;
+
+  if (!screen.valid) {
+    memcpy(out, CLEAR_TERMINAL, sizeof(CLEAR_TERMINAL) - 1);
+    out += sizeof(CLEAR_TERMINAL) - 1;
+
+    blankCells(front, (size_t) cols * screen.rows);
+    known = screen.rows;
+
+    screen.curRow = 0;
+    screen.curCol = 0;
+    screen.valid = true;
+  }
+
+  uint last = (used > screen.pinned) ? used : screen.pinned;
+
+  for (uint r = 0; r < last; r++) {
+    Cell* f = &front[(size_t) r * cols];
+    Cell* b = &back[(size_t) r * cols];
+    uint backEnd = (r < used) ? rowEnd(b) : 0;
+    uint frontEnd = rowEnd(f);
+
+    if (r >= known) {
+      out = moveCursor(out, r, 0);
+      memcpy(out, ERASE_LINE, sizeof(ERASE_LINE) - 1);
+      out += sizeof(ERASE_LINE) - 1;
+    }
+
+    for (uint c = 0; c < backEnd; c++) {
+      if (f[c].glyph == b[c].glyph && f[c].style == b[c].style) continue;
+
+      out = moveCursor(out, r, c);
+      if (b[c].glyph != ' ') out = setStyle(out, b[c].style);
+      out = putGlyph(out, b[c].glyph);
+      f[c] = b[c];
+
+      // Past the last column, where the cursor is depends on the terminal
+      if (++screen.curCol == cols) screen.curRow = NO_CURSOR;
+    }
+
+    if (frontEnd > backEnd) {
+      out = moveCursor(out, r, backEnd);
+      memcpy(out, ERASE_LINE_END, sizeof(ERASE_LINE_END) - 1);
+      out += sizeof(ERASE_LINE_END) - 1;
+
+      blankCells(&f[backEnd], frontEnd - backEnd);
+    }
+  }
+
+  out = setStyle(out, 0);
+
+  // What is printed after the frame scrolls below it, leaving the frame as drawn
+  if (used != screen.pinned) {
+    if (used > 0) out += sprintf(out, "\x1b[%u;%ur", used + 1, screen.rows);
+    else out += sprintf(out, "\x1b[r");
+
+    screen.pinned = used;
+    screen.curRow = NO_CURSOR;
+  }
+
+  out = moveCursor(out, used, 0);
+  memcpy(out, ERASE_BELOW, sizeof(ERASE_BELOW) - 1);
+  out += sizeof(ERASE_BELOW) - 1;
+
+  blankCells(&front[(size_t) used * cols], (size_t) cols * (screen.rows - used));
+
+  return out;
+}
+
+size_t presentScreen() {
+  ensureScreen();
+  if (!screen.front) beginScreen();
+
+  uint used = screen.row + (screen.col > 0);
+  char* out = screen.bytes;
+
+  // The terminal needs a row below the frame for what comes after it
+  if (screen.live && used < screen.rows) out = drawFrame(out, used);
+  else out = printFrame(out, used);
+
+  size_t len = out - screen.bytes;
+  writeTerminal(screen.out, screen.bytes, len);
+
+  return len;
+}
+
+void closeScreen() {
+  if (!screen.out) return;
+
+  if (screen.live && screen.pinned) {
+    writeTerminal(screen.out, UNPIN_FRAME, sizeof(UNPIN_FRAME) - 1);
+    screen.pinned = 0;
+  }
+
+  screen.valid = false;
+}
+
+void deleteScreen() {
+  closeScreen();
+
+  free(screen.front);
+  free(screen.back);
+  free(screen.bytes);
+
+  memset(&screen, 0, sizeof(screen));
+}
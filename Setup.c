@@ -4,7 +4,10 @@
 
 #include "Error.h"
 #include "Setup.h"
+#include "Intern.h"
+#include "Random.h"
 #include "LoadJSON.h"
+#include "MapParser.h"
 
 #define MAPS_DIR "./data/maps";
 
@@ -51,14 +54,28 @@ cJSON* readData(const str filename) {
   return json;
 }
 
+uint parseRoomId(const char* key) {
+  if (!key || !*key) handleError(ERR_DATA, FATAL, "Room ids cannot be empty!\n");
+
+  unsigned long long id = 0;
+  for (const char* c = key; *c; c++) {
+    if (*c < '0' || *c > '9') handleError(ERR_DATA, FATAL, "Room id %s is not a number!\n", key);
+
+    id = id * 10 + (*c - '0');
+    if (id > MAX_ROOM_ID) handleError(ERR_DATA, FATAL, "Room id %s is too big!\n", key);
+  }
+
+  return (uint) id;
+}
+
 /**
  * Given a room, it validates its JSON data
  * @param room The cJSON structure to validate
  */
 static void validateRoom(cJSON* room) {
-  const str dataErr = "Room %d: No %s data found!\n";
+  const str dataErr = "Room %u: No %s data found!\n";
 
-  char roomId = (char) atoi(room->string);
+  uint roomId = parseRoomId(room->string);
 
   cJSON* storyfile = cJSON_GetObjectItemCaseSensitive(room, "storyfile");
   if (!storyfile) handleError(ERR_DATA, FATAL, dataErr, roomId, "storyfile");
@@ -66,7 +83,7 @@ static void validateRoom(cJSON* room) {
   cJSON* isEntry = cJSON_GetObjectItemCaseSensitive(room, "isEntry");
   if (!isEntry) handleError(ERR_DATA, FATAL, dataErr, roomId, "isEntry");
   if (strcmp(room->string, "0") == 0 && isEntry->valueint != 1) {
-    handleError(ERR_DATA, FATAL, "Room %d: No matching isEntry data and room id!\n", roomId);
+    handleError(ERR_DATA, FATAL, "Room %u: No matching isEntry data and room id!\n", roomId);
   }
 
   cJSON* info = cJSON_GetObjectItemCaseSensitive(room, "info");
@@ -77,15 +94,36 @@ static void validateRoom(cJSON* room) {
 
   cJSON* exits = cJSON_GetObjectItemCaseSensitive(room, "exits");
   if (!exits) handleError(ERR_DATA, FATAL, dataErr, roomId, "exits");
-  if (cJSON_GetArraySize(exits) != 4) handleError(ERR_DATA, FATAL, "Room %d: Exits must only be 4!\n", roomId);
+  if (cJSON_GetArraySize(exits) != 4) handleError(ERR_DATA, FATAL, "Room %u: Exits must only be 4!\n", roomId);
   cJSON* e = NULL;
   cJSON_ArrayForEach(e, exits) {
-    if (e->valueint < -1) handleError(ERR_DATA, FATAL, "Room %d: exit markers cannot be less than -1!\n", roomId);
+    if (e->valueint < -1) handleError(ERR_DATA, FATAL, "Room %u: exit markers cannot be less than -1!\n", roomId);
   };
 
+  // Only saves have where the room is drawn, see layoutMaze
+  cJSON* pos = cJSON_GetObjectItemCaseSensitive(room, "pos");
+  if (pos) {
+    if (cJSON_GetArraySize(pos) != 2) handleError(ERR_DATA, FATAL, "Room %u: pos must be [x, y]!\n", roomId);
+    cJSON_ArrayForEach(e, pos) {
+      if (!cJSON_IsNumber(e) || e->valuedouble < -MAX_ROOM_ID || e->valuedouble > MAX_ROOM_ID) {
+        handleError(ERR_DATA, FATAL, "Room %u: pos must be [x, y]!\n", roomId);
+      }
+    };
+  }
+
   cJSON* loot = cJSON_GetObjectItemCaseSensitive(room, "loot");
   if (!loot) handleError(ERR_DATA, FATAL, dataErr, roomId, "loot");
-  e = NULL;
+
+  cJSON* enemy = cJSON_GetObjectItemCaseSensitive(room, "enemy");
+  if (!enemy) handleError(ERR_DATA, FATAL, dataErr, roomId, "enemy");
+
+  validateTables(roomId, hasBoss->valueint == 1, loot, enemy);
+}
+
+void validateTables(uint roomId, bool hasBoss, cJSON* loot, cJSON* enemy) {
+  const str dataErr = "Room %u: No %s data found!\n";
+
+  cJSON* e = NULL;
   cJSON_ArrayForEach(e, loot) {
     cJSON* item = cJSON_GetObjectItemCaseSensitive(e, "item");
     if (!item) handleError(ERR_DATA, FATAL, dataErr, roomId, "loot item");
@@ -108,8 +146,6 @@ static void validateRoom(cJSON* room) {
   //    add a check to make sure all the items in the loot table are valid
   //  Do the same for enemies.
 
-  cJSON* enemy = cJSON_GetObjectItemCaseSensitive(room, "enemy");
-  if (!enemy) handleError(ERR_DATA, FATAL, dataErr, roomId, "enemy");
   e = NULL;
   cJSON_ArrayForEach(e, enemy) {
     cJSON* name = cJSON_GetObjectItemCaseSensitive(e, "name");
@@ -137,23 +173,21 @@ static void validateRoom(cJSON* room) {
     cJSON* crit = cJSON_GetObjectItemCaseSensitive(stats, "ATK_CRIT");
     if (!crit) handleError(ERR_DATA, FATAL, dataErr, roomId, "enemy stats crit");
 
-    if (hasBoss->valueint == 1) {
+    if (hasBoss) {
       handleError(ERR_DATA, WARNING, "BOSS GEAR CHECK NOT IMPLEMENTED!\n");
     }
   }
 }
 
-SoulWeapon* createSoulWeapon(cJSON* obj) {
+SoulWeapon* createSoulWeapon(Arena* arena, cJSON* obj) {
   const str errMsg = "Could not find data for SoulWeapon %s!\n";
 
-  SoulWeapon* sw = (SoulWeapon*) malloc(sizeof(SoulWeapon));
+  SoulWeapon* sw = (SoulWeapon*) arenaAlloc(arena, sizeof(SoulWeapon));
   if (!sw) handleError(ERR_MEM, FATAL, "Could not allocate space for SoulWeapon!\n");
 
   cJSON* name = cJSON_GetObjectItemCaseSensitive(obj, "name");
   if (!name) handleError(ERR_DATA, FATAL, errMsg, "name");
-  sw->name = (str) malloc(strlen(name->valuestring) + 1);
-  if (!sw->name) handleError(ERR_MEM, FATAL, "Could not allocate space for SoulWeapon name!\n");
-  strcpy(sw->name, name->valuestring);
+  sw->name = intern(name->valuestring);
 
   cJSON* atk = cJSON_GetObjectItemCaseSensitive(obj, "atk");
   if (!atk) handleError(ERR_DATA, FATAL, errMsg, "atk");
@@ -186,17 +220,15 @@ SoulWeapon* createSoulWeapon(cJSON* obj) {
   return sw;
 }
 
-Armor* createArmor(cJSON* obj) {
+Armor* createArmor(Arena* arena, cJSON* obj) {
   const str errMsg = "Could not find data for armor %s!\n";
 
-  Armor* armor = (Armor*) malloc(sizeof(Armor));
+  Armor* armor = (Armor*) arenaAlloc(arena, sizeof(Armor));
   if (!armor) handleError(ERR_MEM, FATAL, "Could not allocate space for armor!\n");
 
   cJSON* name = cJSON_GetObjectItemCaseSensitive(obj, "name");
   if (!name) handleError(ERR_DATA, FATAL, errMsg, "name");
-  armor->name = (str) malloc(strlen(name->valuestring) + 1);
-  if (!armor->name) handleError(ERR_MEM, FATAL, "Could not allocate space for armor name!\n");
-  strcpy(armor->name, name->valuestring);
+  armor->name = intern(name->valuestring);
 
   cJSON* type = cJSON_GetObjectItemCaseSensitive(obj, "type");
   if (!type) handleError(ERR_DATA, FATAL, errMsg, "type");
@@ -217,8 +249,8 @@ Armor* createArmor(cJSON* obj) {
   return armor;
 }
 
-HPKit* createHPKit(cJSON* obj) {
-  HPKit* hpKit = (HPKit*) malloc(sizeof(HPKit));
+HPKit* createHPKit(Arena* arena, cJSON* obj) {
+  HPKit* hpKit = (HPKit*) arenaAlloc(arena, sizeof(HPKit));
   if (!hpKit) handleError(ERR_MEM, FATAL, "Could not allocate for HP Kit!\n");
 
   cJSON* type = cJSON_GetObjectItemCaseSensitive(obj, "type");
@@ -227,15 +259,13 @@ HPKit* createHPKit(cJSON* obj) {
 
   cJSON* desc = cJSON_GetObjectItemCaseSensitive(obj, "description");
   if (!desc) handleError(ERR_DATA, FATAL, "Could not find data for HP Kit description!\n");
-  hpKit->desc = (str) malloc(strlen(desc->valuestring) + 1);
-  if (!hpKit->desc) handleError(ERR_MEM, FATAL, "Could not allocate space for HP Kit description!\n");
-  strcpy(hpKit->desc, desc->valuestring);
+  hpKit->desc = intern(desc->valuestring);
 
   return hpKit;
 }
 
-Upgrade* createUpgrade(cJSON* obj) {
-  Upgrade* upgrade = (Upgrade*) malloc(sizeof(Upgrade));
+Upgrade* createUpgrade(Arena* arena, cJSON* obj) {
+  Upgrade* upgrade = (Upgrade*) arenaAlloc(arena, sizeof(Upgrade));
   if (!upgrade) handleError(ERR_MEM, FATAL, "Could not allocate space for upgrade material!\n");
 
   cJSON* rank = cJSON_GetObjectItemCaseSensitive(obj, "rank");
@@ -248,28 +278,24 @@ Upgrade* createUpgrade(cJSON* obj) {
 
   cJSON* desc = cJSON_GetObjectItemCaseSensitive(obj, "description");
   if (!desc) handleError(ERR_DATA, FATAL, "Could not find data for upgrade description!\n");
-  upgrade->desc = (str) malloc(strlen(desc->valuestring) + 1);
-  if (!upgrade->desc) handleError(ERR_MEM, FATAL, "Could not allocate space for upgrade description!\n");
-  strcpy(upgrade->desc, desc->valuestring);
+  upgrade->desc = intern(desc->valuestring);
 
   return upgrade;
 }
 
-Slime* createSlime(cJSON* obj) {
-  Slime* slime = (Slime*) malloc(sizeof(Slime));
+Slime* createSlime(Arena* arena, cJSON* obj) {
+  Slime* slime = (Slime*) arenaAlloc(arena, sizeof(Slime));
   if (!slime) handleError(ERR_MEM, FATAL, "Could not allocate for slime!\n");
 
   cJSON* desc = cJSON_GetObjectItemCaseSensitive(obj, "description");
   if (!desc) handleError(ERR_DATA, FATAL, "Could not find data for slime description!\n");
-  slime->desc = (str) malloc(strlen(desc->valuestring) + 1);
-  if (!slime->desc) handleError(ERR_MEM, FATAL, "Could not allocate space for slime description!\n");
-  strcpy(slime->desc, desc->valuestring);
+  slime->desc = intern(desc->valuestring);
 
   return slime;
 }
 
-Item* createItem(cJSON* obj, item_t type) {
-  Item* item = (Item*) malloc(sizeof(Item));
+Item* createItem(Arena* arena, cJSON* obj, item_t type) {
+  Item* item = (Item*) arenaAlloc(arena, sizeof(Item));
   if (!item) handleError(ERR_MEM, FATAL, "Could not allocate space for item!\n");
 
   item->type = type;
@@ -282,23 +308,23 @@ Item* createItem(cJSON* obj, item_t type) {
 
   switch (type) {
     case SOULWEAPON_T:
-      item->_item = createSoulWeapon(objItem);
+      item->_item = createSoulWeapon(arena, objItem);
       break;
     case HELMET_T:
     case SHOULDER_GUARD_T:
     case CHESTPLATE_T:
     case BOOTS_T:
-      item->_item = createArmor(objItem);
+      item->_item = createArmor(arena, objItem);
       break;
     case HP_KITS_T:
-      item->_item = createHPKit(objItem);
+      item->_item = createHPKit(arena, objItem);
       break;
     case WEAPON_UPGRADE_MATERIALS_T:
     case ARMOR_UPGRADE_MATERIALS_T:
-      item->_item = createUpgrade(objItem);
+      item->_item = createUpgrade(arena, objItem);
       break;
     case SLIME_T:
-      item->_item = createSlime(objItem);
+      item->_item = createSlime(arena, objItem);
       break;
     default:
       break;
@@ -307,22 +333,19 @@ Item* createItem(cJSON* obj, item_t type) {
   return item;
 }
 
-Skill* createSkill(cJSON* obj) {
-  Skill* skill = (Skill*) malloc(sizeof(Skill));
-  if (!skill) handleError(ERR_MEM, FATAL, "Could not allocate space for skill!\n");
-
-
+/**
+ * Fills out the skill with the given cJSON data.
+ * @param obj The raw skill data
+ * @param skill The skill to fill out
+ */
+static void fillSkill(cJSON* obj, Skill* skill) {
   cJSON* name = cJSON_GetObjectItemCaseSensitive(obj, "name");
   if (!name) handleError(ERR_DATA, FATAL, "Could not find data for skill name!\n");
-  skill->name = (str) malloc(strlen(name->valuestring) + 1);
-  if (!skill->name) handleError(ERR_MEM, FATAL, "Could not allocate space for skill name!\n");
-  strcpy(skill->name, name->valuestring);
+  skill->name = intern(name->valuestring);
 
   cJSON* desc = cJSON_GetObjectItemCaseSensitive(obj, "description");
   if (!desc) handleError(ERR_DATA, FATAL, "Could not find data for skill description!\n");
-  skill->description = (str) malloc(strlen(desc->valuestring) + 1);
-  if (!skill->description) handleError(ERR_MEM, FATAL, "Could not allocate space for skill description!\n");
-  strcpy(skill->description, desc->valuestring);
+  skill->description = intern(desc->valuestring);
 
   cJSON* lvl = cJSON_GetObjectItemCaseSensitive(obj, "lvl");
   if (!lvl) handleError(ERR_DATA, FATAL, "Could not find data for skill level!\n");
@@ -352,22 +375,33 @@ Skill* createSkill(cJSON* obj) {
   cJSON* effect2 = cJSON_GetObjectItemCaseSensitive(obj, "effect2");
   if (!effect2) handleError(ERR_DATA, FATAL, "Could not find data for skill effect 2!\n");
   if (skill->activeEffect2 == ATK_CRIT) {
-    skill->effect2.atk_crit = activeEffect2->valuedouble;
+    skill->effect2.atk_crit = effect2->valuedouble;
   } else {
     // Since acc and def occupy the same space, it doesn't matter which is assigned
-    skill->effect2.acc = activeEffect2->valueint;
+    skill->effect2.acc = effect2->valueint;
   }
+}
+
+Skill* createSkill(Arena* arena, cJSON* obj) {
+  Skill* skill = (Skill*) arenaAlloc(arena, sizeof(Skill));
+  if (!skill) handleError(ERR_MEM, FATAL, "Could not allocate space for skill!\n");
+
+  fillSkill(obj, skill);
 
   return skill;
 }
 
 /**
- * 
- * @param arr 
- * @return 
+ * Reads a stat that is either a single value or a [min, max] range.
+ * @param arr The stat array
+ * @param range Where to store the limits, both the same for a single value
+ * @return Whether it is a range
  */
-static float selectFStat(cJSON* arr) {
-  if (cJSON_GetArraySize(arr) == 1) return (cJSON_GetArrayItem(arr, 0))->valuedouble;
+static bool readRange(cJSON* arr, int range[2]) {
+  if (cJSON_GetArraySize(arr) == 1) {
+    range[0] = range[1] = (cJSON_GetArrayItem(arr, 0))->valueint;
+    return false;
+  }
 
   cJSON* lowLimit = cJSON_GetArrayItem(arr, 0);
   if (!lowLimit) handleError(ERR_DATA, FATAL, "Could not get lower limit!\n");
@@ -375,19 +409,23 @@ static float selectFStat(cJSON* arr) {
   cJSON* highLimit = cJSON_GetArrayItem(arr, 1);
   if (!highLimit) handleError(ERR_DATA, FATAL, "Could not get upper limit!\n");
 
-  float min = lowLimit->valuedouble, max = highLimit->valuedouble;
+  range[0] = lowLimit->valueint;
+  range[1] = highLimit->valueint;
 
-  return min + ((float) rand() / RAND_MAX) * (max - min);
-  // return ((float)rand() / RAND_MAX) % (max - min + 1) + min;
+  return true;
 }
 
 /**
- * 
- * @param arr 
- * @return 
+ * Same as readRange, for a float stat.
+ * @param arr The stat array
+ * @param range Where to store the limits
+ * @return Whether it is a range
  */
-static uint selectStat(cJSON* arr) {
-  if (cJSON_GetArraySize(arr) == 1) return (cJSON_GetArrayItem(arr, 0))->valueint;
+static bool readFRange(cJSON* arr, float range[2]) {
+  if (cJSON_GetArraySize(arr) == 1) {
+    range[0] = range[1] = (cJSON_GetArrayItem(arr, 0))->valuedouble;
+    return false;
+  }
 
   cJSON* lowLimit = cJSON_GetArrayItem(arr, 0);
   if (!lowLimit) handleError(ERR_DATA, FATAL, "Could not get lower limit!\n");
@@ -395,222 +433,394 @@ static uint selectStat(cJSON* arr) {
   cJSON* highLimit = cJSON_GetArrayItem(arr, 1);
   if (!highLimit) handleError(ERR_DATA, FATAL, "Could not get upper limit!\n");
 
-  int min = lowLimit->valueint, max = highLimit->valueint;
+  range[0] = lowLimit->valuedouble;
+  range[1] = highLimit->valuedouble;
+
+  return true;
+}
+
+/**
+ * Rolls a stat within its range. A single value does not use up a roll.
+ * @param lo The lower limit
+ * @param hi The upper limit
+ * @param ranged Whether there is a range at all
+ * @return The stat
+ */
+static uint rollStat(uint lo, uint hi, bool ranged) {
+  if (!ranged) return lo;
 
-  return (rand() % (max - min + 1) + min);
+  return randomRange(RNG_ENEMY, lo, hi);
 }
 
 /**
- * Randomly selects an item from the table.
- * @param table The table to select from
- * @return The selected item
+ * Same as rollStat, for a float stat.
+ * @param lo The lower limit
+ * @param hi The upper limit
+ * @param ranged Whether there is a range at all
+ * @return The stat
  */
-static Item* selectLoot(cJSON* table) {
-  int len = cJSON_GetArraySize(table);
+static float rollFStat(float lo, float hi, bool ranged) {
+  if (!ranged) return lo;
 
-  if (len == 0) return NULL; // No items in table
+  return lo + randomFloat(RNG_ENEMY) * (hi - lo);
+}
 
-  int i = rand() % len;
+/**
+ * Gets a member of a loot entry, which must be there.
+ * @param obj The loot entry or its item
+ * @param key The member
+ * @return The member
+ */
+static cJSON* lootMember(cJSON* obj, const char* key) {
+  cJSON* member = cJSON_GetObjectItemCaseSensitive(obj, key);
+  if (!member) handleError(ERR_DATA, FATAL, "Could not find data for loot %s!\n", key);
 
-  cJSON* item = cJSON_GetArrayItem(table, i);
+  return member;
+}
 
-  if (!item) {
-    fprintf(stderr, "Error! Could not get item!\n");
-    exit(-1);
+/**
+ * Reads the gear piece of a loot entry into its record.
+ * @param obj The gear piece
+ * @param rec The loot record, its type already set
+ */
+static void readLootGear(cJSON* obj, LootRecord* rec) {
+  rec->text = intern(lootMember(obj, "name")->valuestring);
+  rec->acc = lootMember(obj, "acc")->valueint;
+  rec->lvl = lootMember(obj, "lvl")->valueint;
+
+  if (rec->type == SOULWEAPON_T) {
+    rec->atk = lootMember(obj, "atk")->valueint;
+    rec->atkCrit = (float) lootMember(obj, "atk_crit")->valuedouble;
+    rec->atkCritDmg = lootMember(obj, "atk_crit_dmg")->valueint;
+    rec->upgrades = lootMember(obj, "upgrades")->valueint;
+    rec->durability = lootMember(obj, "durability")->valueint;
+  } else {
+    rec->kind = lootMember(obj, "type")->valueint;
+    rec->def = lootMember(obj, "def")->valueint;
   }
+}
+
+/**
+ * Reads a loot entry into its record, the same fields createItem reads.
+ * @param loot The loot entry
+ * @param rec The loot record
+ */
+static void readLootRecord(cJSON* loot, LootRecord* rec) {
+  memset(rec, 0, sizeof(LootRecord));
+
+  cJSON* obj = lootMember(loot, "item");
 
-  cJSON* itemType = cJSON_GetObjectItemCaseSensitive(item, "type");
-  item_t type = itemType->valueint;
+  rec->type = lootMember(loot, "type")->valueint;
+  rec->count = lootMember(loot, "count")->valueint;
 
-  return createItem(item, type);
+  switch (rec->type) {
+    case SOULWEAPON_T:
+    case HELMET_T:
+    case SHOULDER_GUARD_T:
+    case CHESTPLATE_T:
+    case BOOTS_T:
+      readLootGear(obj, rec);
+      break;
+    case HP_KITS_T:
+      rec->kind = lootMember(obj, "type")->valueint;
+      rec->text = intern(lootMember(obj, "description")->valuestring);
+      break;
+    case WEAPON_UPGRADE_MATERIALS_T:
+    case ARMOR_UPGRADE_MATERIALS_T:
+      rec->rank = lootMember(obj, "rank")->valueint;
+      rec->kind = lootMember(obj, "type")->valueint;
+      rec->text = intern(lootMember(obj, "description")->valuestring);
+      break;
+    case SLIME_T:
+      rec->text = intern(lootMember(obj, "description")->valuestring);
+      break;
+    default:
+      break;
+  }
 }
 
-static Enemy* initEnemy(cJSON* obj) {
-  const str errMsg = "Could not find data for enemy %s!\n";
+Item* createLootItem(Arena* arena, const LootRecord* rec) {
+  Item* item = (Item*) arenaAlloc(arena, sizeof(Item));
+  if (!item) handleError(ERR_MEM, FATAL, "Could not allocate space for item!\n");
 
-  Enemy* enemy = (Enemy*) malloc(sizeof(Enemy));
-  if (!enemy) handleError(ERR_MEM, FATAL, "Could not allocate space for enemy!\n");
+  item->type = rec->type;
+  item->count = rec->count;
+  item->_item = NULL;
 
-  cJSON* name = cJSON_GetObjectItemCaseSensitive(obj, "name");
-  if (!name) handleError(ERR_DATA, FATAL, errMsg, "name");
-  enemy->name = (str) malloc(strlen(name->valuestring) + 1);
-  if (!enemy->name) handleError(ERR_MEM, FATAL, "Could not allocate space for enemy name!\n");
-  strcpy(enemy->name, name->valuestring);
+  switch (item->type) {
+    case SOULWEAPON_T:
+      SoulWeapon* sw = (SoulWeapon*) arenaAlloc(arena, sizeof(SoulWeapon));
+      if (!sw) handleError(ERR_MEM, FATAL, "Could not allocate space for SoulWeapon!\n");
+      sw->name = rec->text;
+      sw->atk = rec->atk;
+      sw->acc = rec->acc;
+      sw->atk_crit = rec->atkCrit;
+      sw->atk_crit_dmg = rec->atkCritDmg;
+      sw->lvl = rec->lvl;
+      sw->upgrades = rec->upgrades;
+      sw->durability = rec->durability;
+      item->_item = sw;
+      break;
+    case HELMET_T:
+    case SHOULDER_GUARD_T:
+    case CHESTPLATE_T:
+    case BOOTS_T:
+      Armor* armor = (Armor*) arenaAlloc(arena, sizeof(Armor));
+      if (!armor) handleError(ERR_MEM, FATAL, "Could not allocate space for armor!\n");
+      armor->name = rec->text;
+      armor->type = rec->kind;
+      armor->acc = rec->acc;
+      armor->def = rec->def;
+      armor->lvl = rec->lvl;
+      item->_item = armor;
+      break;
+    case HP_KITS_T:
+      HPKit* hpKit = (HPKit*) arenaAlloc(arena, sizeof(HPKit));
+      if (!hpKit) handleError(ERR_MEM, FATAL, "Could not allocate for HP Kit!\n");
+      hpKit->type = rec->kind;
+      hpKit->desc = rec->text;
+      item->_item = hpKit;
+      break;
+    case WEAPON_UPGRADE_MATERIALS_T:
+    case ARMOR_UPGRADE_MATERIALS_T:
+      Upgrade* upgrade = (Upgrade*) arenaAlloc(arena, sizeof(Upgrade));
+      if (!upgrade) handleError(ERR_MEM, FATAL, "Could not allocate space for upgrade material!\n");
+      upgrade->rank = rec->rank;
+      upgrade->type = rec->kind;
+      upgrade->desc = rec->text;
+      item->_item = upgrade;
+      break;
+    case SLIME_T:
+      Slime* slime = (Slime*) arenaAlloc(arena, sizeof(Slime));
+      if (!slime) handleError(ERR_MEM, FATAL, "Could not allocate for slime!\n");
+      slime->desc = rec->text;
+      item->_item = slime;
+      break;
+    default:
+      break;
+  }
 
-  cJSON* xpPoints = cJSON_GetObjectItemCaseSensitive(obj, "xpPoints");
-  if (!xpPoints) handleError(ERR_DATA, FATAL, errMsg, "xp points");
-  enemy->xpPoints = xpPoints->valueint;
+  return item;
+}
 
-  cJSON* hp = cJSON_GetObjectItemCaseSensitive(obj, "hp");
-  if (!hp) handleError(ERR_DATA, FATAL, errMsg, "hp");
-  enemy->hp = selectStat(hp);
+/**
+ * Reads the gear and skills of a boss.
+ * @param arena The arena of the maze
+ * @param obj The raw boss data
+ * @return The boss template
+ */
+static BossTemplate* readBossTemplate(Arena* arena, cJSON* obj) {
+  const str errMsg = "Could not find data for boss %s!\n";
 
-  cJSON* lvl = cJSON_GetObjectItemCaseSensitive(obj, "lvl");
-  if (!lvl) handleError(ERR_DATA, FATAL, errMsg, "lvl");
-  enemy->lvl = lvl->valueint;
+  BossTemplate* boss = (BossTemplate*) arenaAlloc(arena, sizeof(BossTemplate));
+  if (!boss) handleError(ERR_MEM, FATAL, "Could not allocate space for boss!\n");
 
+  cJSON* gear = cJSON_GetObjectItemCaseSensitive(obj, "gear");
+  if (!gear) handleError(ERR_DATA, FATAL, errMsg, "gear");
 
-  cJSON* stats = cJSON_GetObjectItemCaseSensitive(obj, "stats");
+  cJSON* sw = cJSON_GetObjectItemCaseSensitive(gear, "soulweapon");
+  if (!sw) handleError(ERR_DATA, FATAL, errMsg, "gear soulweapon");
+  boss->gearDrop.sw = createSoulWeapon(arena, sw);
 
-  enemy->stats = (Stats*) malloc(sizeof(Stats));
-  if (!enemy->stats) handleError(ERR_MEM, FATAL, "Could not allocate space for enemy stats!\n");
+  cJSON* helmet = cJSON_GetObjectItemCaseSensitive(gear, "helmet");
+  if (!helmet) handleError(ERR_DATA, FATAL, errMsg, "gear helmet");
+  boss->gearDrop.helmet = createArmor(arena, helmet);
 
-  cJSON* atk = cJSON_GetObjectItemCaseSensitive(stats, "ATK");
-  if (!atk) handleError(ERR_DATA, FATAL, errMsg, "ATK");
-  enemy->stats->ATK = (ushort) selectStat(atk);
+  cJSON* guard = cJSON_GetObjectItemCaseSensitive(gear, "shoulder_guard");
+  if (!guard) handleError(ERR_DATA, FATAL, errMsg, "gear shoulder guard");
+  boss->gearDrop.guard = createArmor(arena, guard);
 
-  cJSON* def = cJSON_GetObjectItemCaseSensitive(stats, "DEF");
-  if (!def) handleError(ERR_DATA, FATAL, errMsg, "DEF");
-  enemy->stats->DEF = (ushort) selectStat(def);
+  cJSON* chestplate = cJSON_GetObjectItemCaseSensitive(gear, "chestplate");
+  if (!chestplate) handleError(ERR_DATA, FATAL, errMsg, "gear chestplate");
+  boss->gearDrop.chestplate = createArmor(arena, chestplate);
 
-  cJSON* acc = cJSON_GetObjectItemCaseSensitive(stats, "ACC");
-  if (!acc) handleError(ERR_DATA, FATAL, errMsg, "ACC");
-  enemy->stats->ACC = (ushort) selectStat(acc);
+  cJSON* boots = cJSON_GetObjectItemCaseSensitive(gear, "boots");
+  if (!boots) handleError(ERR_DATA, FATAL, errMsg, "gear boots");
+  boss->gearDrop.boots = createArmor(arena, boots);
 
-  cJSON* atkCrit = cJSON_GetObjectItemCaseSensitive(stats, "ATK_CRIT");
-  if (!atkCrit) handleError(ERR_DATA, FATAL, errMsg, "ATK CRIT");
-  enemy->stats->ATK_CRIT = selectFStat(atkCrit);
 
-  cJSON* critDmg = cJSON_GetObjectItemCaseSensitive(stats, "ATK_CRIT_DMG");
-  if (!critDmg) handleError(ERR_DATA, FATAL, errMsg, "ATK CRIT DMG");
-  enemy->stats->ATK_CRIT_DMG = (ushort) selectStat(critDmg);
+  cJSON* skills = cJSON_GetObjectItemCaseSensitive(obj, "skills");
+  if (!skills) handleError(ERR_DATA, FATAL, errMsg, "skills");
+  if (cJSON_GetArraySize(skills) != BOSS_SKILL_COUNT) handleError(ERR_DATA, FATAL, "Boss must have %d skills!\n", BOSS_SKILL_COUNT);
+  for (int i = 0; i < BOSS_SKILL_COUNT; i++) {
+    cJSON* _skill = cJSON_GetArrayItem(skills, i);
+    if (!_skill) handleError(ERR_DATA, FATAL, "Could not get boss skill!\n");
+
+    // Fill the slot directly, the template is in the arena so there is nothing to free after
+    fillSkill(_skill, &boss->skills[i]);
+    boss->skills[i].cdTimer = 0;
+  }
 
-  return enemy;
+  return boss;
 }
 
-static Boss* initBoss(cJSON* obj) {
-  const str errMsg = "Could not find data for boss %s!\n";
+/**
+ * Reads an enemy definition into a template, keeping its stat ranges to be rolled later.
+ * @param arena The arena of the maze, for the boss data
+ * @param obj The raw enemy data
+ * @param isBoss Whether the enemy is a boss
+ * @param tmpl The template to fill out
+ */
+static void readEnemyTemplate(Arena* arena, cJSON* obj, bool isBoss, EnemyTemplate* tmpl) {
+  const str errMsg = isBoss ? "Could not find data for boss %s!\n" : "Could not find data for enemy %s!\n";
+  int range[2];
 
-  Boss* boss = (Boss*) malloc(sizeof(Boss));
-  if (!boss) handleError(ERR_MEM, FATAL, "Could not allocate space for boss!\n");
+  tmpl->ranged = 0;
 
   cJSON* name = cJSON_GetObjectItemCaseSensitive(obj, "name");
   if (!name) handleError(ERR_DATA, FATAL, errMsg, "name");
-  boss->base.name = (str) malloc(strlen(name->valuestring) + 1);
-  if (!boss->base.name) handleError(ERR_MEM, FATAL, "Could not allocate space for boss name!\n");
-  strcpy(boss->base.name, name->valuestring);
+  tmpl->name = intern(name->valuestring);
 
   cJSON* xpPoints = cJSON_GetObjectItemCaseSensitive(obj, "xpPoints");
   if (!xpPoints) handleError(ERR_DATA, FATAL, errMsg, "xp points");
-  boss->base.xpPoints = xpPoints->valueint;
+  tmpl->xpPoints = xpPoints->valueint;
 
   cJSON* hp = cJSON_GetObjectItemCaseSensitive(obj, "hp");
   if (!hp) handleError(ERR_DATA, FATAL, errMsg, "hp");
-  boss->base.hp = selectStat(hp);
+  if (readRange(hp, range)) tmpl->ranged |= RANGED_HP;
+  tmpl->hp[0] = range[0];
+  tmpl->hp[1] = range[1];
 
   cJSON* lvl = cJSON_GetObjectItemCaseSensitive(obj, "lvl");
   if (!lvl) handleError(ERR_DATA, FATAL, errMsg, "lvl");
-  boss->base.lvl = lvl->valueint;
+  tmpl->lvl = lvl->valueint;
 
 
   cJSON* stats = cJSON_GetObjectItemCaseSensitive(obj, "stats");
 
-  boss->base.stats = (Stats*) malloc(sizeof(Stats));
-  if (!boss->base.stats) handleError(ERR_MEM, FATAL, "Could not allocate space for boss stats!\n");
-
   cJSON* atk = cJSON_GetObjectItemCaseSensitive(stats, "ATK");
   if (!atk) handleError(ERR_DATA, FATAL, errMsg, "ATK");
-  boss->base.stats->ATK = (ushort) selectStat(atk);
+  if (readRange(atk, range)) tmpl->ranged |= RANGED_ATK;
+  tmpl->atk[0] = (ushort) range[0];
+  tmpl->atk[1] = (ushort) range[1];
 
   cJSON* def = cJSON_GetObjectItemCaseSensitive(stats, "DEF");
   if (!def) handleError(ERR_DATA, FATAL, errMsg, "DEF");
-  boss->base.stats->DEF = (ushort) selectStat(def);
+  if (readRange(def, range)) tmpl->ranged |= RANGED_DEF;
+  tmpl->def[0] = (ushort) range[0];
+  tmpl->def[1] = (ushort) range[1];
 
   cJSON* acc = cJSON_GetObjectItemCaseSensitive(stats, "ACC");
   if (!acc) handleError(ERR_DATA, FATAL, errMsg, "ACC");
-  boss->base.stats->ACC = (ushort) selectStat(acc);
+  if (readRange(acc, range)) tmpl->ranged |= RANGED_ACC;
+  tmpl->acc[0] = (ushort) range[0];
+  tmpl->acc[1] = (ushort) range[1];
 
   cJSON* atkCrit = cJSON_GetObjectItemCaseSensitive(stats, "ATK_CRIT");
   if (!atkCrit) handleError(ERR_DATA, FATAL, errMsg, "ATK CRIT");
-  boss->base.stats->ATK_CRIT = selectFStat(atkCrit);
+  if (readFRange(atkCrit, tmpl->atkCrit)) tmpl->ranged |= RANGED_CRIT;
 
   cJSON* critDmg = cJSON_GetObjectItemCaseSensitive(stats, "ATK_CRIT_DMG");
   if (!critDmg) handleError(ERR_DATA, FATAL, errMsg, "ATK CRIT DMG");
-  boss->base.stats->ATK_CRIT_DMG = (ushort) selectStat(critDmg);
+  if (readRange(critDmg, range)) tmpl->ranged |= RANGED_CRIT_DMG;
+  tmpl->atkCritDmg[0] = (ushort) range[0];
+  tmpl->atkCritDmg[1] = (ushort) range[1];
 
+  tmpl->boss = isBoss ? readBossTemplate(arena, obj) : NULL;
+}
 
-  cJSON* gear = cJSON_GetObjectItemCaseSensitive(obj, "gear");
-  if (!gear) handleError(ERR_DATA, FATAL, errMsg, "gear");
+void rollEnemy(EnemyCatalog* catalog, ushort templateId, Enemy* enemy) {
+  EnemyTemplate* tmpl = &catalog->templates[templateId];
+  uchar ranged = tmpl->ranged;
 
-  cJSON* sw = cJSON_GetObjectItemCaseSensitive(gear, "soulweapon");
-  if (!sw) handleError(ERR_DATA, FATAL, errMsg, "gear soulweapon");
-  boss->gearDrop.sw = createSoulWeapon(sw);
+  enemy->templateId = templateId;
 
-  cJSON* helmet = cJSON_GetObjectItemCaseSensitive(gear, "helmet");
-  if (!helmet) handleError(ERR_DATA, FATAL, errMsg, "gear helmet");
-  boss->gearDrop.helmet = createArmor(helmet);
+  // Always in this order, so the same seed rolls the same enemy from any loader
+  enemy->hp = rollStat(tmpl->hp[0], tmpl->hp[1], ranged & RANGED_HP);
+  enemy->stats.ATK = (ushort) rollStat(tmpl->atk[0], tmpl->atk[1], ranged & RANGED_ATK);
+  enemy->stats.DEF = (ushort) rollStat(tmpl->def[0], tmpl->def[1], ranged & RANGED_DEF);
+  enemy->stats.ACC = (ushort) rollStat(tmpl->acc[0], tmpl->acc[1], ranged & RANGED_ACC);
+  enemy->stats.ATK_CRIT = rollFStat(tmpl->atkCrit[0], tmpl->atkCrit[1], ranged & RANGED_CRIT);
+  enemy->stats.ATK_CRIT_DMG = (ushort) rollStat(tmpl->atkCritDmg[0], tmpl->atkCritDmg[1], ranged & RANGED_CRIT_DMG);
+}
 
-  cJSON* guard = cJSON_GetObjectItemCaseSensitive(gear, "shoulder_guard");
-  if (!guard) handleError(ERR_DATA, FATAL, errMsg, "gear shoulder guard");
-  boss->gearDrop.guard = createArmor(guard);
+void populateEnemy(Maze* maze, uint room, RoomTables* tables) {
+  if (maze->rooms.flags[room] & ROOM_BOSS) {
+    Boss* boss = (Boss*) arenaAlloc(maze->arena, sizeof(Boss));
+    if (!boss) handleError(ERR_MEM, FATAL, "Could not allocate space for boss!\n");
 
-  cJSON* chestplate = cJSON_GetObjectItemCaseSensitive(gear, "chestplate");
-  if (!chestplate) handleError(ERR_DATA, FATAL, errMsg, "gear chestplate");
-  boss->gearDrop.chestplate = createArmor(chestplate);
+    rollEnemy(&maze->catalog, tables->enemies[0], &boss->base);
+    memset(boss->cdTimers, 0, sizeof(boss->cdTimers));
 
-  cJSON* boots = cJSON_GetObjectItemCaseSensitive(gear, "boots");
-  if (!boots) handleError(ERR_DATA, FATAL, errMsg, "gear boots");
-  boss->gearDrop.boots = createArmor(boots);
+    maze->rooms.enemies[room].boss = boss;
+  } else if (tables->enemyCount != 0) {
+    Enemy* enemy = (Enemy*) arenaAlloc(maze->arena, sizeof(Enemy));
+    if (!enemy) handleError(ERR_MEM, FATAL, "Could not allocate space for enemy!\n");
 
+    rollEnemy(&maze->catalog, tables->enemies[randomBelow(RNG_ENEMY, tables->enemyCount)], enemy);
 
-  cJSON* skills = cJSON_GetObjectItemCaseSensitive(obj, "skills");
-  if (!skills) handleError(ERR_DATA, FATAL, errMsg, "skills");
-  for (int i = 0; i < cJSON_GetArraySize(skills); i++) {
-    cJSON* _skill = cJSON_GetArrayItem(skills, i);
-    if (!_skill) handleError(ERR_DATA, FATAL, "Could not get boss skill!\n");
+    maze->rooms.enemies[room].enemy = enemy;
+  }
+}
 
-    Skill* skill = createSkill(_skill);
+void populateRoom(Maze* maze, uint room, RoomTables* tables) {
+  const LootRecord* records = (const LootRecord*) tables->loot;
 
-    // strcpy(boss->skills[i].name, skill->name);
-    boss->skills[i].name = skill->name;
-    // strcpy(boss->skills[i].description, skill->description);
-    boss->skills[i].description = skill->description;
-    boss->skills[i].lvl = skill->lvl;
-    boss->skills[i].cooldown = skill->cooldown;
-    boss->skills[i].cdTimer = 0;
-    boss->skills[i].id = skill->id;
-    boss->skills[i].effect1 = skill->effect1;
-    boss->skills[i].effect2 = skill->effect2;
-    boss->skills[i].activeEffect1 = skill->activeEffect1;
-    boss->skills[i].activeEffect2 = skill->activeEffect2;
+  if (tables->lootCount != 0) maze->rooms.loot[room] = createLootItem(maze->arena, &records[randomBelow(RNG_LOOT, tables->lootCount)]);
+
+  populateEnemy(maze, room, tables);
+}
+
+RoomTables* deferRoom(Arena* arena, EnemyCatalog* catalog, bool hasBoss, cJSON* lootTable, cJSON* enemyTable) {
+  RoomTables* roomTables = (RoomTables*) arenaAlloc(arena, sizeof(RoomTables));
+  if (!roomTables) handleError(ERR_MEM, FATAL, "Could not allocate space for room tables!\n");
+
+  uint lootCount = cJSON_GetArraySize(lootTable);
+
+  roomTables->lootCount = lootCount;
+  roomTables->loot = NULL;
+
+  if (lootCount != 0) {
+    LootRecord* records = (LootRecord*) arenaAlloc(arena, lootCount * sizeof(LootRecord));
+    if (!records) handleError(ERR_MEM, FATAL, "Could not allocate space for room loot!\n");
+
+    cJSON* l = lootTable->child;
+    for (uint i = 0; i < lootCount; i++, l = l->next) readLootRecord(l, &records[i]);
 
-    free(skill);
+    roomTables->loot = records;
   }
 
-  return boss;
-}
+  // Only the first entry of a boss room is ever used
+  uint enemyCount = cJSON_GetArraySize(enemyTable);
+  if (hasBoss) {
+    if (enemyCount == 0) handleError(ERR_DATA, FATAL, "Could not get boss data!\n");
+    enemyCount = 1;
+  }
 
-/**
- * 
- * @param table 
- * @return 
- */
-static Enemy* selectEnemy(cJSON* table) {
-  int len = cJSON_GetArraySize(table);
+  roomTables->enemyCount = enemyCount;
+  roomTables->enemies = NULL;
 
-  if (len == 0) return NULL; // No items in table
+  if (enemyCount != 0) {
+    roomTables->enemies = (ushort*) arenaAlloc(arena, enemyCount * sizeof(ushort));
+    if (!roomTables->enemies) handleError(ERR_MEM, FATAL, "Could not allocate space for room enemies!\n");
+  }
 
-  int i = rand() % len;
+  cJSON* e = enemyTable->child;
+  for (uint i = 0; i < enemyCount; i++, e = e->next) {
+    EnemyTemplate tmpl;
+    readEnemyTemplate(arena, e, hasBoss, &tmpl);
 
-  cJSON* enemy = cJSON_GetArrayItem(table, i);
-  if (!enemy) handleError(ERR_DATA, FATAL, "Could not get enemy!\n");
+    roomTables->enemies[i] = addEnemyTemplate(catalog, &tmpl);
+  }
+
+  // The records and the catalog hold everything needed from the tables
+  cJSON_Delete(lootTable);
+  cJSON_Delete(enemyTable);
 
-  return initEnemy(enemy);
+  return roomTables;
 }
 
 /**
- * Given a cJSON room, it creates a Room structure using its data
+ * Given a cJSON room, it adds the room to the store using its data.
+ * Its loot is read into records and its enemies into the catalog, to be rolled when it is first entered.
+ * Its exits are left as room ids, see connectRooms.
+ * @param rooms The room store of the maze
+ * @param arena The arena of the maze
+ * @param catalog The enemy catalog of the maze
  * @param _room The cJSON room structure
- * @return The new Room
+ * @return The slot of the new room
  */
-static Room* createRoom(cJSON* _room) {
-  Room* room = (Room*) malloc(sizeof(Room));
-  if (!room) handleError(ERR_MEM, FATAL, "Could not allocate space for room!\n");
-
-  room->enemy.enemy = NULL;
-  room->loot = NULL;
-  room->file = NULL;
-
+static uint createRoom(RoomStore* rooms, Arena* arena, EnemyCatalog* catalog, cJSON* _room) {
   cJSON* storyfile = cJSON_GetObjectItemCaseSensitive(_room, "storyfile");
   if (!storyfile) handleError(ERR_DATA, FATAL, "Could not get room storyfile!\n");
 
@@ -630,76 +840,49 @@ static Room* createRoom(cJSON* _room) {
   if (!enemyTable) handleError(ERR_DATA, FATAL, "Could not get room enemies!\n");
 
 
-  room->id = (byte) atoi(_room->string);
-
-  room->hasBoss = (bool) hasBoss->valueint;
+  bool isBoss = (bool) hasBoss->valueint;
 
   // A room w/o storyfile stores an empty string
   size_t storyfileLen = strlen(storyfile->valuestring);
-  if (storyfileLen != 0) {
-    room->storyFile = (str) malloc(sizeof(char) * storyfileLen + 1);
-    if (!room->storyFile) handleError(ERR_MEM, FATAL, "Could not allocate space for room storyfile!\n");
-    strcpy(room->storyFile, storyfile->valuestring);
-  } else room->storyFile = NULL;
-
-  room->info = (str) malloc(sizeof(char) * strlen(info->valuestring) + 1);
-  if (!room->info) handleError(ERR_MEM, FATAL, "Could not allocate space for room info!\n");
-  strcpy(room->info, info->valuestring);
-
-  Item* loot = selectLoot(lootTable);
-  room->loot = loot;
-
-  bool _hasBoss = (bool) hasBoss->valueint;
-
-  if (_hasBoss) {
-    cJSON* _boss = cJSON_GetArrayItem(enemyTable, 0);
-    if (!_boss) handleError(ERR_DATA, FATAL, "Could not get boss data!\n");
-    
-    Boss* boss = initBoss(_boss);
-    room->enemy.boss = boss;
-  } else {
-    Enemy* enemy = selectEnemy(enemyTable);
-    room->enemy.enemy = enemy;
-  }
+  str storyFile = (storyfileLen != 0) ? intern(storyfile->valuestring) : NULL;
+
+  uint room = addRoom(rooms, parseRoomId(_room->string), intern(info->valuestring), storyFile, isBoss ? ROOM_BOSS : 0);
+
+  cJSON_DetachItemViaPointer(_room, lootTable);
+  cJSON_DetachItemViaPointer(_room, enemyTable);
+  rooms->tables[room] = deferRoom(arena, catalog, isBoss, lootTable, enemyTable);
 
   cJSON* e = NULL;
   int i = 0;
   cJSON_ArrayForEach(e, exits) {
-    if (e->valueint == -1) room->exits[i] = (void*) ((long long) NO_EXIT);
-    else room->exits[i] = (void*) ((long long) e->valueint);
+    rooms->exits[room][i] = (e->valueint == -1) ? NO_ROOM : (uint) e->valueint;
 
     i++;
   };
 
-  return room;
-}
+  cJSON* pos = cJSON_GetObjectItemCaseSensitive(_room, "pos");
+  if (pos) rooms->pos[room] = (RoomPos) { cJSON_GetArrayItem(pos, 0)->valueint, cJSON_GetArrayItem(pos, 1)->valueint };
 
-// To move out????
-Room* connectRooms(Table* table) {
-  Room *entry, *room;
+  cJSON* visited = cJSON_GetObjectItemCaseSensitive(_room, "visited");
+  if (visited && visited->valueint == 1) setRoomSeen(rooms, room);
 
-  // Iterate though the table, getting each room
-  for (int i = 0; i < table->len; i++) {
-    room = table->rooms[i];
+  return room;
+}
 
-    if (room->id == 0) entry = room;
-    
-    // For a given room, iterate through its exits to connect
-    for (int j = 0; j < 4; j++) {
-      // Skip the ones that have no exit, keep the pointer to NO_EXIT
-      if ((long long) room->exits[j] != NO_EXIT) {
-        // Get the temp "address", aka the ids in terms of addresses/hex
-        long long id = (long long) room->exits[j];
+Maze* initMaze(const str filename) {
+  // Prefer the compiled maze when one was built from this map
+  str binFile = mazeBinFor(filename);
+  if (binFile) {
+    Maze* maze = loadMazeBin(binFile);
+    free(binFile);
 
-        room->exits[j] = table->rooms[id];
-      }
-    }
+    return maze;
   }
 
-  return entry;
+  return parseMaze(filename);
 }
 
-Maze* initMaze(const str filename) {
+Maze* initMazeDOM(const str filename) {
   cJSON* root = readData(filename);
   if (!root) handleError(ERR_DATA, FATAL, "Could not parse JSON!\n");
 
@@ -712,43 +895,60 @@ Maze* initMaze(const str filename) {
   cJSON* mazeName = cJSON_GetObjectItemCaseSensitive(root, "name");
   if (!mazeName) handleError(ERR_DATA, FATAL, "Maze name could not be found!\n");
 
+  // Everything created for the maze comes from its arena
+  Arena* arena = initArena(ARENA_CHUNK_SIZE);
+
   // Since "name" is the first child, the actual rooms start after that
   cJSON* roomI = root->child->next;
-  int mazeSize = 0;
 
-  Table* roomTable = initTable();
+  // Count the rooms first, so the table and the store are allocated once
+  uint roomCount = 0, maxId = 0;
+  for (cJSON* r = roomI; r; r = r->next, roomCount++) {
+    uint id = parseRoomId(r->string);
+    if (id > maxId) maxId = id;
+  }
+
+  Table* roomTable = initTableL(roomCount, maxId);
   if (!roomTable) handleError(ERR_MEM, FATAL, "Could not allocate space for the table!\n");
 
+  RoomStore rooms;
+  initRoomStore(&rooms, roomCount);
+
+  EnemyCatalog catalog = { NULL, 0, 0 };
+
   while (roomI) {
     // Traversing through the rooms
 
     // Maybe validate each section, and if validated, add to the structure??
     // Instead of validating everything then getting/adding????
     validateRoom(roomI);
-    Room* room = createRoom(roomI);
-    mazeSize++;
 
-    putRoom(roomTable, room, true);
+    // A room with a repeated id is dropped, the first one is kept
+    uint id = parseRoomId(roomI->string);
+    if (putRoom(roomTable, id, rooms.len, true)) createRoom(&rooms, arena, &catalog, roomI);
 
     roomI = roomI->next;
   }
 
-  // fprintf(stdout, "%d rooms have been created...", mazeSize);
-
-  Room* entry = connectRooms(roomTable);
-  if (!entry) handleError(ERR_DATA, FATAL, "Entry is null!\n");
+  uint entry = connectRooms(&rooms, roomTable);
+  if (entry == NO_ROOM) handleError(ERR_DATA, FATAL, "Entry is null!\n");
 
   // Maybe a function to make sure all rooms have at least one connection???
-  deleteTable(roomTable);
 
   Maze* maze = (Maze*) malloc(sizeof(Maze));
   if (!maze) handleError(ERR_MEM, FATAL, "Could not allocate space for maze!\n");
 
   maze->entry = entry;
-  maze->size = mazeSize;
-  maze->name = (str) malloc(strlen(mazeName->valuestring) + 1);
-  if (!maze->name) handleError(ERR_MEM, FATAL, "Could not allocate space for the maze name!\n");
-  strcpy(maze->name, mazeName->valuestring);
+  maze->rooms = rooms;
+  maze->ids = roomTable;
+  maze->arena = arena;
+  maze->tables = NULL;
+  maze->catalog = catalog;
+  maze->tablesType = TABLES_JSON;
+  maze->name = intern(mazeName->valuestring);
+  maze->frame = (MapFrame) { 0 };
+
+  layoutMaze(maze);
 
   cJSON_Delete(root);
 
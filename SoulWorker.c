@@ -3,7 +3,11 @@
 #include <string.h>
 
 #include "SoulWorker.h"
+#include "Damage.h"
 #include "Error.h"
+#include "Intern.h"
+#include "Random.h"
+#include "Screen.h"
 
 #define NO_ITEM NULL
 #define NO_SKILL NULL
@@ -26,7 +30,7 @@ SoulWorker* initSoulWorker(str name) {
   sw->dzenai = 0;
   sw->maxHP = 5;
 
-  sw->room = NULL;
+  sw->room = NO_ROOM;
 
   // Set gear
   sw->gear.sw = NO_ITEM;
@@ -54,6 +58,7 @@ SoulWorker* initSoulWorker(str name) {
   stats->ATK_CRIT_DMG = 2;
   stats->ATK_CRIT = 0.05;
   sw->stats = stats;
+  updateStats(sw);
 
   // Set skill tree
   sw->skills = initSkillTree();
@@ -190,15 +195,17 @@ void removeFromInv(SoulWorker* sw, Item* item, ushort count) {
 }
 
 void viewInventory(SoulWorker* sw) {
-  if (sw->invCount == 0) printf("You have no items.\n");
+  beginScreen();
+
+  if (sw->invCount == 0) screenPrintf("You have no items.\n");
   else {
-    printf("You have %d item%s: \n", sw->invCount, (sw->invCount == 1) ? "" : "s");
+    screenPrintf("You have %d item%s: \n", sw->invCount, (sw->invCount == 1) ? "" : "s");
 
     for (int i = 0; i < INV_CAP; i++) {
       if (sw->inv[i]._item != NO_ITEM) {
         str name = getItemName(&(sw->inv[i]));
 
-        printf("%d: %s * %d\n", i+1, name, sw->inv[i].count);
+        screenPrintf("%d: %s * %d\n", i+1, name, sw->inv[i].count);
 
         // Since some strings have been alloc'd, free them
         switch (sw->inv[i].type) {
@@ -213,6 +220,8 @@ void viewInventory(SoulWorker* sw) {
       }
     }
   }
+
+  presentScreen();
 }
 
 /**
@@ -266,11 +275,11 @@ static void viewGear(SoulWorker* sw) {
   if (boots == NO_ITEM) sprintf(bootsStats, "Unequipped");
   else sprintf(bootsStats, "%s; LVL: %d, ACC: %d, DEF: %d", boots->name, boots->lvl, boots->acc, boots->def);
 
-  printf("SoulWeapon: %s\n", weaponStats);
-  printf("Helmet: %s\n", helmetStats);
-  printf("Shoulder Guard: %s\n", shoulderGuardStats);
-  printf("Chestplate: %s\n", chestplateStats);
-  printf("Boots: %s\n", bootsStats);
+  screenPrintf("SoulWeapon: %s\n", weaponStats);
+  screenPrintf("Helmet: %s\n", helmetStats);
+  screenPrintf("Shoulder Guard: %s\n", shoulderGuardStats);
+  screenPrintf("Chestplate: %s\n", chestplateStats);
+  screenPrintf("Boots: %s\n", bootsStats);
 
   free(weaponStats);
   free(helmetStats);
@@ -286,28 +295,18 @@ void viewSelf(SoulWorker* sw) {
    * ATK: [atk]; DEF: [def]; ACC: [acc]; ATK CRIT DMG: [atk_crit_dmg]; ATK CRIT: [atk_crit]\n
    */
 
-  Gear* gear = &(sw->gear);
+  Stats* total = &sw->totalStats;
+
+  beginScreen();
 
-  // Maybe something nicer looking or better??
-  uint totalAtk = sw->stats->ATK + ((gear->sw != NO_ITEM) ? gear->sw->atk : 0);
-  uint totalDef = sw->stats->DEF + ((gear->helmet != NO_ITEM) ? gear->helmet->def : 0) + 
-                                   ((gear->guard != NO_ITEM) ? gear->guard->def : 0) + 
-                                   ((gear->chestplate != NO_ITEM) ? gear->chestplate->def : 0) +
-                                   ((gear->boots != NO_ITEM) ? gear->boots->def : 0);
-  uint totalAcc = sw->stats->ACC + ((gear->sw != NO_ITEM) ? gear->sw->acc : 0) +                                   
-                                   ((gear->helmet != NO_ITEM) ? gear->helmet->acc : 0) + 
-                                   ((gear->guard != NO_ITEM) ? gear->guard->acc : 0) + 
-                                   ((gear->chestplate != NO_ITEM) ? gear->chestplate->acc : 0) +
-                                   ((gear->boots != NO_ITEM) ? gear->boots->acc : 0);
-  uint totalCritDmg = sw->stats->ATK_CRIT_DMG + ((gear->sw != NO_ITEM) ? gear->sw->atk_crit_dmg : 0);
-  float totalCrit = sw->stats->ATK_CRIT + ((gear->sw != NO_ITEM) ? gear->sw->atk_crit : 0);
-
-  printf("%s, LVL %d; %s%d%s/%d\nXP: %d/%d; %d DZ\nATK: %d; DEF: %d; ACC: %d; ATK CRIT DMG: %d; ATK CRIT: %3.2f\n\n", 
+  screenPrintf("%s, LVL %d; %s%d%s/%d\nXP: %d/%d; %d DZ\nATK: %d; DEF: %d; ACC: %d; ATK CRIT DMG: %d; ATK CRIT: %3.2f\n\n", 
           sw->name, sw->lvl, (sw->hp <= (sw->maxHP / 2)) ? RED : GREEN, sw->hp, RESET, sw->maxHP, 
           sw->xp, sw->xpReq, sw->dzenai,
-          totalAtk, totalDef, totalAcc, totalCritDmg, totalCrit);
+          total->ATK, total->DEF, total->ACC, total->ATK_CRIT_DMG, total->ATK_CRIT);
           
   viewGear(sw);
+
+  presentScreen();
 }
 
 /**
@@ -323,21 +322,21 @@ void skillRow(SkillTree* skillTree, int start, int end, int COL_WIDTH) {
 
 // Print slot/id
   for (int i = start; i < end; i++) {
-    printf("|%s%*d%*s%s", isSkillUnlocked(skillTree, i + 1) ? UNLOCKED : LOCKED, COL_WIDTH / 2, i + 1, COL_WIDTH / 2, " ", RESET);
+    screenPrintf("|%s%*d%*s%s", isSkillUnlocked(skillTree, i + 1) ? UNLOCKED : LOCKED, COL_WIDTH / 2, i + 1, COL_WIDTH / 2, " ", RESET);
   }
-  printf("|\n");
+  screenPrintf("|\n");
 
   // Print name and level
   for (int i = start; i < end; i++) {
-    printf("| %-*s LVL %d", COL_WIDTH - 7, skillTree->skills[i].name, skillTree->skills[i].lvl);
+    screenPrintf("| %-*s LVL %d", COL_WIDTH - 7, skillTree->skills[i].name, skillTree->skills[i].lvl);
   }
-  printf("|\n");
+  screenPrintf("|\n");
 
   // Print cooldown
   for (int i = start; i < end; i++) {
-    printf("| CD: %-*d", COL_WIDTH - 5, skillTree->skills[i].cooldown);
+    screenPrintf("| CD: %-*d", COL_WIDTH - 5, skillTree->skills[i].cooldown);
   }
-  printf("|\n");
+  screenPrintf("|\n");
 
 
   str activeEffect;
@@ -363,9 +362,9 @@ void skillRow(SkillTree* skillTree, int start, int end, int COL_WIDTH) {
         break;
     }
 
-    printf("| %s: %-*d", activeEffect, COL_WIDTH - 6, effect);
+    screenPrintf("| %s: %-*d", activeEffect, COL_WIDTH - 6, effect);
   }
-  printf("|\n");
+  screenPrintf("|\n");
 
   // Print effect 2
   for (int i = start; i < end; i++) {
@@ -388,19 +387,19 @@ void skillRow(SkillTree* skillTree, int start, int end, int COL_WIDTH) {
         break;
     }
 
-    if (_activeEffect == ATK_CRIT) printf("| %s: %-*.2f", activeEffect, (COL_WIDTH / 2) - 1, effectF);
-    else printf("| %s: %-*d", activeEffect, COL_WIDTH - 6, effect);
+    if (_activeEffect == ATK_CRIT) screenPrintf("| %s: %-*.2f", activeEffect, (COL_WIDTH / 2) - 1, effectF);
+    else screenPrintf("| %s: %-*d", activeEffect, COL_WIDTH - 6, effect);
   }
-  printf("|\n");
+  screenPrintf("|\n");
 
   // Print seperator
-  printf("|");
+  screenPrintf("|");
   for (int i = start; i < end; i++) {
     for (int j = 0; j < COL_WIDTH + 1; j++) {
-      printf("-");
+      screenPrintf("-");
     }
   }
-  printf("|\n");
+  screenPrintf("|\n");
 }
 
 void viewSkills(SkillTree* skillTree) {
@@ -421,20 +420,23 @@ void viewSkills(SkillTree* skillTree) {
    * Current Skill Points: []
    */
 
-  printf("%sSkills:%s\n", CYAN, RESET);
+  beginScreen();
+
+  screenPrintf("%sSkills:%s\n", CYAN, RESET);
 
   skillRow(skillTree, 0, TOTAL_SKILLS / 2, COL_WIDTH);
   skillRow(skillTree, TOTAL_SKILLS / 2, TOTAL_SKILLS, COL_WIDTH);
 
-  printf("Active skills:\n");
+  screenPrintf("Active skills:\n");
   for (int i = 0; i < EQUIPPED_SKILL_COUNT; i++) {
-    if (skillTree->equippedSkills[i] == NO_SKILL) printf("| %-*s", COL_WIDTH - 1, "");
-    else printf("| %-*s", COL_WIDTH - 1, skillTree->equippedSkills[i]->name);
+    if (skillTree->equippedSkills[i] == NO_SKILL) screenPrintf("| %-*s", COL_WIDTH - 1, "");
+    else screenPrintf("| %-*s", COL_WIDTH - 1, skillTree->equippedSkills[i]->name);
   }
-  printf("|\n");
+  screenPrintf("|\n");
 
-  printf("Current Skill Points: %d\n", skillTree->totalSkillPoints);
+  screenPrintf("Current Skill Points: %d\n", skillTree->totalSkillPoints);
 
+  presentScreen();
 }
 
 void viewSkill(Skill* skill) {
@@ -646,6 +648,8 @@ void unequipGear(SoulWorker* sw) {
 
   free(gear);
   gear = NULL;
+
+  updateStats(sw);
 }
 
 void equipGear(SoulWorker* sw, Item* item) {
@@ -701,6 +705,8 @@ void equipGear(SoulWorker* sw, Item* item) {
     sw->invCount--;
   }
 
+  updateStats(sw);
+
   printf("Equipped!\n");
 }
 
@@ -769,9 +775,15 @@ static void levelUp(SoulWorker* sw) {
 
   stats->ATK += stats->ATK * growthFactor * (1 + (1) / 100.0);
   stats->ACC += stats->ACC * growthFactor * (1 + (1) / 100.0);
-  stats->ATK_CRIT += stats->ATK_CRIT * growthFactor; // * (1 + (rand() % 1) / 100.0);
-  stats->ATK_CRIT_DMG += stats->ATK_CRIT_DMG * growthFactor * (1 + (rand() % 1) / 100.0);
+  stats->ATK_CRIT += stats->ATK_CRIT * growthFactor; // * (1 + randomBelow(RNG_LEVEL, 1) / 100.0);
+  stats->ATK_CRIT_DMG += stats->ATK_CRIT_DMG * growthFactor * (1 + randomBelow(RNG_LEVEL, 1) / 100.0);
   stats->DEF += stats->DEF * growthFactor * (1 + (1) / 100.0);
+
+  updateStats(sw);
+}
+
+void updateStats(SoulWorker* sw) {
+  sw->totalStats = gearStats(sw->stats, &sw->gear);
 }
 
 void updateXP(SoulWorker* sw, uint xp) {
@@ -804,6 +816,13 @@ void updateXP(SoulWorker* sw, uint xp) {
   if (leveledUp) printf("Leveled up to LVL %d!\n", sw->lvl);
 }
 
+void setLevel(SoulWorker* sw, uint lvl) {
+  while (sw->lvl < lvl) levelUp(sw);
+
+  sw->xp = 0;
+  sw->xpReq = xpRequired(sw->lvl);
+}
+
 /**
  * Initiates the skill tree for the player.
  * The skills are predetermined. It is only a matter of unlocking.
@@ -839,21 +858,13 @@ static SkillTree* initSkillTree() {
 
     fgets(buffer, SIZE, skillsFile);
     if ((pos = strchr(buffer, '\n')) != NULL) *pos = '\0';
-#ifdef _WIN64
-    name = _strdup(buffer);
-#else
-    name = strdup(buffer);
-#endif
+    name = intern(buffer);
     // printf("name: %s\n", name);
 
     fgets(buffer, SIZE, skillsFile);
     if ((pos = strchr(buffer, '\n')) != NULL) *pos = '\0';
     // printf("Buffer for desc: %s\n", buffer);
-#ifdef _WIN64
-    description = _strdup(buffer);
-#else
-    description = strdup(buffer);
-#endif
+    description = intern(buffer);
     // printf("description: %s\n", description);
 
     fgets(buffer, 5, skillsFile);
@@ -906,8 +917,7 @@ static SkillTree* initSkillTree() {
  * @param skillTree 
  */
 static void deleteSkillTree(SkillTree* skillTree) {
-  deleteSkills(skillTree->skills, TOTAL_SKILLS);
-
+  // Skill names and descriptions are interned
   free(skillTree);
 }
 
@@ -0,0 +1,344 @@
+#include <stdlib.h>
+#include <stdint.h>
+
+#ifndef _WIN64
+  #include <unistd.h>
+#endif
+
+#include "Error.h"
+#include "Workers.h"
+
+
+#ifdef _WIN64
+  typedef CRITICAL_SECTION lock_t;
+  typedef CONDITION_VARIABLE cond_t;
+  #define initLock(l) InitializeCriticalSection(l)
+  #define lock(l) EnterCriticalSection(l)
+  #define unlock(l) LeaveCriticalSection(l)
+  #define initCond(c) InitializeConditionVariable(c)
+  #define waitCond(c, l) SleepConditionVariableCS(c, l, INFINITE)
+  #define signalCond(c) WakeConditionVariable(c)
+  #define broadcastCond(c) WakeAllConditionVariable(c)
+#else
+  typedef pthread_mutex_t lock_t;
+  typedef pthread_cond_t cond_t;
+  #define initLock(l) pthread_mutex_init(l, NULL)
+  #define lock(l) pthread_mutex_lock(l)
+  #define unlock(l) pthread_mutex_unlock(l)
+  #define initCond(c) pthread_cond_init(c, NULL)
+  #define waitCond(c, l) pthread_cond_wait(c, l)
+  #define signalCond(c) pthread_cond_signal(c)
+  #define broadcastCond(c) pthread_cond_broadcast(c)
+#endif
+
+#define DEQUE_CAP 64 // Starting capacity of a deque, always a power of 2
+
+// A part of a job, see runWorkers
+typedef struct WorkerPart { // 20B+4B(PAD) = 24B
+  work_f work; // Does the part   8B
+  void* ctx; // The context of the job   8B
+  uint worker; // Which part it is   4B
+} WorkerPart;
+
+// A task waiting in a deque
+typedef struct Task {   // 24B
+  task_f run; //           8B
+  void* arg; //            8B
+  TaskGroup* group; //     8B
+} Task;
+
+// The tasks of one thread of the pool. The owner pushes and takes at the bottom, thieves take from the top.
+typedef struct TaskDeque {            // 20B+4B(PAD)+lock
+  Task* tasks; // Ring of cap tasks        8B
+  uint cap; //                             4B
+  uint top; // The oldest task             4B
+  uint bottom; // Where the next is pushed 4B
+  lock_t lock;
+} TaskDeque;
+
+// The pool, started by the first task and kept until the program ends
+typedef struct Pool {
+  uint count; // Number of threads
+  uint queued; // Tasks in the deques, guarded by lock
+  lock_t lock;
+  cond_t wake; // Tasks were queued
+  cond_t done; // A group is done
+  TaskDeque deques[MAX_WORKERS + 1]; // [0] is shared by every thread outside the pool
+} Pool;
+
+static uint workers = 0; // Set by setWorkerCount, 0 for one per CPU
+
+static Pool pool;
+static THREAD_LOCAL uint self = 0; // The deque of the calling thread
+
+
+void startThread(_THREAD_RETURN (*routine)(void*), void* arg, thread_t* thread) {
+#ifdef _WIN64
+  HANDLE handle = CreateThread(NULL, 0, routine, arg, 0, NULL);
+  if (!handle) handleError(ERR_MEM, FATAL, "Could not create thread!\n");
+
+  if (thread) *thread = handle;
+  else CloseHandle(handle);
+#else
+  pthread_t handle;
+
+  int threadRet = pthread_create(&handle, NULL, routine, arg);
+  if (threadRet != 0) handleError(ERR_MEM, FATAL, "Could not create thread!\n");
+
+  if (thread) *thread = handle;
+  else pthread_detach(handle);
+#endif
+}
+
+void joinThread(thread_t thread) {
+#ifdef _WIN64
+  WaitForSingleObject(thread, INFINITE);
+  CloseHandle(thread);
+#else
+  pthread_join(thread, NULL);
+#endif
+}
+
+uint workerCount() {
+  if (workers != 0) return workers;
+
+#ifdef _WIN64
+  SYSTEM_INFO info;
+  GetSystemInfo(&info);
+  long cpus = (long) info.dwNumberOfProcessors;
+#else
+  long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+#endif
+
+  if (cpus < 1) return 1;
+  return (cpus > MAX_WORKERS) ? MAX_WORKERS : (uint) cpus;
+}
+
+void setWorkerCount(uint count) {
+  workers = (count > MAX_WORKERS) ? MAX_WORKERS : count;
+}
+
+/**
+ * Pushes the task at the bottom of the deque.
+ * @param deque The deque
+ * @param task The task
+ */
+static void pushTask(TaskDeque* deque, const Task* task) {
+  lock(&deque->lock);
+
+  if (deque->bottom - deque->top == deque->cap) {
+    uint cap = deque->cap * 2;
+
+    Task* tasks = (Task*) malloc(cap * sizeof(Task));
+    if (!tasks) handleError(ERR_MEM, FATAL, "Could not allocate space for the tasks!\n");
+
+    // Unwrap the ring into the bigger one
+    for (uint i = deque->top; i != deque->bottom; i++) tasks[i & (cap - 1)] = deque->tasks[i & (deque->cap - 1)];
+
+    free(deque->tasks);
+    deque->tasks = tasks;
+    deque->cap = cap;
+  }
+
+  deque->tasks[deque->bottom++ & (deque->cap - 1)] = *task;
+
+  unlock(&deque->lock);
+}
+
+/**
+ * Takes a task off the deque.
+ * @param deque The deque
+ * @param newest Whether to take the newest (the owner) or the oldest (a thief)
+ * @param task Where to store the task
+ * @return Whether there was a task
+ */
+static bool popTask(TaskDeque* deque, bool newest, Task* task) {
+  lock(&deque->lock);
+
+  bool found = deque->top != deque->bottom;
+  if (found) {
+    if (newest) *task = deque->tasks[--deque->bottom & (deque->cap - 1)];
+    else *task = deque->tasks[deque->top++ & (deque->cap - 1)];
+  }
+
+  unlock(&deque->lock);
+
+  return found;
+}
+
+/**
+ * Takes a task for the calling thread: its own newest, or else the oldest of another deque.
+ * @param task Where to store the task
+ * @return Whether there was a task
+ */
+static bool takeTask(Task* task) {
+  bool found = popTask(&pool.deques[self], true, task);
+
+  for (uint i = 1; !found && i <= pool.count; i++) {
+    found = popTask(&pool.deques[(self + i) % (pool.count + 1)], false, task);
+  }
+
+  if (found) {
+    lock(&pool.lock);
+    pool.queued--;
+    unlock(&pool.lock);
+  }
+
+  return found;
+}
+
+/**
+ * Runs the task and counts it done in its group.
+ * @param task The task
+ */
+static void runTask(Task* task) {
+  task->run(task->arg);
+
+  if (!task->group) return;
+
+  lock(&pool.lock);
+  if (--task->group->pending == 0) broadcastCond(&pool.done);
+  unlock(&pool.lock);
+}
+
+/**
+ * Runs tasks for as long as the program runs.
+ * @param _self The deque of the thread
+ * @return Never
+ */
+static _THREAD_RETURN poolLoop(void* _self) {
+  self = (uint) (uintptr_t) _self;
+
+  Task task;
+
+  while (true) {
+    if (takeTask(&task)) { runTask(&task); continue; }
+
+    lock(&pool.lock);
+    while (pool.queued == 0) waitCond(&pool.wake, &pool.lock);
+    unlock(&pool.lock);
+  }
+
+  return _THREAD_DONE;
+}
+
+/**
+ * Starts the threads of the pool.
+ */
+static void startPool() {
+  pool.count = workerCount();
+  pool.queued = 0;
+
+  initLock(&pool.lock);
+  initCond(&pool.wake);
+  initCond(&pool.done);
+
+  for (uint i = 0; i <= pool.count; i++) {
+    TaskDeque* deque = &pool.deques[i];
+
+    deque->tasks = (Task*) malloc(DEQUE_CAP * sizeof(Task));
+    if (!deque->tasks) handleError(ERR_MEM, FATAL, "Could not allocate space for the tasks!\n");
+
+    deque->cap = DEQUE_CAP;
+    deque->top = deque->bottom = 0;
+    initLock(&deque->lock);
+  }
+
+  // Every deque is ready before any thread can steal from it
+  for (uint i = 1; i <= pool.count; i++) startThread(poolLoop, (void*) (uintptr_t) i, NULL);
+}
+
+#ifdef _WIN64
+static INIT_ONCE poolOnce = INIT_ONCE_STATIC_INIT;
+
+static BOOL CALLBACK startPoolOnce(PINIT_ONCE once, PVOID param, PVOID* ctx) {
+  startPool();
+  return TRUE;
+}
+
+  #define ensurePool() InitOnceExecuteOnce(&poolOnce, startPoolOnce, NULL, NULL)
+#else
+static pthread_once_t poolOnce = PTHREAD_ONCE_INIT;
+
+  #define ensurePool() pthread_once(&poolOnce, startPool)
+#endif
+
+void submitTask(TaskGroup* group, task_f task, void* arg) {
+  ensurePool();
+
+  Task queuedTask = { task, arg, group };
+
+  // Counted before it is pushed, so it cannot be done before it is counted
+  if (group) {
+    lock(&pool.lock);
+    group->pending++;
+    unlock(&pool.lock);
+  }
+
+  pushTask(&pool.deques[self], &queuedTask);
+
+  lock(&pool.lock);
+  pool.queued++;
+  signalCond(&pool.wake);
+  unlock(&pool.lock);
+}
+
+void waitTasks(TaskGroup* group) {
+  ensurePool();
+
+  Task task;
+
+  while (true) {
+    lock(&pool.lock);
+    bool pending = group->pending != 0;
+    unlock(&pool.lock);
+
+    if (!pending) return;
+
+    // Help instead of sleeping, the group may be waiting on a task in some deque
+    if (takeTask(&task)) { runTask(&task); continue; }
+
+    lock(&pool.lock);
+    while (group->pending != 0 && pool.queued == 0) waitCond(&pool.done, &pool.lock);
+    unlock(&pool.lock);
+  }
+}
+
+uint poolWorker() {
+  return self;
+}
+
+uint poolSize() {
+  ensurePool();
+
+  return pool.count;
+}
+
+/**
+ * Does the part of the job.
+ * @param _part The part
+ */
+static void runPart(void* _part) {
+  WorkerPart* part = (WorkerPart*) _part;
+
+  part->work(part->ctx, part->worker);
+}
+
+void runWorkers(uint count, work_f work, void* ctx) {
+  if (count > MAX_WORKERS) handleError(ERR_DATA, FATAL, "Cannot split a job across more than %d workers!\n", MAX_WORKERS);
+
+  WorkerPart parts[MAX_WORKERS];
+  TaskGroup group = { 0 };
+
+  for (uint i = 1; i < count; i++) {
+    parts[i].work = work;
+    parts[i].ctx = ctx;
+    parts[i].worker = i;
+
+    submitTask(&group, runPart, &parts[i]);
+  }
+
+  if (count > 0) work(ctx, 0);
+
+  waitTasks(&group);
+}
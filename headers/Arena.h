@@ -0,0 +1,75 @@
+#ifndef _ARENA_H
+#define _ARENA_H
+
+#include <stddef.h>
+
+#include "Misc.h"
+
+
+#define ARENA_CHUNK_SIZE 16384 // The default size of a chunk, enough for a small maze
+#define ARENA_ALIGNMENT (2 * sizeof(void*)) // Makes sure the right alignment on 32/64 bits
+
+// A single block of memory that the arena hands out from
+typedef struct ArenaChunk {
+  struct ArenaChunk* next; // The next chunk
+  size_t cap; // The capacity of the buffer
+  char buffer[]; // The memory
+} ArenaChunk;
+
+// A bump allocator. Everything allocated from it is freed all at once.
+typedef struct Arena {                                 // 32B
+  ArenaChunk* root; // The first chunk                     8B
+  ArenaChunk* current; // The chunk being allocated from   8B
+  size_t offset; // The offset into the current chunk      8B
+  size_t chunkSize; // The size of new chunks              8B
+} Arena;
+
+
+/**
+ * Initiates an arena.
+ * @param chunkSize The size of each chunk
+ * @return The arena
+ */
+Arena* initArena(size_t chunkSize);
+
+/**
+ * Allocates zeroed memory from the arena.
+ * If arena is NULL, the memory comes from the heap instead and must be freed by the caller.
+ * @param arena The arena, or NULL
+ * @param size The amount of bytes
+ * @return The memory
+ */
+void* arenaAlloc(Arena* arena, size_t size);
+
+/**
+ * Copies the string into the arena.
+ * If arena is NULL, the copy is on the heap instead and must be freed by the caller.
+ * @param arena The arena, or NULL
+ * @param s The string to copy
+ * @return The copy
+ */
+str arenaString(Arena* arena, const char* s);
+
+/**
+ * Resets the arena so its memory can be used again, keeping the chunks.
+ * Everything that was allocated from it is no longer valid.
+ * @param arena The arena
+ */
+void resetArena(Arena* arena);
+
+/**
+ * Moves every chunk of the other arena into the arena, so they are freed with it.
+ * What was allocated from the other arena stays where it is. The other arena is deleted.
+ * @param arena The arena
+ * @param other The arena to take the chunks of
+ */
+void adoptArena(Arena* arena, Arena* other);
+
+/**
+ * Deletes the arena, freeing all of its memory at once.
+ * @param arena The arena to delete
+ */
+void deleteArena(Arena* arena);
+
+
+#endif
@@ -29,10 +29,4 @@ void battleEnemy(Enemy* enemy);
  */
 bool bossBattle(Boss* boss);
 
-/**
- * Wrapper around sleep function for Windows and Linux.
- * @param ms Amount of milliseconds to sleep for
- */
-void ssleep(int ms);
-
 #endif
\ No newline at end of file
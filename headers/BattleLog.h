@@ -0,0 +1,116 @@
+#ifndef _BATTLELOG_H
+#define _BATTLELOG_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+#include "Misc.h"
+
+
+#define BATTLE_LOG_PATH "./data/saves/battle.log"
+#define BATTLE_LOG_MAGIC "CLSWLOG" // The first 8 bytes of a log, with its null
+#define BATTLE_LOG_VERSION 1
+#define BATTLE_LOG_EVENTS 4096 // The events kept, the oldest are written over. A power of 2
+#define NO_SKILL 0xFF // The skill of a basic attack
+
+// The bytes of a Skill that change its damage, from effect1 to activeEffect2
+#define SKILL_EFFECTS_SIZE (offsetof(Skill, activeEffect2) + sizeof(effect_t) - offsetof(Skill, effect1))
+
+typedef enum {
+  LOG_BEGIN, // A battle starts, value is 1 for a boss
+  LOG_SIDE, // The stats of one side as the battle starts, value is its level
+  LOG_SKILL, // A skill in play, skill is its slot as in Cooldowns
+  LOG_ROUND, // An attack, value is the turn
+  LOG_END // The battle is over, value is 1 if the player won
+} log_event_t;
+
+typedef enum {
+  SIDE_PLAYER,
+  SIDE_ENEMY
+} side_t;
+
+// What happened in a battle, all the same size so logging one only fills the next slot.
+typedef struct BattleEvent {    // 24B
+  uchar type; // See log_event_t        1B
+  uchar side; // See side_t, for a round the attacker  1B
+  uchar skill; // The slot of the skill, NO_SKILL if none  1B
+  uchar pad; //                         1B
+  uint value; // See log_event_t        4B
+  union { //                            16B
+    struct {
+      Stats stats; // With the gear on  12B
+      uint hp; //                       4B
+    } start;
+    uchar effects[SKILL_EFFECTS_SIZE]; // Copied from the Skill  16B
+    struct {
+      uint64_t rng; // RNG_BATTLE before the rolls, see getRandomState  8B
+      uint hpAfter; // The HP the target has left  4B
+      ushort dmg; // 0 for a miss       2B
+    } round;
+  };
+} BattleEvent;
+
+// What a log file starts with, followed by its events from oldest to newest.
+typedef struct BattleLogHeader {   // 32B
+  char magic[8]; // BATTLE_LOG_MAGIC        8B
+  uint version; // BATTLE_LOG_VERSION      4B
+  uint count; // The events that follow    4B
+  uint64_t seed; // The seed of the game    8B
+  uint64_t dropped; // The older events written over  8B
+} BattleLogHeader;
+
+
+/**
+ * Starts keeping the log of the game's battles, dropping anything logged before. It is written
+ * to the file when the game exits, or is killed or crashes, as long as a battle was fought.
+ * @param path Where to write the log
+ * @param seed The seed of the game
+ */
+void openBattleLog(const char* path, uint64_t seed);
+
+/**
+ * Logs the start of a battle. The sides, and the skills for a boss, are logged right after.
+ * @param boss Whether it is a boss battle
+ */
+void logBegin(bool boss);
+
+/**
+ * Logs a side of the battle as it starts.
+ * @param side The side
+ * @param stats The stats, with the gear on
+ * @param hp The HP
+ * @param lvl The level
+ */
+void logSide(side_t side, const Stats* stats, uint hp, uint lvl);
+
+/**
+ * Logs a skill that can be used in the battle.
+ * @param slot The slot, PLAYER_CD or BOSS_CD plus the skill
+ * @param skill The skill
+ */
+void logSkill(uint slot, const Skill* skill);
+
+/**
+ * Logs an attack. Meant to be cheap enough to log every one.
+ * @param side The attacker
+ * @param skill The slot of the skill used, NO_SKILL for the basic
+ * @param turn The turn of the battle
+ * @param rng The state of RNG_BATTLE before the attack rolled
+ * @param dmg The damage
+ * @param hpAfter The HP the target has left
+ */
+void logRound(side_t side, uint skill, uint turn, uint64_t rng, ushort dmg, uint hpAfter);
+
+/**
+ * Logs the end of a battle.
+ * @param won Whether the player won
+ */
+void logEnd(bool won);
+
+/**
+ * Writes the log to its file, once. Safe to call from a signal handler.
+ */
+void flushBattleLog();
+
+
+#endif
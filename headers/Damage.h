@@ -0,0 +1,113 @@
+#ifndef _DAMAGE_H
+#define _DAMAGE_H
+
+#include <stdint.h>
+
+#include "Misc.h"
+
+
+#define PLAYER_CD 0 // The first cooldown of the player's equipped skills, in slot order
+#define BOSS_CD 5 // The first cooldown of the boss skills, right after the player's EQUIPPED_SKILL_COUNT
+#define MAX_CD 0x7F // The longest a timer runs, so every timer fits in 7 bits
+
+// Every cooldown of a battle, packed so one step ticks them all.
+typedef union Cooldowns {   // 16B
+  char timers[16]; // The turns left, see PLAYER_CD and BOSS_CD  16B
+  uint64_t words[2]; // The same, to tick 8 at a time
+} Cooldowns;
+
+
+// The rolls of a battle, shared by the game and the simulator so both hit the same.
+// Everything rolls from RNG_BATTLE and RNG_BOSS, nothing here prints or waits.
+
+
+/**
+ * Adds the gear onto the stats. The SoulWeapon adds to every attack stat,
+ * the armor adds its ACC and DEF.
+ * @param stats The stats without gear
+ * @param gear The gear, any piece can be NULL
+ * @return The stats with the gear on
+ */
+Stats gearStats(const Stats* stats, const Gear* gear);
+
+/**
+ * Adds what a skill does onto the stats of an attack. Its DEF goes to the target.
+ * @param skill The skill used, NULL for the basic attack which changes nothing
+ * @param attacker The stats of the attacker, with its gear on
+ * @param target The stats of the target, with its gear on
+ */
+void applySkill(const Skill* skill, Stats* attacker, Stats* target);
+
+/**
+ * Rolls how much HP the target loses to one attack.
+ * Note, putting the skill on cooldown is up to the caller, and only a hit does.
+ * @param attacker The stats of the attacker, with its gear on
+ * @param target The stats of the target, with its gear on
+ * @param skill The skill used, NULL for the basic attack
+ * @param playerLvl The level of the player, which sets how hard it is to hit
+ * @param hit Where to store whether the attack hit, can be NULL
+ * @return How much damage taken, 0 for a miss
+ */
+ushort rollDamage(const Stats* attacker, const Stats* target, const Skill* skill, uint playerLvl, bool* hit);
+
+/**
+ * Rolls out a batch of attacks, 8 at a time with AVX2 or NEON where the CPU has it.
+ * Given the same rolls, each comes out the same as rollDamage. A skill goes into the stats first, see applySkill.
+ * Note, unlike rollDamage, every attack takes a crit roll, hit or not.
+ * @param attackers The stats of each attacker, with its gear on
+ * @param targets The stats of each target, with its gear on
+ * @param hitRolls The hit roll of each attack, ie. from randomFillFloat
+ * @param critRolls The crit roll of each attack
+ * @param playerLvl The level of the player, which sets how hard it is to hit
+ * @param out Where to store how much damage each target takes, 0 for a miss
+ * @param n The number of attacks
+ */
+void batchDamage(const Stats* attackers, const Stats* targets, const float* hitRolls, const float* critRolls,
+                 uint playerLvl, ushort* out, uint n);
+
+/**
+ * Gets which kernel batchDamage runs on this CPU.
+ * @return "avx2", "neon" or "scalar"
+ */
+const char* batchDamageKernel();
+
+/**
+ * Chooses a skill for the boss to use from its
+ * array of possible skills. It can also choose its basic.
+ * @param cdTimers The cooldown left of each boss skill
+ * @return The index of the skill to use, -1 for the basic (also when every skill is on cooldown)
+ */
+int chooseBossSkill(const char* cdTimers);
+
+/**
+ * Puts a skill on cooldown. It can be used again once the timer is back to 0.
+ * @param cd The cooldowns
+ * @param slot The timer, PLAYER_CD or BOSS_CD plus the skill
+ * @param cooldown The cooldown of the skill
+ */
+void startCooldown(Cooldowns* cd, uint slot, byte cooldown);
+
+/**
+ * Takes a turn off every running timer, all in one step.
+ * @param cd The cooldowns
+ */
+void tickCooldowns(Cooldowns* cd);
+
+/**
+ * Packs the cooldowns of a battle. Skills keep their cdTimer between battles.
+ * @param cd The cooldowns
+ * @param equipped The EQUIPPED_SKILL_COUNT equipped skills of the player, any can be NULL
+ * @param bossTimers The cooldowns of the boss skills
+ */
+void loadCooldowns(Cooldowns* cd, Skill** equipped, const char* bossTimers);
+
+/**
+ * Hands the cooldowns back to the skills and the boss once the battle is over.
+ * @param cd The cooldowns
+ * @param equipped The EQUIPPED_SKILL_COUNT equipped skills of the player, any can be NULL
+ * @param bossTimers The cooldowns of the boss skills
+ */
+void storeCooldowns(const Cooldowns* cd, Skill** equipped, char* bossTimers);
+
+
+#endif
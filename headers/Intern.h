@@ -0,0 +1,41 @@
+#ifndef _INTERN_H
+#define _INTERN_H
+
+#include <stddef.h>
+
+#include "Misc.h"
+
+
+#define INTERN_INIT_CAP 256 // The starting number of slots, always a power of two
+
+// Counts of what the table saved
+typedef struct InternStats {                                    // 24B
+  size_t rawBytes; // Bytes that would have been copied without it  8B
+  size_t internedBytes; // Bytes actually stored                     8B
+  uint count; // Number of distinct strings                          4B
+} InternStats;
+
+
+/**
+ * Gets the single stored copy of the string, storing it the first time it is seen.
+ * Interned strings live until the game exits, so they are never freed and must not be modified.
+ * Two interned strings are equal only if they are the same pointer.
+ * Safe to call from any thread, like the prefetch thread or the map workers.
+ * @param s The string, or NULL
+ * @return The interned string, or NULL if s is NULL
+ */
+str intern(const char* s);
+
+/**
+ * Gets how many bytes interning saved so far.
+ * @return The stats
+ */
+InternStats getInternStats();
+
+/**
+ * Prints the interned versus raw byte counts.
+ */
+void printInternStats();
+
+
+#endif
@@ -0,0 +1,55 @@
+#ifndef _MAPPARSER_H
+#define _MAPPARSER_H
+
+#include <stdio.h>
+
+#include "Maze.h"
+
+
+// The events emitted while a JSON document is tokenized
+typedef enum {
+  JSON_OBJECT_START,
+  JSON_OBJECT_END,
+  JSON_ARRAY_START,
+  JSON_ARRAY_END,
+  JSON_KEY, // text holds the key
+  JSON_STRING, // text holds the string
+  JSON_NUMBER, // number holds the value
+  JSON_TRUE,
+  JSON_FALSE,
+  JSON_NULL
+} jsonevent_t;
+
+/**
+ * Receives each event of the document in order.
+ * Note, text is only valid for the duration of the call.
+ * @param ctx The context given to parseJSONStream
+ * @param event The event
+ * @param text The key or string, NULL otherwise
+ * @param number The number, 0 otherwise
+ */
+typedef void (*JSONHandler)(void* ctx, jsonevent_t event, const char* text, double number);
+
+
+/**
+ * Tokenizes the JSON file in a single forward pass, calling handler for every event.
+ * Only a small read buffer and the current token are held in memory.
+ * @param file The JSON file
+ * @param filename The file name, for errors
+ * @param handler The event handler
+ * @param ctx The context passed to the handler
+ */
+void parseJSONStream(FILE* file, const char* filename, JSONHandler handler, void* ctx);
+
+/**
+ * Creates the maze by streaming the map, building each room as soon as its object ends.
+ * Produces the same maze as initMazeDOM. Only the loot and enemy tables are kept as JSON, until each room is entered.
+ * Big maps are split between workers (see workerCount), each building its own rooms, which are then merged in file order.
+ * The maze is the same for any number of workers.
+ * @param filename The map to initiate
+ * @return The Maze structure
+ */
+Maze* parseMaze(const char* filename);
+
+
+#endif
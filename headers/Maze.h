@@ -2,72 +2,297 @@
 #define _MAZE_H
 
 #include <stdbool.h>
+#include <stdint.h>
+#include <limits.h>
 
 #include "Misc.h"
+#include "Arena.h"
 
 
-#define NO_EXIT 0xFEEDFAED
+#define NO_ROOM 0xFFFFFFFF // The room behind an exit that leads nowhere
+#define MAX_ROOM_ID 0x7FFFFFFF // Ids are non-negative JSON integers (-1 is no exit), so a slot never reaches NO_ROOM
+
+#define NO_POS INT_MIN // The position of a room left off the map, see layoutMaze
+
+// The bits of RoomStore.flags
+#define ROOM_BOSS 0x01 // The room holds a boss instead of a normal enemy
 
 // Better name
 typedef union EnemyU {
   Enemy* enemy;
   Boss* boss;
 } EnemyU;
-// A structure representing a room within a maze. Has connections to other possible rooms.
-typedef struct Room {                                       // 74B+6B(PAD) = 80B
-  struct Room* exits[4]; // The possible exits that a room can have          32B
-  str info; // The description of the room.                                   8B
-  str storyFile; // The name of the story text file.                          8B
-  FILE* file; // The file for the story text file.                            8B
-  // At initialization, the pointers will be the room ids in hex (-1 -> 0xFEEDFAED; 0 -> 0x0; 1 -> 0x1; ...; 10 -> 0xa; etc..)
-  EnemyU enemy; // The possible enemy that the room can have                  8B
-  Item* loot;// The possible loot item that the room can have                 8B
-  bool hasBoss; // Whether the room holds a normal enemy or a boss            1B
-  byte id; // The room id, note: it is not a string, just a number of 1 byte  1B
-} Room;
+
+// Where the loot and enemy tables of a maze are kept until every room is materialized
+typedef enum {
+  TABLES_NONE, // Nothing left to roll
+  TABLES_JSON, // LootRecords read from the map, in the arena like everything else
+  TABLES_MZB // Records of the .mzb, which stays mapped at Maze.tables
+} tables_t;
+
+// An item of a loot table, read from a JSON map so none of its cJSON outlives the load. See MzbItem for .mzb maps.
+typedef struct LootRecord {                                       // 33B+7B(PAD) = 40B
+  str text; // The name (gear) or description, interned               8B
+  uint count; //                                                      4B
+  uint kind; // armor_t, hpkit_t or upgrade_t                         4B
+  float atkCrit; //                                                   4B
+  ushort atk; //                                                      2B
+  ushort acc; //                                                      2B
+  ushort def; //                                                      2B
+  ushort atkCritDmg; //                                               2B
+  uchar type; // item_t                                               1B
+  uchar lvl; //                                                       1B
+  uchar upgrades; //                                                  1B
+  uchar durability; //                                                1B
+  uchar rank; // value_t of upgrade materials                         1B
+} LootRecord;
+
+// A reference to the loot and enemy tables of a room that has not been entered yet.
+typedef struct RoomTables {                                 // 24B
+  void* loot; // The loot table (LootRecord or MzbItem)         8B
+  ushort* enemies; // The enemy table, as EnemyCatalog indices  8B
+  uint lootCount; // Number of items in the table               4B
+  uint enemyCount; // Number of enemies in the table            4B
+} RoomTables;
+
+#define MAX_ENEMY_TEMPLATES 0xFFFF // Enemy.templateId is a ushort
+
+// The enemy templates of a maze. Rooms and enemies refer to them by index, so they can grow while loading.
+typedef struct EnemyCatalog {                 // 16B
+  EnemyTemplate* templates; // Heap allocated     8B
+  uint len; // Number of templates                4B
+  uint cap; // Capacity of templates              4B
+} EnemyCatalog;
+
+// The exits of a room, in the order north, east, south, west. Each is a room slot, or NO_ROOM.
+typedef uint RoomExits[4];
+
+// Where a room is drawn on the map, in rooms east and south of the entry. Both are NO_POS if it is not drawn.
+typedef struct RoomPos { // 8B
+  int x;                 // 4B
+  int y;                 // 4B
+} RoomPos;
+
+// The rooms of a maze, stored as parallel arrays indexed by slot. Rooms are referred to by slot, never by pointer.
+// Moving and walking only touch the hot arrays; the text is only read when a room is shown or saved.
+typedef struct RoomStore {                                                      // 88B
+  // Hot
+  RoomExits* exits; // Where each exit of a room leads                              8B
+  uchar* flags; // The ROOM_* bits of a room                                        8B
+  EnemyU* enemies; // The possible enemy (or boss) of a room                        8B
+  Item** loot; // The possible loot item of a room                                  8B
+  // The loot and enemy are only rolled from the tables the first time the room is entered.
+  RoomTables** tables; // The tables to roll from, NULL once materialized           8B
+  // Cold
+  uint* ids; // The room id, up to MAX_ROOM_ID                                      8B
+  str* info; // The description of the room                                        8B
+  str* storyFiles; // The name of the story text file, NULL if none                 8B
+  RoomPos* pos; // Where the room is drawn on the map                               8B
+  uint64_t* seen; // A bit per room, set once the player has been in it             8B
+  uint len; // Number of rooms                                                      4B
+  uint cap; // Capacity of every array                                              4B
+} RoomStore;
+
+// A table of room slots by id. The one built while loading a maze is kept as its room index.
+// Ids that are mostly in use index the slots directly, sparse ones are hashed with linear probing.
+typedef struct Table {                                         // 24B
+  uint* slots; // The room slots (by id if direct), NO_ROOM if none 8B
+  uint* ids; // The id in each bucket if hashed, NULL if direct     8B
+  uint cap; // The current capacity of the table                   4B
+  uint len; // Number of items that the table contains             4B
+} Table;
+
+// The bounding box of the rooms drawn on the map, see layoutMaze
+typedef struct MapLayout {                // 16B
+  int minX; // The westmost room               4B
+  int minY; // The northmost room              4B
+  uint width; // Rooms across                  4B
+  uint height; // Rooms down                   4B
+} MapLayout;
+
+// The map as drawn by showMap, kept so drawing it again allocates nothing
+typedef struct MapFrame {                                                          // 40B
+  char* cells; // A character per cell, NULL until first drawn                          8B
+  char* bytes; // The frame as written, with its colors                                 8B
+  size_t len; // Bytes of the last frame                                                8B
+  // The spatial index of the map windows, built for the first one
+  uint* byRow; // The slots of the rooms on the map, by row then column, NULL if none   8B
+  uint* rowStart; // Where each row of the map starts in byRow, and where the last ends 8B
+} MapFrame;
+
+// A window of the map around the player, for mazes bigger than the terminal
+typedef struct MapView {                         // 40B
+  char* cells; // A character per cell               8B
+  char* bytes; // The window as written              8B
+  size_t len; // Bytes of the last window            8B
+  int x; // The room at the center of the window     4B
+  int y;                                          // 4B
+  uint cols; // Cells across                         4B
+  uint rows; // Cells down                           4B
+} MapView;
 
 // A structure representing a single maze with an entry.
-typedef struct Maze {                     // 17B+7B(PAD) = 24B
+// Everything in the maze (enemies, loot, room tables) is allocated from its arena, their strings are interned.
+typedef struct Maze {                     // 200B
   char* name; // The name of the maze/directory for story   8B
-  Room* entry; // The entrance of the maze                  8B  
-  byte size; // The number of rooms that the maze has       1B
+  RoomStore rooms; // Every room of the maze               88B
+  Table* ids; // The slot of every room id, see getRoom     8B
+  Arena* arena; // Owns all the memory of the maze          8B
+  void* tables; // The mapped .mzb if TABLES_MZB, else NULL  8B
+  EnemyCatalog catalog; // The enemy templates             16B
+  MapLayout layout; // Where the rooms are drawn           16B
+  MapFrame frame; // The last map drawn                    40B
+  tables_t tablesType; // Where the room tables point      4B
+  uint entry; // The slot of the entrance of the maze       4B
 } Maze;
 
-// A temporary hashtable to store the rooms for saving, loading, and deleting
-typedef struct Table {                              // 16B
-  Room** rooms; // The array of room pointers           8B
-  uint cap; // The current capacity of the table        4B
-  uint len; // Number of items that the table contains  4B
-} Table;
 
+/**
+ * Draws the map of the maze into its frame, from the layout worked out when it was loaded.
+ * Colors are only switched where they change, and blank cells never switch them.
+ * @param maze The maze
+ * @param playerRoom The slot of the room the player is in
+ * @return The bytes of the frame, see Maze.frame
+ */
+size_t renderMap(Maze* maze, uint playerRoom);
+
+/**
+ * Displays the map of the maze, drawn by renderMap and written out at once.
+ * @param maze The maze
+ * @param playerRoom The slot of the room the player is in
+ */
+void showMap(Maze* maze, uint playerRoom);
+
+/**
+ * Tells whether the whole map fits in the given cells.
+ * @param maze The maze
+ * @param cols The cells across
+ * @param rows The cells down
+ * @return True if it fits
+ */
+bool mapFits(Maze* maze, uint cols, uint rows);
+
+/**
+ * Sets up a window of the map, centered on the entry.
+ * @param maze The maze
+ * @param view The window
+ * @param cols The cells across
+ * @param rows The cells down
+ */
+void initMapView(Maze* maze, MapView* view, uint cols, uint rows);
+
+/**
+ * Centers the window on the room, or on the entry if the room is not on the map.
+ * @param maze The maze
+ * @param view The window
+ * @param room The room
+ */
+void centerMapView(Maze* maze, MapView* view, uint room);
+
+/**
+ * Moves the window half its size, keeping its center on the map.
+ * @param maze The maze
+ * @param view The window
+ * @param dx Columns of half windows to move east (negative is west)
+ * @param dy Rows of half windows to move south (negative is north)
+ */
+void scrollMapView(Maze* maze, MapView* view, int dx, int dy);
+
+/**
+ * Draws the window of the map into its buffer. Only the rooms the player has been in are drawn (fog of war).
+ * The rooms are found through the spatial index, so the cost depends on the window and not on the maze.
+ * @param maze The maze
+ * @param view The window
+ * @param playerRoom The slot of the room the player is in
+ * @return The bytes of the window, see MapView.bytes
+ */
+size_t renderMapView(Maze* maze, MapView* view, uint playerRoom);
+
+/**
+ * Displays the window of the map, drawn by renderMapView and written out at once.
+ * @param maze The maze
+ * @param view The window
+ * @param playerRoom The slot of the room the player is in
+ */
+void showMapView(Maze* maze, MapView* view, uint playerRoom);
+
+/**
+ * Frees the buffers of the window.
+ * @param view The window
+ */
+void deleteMapView(MapView* view);
+
+/**
+ * Enters the room: rolls its loot and enemy if it is the first time, and clears its fog.
+ * @param maze The maze holding the room
+ * @param room The room
+ */
+void visitRoom(Maze* maze, uint room);
 
 /**
- * Displays
- * @param maze 
+ * Marks the room as one the player has been in.
+ * @param rooms The store
+ * @param room The room
  */
-void showMap(Maze* maze, Room* playerRoom);
+void setRoomSeen(RoomStore* rooms, uint room);
 
 /**
- * Deletes the given room, freeing the memory.
- * @param room The room to delete
+ * Tells whether the player has been in the room.
+ * @param rooms The store
+ * @param room The room
+ * @return True if the room is out of the fog
  */
-void deleteRoom(Room* room);
+bool roomSeen(const RoomStore* rooms, uint room);
 
 /**
- * Removes an item from the given room. Note, this only frees the item structure, and not _item.
- * All data must be copied before removing and the _item pointer must be in the player's hands.
- * Thus, the contents of _item must be freed by the player.
+ * Works out where every room is drawn on the map, once the rooms are connected.
+ * Rooms are placed walking out from the entry, each exit being one room away. A room whose place is
+ * already taken by another is left off the map, as are the rooms only reached through it.
+ * If the entry already has a position, the map came with its layout (like a save) and it is kept.
+ * @param maze The maze
+ */
+void layoutMaze(Maze* maze);
+
+/**
+ * Removes an item from the given room. Note, the item is owned by the maze arena and is not freed.
+ * The player must hold a copy of it (see promoteItem) before removing.
+ * @param maze The maze holding the room
  * @param room The target room
  */
-void removeItemFromMap(Room* room);
+void removeItemFromMap(Maze* maze, uint room);
 
 /**
- * Deletes an enemy from the given room.
+ * Removes an enemy from the given room. Note, the enemy is owned by the maze arena and is not freed.
+ * Any boss gear the player keeps must be copied out of the arena (see promoteItemData).
+ * @param maze The maze holding the room
  * @param room The target room
- * @param deleteGear Whether to delete the boss gear
- * @return True if it was deleted, false otherwise
+ * @return True if it was removed, false otherwise
  */
-bool deleteEnemyFromMap(Room* room, bool deleteGear);
+bool deleteEnemyFromMap(Maze* maze, uint room);
+
+/**
+ * Sets up an empty room store.
+ * @param rooms The store
+ * @param cap How many rooms to make space for
+ */
+void initRoomStore(RoomStore* rooms, uint cap);
+
+/**
+ * Appends a room with no exits, enemy, loot or tables to the store, off the map and unseen, growing it if needed.
+ * @param rooms The store
+ * @param id The room id
+ * @param info The description, interned
+ * @param storyFile The story text file, interned, or NULL
+ * @param flags The ROOM_* bits
+ * @return The slot of the room
+ */
+uint addRoom(RoomStore* rooms, uint id, str info, str storyFile, uchar flags);
+
+/**
+ * Frees the arrays of the store. What they point to lives in the maze arena or is interned.
+ * @param rooms The store
+ */
+void deleteRoomStore(RoomStore* rooms);
 
 /**
  * Inititates the temporary table to store the room
@@ -76,35 +301,41 @@ bool deleteEnemyFromMap(Room* room, bool deleteGear);
 Table* initTable();
 
 /**
- * Initiates the temporary table to store the room with a set size.
- * @param size The size to set the table.
+ * Initiates the temporary table to store the rooms, sized for them so it never grows.
+ * The table is hashed if the ids are too sparse to index directly.
+ * @param count The number of rooms
+ * @param maxId The biggest room id
  * @return The table.
  */
-Table* initTableL(int size);
+Table* initTableL(uint count, uint maxId);
 
 /**
- * Inserts the given room into the given table
+ * Inserts the slot of a room into the given table, growing it to fit the room id.
+ * A direct table switches to hashing if growing it to the id would leave it mostly empty.
  * @param table The table
- * @param room The room to store
+ * @param id The room id
+ * @param slot The slot of the room
  * @param overwrite Whether to overwrite the room if one exists
  * @return Whether the room was put
  */
-bool putRoom(Table* table, Room* room, bool overwrite);
+bool putRoom(Table* table, uint id, uint slot, bool overwrite);
 
 /**
- * Recursively, adds the room to the table.
- * Note: Depending on size of maze, may or may not rework to avoid stack overflow
- * @param room The room to add
- * @param table The table to add to
+ * Gets the slot of the room with the given id.
+ * @param table The table
+ * @param id The room id
+ * @return The slot, or NO_ROOM if the table has no such room
  */
-void addAndRecurse(Room* room, Table* table);
+uint lookupRoom(Table* table, uint id);
 
 /**
  * Connects the created rooms to form the maze.
- * @param table The table containing the rooms
- * @return The entry room
+ * Their exits hold room ids until then, which are turned into slots.
+ * @param rooms The rooms
+ * @param ids The table of room slots by id
+ * @return The slot of the entry room, NO_ROOM if there is none
  */
-Room* connectRooms(Table* table);
+uint connectRooms(RoomStore* rooms, Table* ids);
 
 /**
  * Deletes the temporary table.
@@ -113,7 +344,71 @@ Room* connectRooms(Table* table);
 void deleteTable(Table* table);
 
 /**
- * Deletes the maze.
+ * Rolls the loot and enemy of a room from its tables, if it has not been done yet.
+ * Called when the player enters the room.
+ * @param maze The maze holding the room
+ * @param room The room
+ */
+void materializeRoom(Maze* maze, uint room);
+
+/**
+ * Reads an item of the loot table of a room that has not been entered yet, without rolling anything.
+ * @param maze The maze holding the room
+ * @param tables The tables of the room
+ * @param i The item of the loot table, below its lootCount
+ * @param rec The loot record to fill out
+ */
+void readRoomLoot(Maze* maze, RoomTables* tables, uint i, LootRecord* rec);
+
+/**
+ * Tells whether the room has, or is going to have, an enemy.
+ * @param maze The maze holding the room
+ * @param room The room
+ * @return True if there is an enemy to fight
+ */
+bool roomHasEnemy(Maze* maze, uint room);
+
+/**
+ * Tells whether the room has, or is going to have, loot.
+ * @param maze The maze holding the room
+ * @param room The room
+ * @return True if there is loot to pick up
+ */
+bool roomHasLoot(Maze* maze, uint room);
+
+/**
+ * Adds the template to the catalog, unless the same one is already there.
+ * Boss templates are only the same if they share the same BossTemplate.
+ * @param catalog The catalog
+ * @param tmpl The template, copied into the catalog
+ * @return The index of the template
+ */
+ushort addEnemyTemplate(EnemyCatalog* catalog, const EnemyTemplate* tmpl);
+
+/**
+ * Frees the templates of the catalog. Boss templates live in the maze arena.
+ * @param catalog The catalog
+ */
+void deleteEnemyCatalog(EnemyCatalog* catalog);
+
+/**
+ * Gets the room with the given id, without walking the maze.
+ * @param maze The maze
+ * @param id The room id
+ * @return The slot of the room, or NO_ROOM if the maze has no such room
+ */
+uint getRoom(Maze* maze, uint id);
+
+/**
+ * Gets the template the enemy was rolled from.
+ * @param maze The maze holding the enemy
+ * @param enemy The enemy (or the base of a boss)
+ * @return The template
+ */
+EnemyTemplate* getEnemyTemplate(Maze* maze, Enemy* enemy);
+
+/**
+ * Deletes the maze, releasing its arena (and the tables) all at once.
  * @param maze The maze to delete
  */
 void deleteMaze(Maze* maze);
@@ -0,0 +1,115 @@
+#ifndef _MAZEBIN_H
+#define _MAZEBIN_H
+
+#include <stdint.h>
+
+/**
+ * The compiled binary maze format (.mzb).
+ *
+ * A .mzb file is the same data as a map .json, laid out so it can be mapped into memory and
+ * walked without parsing. Everything is stored in host byte order, 4-byte aligned.
+ *
+ * Layout:
+ *   MzbHeader
+ *   MzbRoom[roomCount]      The room table, entry included
+ *   MzbItem[itemCount]      Loot tables of every room, followed by boss gear (5 per boss)
+ *   MzbEnemy[enemyCount]    Enemy tables of every room
+ *   MzbSkill[skillCount]    Boss skills
+ *   char[strSize]           The string section, NUL-terminated strings referenced by offset
+ *
+ * Exits are stored as indices into the room table, not as room ids.
+ * Note, this header is shared with the tools, so only fixed-width types are used here.
+ */
+
+#define MZB_MAGIC "MZB"
+#define MZB_VERSION 1
+
+#define MZB_NONE 0xFFFFFFFF // No exit, no story file, no gear
+
+// Bits of MzbEnemy.ranged, set when the stat is a [min, max] range rather than a single value
+#define MZB_RANGED_HP 0x01
+#define MZB_RANGED_ATK 0x02
+#define MZB_RANGED_DEF 0x04
+#define MZB_RANGED_ACC 0x08
+#define MZB_RANGED_CRIT_DMG 0x10
+#define MZB_RANGED_CRIT 0x20
+
+typedef struct MzbHeader {                                  // 60B
+  char magic[4]; // "MZB\0"                                     4B
+  uint32_t version; // MZB_VERSION                              4B
+  uint32_t roomCount; // Number of rooms                        4B
+  uint32_t entry; // Index of the entry room                    4B
+  uint32_t name; // String offset of the maze name              4B
+  uint32_t roomOffset; // File offset of the room table         4B
+  uint32_t itemOffset; // File offset of the item table         4B
+  uint32_t itemCount; //                                        4B
+  uint32_t enemyOffset; // File offset of the enemy table       4B
+  uint32_t enemyCount; //                                       4B
+  uint32_t skillOffset; // File offset of the skill table       4B
+  uint32_t skillCount; //                                       4B
+  uint32_t strOffset; // File offset of the string section      4B
+  uint32_t strSize; // Size of the string section               4B
+  uint32_t fileSize; // Total size, to catch truncated files    4B
+} MzbHeader;
+
+typedef struct MzbRoom {                      // 48B
+  uint32_t id; // The room id                     4B
+  uint32_t exits[4]; // Room indices or MZB_NONE 16B
+  uint32_t info; // String offset                 4B
+  uint32_t storyFile; // String offset or MZB_NONE 4B
+  uint32_t lootStart; // First item in its table  4B
+  uint32_t lootCount; //                          4B
+  uint32_t enemyStart; // First enemy in its table 4B
+  uint32_t enemyCount; //                          4B
+  uint32_t hasBoss; // 1 if the enemy is a boss    4B
+} MzbRoom;
+
+typedef struct MzbItem {                                           // 32B
+  uint32_t type; // item_t                                             4B
+  uint32_t count; //                                                   4B
+  uint32_t text; // String offset of the name (gear) or description   4B
+  uint32_t kind; // armor_t, hpkit_t or upgrade_t                      4B
+  uint16_t atk; //                                                     2B
+  uint16_t acc; //                                                     2B
+  uint16_t def; //                                                     2B
+  uint16_t atkCritDmg; //                                              2B
+  float atkCrit; //                                                    4B
+  uint8_t lvl; //                                                      1B
+  uint8_t upgrades; //                                                 1B
+  uint8_t durability; //                                               1B
+  uint8_t rank; // value_t of upgrade materials                        1B
+} MzbItem;
+
+typedef struct MzbEnemy {                          // 56B
+  uint32_t name; // String offset                      4B
+  uint32_t xpPoints; //                                4B
+  uint32_t hp[2]; // [min, max]                        8B
+  uint16_t atk[2]; //                                  4B
+  uint16_t def[2]; //                                  4B
+  uint16_t acc[2]; //                                  4B
+  uint16_t atkCritDmg[2]; //                           4B
+  float atkCrit[2]; //                                 8B
+  uint8_t lvl; //                                      1B
+  uint8_t ranged; // MZB_RANGED_* bits                 1B
+  uint16_t pad; //                                     2B
+  uint32_t gear; // First of 5 gear items or MZB_NONE  4B
+  uint32_t skillStart; //                              4B
+  uint32_t skillCount; //                              4B
+} MzbEnemy;
+
+typedef struct MzbSkill {             // 28B
+  uint32_t name; // String offset         4B
+  uint32_t description; // String offset  4B
+  uint8_t lvl; //                         1B
+  uint8_t cooldown; //                    1B
+  uint8_t id; //                          1B
+  uint8_t pad; //                         1B
+  uint16_t effect1; //                    2B
+  uint16_t pad2; //                       2B
+  float effect2; //                       4B
+  uint32_t activeEffect1; //              4B
+  uint32_t activeEffect2; //              4B
+} MzbSkill;
+
+
+#endif
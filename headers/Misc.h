@@ -184,6 +184,22 @@ void deleteArmor(Armor* armor);
  */
 void deleteOther(HPKit* item);
 
+/**
+ * Copies the item data onto the heap. Items in a maze are owned by its arena,
+ * so anything the player keeps must be promoted first. Strings are interned, so they are shared.
+ * @param _item The item data
+ * @param type The type of the item
+ * @return The heap copy, to be deleted like any player item
+ */
+void* promoteItemData(void* _item, item_t type);
+
+/**
+ * Copies the item and its data onto the heap.
+ * @param item The item, usually owned by a maze arena
+ * @return The heap copy
+ */
+Item* promoteItem(Item* item);
+
 
 typedef struct Gear {
   SoulWeapon* sw; //    8B
@@ -222,27 +238,55 @@ typedef struct Skill { // 34B+6B(PAD) = 40B
   effect_t activeEffect2; //             4B
 } Skill;
 
-typedef struct Enemy { // 25B+7B(PAD) = 32B
-  str name; //                           8B
-  uint xpPoints; //                      4B
-  uint hp; //                            4B
-  uchar lvl; //                          1B
-  Stats* stats; //                       8B
-} Enemy;
-
 #define BOSS_SKILL_COUNT 5
 
-typedef struct Boss { //               272B
-  Enemy base; //                        32B
+// What a boss drops and fights with, shared by every boss made from the same template.
+typedef struct BossTemplate { //       240B
   Gear gearDrop; //                     40B
-  Skill skills[BOSS_SKILL_COUNT]; //   200B
+  Skill skills[BOSS_SKILL_COUNT]; //   200B, cdTimer is unused, see Boss.cdTimers
+} BossTemplate;
+
+// Which stats of an enemy template are a [min, max] range, the others are a single value (same bits as the .mzb)
+#define RANGED_HP 0x01
+#define RANGED_ATK 0x02
+#define RANGED_DEF 0x04
+#define RANGED_ACC 0x08
+#define RANGED_CRIT_DMG 0x10
+#define RANGED_CRIT 0x20
+
+// The definition of an enemy, parsed once per maze (see EnemyCatalog). Never changes once added.
+typedef struct EnemyTemplate { // 54B+2B(PAD) = 56B
+  str name; // Interned                          8B
+  BossTemplate* boss; // NULL for normal enemies 8B
+  uint xpPoints; //                              4B
+  uint hp[2]; // [min, max]                      8B
+  ushort atk[2]; //                              4B
+  ushort def[2]; //                              4B
+  ushort acc[2]; //                              4B
+  ushort atkCritDmg[2]; //                       4B
+  float atkCrit[2]; //                           8B
+  uchar lvl; //                                  1B
+  uchar ranged; // RANGED_* bits                 1B
+} EnemyTemplate;
+
+// An enemy in a room. Only what was rolled is kept, the rest is in its template.
+typedef struct Enemy { // 18B+2B(PAD) = 20B
+  Stats stats; // The rolled stats       12B
+  uint hp; // The rolled (current) hp     4B
+  ushort templateId; // See EnemyCatalog  2B
+} Enemy;
+
+typedef struct Boss { // 25B+3B(PAD) = 28B
+  Enemy base; //                        20B
+  char cdTimers[BOSS_SKILL_COUNT]; // The cooldown left of each template skill 5B
 } Boss;
 
 /**
  * Displays the stats of the enemy.
+ * @param tmpl The template of the enemy
  * @param enemy The enemy to display
  */
-void displayEnemyStats(Enemy* enemy);
+void displayEnemyStats(EnemyTemplate* tmpl, Enemy* enemy);
 
 // TODO: Better way to init skill
 /**
@@ -262,27 +306,6 @@ void displayEnemyStats(Enemy* enemy);
 void initSkill(Skill* skill, str name, str desc, byte lvl, byte cooldown, 
     ushort effect1, float effect2, effect_t active1, effect_t active2, byte id);
 
-/**
- * Deletes the skills' name and description
- * @param skills The skills to delete
- * @param len The length of the skill array
- */
-void deleteSkills(Skill skills[], int len);
-
-/**
- * Deletes the enemy, freeing the memory.
- * @param enemy The enemy to delete
- * @return True if the enemy was deleted, false otherwise
- */
-bool deleteEnemy(Enemy* enemy);
-
-/**
- * Deletes the boss, freeing the memory. Note, does not free the dropped gear.
- * @param boss 
- * @return 
- */
-bool deleteBoss(Boss* boss, bool deleteGear);
-
 
 
 
@@ -0,0 +1,36 @@
+#ifndef _PACE_H
+#define _PACE_H
+
+#include "Misc.h"
+
+
+// What a delay is for, each can be paced on its own.
+typedef enum {
+  PACE_BATTLE, // The rounds of a battle
+  PACE_STORY, // The lines of the story
+  PACE_SPLASH, // The welcome, the tutorial and the lines between them
+  PACE_CATEGORIES
+} pace_t;
+
+
+/**
+ * Sets how long the delays take, as a scale of their usual length.
+ * The spec is a list split by commas, each either a scale for every category
+ * or a category with its own scale, ie. "0" or "0.5,story=1".
+ * The names are battle, story and splash. 0 takes the delays out, 1 is the usual pace.
+ * @param spec The spec
+ * @return Whether the spec was valid, nothing is changed otherwise
+ */
+bool setPace(const char* spec);
+
+/**
+ * Waits out a delay of the game, scaled by the pace of its category.
+ * When the player presses enter, the delay is cut short and the line is let go.
+ * Scripted runs, with stdin not a terminal, always wait the delay out.
+ * @param category What the delay is for
+ * @param ms How long the delay is at the usual pace, in milliseconds
+ */
+void pace(pace_t category, uint ms);
+
+
+#endif
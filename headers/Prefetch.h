@@ -0,0 +1,36 @@
+#ifndef _PREFETCH_H
+#define _PREFETCH_H
+
+#include "Maze.h"
+
+
+/**
+ * Starts loading the maze on the pool (see submitTask), so it is ready when the player gets to it.
+ * Nothing happens if a maze is already being prefetched.
+ * Note, loading never rolls anything (see materializeRoom), so it does not touch the RNG streams (see Random.h).
+ * @param filename The map to load, owned by the prefetch from now on
+ */
+void prefetchMaze(str filename);
+
+/**
+ * Hands over the prefetched maze, waiting for the task if it is not done yet.
+ * @param filename The map that is wanted
+ * @return The maze, or NULL if that map was not prefetched
+ */
+Maze* takePrefetchedMaze(const str filename);
+
+/**
+ * Deletes the maze on the pool, so the caller does not have to wait for it.
+ * Nothing may point into the maze anymore.
+ * @param maze The maze to delete
+ */
+void deleteMazeAsync(Maze* maze);
+
+/**
+ * Gets a monotonic timestamp, to time how long something takes.
+ * @return The time in milliseconds
+ */
+double getTimeMs();
+
+
+#endif
@@ -0,0 +1,112 @@
+#ifndef _RANDOM_H
+#define _RANDOM_H
+
+#include <stdint.h>
+
+#include "Misc.h"
+
+
+// The independent streams of rolls, one per part of the game.
+// Rolling in one never changes what another rolls next. Each thread has its own set.
+typedef enum {
+  RNG_LOOT, // Which loot a room holds
+  RNG_ENEMY, // Which enemy a room holds, and its stats
+  RNG_BATTLE, // Hits and crits
+  RNG_BOSS, // The skills bosses use
+  RNG_SHOP, // Selling prices
+  RNG_LEVEL, // Stat growth on level up
+  RNG_STREAMS
+} rng_t;
+
+
+/**
+ * Seeds every stream of the calling thread from the one seed. The same seed always gives the same rolls.
+ * @param seed The seed
+ */
+void seedRandom(uint64_t seed);
+
+/**
+ * Gets a seed from the clock, for when none is given.
+ * @return The seed
+ */
+uint64_t clockSeed();
+
+/**
+ * Rolls 32 random bits.
+ * @param stream The stream to roll from
+ * @return The roll
+ */
+uint randomU32(rng_t stream);
+
+/**
+ * Rolls a number below the bound, without the bias of a plain modulo.
+ * @param stream The stream to roll from
+ * @param bound The bound, 0 for any 32 bit number
+ * @return The roll, from 0 to bound - 1
+ */
+uint randomBelow(rng_t stream, uint bound);
+
+/**
+ * Rolls a number within the range.
+ * @param stream The stream to roll from
+ * @param lo The lower limit
+ * @param hi The upper limit, included
+ * @return The roll
+ */
+uint randomRange(rng_t stream, uint lo, uint hi);
+
+/**
+ * Rolls a float.
+ * @param stream The stream to roll from
+ * @return The roll, from 0 up to but not including 1
+ */
+float randomFloat(rng_t stream);
+
+/**
+ * Fills the array with rolls of 32 random bits, the same as calling randomU32 for each.
+ * @param stream The stream to roll from
+ * @param out The array
+ * @param n The number of rolls
+ */
+void randomFill(rng_t stream, uint* out, uint n);
+
+/**
+ * Fills the array with rolls below the bound, the same as calling randomBelow for each.
+ * @param stream The stream to roll from
+ * @param out The array
+ * @param n The number of rolls
+ * @param bound The bound, 0 for any 32 bit number
+ */
+void randomFillBelow(rng_t stream, uint* out, uint n, uint bound);
+
+/**
+ * Fills the array with float rolls, the same as calling randomFloat for each.
+ * @param stream The stream to roll from
+ * @param out The array
+ * @param n The number of rolls
+ */
+void randomFillFloat(rng_t stream, float* out, uint n);
+
+/**
+ * Gets the name of the stream, as it is saved.
+ * @param stream The stream
+ * @return The name
+ */
+const char* randomStreamName(rng_t stream);
+
+/**
+ * Gets where the stream is in its sequence, to save it.
+ * @param stream The stream
+ * @return The state
+ */
+uint64_t getRandomState(rng_t stream);
+
+/**
+ * Sets where the stream is in its sequence, so a loaded game continues the same rolls.
+ * @param stream The stream
+ * @param state The state, from getRandomState
+ */
+void setRandomState(rng_t stream, uint64_t state);
+
+
+#endif
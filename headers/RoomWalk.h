@@ -0,0 +1,54 @@
+#ifndef _ROOM_WALK_H
+#define _ROOM_WALK_H
+
+#include <stdint.h>
+
+#include "Maze.h"
+
+
+#define WALK_INIT_CAP 64 // The starting capacity of the work queue
+
+// The order the rooms are walked in
+typedef enum {
+  WALK_BFS, // Nearest rooms first
+  WALK_DFS // Down the first exit as far as it goes, like the recursive walks did
+} walk_t;
+
+// What the walk does after visiting a room
+typedef enum {
+  WALK_CONTINUE, // Go through the exits of the room
+  WALK_SKIP, // Do not go through the exits of the room
+  WALK_STOP // End the walk at this room
+} walk_action_t;
+
+// A room reached by the walk
+typedef struct WalkStep {                                  // 12B
+  uint room; // The slot of the room                           4B
+  int x; // Cells east of the start room, following the exits  4B
+  int y; // Cells south of the start room                      4B
+} WalkStep;
+
+/**
+ * Called once for every room the walk reaches.
+ * @param step The room and where it is
+ * @param ctx The context given to walkRooms
+ * @return What to do next
+ */
+typedef walk_action_t (*walk_f)(WalkStep* step, void* ctx);
+
+
+/**
+ * Walks every room reachable from start once, without recursing.
+ * Rooms are marked in a bitset by slot when they are queued, so the walk is linear in the rooms and exits,
+ * and the work queue never holds more than the number of rooms. Only the exits of the rooms are read.
+ * @param maze The maze
+ * @param start The slot of the room to start from
+ * @param order Breadth or depth first
+ * @param visit Called for each room
+ * @param ctx Passed to visit
+ * @return The slot of the room the walk was stopped at, or NO_ROOM if it went through every room
+ */
+uint walkRooms(Maze* maze, uint start, walk_t order, walk_f visit, void* ctx);
+
+
+#endif
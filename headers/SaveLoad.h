@@ -1,3 +1,6 @@
+#ifndef _SAVELOAD_H
+#define _SAVELOAD_H
+
 #include "SoulWorker.h"
 
 
@@ -12,4 +15,15 @@ void saveGame();
 /**
  * Loads saved game.
  */
-void loadGame();
\ No newline at end of file
+void loadGame();
+
+/**
+ * Creates the maze state for saving.
+ * Rooms that were not entered yet keep their tables, the rest are written as rolled.
+ * @param maze The maze
+ * @return The maze as a JSON string (to be freed with cJSON_free), or NULL on failure
+ */
+str createMapState(Maze* maze);
+
+
+#endif
@@ -0,0 +1,74 @@
+#ifndef _SCREEN_H
+#define _SCREEN_H
+
+#include <stdio.h>
+#include <stddef.h>
+
+#include "Misc.h"
+
+
+/**
+ * Gets the size of the terminal, or of a common one if stdout is not a terminal.
+ * @param cols Where to store the columns
+ * @param rows Where to store the rows
+ * @return Whether stdout is a terminal
+ */
+bool getTerminalSize(uint* cols, uint* rows);
+
+/**
+ * Writes the bytes out in a single call, after anything printed before them.
+ * @param out Where to write
+ * @param bytes The bytes
+ * @param len The number of bytes
+ */
+void writeTerminal(FILE* out, const char* bytes, size_t len);
+
+/**
+ * Sets where frames go. Without it, they go to stdout, diffed only if it is a terminal.
+ * @param out Where to write
+ * @param live Whether out is a terminal, so frames are drawn in place and only their changes sent
+ */
+void initScreen(FILE* out, bool live);
+
+/**
+ * Clears the terminal.
+ */
+void clearScreen();
+
+/**
+ * Starts a new frame, blank, drawn from the top left.
+ */
+void beginScreen();
+
+/**
+ * Draws text into the frame, the way printing it would: newlines, tabs and the codes of Colors.h are followed.
+ * @param text The text
+ * @param len The bytes of the text
+ */
+void screenWrite(const char* text, size_t len);
+
+/**
+ * Draws formatted text into the frame, see screenWrite.
+ * @param format The format, as for printf
+ */
+void screenPrintf(const char* format, ...);
+
+/**
+ * Shows the frame. On a terminal, only the cells that differ from the last frame are sent,
+ * and the frame is kept at the top while what is printed after it scrolls below.
+ * Anywhere else, or if the frame is taller than the terminal, it is printed as text.
+ * @return The bytes sent
+ */
+size_t presentScreen();
+
+/**
+ * Lets what is printed next scroll over the last frame. The next frame starts from a clear terminal.
+ */
+void closeScreen();
+
+/**
+ * Gives the terminal back and frees the frames.
+ */
+void deleteScreen();
+
+#endif
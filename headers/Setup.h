@@ -18,54 +18,169 @@
  */
 Maze* initMaze(const str filename);
 
+/**
+ * Creates the maze by parsing the whole map into a cJSON tree first.
+ * initMaze streams the map instead, this is kept to compare against.
+ * @param filename The map to initiate
+ * @return The Maze structure
+ */
+Maze* initMazeDOM(const str filename);
+
+/**
+ * Creates the maze from a compiled binary maze (.mzb), without parsing JSON.
+ * @param filename The compiled map to load
+ * @return The Maze structure
+ */
+Maze* loadMazeBin(const str filename);
+
+/**
+ * Rolls the loot and enemy of a room of a compiled maze, the loot from its records.
+ * @param maze The maze, whose tables are the mapped .mzb
+ * @param room The slot of the room to fill out
+ * @param tables The tables of the room
+ */
+void materializeMazeBin(Maze* maze, uint room, RoomTables* tables);
+
+/**
+ * Reads an item of the loot table of a room of a compiled maze, without rolling anything.
+ * @param maze The maze, whose tables are the mapped .mzb
+ * @param tables The tables of the room
+ * @param i The item of the loot table
+ * @param rec The loot record to fill out
+ */
+void readMazeBinLoot(Maze* maze, RoomTables* tables, uint i, LootRecord* rec);
+
+/**
+ * Unmaps a compiled maze once its maze is deleted.
+ * @param view The mapped .mzb (Maze.tables)
+ */
+void closeMazeBin(void* view);
+
+/**
+ * Finds the compiled maze that sits next to the given map, if there is one.
+ * A compiled maze older than its map is ignored.
+ * @param filename The map json file
+ * @return The .mzb filename (to be freed), or NULL if there is none to use
+ */
+str mazeBinFor(const str filename);
+
+/**
+ * Reads a room id from its key in the map.
+ * Ids are decimal and go up to MAX_ROOM_ID, anything else is a fatal data error.
+ * @param key The key of the room
+ * @return The room id
+ */
+uint parseRoomId(const char* key);
+
+/**
+ * Validates the loot and enemy tables of a room.
+ * @param roomId The room id, for errors
+ * @param hasBoss Whether the room holds a boss
+ * @param loot The loot table
+ * @param enemy The enemy table
+ */
+void validateTables(uint roomId, bool hasBoss, cJSON* loot, cJSON* enemy);
+
+/**
+ * Rolls the hp and stats of an enemy from its template.
+ * @param catalog The enemy catalog of the maze
+ * @param templateId The template to roll from
+ * @param enemy The enemy to fill out
+ */
+void rollEnemy(EnemyCatalog* catalog, ushort templateId, Enemy* enemy);
+
+/**
+ * Rolls the enemy (or boss) of the room from the enemy catalog of the maze.
+ * The ROOM_BOSS flag of the room must already be set.
+ * @param maze The maze
+ * @param room The slot of the room to fill out
+ * @param tables The tables of the room
+ */
+void populateEnemy(Maze* maze, uint room, RoomTables* tables);
+
+/**
+ * Selects the loot and the enemy (or boss) of the room from the tables read from its JSON.
+ * @param maze The maze
+ * @param room The slot of the room to fill out
+ * @param tables The tables of the room
+ */
+void populateRoom(Maze* maze, uint room, RoomTables* tables);
+
+/**
+ * Keeps the tables of the room so its loot and enemy get rolled when it is first entered.
+ * The loot is read into records and the enemies into the catalog right away, only their indices are kept.
+ * @param arena The arena of the maze
+ * @param catalog The enemy catalog of the maze
+ * @param hasBoss Whether the room holds a boss
+ * @param lootTable The loot table, not part of any other cJSON. It is deleted
+ * @param enemyTable The enemy table, not part of any other cJSON. It is deleted
+ * @return The tables of the room
+ */
+RoomTables* deferRoom(Arena* arena, EnemyCatalog* catalog, bool hasBoss, cJSON* lootTable, cJSON* enemyTable);
+
 /**
  * Creates a SoulWeapon with the given cJSON data.
+ * @param arena The arena to allocate from, or NULL for the heap
  * @param obj The data to create the SoulWeapon
  * @return The SoulWeapon
  */
-SoulWeapon* createSoulWeapon(cJSON* obj);
+SoulWeapon* createSoulWeapon(Arena* arena, cJSON* obj);
 
 /**
  * Creates an armor with the given cJSON data.
+ * @param arena The arena to allocate from, or NULL for the heap
  * @param obj The data to create the armor
  * @return The armor
  */
-Armor* createArmor(cJSON* obj);
+Armor* createArmor(Arena* arena, cJSON* obj);
 
 /**
  * Creates an HP Kit with the given cJSON data.
+ * @param arena The arena to allocate from, or NULL for the heap
  * @param obj The data to create the HP Kit
  * @return The HP Kit
  */
-HPKit* createHPKit(cJSON* obj);
+HPKit* createHPKit(Arena* arena, cJSON* obj);
 
 /**
  * Creates a upgrade material with the given cJSON data.
+ * @param arena The arena to allocate from, or NULL for the heap
  * @param obj The data to create the upgrade material
  * @return The upgrade material
  */
-Upgrade* createUpgrade(cJSON* obj);
+Upgrade* createUpgrade(Arena* arena, cJSON* obj);
 
 /**
  * Creates a slime with the given cJSON data.
+ * @param arena The arena to allocate from, or NULL for the heap
  * @param obj The data to create the slime
  * @return The slime
  */
-Slime* createSlime(cJSON* obj);
+Slime* createSlime(Arena* arena, cJSON* obj);
 
 /**
  * Creates an item object given the cJSON object.
+ * @param arena The arena to allocate from, or NULL for the heap
  * @param obj The raw item data
  * @param type The type of item
  * @return The item
  */
-Item* createItem(cJSON* obj, item_t type);
+Item* createItem(Arena* arena, cJSON* obj, item_t type);
+
+/**
+ * Creates an item from a loot record, as createItem does from its cJSON.
+ * @param arena The arena to allocate from, or NULL for the heap
+ * @param rec The loot record
+ * @return The item
+ */
+Item* createLootItem(Arena* arena, const LootRecord* rec);
 
 /**
  * Creates a skill object given the cJSON object.
+ * @param arena The arena to allocate from, or NULL for the heap
  * @param obj The raw skill data
  * @return The skill
  */
-Skill* createSkill(cJSON* obj);
+Skill* createSkill(Arena* arena, cJSON* obj);
 
 #endif
\ No newline at end of file
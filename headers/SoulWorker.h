@@ -12,9 +12,9 @@
 #define TOTAL_SKILLS 10
 
 // The player model.
-typedef struct SoulWorker {            // 506B+6B(PAD) = 512B
+typedef struct SoulWorker {            // 514B+14B(PAD) = 528B
   str name; // The name of the player                       8B
-  Room* room; // The current room that the player is in     8B
+  uint room; // The slot of the room the player is in       4B
   uint xp; // The current XP                                4B
   uint xpReq; // The total required XP for level up         4B
   uint lvl; // The current level                            4B
@@ -22,7 +22,8 @@ typedef struct SoulWorker {            // 506B+6B(PAD) = 512B
   uint maxHP; // The max HP                                 4B
   uint dzenai; // The currency                              4B
   Gear gear; //                                            40B
-  Stats* stats; //                                          8B
+  Stats* stats; // Without the gear                         8B
+  Stats totalStats; // With the gear on, see updateStats   12B
   struct SkillTree* skills; //                              8B
   Item* hpSlot; // The slot to keep quick HP kits           8B
   ushort invCount; // Current items in the inventory        2B
@@ -63,18 +64,21 @@ void removeFromInv(SoulWorker* sw, Item* loot, ushort count);
 
 /**
  * Displays the current inventory of the player.
+ * It is drawn as a frame of the screen, see presentScreen.
  * @param sw The player
  */
 void viewInventory(SoulWorker* sw);
 
 /**
  * Displays player info, including the equipped gear.
+ * It is drawn as a frame of the screen, see presentScreen.
  * @param sw The player
  */
 void viewSelf(SoulWorker* sw);
 
 /**
  * Displays player skills, including currently equipped.
+ * It is drawn as a frame of the screen, see presentScreen.
  * @param sw The player's skill tree
  */
 void viewSkills(SkillTree* skillTree);
@@ -138,6 +142,13 @@ void equipGear(SoulWorker* sw, Item* item);
  */
 void heal(SoulWorker* sw, Item* item);
 
+/**
+ * Works out the stats of the player with its gear on, into totalStats.
+ * Equipping, unequipping and leveling up already do, anything else that changes the stats or the gear has to call it.
+ * @param sw The player
+ */
+void updateStats(SoulWorker* sw);
+
 /**
  * Updates the player's XP, increase the level if necessary.
  * @param sw The player
@@ -145,6 +156,13 @@ void heal(SoulWorker* sw, Item* item);
  */
 void updateXP(SoulWorker* sw, uint xp);
 
+/**
+ * Levels the player up to the given level, as if it had earned the XP, without printing.
+ * @param sw The player
+ * @param lvl The level, nothing happens if the player is already past it
+ */
+void setLevel(SoulWorker* sw, uint lvl);
+
 /**
  * Deletes the structure and frees the memory for the end of the gametime.
  * @param sw The SoulWorker structure to delete and free
@@ -0,0 +1,111 @@
+#ifndef _WORKERS_H
+#define _WORKERS_H
+
+#ifdef _WIN64
+  #include <windows.h>
+#else
+  #include <pthread.h>
+#endif
+
+#include "Misc.h"
+
+
+#ifdef _WIN64
+  #define _THREAD_RETURN DWORD WINAPI
+  #define _THREAD_DONE 0
+  #define THREAD_LOCAL __declspec(thread)
+  typedef HANDLE thread_t;
+#else
+  #define _THREAD_RETURN void*
+  #define _THREAD_DONE NULL
+  #define THREAD_LOCAL __thread
+  typedef pthread_t thread_t;
+#endif
+
+#define MAX_WORKERS 64 // The most threads a job is split across, and the most the pool starts
+
+/**
+ * Does one part of a job split across workers.
+ * @param ctx The context given to runWorkers
+ * @param worker Which part to do, from 0 to count - 1
+ */
+typedef void (*work_f)(void* ctx, uint worker);
+
+/**
+ * A task for the pool.
+ * @param arg The argument given to submitTask
+ */
+typedef void (*task_f)(void* arg);
+
+// Tasks to wait for together. Start it zeroed, it is done once pending is back to 0.
+typedef struct TaskGroup { // 4B
+  uint pending; // Tasks submitted and not done yet, only touched by the pool  4B
+} TaskGroup;
+
+
+/**
+ * Starts the given routine on a new thread.
+ * @param routine The routine
+ * @param arg The argument of the routine
+ * @param thread Where to store the thread, or NULL to detach it
+ */
+void startThread(_THREAD_RETURN (*routine)(void*), void* arg, thread_t* thread);
+
+/**
+ * Waits for the thread to finish.
+ * @param thread The thread
+ */
+void joinThread(thread_t thread);
+
+/**
+ * Gets how many workers a job is split across, one per CPU unless set with setWorkerCount.
+ * @return The number of workers, from 1 to MAX_WORKERS
+ */
+uint workerCount();
+
+/**
+ * Sets how many workers a job is split across.
+ * @param count The number of workers, 0 for one per CPU
+ */
+void setWorkerCount(uint count);
+
+/**
+ * Runs every part of the job on the pool and waits for all of them.
+ * Part 0 runs on the calling thread.
+ * @param count The number of parts, up to MAX_WORKERS
+ * @param work Does a part
+ * @param ctx The context passed to work
+ */
+void runWorkers(uint count, work_f work, void* ctx);
+
+/**
+ * Hands a task to the pool. The pool is started by the first task, with one thread per worker (see workerCount),
+ * and is kept for the rest of the program.
+ * Each thread keeps its own deque of tasks: it takes its newest task first and, once it has none,
+ * steals the oldest task of another thread.
+ * @param group The group to count the task in, NULL if nobody waits for it
+ * @param task The task
+ * @param arg The argument of the task
+ */
+void submitTask(TaskGroup* group, task_f task, void* arg);
+
+/**
+ * Waits for every task of the group, running tasks of the pool meanwhile.
+ * @param group The group
+ */
+void waitTasks(TaskGroup* group);
+
+/**
+ * Gets which thread of the pool is calling, to keep something per thread without locking.
+ * @return From 1 to poolSize() in the pool, 0 for any thread outside it
+ */
+uint poolWorker();
+
+/**
+ * Gets how many threads the pool has, starting it if no task has yet.
+ * @return The number of threads
+ */
+uint poolSize();
+
+
+#endif
@@ -207,6 +207,13 @@ static void runInstaller(enum OPTS opt) {
 }
 
 int main(int argc, char const* argv[]) {
+  // Passed on to the game, so the same game can be played again
+  const char* seed = NULL;
+  const char* pace = NULL; // Also passed on, ie. --pace=0 for scripted runs
+  for (int i = 1; i < argc; i++) {
+    if (strcmp(argv[i], "--seed") == 0 && i + 1 < argc) seed = argv[++i];
+    else if (strncmp(argv[i], "--pace=", 7) == 0) pace = argv[i];
+  }
 
   // check existance of version file
   FILE* versionFile = fopen("version", "r");
@@ -350,8 +357,9 @@ int main(int argc, char const* argv[]) {
   si.cb = sizeof(si);
   ZeroMemory(&pi, sizeof(pi));
 
-  char argvIn[13] = {0};
-  snprintf(argvIn, 13, "%s %s", GAME, launcherFlag);
+  char argvIn[256] = {0};
+  snprintf(argvIn, sizeof(argvIn), "%s %s%s%s%s%s", GAME, launcherFlag,
+           seed ? " --seed " : "", seed ? seed : "", pace ? " " : "", pace ? pace : "");
   execRet = (int) CreateProcess(GAME, argvIn, NULL, NULL, FALSE, CREATE_NEW_CONSOLE, NULL, NULL, &si, &pi);
   if (!execRet) {
     printf("COULD NOT EXECUTE CLISW.EXE, ABORTING\n");
@@ -361,7 +369,12 @@ int main(int argc, char const* argv[]) {
   CloseHandle(pi.hProcess);
   CloseHandle(pi.hThread);
 #else
-  execRet = execl(GAME, GAME, launcherFlag, NULL);
+  char* gameArgs[6] = { GAME, (char*) launcherFlag };
+  int gameArgc = 2;
+  if (seed) { gameArgs[gameArgc++] = "--seed"; gameArgs[gameArgc++] = (char*) seed; }
+  if (pace) gameArgs[gameArgc++] = (char*) pace;
+
+  execRet = execv(GAME, gameArgs);
   if (execRet == -1) {
     printf("COULD NOT EXECUTE CLISW, ABORTING\n");
     exit(-1);
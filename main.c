@@ -9,13 +9,22 @@
 
 #include "Error.h"
 #include "Keyboard.h"
+#include "Pace.h"
 #include "SaveLoad.h"
 #include "Battle.h"
+#include "BattleLog.h"
+#include "Prefetch.h"
+#include "Intern.h"
+#include "Random.h"
+#include "Screen.h"
 
 
 SoulWorker* player;
 Maze* maze;
 
+// The story of the current boss room, kept open to finish the story after the fight
+static FILE* roomStory = NULL;
+
 #define NUM_MAZES 2
 int mazeIdx; // The index indicating the current maze name from mazes
 // The array of the names of all possible mazes
@@ -54,11 +63,7 @@ static void printSplashScreen() {
   ungetc('\n', stdin);
 
   FLUSH()
-#ifdef _WIN64
-  system("cls");
-#else
-  system("clear"); // I DO NOT like this, extra overhead???
-#endif
+  clearScreen();
 }
 
 /**
@@ -72,13 +77,13 @@ static void printWelcome() {
   printf("      . . . .\n");
 
   printf("Cloudream, divided.\n");
-  ssleep(1000);
+  pace(PACE_SPLASH, 1000);
   printf("North. East. South. %sWest%s...\n", PURPLE, RESET);
-  ssleep(1000);
+  pace(PACE_SPLASH, 1000);
   printf("Which %sRosca%s hath forsaken\n", YELLOW, RESET);
-  ssleep(1000);
+  pace(PACE_SPLASH, 1000);
   printf("To which %sKent%s then envores\n", RED, RESET);
-  ssleep(1000);
+  pace(PACE_SPLASH, 1000);
   printf("\n\n");
 }
 
@@ -87,7 +92,7 @@ static void printWelcome() {
  */
 static void tutorial() {
   printf("*~%sRosca%s shows you how to navigate the New World~*\n", YELLOW, RESET);
-  ssleep(500);
+  pace(PACE_SPLASH, 500);
 
   // Maybe extract to a text file?
 
@@ -101,7 +106,7 @@ static void tutorial() {
   printf("\tTo unequip all the gear: ('g')\n");
   printf("\tTo save and quit: ('q')\n");
   printf("\tTo view the main help message: ('h')\n");
-  ssleep(500);
+  pace(PACE_SPLASH, 500);
 
   printf("In Inventory Menu:\n");
   printf("\tTo view the item: ('i')\n");
@@ -109,14 +114,14 @@ static void tutorial() {
   printf("\tTo use an item (opens item menu): ('u')\n");
   printf("\tTo close the inventory: ('q')\n");
   printf("\tTo view the inventory help message: ('h')\n");
-  ssleep(500);
+  pace(PACE_SPLASH, 500);
 
   printf("In Item Menu:\n");
   printf("\tTo sell the item (all items): ('s')\n");
   printf("\tTo equip (only for gear): ('e')\n");
   printf("\tTo upgrade (only for gear): ('u')\n");
   printf("\tTo heal (only for HP kits): ('h')\n");
-  ssleep(500);
+  pace(PACE_SPLASH, 500);
 
   printf("In Skill Menu:\n");
   printf("\tTo view skill info: ('i')\n");
@@ -126,12 +131,12 @@ static void tutorial() {
   printf("\tTo upgrade a skill: ('u')\n");
   printf("\tTo close the menu: ('q')\n");
   printf("\tTo view the skill menu help message: ('h')\n");
-  ssleep(500);
+  pace(PACE_SPLASH, 500);
 
 
   // Add more info????
   printf("%sRosca%s wishes you the best...\n\n", YELLOW, RESET);
-  ssleep(500);
+  pace(PACE_SPLASH, 500);
 }
 
 /**
@@ -163,12 +168,13 @@ static void story(bool room) {
   // If the story to be printed is for a room
   if (room) {
     size_t mazeNameLen = strlen(maze->name);
-    size_t roomStoryLen = strlen(player->room->storyFile);
+    str storyFile = maze->rooms.storyFiles[player->room];
+    size_t roomStoryLen = strlen(storyFile);
 
     filename = (str) malloc(14 + mazeNameLen + roomStoryLen + 1);
     if (!filename) handleError(ERR_MEM, FATAL, "Could not allocate space for filename!\n");
 
-    sprintf(filename, "%s/%s/%s", base, maze->name, player->room->storyFile);
+    sprintf(filename, "%s/%s/%s", base, maze->name, storyFile);
   } else { // The story is the introduction story
     filename = (str) malloc(25);
     if (!filename) handleError(ERR_MEM, FATAL, "Could not allocate space for filename!\n");
@@ -180,7 +186,7 @@ static void story(bool room) {
   if (!story) handleError(ERR_IO, FATAL, "Could not open story!\n");
   free(filename);
 
-  if (room) player->room->file = story;
+  if (room) roomStory = story;
 
   str line = NULL;
   size_t n = 0;
@@ -192,30 +198,32 @@ static void story(bool room) {
 
     if (strncmp(line, "FIGHT\n", 6) == 0) break;
 
-    ssleep(1000);
+    pace(PACE_STORY, 1000);
     printf("%s", line);
   }
 
   if (line != NULL) free(line);
 
   printf("\n\n");
-  ssleep(500);
+  pace(PACE_STORY, 500);
 
-  if (!room) { fclose(story); player->room->file = NULL; 
-  } else { free(player->room->storyFile); player->room->storyFile = NULL; }
+  // The story file name is interned, so only let go of it
+  if (!room) fclose(story);
+  else maze->rooms.storyFiles[player->room] = NULL;
 }
 
 /**
  * Gets the next maze to load up, or null if no more
+ * @param idx The index of the maze in mazes
  * @return Next maze
  */
-static str getNextMaze() {
+static str getNextMaze(int idx) {
   str nextMaze = NULL;
 
   // Out of bounds, as in no more mazes
-  if (mazeIdx >= NUM_MAZES) return nextMaze;
+  if (idx >= NUM_MAZES) return nextMaze;
 
-  str maze = mazes[mazeIdx];
+  str maze = mazes[idx];
 
   nextMaze = (str) malloc(18 + strlen(maze));
   if (!nextMaze) handleError(ERR_MEM, FATAL, "Could not allocate space for maze name when loading new!\n");
@@ -247,33 +255,41 @@ void endOfGame() {
  * Main game loop
  */
 void loop() {
-  Room* currRoom = player->room;
+  uint currRoom = player->room;
+  RoomStore* rooms = &maze->rooms;
   Commands choice;
 
   // Code only runs from here only if it's the start of a new maze 
   // Or when the save file is loaded 
   START:
   
-  printf("You find yourself in %s...\n", currRoom->info);
+  printf("You find yourself in %s...\n", rooms->info[currRoom]);
 
-  if (currRoom->storyFile != NULL) {
+  if (rooms->storyFiles[currRoom] != NULL) {
     // story(true);
-    // fclose(currRoom->file);
-    // currRoom->file = NULL;
+    // fclose(roomStory);
+    // roomStory = NULL;
   }
 
   while (true) {
-    if (!currRoom->hasBoss && currRoom->enemy.enemy != NULL) {
-      battleEnemy(currRoom->enemy.enemy);
+    // The loot and enemy of a room are only rolled once the player walks in
+    visitRoom(maze, currRoom);
+
+    if (!(rooms->flags[currRoom] & ROOM_BOSS) && rooms->enemies[currRoom].enemy != NULL) {
+      battleEnemy(rooms->enemies[currRoom].enemy);
       // Update currRoom in case player respawned at entrance
       // Prevent from getting the loot, if one exists
       currRoom = player->room;
+      visitRoom(maze, currRoom);
     }
 
-    if (currRoom->hasBoss && currRoom->enemy.boss != NULL) {
+    if ((rooms->flags[currRoom] & ROOM_BOSS) && rooms->enemies[currRoom].boss != NULL) {
+      // Load the next maze while the player goes through the story and the fight
+      prefetchMaze(getNextMaze(mazeIdx + 1));
+
       story(true);
 
-      bool win = bossBattle(currRoom->enemy.boss);
+      bool win = bossBattle(rooms->enemies[currRoom].boss);
 
       // If the battle was a win, then print story and move on to next maze
       // Otherwise, player is respawned to current maze entry
@@ -286,42 +302,60 @@ void loop() {
         size_t n = 0;
 
         printf("\n");
-        while (!feof(currRoom->file)) {
-          getline(&line, &n, currRoom->file);
-          ssleep(1000);
+        while (!feof(roomStory)) {
+          getline(&line, &n, roomStory);
+          pace(PACE_STORY, 1000);
           printf("%s", line);
           line = NULL;
         }
-        ssleep(1000);
+        pace(PACE_STORY, 1000);
         printf("\n\n");
 
+        fclose(roomStory);
+        roomStory = NULL;
+
         
         // Transport to next maze
         // printf("GOING TO NEXT MAZE\n");
-
-        deleteMaze(maze);
+        double transitionStart = getTimeMs();
 
         mazeIdx++;
-        str mazeFile = getNextMaze();
+        str mazeFile = getNextMaze(mazeIdx);
 
         if (!mazeFile) endOfGame();
 
-        maze = initMaze(mazeFile);
+        // Normally the maze is ready by now, otherwise load it here
+        Maze* nextMaze = takePrefetchedMaze(mazeFile);
+        if (!nextMaze) nextMaze = initMaze(mazeFile);
+        free(mazeFile);
+
+        Maze* oldMaze = maze;
+        maze = nextMaze;
 
         player->room = maze->entry;
         currRoom = player->room;
+        rooms = &maze->rooms;
+
+        // Nothing points into the old maze anymore
+        deleteMazeAsync(oldMaze);
+
+        printf("(Maze transition took %.3f ms)\n", getTimeMs() - transitionStart);
+        printInternStats();
 
         goto START;
       }
     }
 
-    if (currRoom->loot != NULL) {
-      str name = getItemName(currRoom->loot);
-      printf("You found %d * %s!\n", currRoom->loot->count, name);
-      bool added = addToInv(player, currRoom->loot);
+    Item* roomLoot = rooms->loot[currRoom];
+    if (roomLoot != NULL) {
+      str name = getItemName(roomLoot);
+      printf("You found %d * %s!\n", roomLoot->count, name);
+      // The loot belongs to the maze arena, the player gets its own copy
+      Item* loot = promoteItem(roomLoot);
+      bool added = addToInv(player, loot);
 
       // Since some strings have been alloc'd, free them
-      switch (currRoom->loot->type) {
+      switch (roomLoot->type) {
         case HP_KITS_T:
         case WEAPON_UPGRADE_MATERIALS_T:
         case ARMOR_UPGRADE_MATERIALS_T:
@@ -332,9 +366,12 @@ void loop() {
       }
 
       if (added) {
-        printf("ADDED TO INV! REMOVING %p!\n", currRoom->loot);
-        removeItemFromMap(currRoom);
-      }
+        printf("ADDED TO INV! REMOVING %p!\n", roomLoot);
+        removeItemFromMap(maze, currRoom);
+
+        // The inventory now holds loot->_item
+        free(loot);
+      } else deleteItem(loot);
     }
 
     printf("What are you going to do?... ");
@@ -355,12 +392,31 @@ void loop() {
 
 
 int main(int argc, char const *argv[]) {
-  if (argc != 2) exit(1); // running without launcher, exit silently
+  if (argc < 2) exit(1); // running without launcher, exit silently
 
   // if ran in cmd, check it was done by the launcher
   const char* arg = argv[1];
   if (strncmp(arg, "-l", 2) != 0) exit(1);
 
+  // The same seed replays the same game, a loaded save continues from its own rolls
+  uint64_t seed = clockSeed();
+
+  for (int i = 2; i < argc; i++) {
+    str end = NULL;
+
+    if (strcmp(argv[i], "--seed") == 0 && i + 1 < argc) seed = strtoull(argv[++i], &end, 10);
+    // Scripted runs can take the delays out, ie. --pace=0
+    else if (strncmp(argv[i], "--pace=", 7) == 0 && setPace(argv[i] + 7)) end = "";
+
+    if (!end || *end != '\0') {
+      printf("usage: clisw -l [--seed n] [--pace=scale[,battle|story|splash=scale]...]\n");
+      exit(1);
+    }
+  }
+
+  seedRandom(seed);
+  openBattleLog(BATTLE_LOG_PATH, seed);
+
   // Funky utf8 windows stuff
 #ifdef _WIN64
   SetConsoleOutputCP(CP_UTF8);
@@ -390,6 +446,7 @@ int main(int argc, char const *argv[]) {
       loadGame();
 
       printf("%sRosca%s welcomes you back, %s...\n", YELLOW, RESET, player->name);
+      printInternStats();
 
       // When loading from a save, the mazeIdx for the progression is lost
       // Reverse search to get the mazeIdx and reset so proper progression can happen
@@ -408,7 +465,8 @@ int main(int argc, char const *argv[]) {
   }
 
   mazeIdx = 0;
-  maze = initMaze(getNextMaze());
+  maze = initMaze(getNextMaze(mazeIdx));
+  printInternStats();
 
   printf("What shall the Records name you, birthing %sSoul%s? ", CYAN, RESET);
 
@@ -426,7 +484,7 @@ int main(int argc, char const *argv[]) {
   // printf("")
 
   printf("%sRosca%s cordially welcomes you, %sSoulWorker %s%s, to Cloudream...\n\n", YELLOW, RESET, CYAN, player->name, RESET);
-  ssleep(1000);
+  pace(PACE_SPLASH, 1000);
 
   // tutorial();
   // story(false);
@@ -11,9 +11,12 @@ i32 main() {
     });
 
     char* files[] = {
-      "./main.c", "./cJSON.c", "./Setup.c", "./RoomTable.c",
+      "./main.c", "./cJSON.c", "./Setup.c", "./RoomTable.c", "./RoomStore.c",
       "./SoulWorker.c", "./Maze.c", "./Error.c", "./Keyboard.c",
-      "./SaveLoad.c", "./itoa.s", "./DArray.c", "./Misc.c", "./Battle.c"
+      "./SaveLoad.c", "./itoa.s", "./RoomWalk.c", "./Misc.c", "./Battle.c",
+      "./MazeBin.c", "./Arena.c", "./MapParser.c",
+      "./Prefetch.c", "./Intern.c", "./Workers.c", "./Random.c", "./Screen.c",
+      "./Damage.c", "./Pace.c", "./BattleLog.c"
     };
 
     AddFiles(exe, files);
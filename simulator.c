@@ -0,0 +1,539 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "Damage.h"
+#include "Error.h"
+#include "Prefetch.h"
+#include "Random.h"
+#include "Setup.h"
+#include "SoulWorker.h"
+#include "Workers.h"
+
+
+#define DEFAULT_FIGHTS 100000
+#define DEFAULT_SEED 1
+
+#define MAX_MAPS 16
+#define MAX_BUILDS 32
+#define FIGHT_CHUNK 1024 // Fights seeded together, so the results do not depend on the number of workers
+#define MAX_TURNS 4096 // A fight still going after this many turns is a loss, both sides keep missing
+#define DMG_BINS 0x10000 // Damage of a hit, every ushort
+
+// A player build: its level, the skills it has equipped and the gear it wears
+typedef struct SimBuild {                                   // 41B+7B(PAD) = 48B
+  const char* spec; // As given, to name it in the report         8B
+  const char* gearFrom; // The boss whose drop is worn, or NULL   8B
+  Stats stats; // The stats with the gear on                     12B
+  uint lvl; //                                                    4B
+  uint maxHP; //                                                  4B
+  byte skillIds[EQUIPPED_SKILL_COUNT]; // 0 for an empty slot     5B
+} SimBuild;
+
+// What a worker saw over its fights of one enemy and one build
+typedef struct SimTally {
+  uint64_t fights;
+  uint64_t wins;
+  uint64_t capped; // Fights stopped at MAX_TURNS
+  uint64_t dealtSum;
+  uint64_t receivedSum;
+  uint64_t turns[MAX_TURNS + 1]; // Wins by the number of turns to kill
+  uint64_t dealt[DMG_BINS]; // Player hits by damage, 0 is a miss
+  uint64_t received[DMG_BINS]; // Enemy hits by damage
+} SimTally;
+
+// One enemy against one build, split into chunks across the pool
+typedef struct SimJob {
+  EnemyCatalog* catalog;
+  ushort templateId;
+  const SimBuild* build;
+  const Skill* equipped[EQUIPPED_SKILL_COUNT]; // The equipped skills of the build, NULL for an empty slot
+  uint64_t seed; // Seeds the chunks of this job
+  uint fights;
+  SimTally* tallies; // One per thread, see poolWorker
+} SimJob;
+
+// The fights of a chunk as they are fought a turn at a time, the fights still going packed at the front of live
+typedef struct SimFights {
+  Enemy enemies[FIGHT_CHUNK];
+  uint hp[FIGHT_CHUNK]; // Of the player
+  Cooldowns cd[FIGHT_CHUNK];
+  uint live[FIGHT_CHUNK]; // The fights still going
+  // The attacks of one side of the turn, by their place in live
+  int skills[FIGHT_CHUNK]; // The slot of the skill used, -1 for the basic
+  Stats attackers[FIGHT_CHUNK];
+  Stats targets[FIGHT_CHUNK];
+  float hitRolls[FIGHT_CHUNK];
+  float critRolls[FIGHT_CHUNK];
+  ushort dmg[FIGHT_CHUNK];
+} SimFights;
+
+// A chunk of the fights of a job, a task of the pool
+typedef struct SimChunk { // 12B+4B(PAD) = 16B
+  SimJob* job; //            8B
+  uint index; //             4B
+} SimChunk;
+
+// Where each worker fights its chunks, kept per thread like the RNG streams
+static THREAD_LOCAL SimFights simFights;
+
+
+static void usage() {
+  printf("usage: clisw-sim [-n fights] [-j workers] [-s seed] [-o out.csv] -b build [-b build...] map.json...\n");
+  printf("  -n  Fights of each build against each enemy (default %d)\n", DEFAULT_FIGHTS);
+  printf("  -j  Threads in the pool the fights are split across (default one per CPU)\n");
+  printf("  -s  Seed, the same seed gives the same report (default %d)\n", DEFAULT_SEED);
+  printf("  -o  The CSV to write (default stdout)\n");
+  printf("  -b  A build, LVL[:SKILLS[:BOSS]], ie. 10:1+4+7:Big Eye\n");
+  printf("      SKILLS are the skill numbers (1 to %d) in their slot order, - for none.\n", TOTAL_SKILLS);
+  printf("      The build wears the gear dropped by BOSS, none if not given.\n");
+  printf("  Against bosses, the build uses its first skill off cooldown, the basic otherwise.\n");
+}
+
+/**
+ * Reads a build from the command line.
+ * @param spec The build, see usage
+ * @param build Where to store the build
+ */
+static void parseBuild(const char* spec, SimBuild* build) {
+  char* end;
+
+  memset(build, 0, sizeof(SimBuild));
+  build->spec = spec;
+
+  build->lvl = (uint) strtoul(spec, &end, 10);
+  if (end == spec || build->lvl == 0 || (*end != '\0' && *end != ':')) {
+    handleError(ERR_DATA, FATAL, "Invalid build level in %s!\n", spec);
+  }
+  if (*end == '\0') return;
+
+  const char* pos = end + 1;
+
+  if (*pos == '-') pos++;
+  else {
+    for (int slot = 0; *pos != '\0' && *pos != ':'; slot++) {
+      unsigned long id = strtoul(pos, &end, 10);
+
+      if (end == pos || id < 1 || id > TOTAL_SKILLS) handleError(ERR_DATA, FATAL, "Invalid skill in %s!\n", spec);
+      if (slot == EQUIPPED_SKILL_COUNT) handleError(ERR_DATA, FATAL, "At most %d skills are equipped in %s!\n", EQUIPPED_SKILL_COUNT, spec);
+
+      build->skillIds[slot] = (byte) id;
+
+      pos = end;
+      if (*pos == '+') pos++;
+    }
+  }
+
+  if (*pos == ':') build->gearFrom = pos + 1;
+  else if (*pos != '\0') handleError(ERR_DATA, FATAL, "Invalid build %s!\n", spec);
+}
+
+/**
+ * Finds the gear dropped by the named boss in any of the maps.
+ * @param mazes The maps
+ * @param mapCount The number of maps
+ * @param name The name of the boss
+ * @return The gear
+ */
+static Gear* findGear(Maze** mazes, uint mapCount, const char* name) {
+  for (uint m = 0; m < mapCount; m++) {
+    EnemyCatalog* catalog = &mazes[m]->catalog;
+
+    for (uint i = 0; i < catalog->len; i++) {
+      EnemyTemplate* tmpl = &catalog->templates[i];
+      if (tmpl->boss && strcmp(tmpl->name, name) == 0) return &tmpl->boss->gearDrop;
+    }
+  }
+
+  handleError(ERR_DATA, FATAL, "No boss named %s drops gear in the maps!\n", name);
+  return NULL;
+}
+
+/**
+ * Levels a fresh player up to the build and works out its stats, the same way the game does.
+ * @param build The build
+ * @param mazes The maps, for the gear
+ * @param mapCount The number of maps
+ * @param skills Where to copy the equipped skills
+ */
+static void makeBuild(SimBuild* build, Maze** mazes, uint mapCount, Skill skills[EQUIPPED_SKILL_COUNT]) {
+  SoulWorker* sw = initSoulWorker(strdup("sim"));
+  setLevel(sw, build->lvl);
+
+  if (build->gearFrom) {
+    sw->gear = *findGear(mazes, mapCount, build->gearFrom);
+    updateStats(sw);
+  }
+
+  build->stats = sw->totalStats;
+  build->maxHP = sw->maxHP;
+
+  memset(skills, 0, EQUIPPED_SKILL_COUNT * sizeof(Skill));
+  for (int i = 0; i < EQUIPPED_SKILL_COUNT; i++) {
+    if (build->skillIds[i]) skills[i] = sw->skills->skills[build->skillIds[i] - 1];
+  }
+
+  // The gear belongs to the maze
+  memset(&sw->gear, 0, sizeof(Gear));
+  deleteSoulWorker(sw);
+}
+
+/**
+ * Counts a hit.
+ * @param hist The damage histogram
+ * @param sum The damage so far
+ * @param dmg The damage of the hit
+ */
+static inline void countHit(uint64_t* hist, uint64_t* sum, ushort dmg) {
+  hist[dmg]++;
+  *sum += dmg;
+}
+
+/**
+ * Rolls out the attacks of one side of a turn, one per fight still going, in a single batch.
+ * @param fights The attacks, in attackers and targets
+ * @param n The number of attacks
+ * @param lvl The level of the player
+ */
+static void rollAttacks(SimFights* fights, uint n, uint lvl) {
+  randomFillFloat(RNG_BATTLE, fights->hitRolls, n);
+  randomFillFloat(RNG_BATTLE, fights->critRolls, n);
+  batchDamage(fights->attackers, fights->targets, fights->hitRolls, fights->critRolls, lvl, fights->dmg, n);
+}
+
+/**
+ * Fights the fights of a chunk the way battleEnemy and bossBattle do, with the build picking its skills.
+ * They are fought a turn at a time, so every attack of a side rolls out together in one batch.
+ * @param job The job
+ * @param tally Where to count the fights
+ * @param n The number of fights
+ */
+static void fightChunk(const SimJob* job, SimTally* tally, uint n) {
+  const SimBuild* build = job->build;
+  BossTemplate* bossData = job->catalog->templates[job->templateId].boss;
+  SimFights* f = &simFights;
+
+  // The same scale batchDamage multiplies by, to tell a hit apart
+  float hitScale = build->lvl * 3;
+
+  for (uint i = 0; i < n; i++) {
+    rollEnemy(job->catalog, job->templateId, &f->enemies[i]);
+    f->hp[i] = build->maxHP;
+    // Every fight starts with the skills off cooldown
+    memset(&f->cd[i], 0, sizeof(Cooldowns));
+    f->live[i] = i;
+  }
+
+  uint live = n;
+
+  for (uint turn = 1; turn <= MAX_TURNS && live > 0; turn++) {
+    for (uint k = 0; k < live; k++) {
+      uint i = f->live[k];
+      const Skill* skill = NULL;
+
+      f->skills[k] = -1;
+      for (int slot = 0; bossData && slot < EQUIPPED_SKILL_COUNT; slot++) {
+        if (job->equipped[slot] && f->cd[i].timers[PLAYER_CD + slot] == 0) { skill = job->equipped[slot]; f->skills[k] = slot; break; }
+      }
+
+      f->attackers[k] = build->stats;
+      f->targets[k] = f->enemies[i].stats;
+      applySkill(skill, &f->attackers[k], &f->targets[k]);
+    }
+
+    rollAttacks(f, live, build->lvl);
+
+    uint kept = 0;
+    for (uint k = 0; k < live; k++) {
+      uint i = f->live[k];
+      ushort dmg = f->dmg[k];
+      Enemy* enemy = &f->enemies[i];
+
+      // Like the game, a miss does not use up the skill
+      bool hit = !(f->hitRolls[k] * hitScale > f->attackers[k].ACC);
+      if (f->skills[k] != -1 && hit) startCooldown(&f->cd[i], PLAYER_CD + f->skills[k], job->equipped[f->skills[k]]->cooldown);
+      countHit(tally->dealt, &tally->dealtSum, dmg);
+
+      if (dmg >= enemy->hp) { tally->wins++; tally->turns[turn]++; continue; }
+      enemy->hp -= dmg;
+      f->live[kept++] = i;
+    }
+    live = kept;
+
+    for (uint k = 0; k < live; k++) {
+      uint i = f->live[k];
+      const Skill* skill = NULL;
+
+      f->skills[k] = bossData ? chooseBossSkill(f->cd[i].timers + BOSS_CD) : -1;
+      if (f->skills[k] != -1) skill = &bossData->skills[f->skills[k]];
+
+      f->attackers[k] = f->enemies[i].stats;
+      f->targets[k] = build->stats;
+      applySkill(skill, &f->attackers[k], &f->targets[k]);
+    }
+
+    rollAttacks(f, live, build->lvl);
+
+    kept = 0;
+    for (uint k = 0; k < live; k++) {
+      uint i = f->live[k];
+      ushort dmg = f->dmg[k];
+
+      bool hit = !(f->hitRolls[k] * hitScale > f->attackers[k].ACC);
+      if (f->skills[k] != -1 && hit) startCooldown(&f->cd[i], BOSS_CD + f->skills[k], bossData->skills[f->skills[k]].cooldown);
+      countHit(tally->received, &tally->receivedSum, dmg);
+
+      if (dmg >= f->hp[i]) continue;
+      f->hp[i] -= dmg;
+
+      if (bossData) tickCooldowns(&f->cd[i]);
+      f->live[kept++] = i;
+    }
+    live = kept;
+  }
+
+  tally->capped += live;
+}
+
+/**
+ * Runs a chunk of the fights of a job, counting them in the tally of the thread running it.
+ * @param _chunk The chunk
+ */
+static void simulate(void* _chunk) {
+  SimChunk* chunk = (SimChunk*) _chunk;
+  SimJob* job = chunk->job;
+  SimTally* tally = &job->tallies[poolWorker()];
+
+  // Each thread rolls its own streams, seeded per chunk
+  seedRandom(job->seed + chunk->index);
+
+  uint start = chunk->index * FIGHT_CHUNK;
+  uint fights = (job->fights - start < FIGHT_CHUNK) ? job->fights - start : FIGHT_CHUNK;
+
+  fightChunk(job, tally, fights);
+  tally->fights += fights;
+}
+
+/**
+ * Adds the tallies of every thread into the first.
+ * @param tallies The tallies
+ * @param count The number of tallies
+ */
+static void mergeTallies(SimTally* tallies, uint count) {
+  SimTally* total = &tallies[0];
+
+  for (uint w = 1; w < count; w++) {
+    SimTally* tally = &tallies[w];
+
+    total->fights += tally->fights;
+    total->wins += tally->wins;
+    total->capped += tally->capped;
+    total->dealtSum += tally->dealtSum;
+    total->receivedSum += tally->receivedSum;
+
+    for (uint i = 0; i <= MAX_TURNS; i++) total->turns[i] += tally->turns[i];
+    for (uint i = 0; i < DMG_BINS; i++) total->dealt[i] += tally->dealt[i];
+    for (uint i = 0; i < DMG_BINS; i++) total->received[i] += tally->received[i];
+  }
+}
+
+/**
+ * Gets the value at the given percentile of a histogram.
+ * @param hist The histogram
+ * @param bins The number of bins
+ * @param p The percentile, from 0 to 1
+ * @return The bin, 0 if the histogram is empty
+ */
+static uint percentile(const uint64_t* hist, uint bins, double p) {
+  uint64_t total = 0;
+  for (uint i = 0; i < bins; i++) total += hist[i];
+  if (total == 0) return 0;
+
+  uint64_t rank = (uint64_t) (p * (total - 1)) + 1;
+  uint64_t seen = 0;
+
+  for (uint i = 0; i < bins; i++) {
+    seen += hist[i];
+    if (seen >= rank) return i;
+  }
+
+  return bins - 1;
+}
+
+/**
+ * Writes a field of the report, quoted if it has to be.
+ * @param out The report
+ * @param field The field
+ */
+static void writeField(FILE* out, const char* field) {
+  if (!strpbrk(field, ",\"\n")) { fputs(field, out); return; }
+
+  fputc('"', out);
+  for (const char* c = field; *c; c++) {
+    if (*c == '"') fputc('"', out);
+    fputc(*c, out);
+  }
+  fputc('"', out);
+}
+
+/**
+ * Writes the mean, misses, percentiles and max of a damage histogram.
+ * @param out The report
+ * @param hist The histogram
+ * @param sum The damage of every hit
+ */
+static void writeDamage(FILE* out, const uint64_t* hist, uint64_t sum) {
+  uint64_t hits = 0;
+  for (uint i = 0; i < DMG_BINS; i++) hits += hist[i];
+
+  double mean = (hits) ? (double) sum / hits : 0.0;
+  double misses = (hits) ? (double) hist[0] / hits : 0.0;
+
+  fprintf(out, ",%.3f,%.4f,%u,%u,%u,%u", mean, misses, percentile(hist, DMG_BINS, 0.5),
+      percentile(hist, DMG_BINS, 0.9), percentile(hist, DMG_BINS, 0.99), percentile(hist, DMG_BINS, 1.0));
+}
+
+/**
+ * Writes the row of the report of one enemy against one build.
+ * @param out The report
+ * @param map The map the enemy is from
+ * @param tmpl The enemy
+ * @param build The build
+ * @param tally What the fights added up to
+ */
+static void writeRow(FILE* out, const char* map, EnemyTemplate* tmpl, const SimBuild* build, SimTally* tally) {
+  uint64_t turnsSum = 0;
+  for (uint i = 0; i <= MAX_TURNS; i++) turnsSum += tally->turns[i] * i;
+
+  writeField(out, map);
+  fputc(',', out);
+  writeField(out, tmpl->name);
+  fprintf(out, ",%d,", tmpl->boss != NULL);
+  writeField(out, build->spec);
+
+  fprintf(out, ",%llu,%llu,%.4f,%llu", (unsigned long long) tally->fights, (unsigned long long) tally->wins,
+      (tally->fights) ? (double) tally->wins / tally->fights : 0.0, (unsigned long long) tally->capped);
+
+  fprintf(out, ",%.3f,%u,%u,%u,%u", (tally->wins) ? (double) turnsSum / tally->wins : 0.0,
+      percentile(tally->turns, MAX_TURNS + 1, 0.5), percentile(tally->turns, MAX_TURNS + 1, 0.9),
+      percentile(tally->turns, MAX_TURNS + 1, 0.99), percentile(tally->turns, MAX_TURNS + 1, 1.0));
+
+  writeDamage(out, tally->dealt, tally->dealtSum);
+  writeDamage(out, tally->received, tally->receivedSum);
+  fputc('\n', out);
+}
+
+int main(int argc, char* argv[]) {
+  uint fights = DEFAULT_FIGHTS;
+  uint64_t seed = DEFAULT_SEED;
+  const char* outName = NULL;
+
+  SimBuild builds[MAX_BUILDS];
+  uint buildCount = 0;
+  const char* maps[MAX_MAPS];
+  uint mapCount = 0;
+
+  for (int i = 1; i < argc; i++) {
+    if (argv[i][0] != '-') {
+      if (mapCount == MAX_MAPS) handleError(ERR_DATA, FATAL, "At most %d maps!\n", MAX_MAPS);
+      maps[mapCount++] = argv[i];
+      continue;
+    }
+
+    if (argv[i][1] == '\0' || argv[i][2] != '\0' || i + 1 == argc) { usage(); return 1; }
+
+    char* value = argv[++i];
+
+    switch (argv[i - 1][1]) {
+      case 'n': fights = (uint) strtoul(value, NULL, 10); break;
+      case 'j': setWorkerCount((uint) strtoul(value, NULL, 10)); break;
+      case 's': seed = strtoull(value, NULL, 10); break;
+      case 'o': outName = value; break;
+      case 'b':
+        if (buildCount == MAX_BUILDS) handleError(ERR_DATA, FATAL, "At most %d builds!\n", MAX_BUILDS);
+        parseBuild(value, &builds[buildCount++]);
+        break;
+      default: usage(); return 1;
+    }
+  }
+
+  if (mapCount == 0 || buildCount == 0 || fights == 0) { usage(); return 1; }
+
+  Maze* mazes[MAX_MAPS];
+  for (uint m = 0; m < mapCount; m++) mazes[m] = initMaze((str) maps[m]);
+
+  // Level ups roll too, so the builds come out the same for the same seed
+  seedRandom(seed);
+
+  Skill skills[MAX_BUILDS][EQUIPPED_SKILL_COUNT];
+  for (uint b = 0; b < buildCount; b++) makeBuild(&builds[b], mazes, mapCount, skills[b]);
+
+  FILE* out = (outName) ? fopen(outName, "w") : stdout;
+  if (!out) handleError(ERR_IO, FATAL, "Could not open %s!\n", outName);
+
+  fprintf(out, "map,enemy,boss,build,fights,wins,win_rate,capped,"
+      "turns_mean,turns_p50,turns_p90,turns_p99,turns_max,"
+      "dealt_mean,dealt_miss,dealt_p50,dealt_p90,dealt_p99,dealt_max,"
+      "received_mean,received_miss,received_p50,received_p90,received_p99,received_max\n");
+
+  // One tally per thread that can run a chunk: the pool's and the one waiting for it
+  uint threads = poolSize() + 1;
+  SimTally* tallies = (SimTally*) malloc(threads * sizeof(SimTally));
+  if (!tallies) handleError(ERR_MEM, FATAL, "Could not allocate space for the tallies!\n");
+
+  uint chunkCount = (fights + FIGHT_CHUNK - 1) / FIGHT_CHUNK;
+  SimChunk* chunks = (SimChunk*) malloc(chunkCount * sizeof(SimChunk));
+  if (!chunks) handleError(ERR_MEM, FATAL, "Could not allocate space for the chunks!\n");
+
+  SimJob job;
+  job.fights = fights;
+  job.tallies = tallies;
+
+  uint64_t jobs = 0;
+  double start = getTimeMs();
+
+  for (uint m = 0; m < mapCount; m++) {
+    job.catalog = &mazes[m]->catalog;
+
+    for (uint t = 0; t < job.catalog->len; t++) {
+      job.templateId = (ushort) t;
+
+      for (uint b = 0; b < buildCount; b++) {
+        job.build = &builds[b];
+        for (int i = 0; i < EQUIPPED_SKILL_COUNT; i++) job.equipped[i] = (builds[b].skillIds[i]) ? &skills[b][i] : NULL;
+
+        // Far apart for every job, the chunks count up from there
+        job.seed = seed + (jobs++ << 32);
+
+        memset(tallies, 0, threads * sizeof(SimTally));
+
+        // The threads that run out of chunks steal the rest, so a slow chunk does not hold the others up
+        TaskGroup group = { 0 };
+        for (uint c = 0; c < chunkCount; c++) {
+          chunks[c].job = &job;
+          chunks[c].index = c;
+          submitTask(&group, simulate, &chunks[c]);
+        }
+        waitTasks(&group);
+
+        mergeTallies(tallies, threads);
+
+        writeRow(out, maps[m], &job.catalog->templates[t], job.build, &tallies[0]);
+      }
+    }
+  }
+
+  double ms = getTimeMs() - start;
+  fprintf(stderr, "%llu fights across %u threads in %.1f ms (%.0f fights/s)\n",
+      (unsigned long long) jobs * fights, poolSize(), ms, jobs * fights / (ms / 1000.0));
+
+  if (out != stdout) fclose(out);
+  free(tallies);
+  free(chunks);
+
+  for (uint m = 0; m < mapCount; m++) deleteMaze(mazes[m]);
+
+  return 0;
+}
@@ -0,0 +1,28 @@
+#ifndef _BENCH_H
+#define _BENCH_H
+
+#include <time.h>
+
+
+/**
+ * Gets the milliseconds since start.
+ */
+static inline double elapsedMs(struct timespec* start) {
+  struct timespec end;
+  clock_gettime(CLOCK_MONOTONIC, &end);
+
+  return (end.tv_sec - start->tv_sec) * 1e3 + (end.tv_nsec - start->tv_nsec) / 1e6;
+}
+
+/**
+ * Gets the nanoseconds since start.
+ */
+static inline double elapsedNs(struct timespec* start) {
+  struct timespec end;
+  clock_gettime(CLOCK_MONOTONIC, &end);
+
+  return (end.tv_sec - start->tv_sec) * 1e9 + (end.tv_nsec - start->tv_nsec);
+}
+
+
+#endif
@@ -0,0 +1,141 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "Damage.h"
+#include "Random.h"
+#include "SoulWorker.h"
+#include "Bench.h"
+
+
+#define DEFAULT_ATTACKS 1000003 // Not a multiple of 8, so the attacks left over are checked too
+#define SEED 1234
+#define RUNS 5
+
+// The levels checked, the hit roll scales with the level
+static const uint levels[] = { 1, 10, 99, 21845 };
+
+
+/**
+ * Rolls the stats of the attacks. Most are like the game's, the rest are anything a ushort holds,
+ * so the damage wraps and the crit damage overflows the way it can.
+ */
+static void rollStats(Stats* attackers, Stats* targets, uint n) {
+  for (uint i = 0; i < n; i++) {
+    bool wild = randomBelow(RNG_LOOT, 4) == 0;
+
+    attackers[i].ATK = wild ? randomBelow(RNG_LOOT, 0x10000) : randomRange(RNG_LOOT, 5, 400);
+    attackers[i].ACC = wild ? randomBelow(RNG_LOOT, 0x10000) : randomRange(RNG_LOOT, 0, 300);
+    attackers[i].ATK_CRIT_DMG = wild ? randomBelow(RNG_LOOT, 0x10000) : randomRange(RNG_LOOT, 50, 300);
+    attackers[i].ATK_CRIT = wild ? randomFloat(RNG_LOOT) * 4 - 1 : randomFloat(RNG_LOOT);
+    attackers[i].DEF = 0;
+
+    // Only the DEF of the target counts
+    targets[i] = attackers[i];
+    targets[i].DEF = wild ? randomBelow(RNG_LOOT, 0x10000) : randomRange(RNG_LOOT, 0, 300);
+  }
+}
+
+/**
+ * Rolls each attack with rollDamage, then takes the same rolls back out of the stream for the batch.
+ * A miss never rolls its crit, so any roll does for it.
+ * @return The number of attacks the batch got wrong
+ */
+static uint check(const Stats* attackers, const Stats* targets, float* hitRolls, float* critRolls,
+                  ushort* expected, ushort* out, uint n, uint lvl) {
+  seedRandom(SEED + lvl);
+  for (uint i = 0; i < n; i++) expected[i] = rollDamage(&attackers[i], &targets[i], NULL, lvl, NULL);
+
+  seedRandom(SEED + lvl);
+  for (uint i = 0; i < n; i++) {
+    hitRolls[i] = randomFloat(RNG_BATTLE);
+
+    if (hitRolls[i] * (lvl * 3) > attackers[i].ACC) critRolls[i] = randomFloat(RNG_LOOT);
+    else critRolls[i] = randomFloat(RNG_BATTLE);
+  }
+
+  batchDamage(attackers, targets, hitRolls, critRolls, lvl, out, n);
+
+  uint wrong = 0;
+  for (uint i = 0; i < n; i++) {
+    if (out[i] == expected[i]) continue;
+
+    if (wrong++ < 5) {
+      printf("  attack %u: ATK %u ACC %u CRIT %g CRIT DMG %u against DEF %u gave %u, rollDamage %u\n", i, attackers[i].ATK,
+             attackers[i].ACC, attackers[i].ATK_CRIT, attackers[i].ATK_CRIT_DMG, targets[i].DEF, out[i], expected[i]);
+    }
+  }
+
+  return wrong;
+}
+
+int main(int argc, str* argv) {
+  uint n = (argc > 1) ? (uint) atoi(argv[1]) : DEFAULT_ATTACKS;
+  if (n == 0) n = DEFAULT_ATTACKS;
+
+  Stats* attackers = (Stats*) malloc(n * sizeof(Stats));
+  Stats* targets = (Stats*) malloc(n * sizeof(Stats));
+  float* hitRolls = (float*) malloc(n * sizeof(float));
+  float* critRolls = (float*) malloc(n * sizeof(float));
+  ushort* expected = (ushort*) malloc(n * sizeof(ushort));
+  ushort* out = (ushort*) malloc(n * sizeof(ushort));
+
+  if (!attackers || !targets || !hitRolls || !critRolls || !expected || !out) {
+    printf("Could not allocate space for the attacks!\n");
+    return 1;
+  }
+
+  seedRandom(SEED);
+  rollStats(attackers, targets, n);
+
+  printf("Batch damage, %s kernel (%u attacks)\n", batchDamageKernel(), n);
+
+  uint wrong = 0;
+  for (uint l = 0; l < sizeof(levels) / sizeof(levels[0]); l++) {
+    wrong += check(attackers, targets, hitRolls, critRolls, expected, out, n, levels[l]);
+  }
+
+  printf("  same as rollDamage at every level: %s\n", wrong ? "NO" : "yes");
+
+  // Best of a few runs, so the timing is not thrown off by the first touch of the arrays
+  double single = 1e30, batch = 1e30, kernel = 1e30;
+  uint sum = 0;
+
+  for (int r = 0; r < RUNS; r++) {
+    struct timespec start;
+
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    for (uint i = 0; i < n; i++) sum += rollDamage(&attackers[i], &targets[i], NULL, 10, NULL);
+    double ms = elapsedMs(&start);
+    if (ms < single) single = ms;
+
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    randomFillFloat(RNG_BATTLE, hitRolls, n);
+    randomFillFloat(RNG_BATTLE, critRolls, n);
+    batchDamage(attackers, targets, hitRolls, critRolls, 10, out, n);
+    ms = elapsedMs(&start);
+    if (ms < batch) batch = ms;
+    sum += out[n - 1];
+
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    batchDamage(attackers, targets, hitRolls, critRolls, 10, out, n);
+    ms = elapsedMs(&start);
+    if (ms < kernel) kernel = ms;
+    sum += out[0];
+  }
+
+  printf("  %-32s %8.3f ms  %7.1f M attacks/s\n", "rollDamage, one at a time", single, n / single / 1e3);
+  printf("  %-32s %8.3f ms  %7.1f M attacks/s\n", "filled rolls and batchDamage", batch, n / batch / 1e3);
+  printf("  %-32s %8.3f ms  %7.1f M attacks/s\n", "batchDamage alone", kernel, n / kernel / 1e3);
+  printf("  (checksum %u)\n", sum);
+
+  free(attackers);
+  free(targets);
+  free(hitRolls);
+  free(critRolls);
+  free(expected);
+  free(out);
+
+  return wrong ? 1 : 0;
+}
@@ -0,0 +1,129 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "BattleLog.h"
+#include "Damage.h"
+#include "Random.h"
+#include "SoulWorker.h"
+#include "Bench.h"
+
+
+#define DEFAULT_LOG "out/bench_battle.log"
+#define SEED 1234
+#define EVENTS 10000000 // The events timed on their own
+#define FIGHTS 200000 // The fights timed with and without the log
+#define LOGGED_FIGHTS 600 // The fights written to the log, more than the ring keeps
+
+
+/**
+ * Rolls stats like the game's, for either side.
+ */
+static void rollSide(Stats* stats, uint* hp) {
+  stats->ATK = randomRange(RNG_ENEMY, 20, 60);
+  stats->DEF = randomRange(RNG_ENEMY, 5, 30);
+  stats->ACC = randomRange(RNG_ENEMY, 10, 40);
+  stats->ATK_CRIT_DMG = randomRange(RNG_ENEMY, 50, 200);
+  stats->ATK_CRIT = randomFloat(RNG_ENEMY) * 0.5f;
+  *hp = randomRange(RNG_ENEMY, 100, 400);
+}
+
+/**
+ * Fights the way Battle.c does, logging every attack if asked to.
+ * Boss fights also use skills, so their effects go through the log too.
+ * @param skills The skills of both sides, by their slot as in Cooldowns
+ * @param boss Whether to fight as a boss battle
+ * @param log Whether to log
+ * @return The attacks made
+ */
+static uint fight(const Skill* skills, bool boss, bool log) {
+  Stats sides[2];
+  uint hp[2];
+  uint lvl = 10;
+
+  rollSide(&sides[SIDE_PLAYER], &hp[SIDE_PLAYER]);
+  rollSide(&sides[SIDE_ENEMY], &hp[SIDE_ENEMY]);
+
+  if (log) {
+    logBegin(boss);
+    logSide(SIDE_PLAYER, &sides[SIDE_PLAYER], hp[SIDE_PLAYER], lvl);
+    logSide(SIDE_ENEMY, &sides[SIDE_ENEMY], hp[SIDE_ENEMY], lvl);
+    if (boss) {
+      for (uint i = 0; i < EQUIPPED_SKILL_COUNT + BOSS_SKILL_COUNT; i++) logSkill(i, &skills[i]);
+    }
+  }
+
+  uint attacks = 0;
+
+  for (uint turn = 0; ; turn++) {
+    for (int side = SIDE_PLAYER; side <= SIDE_ENEMY; side++) {
+      uint slot = (boss && turn % 3 != 2) ? (uint) (side == SIDE_PLAYER ? PLAYER_CD : BOSS_CD) + turn % 5 : NO_SKILL;
+      const Skill* skill = (slot == NO_SKILL) ? NULL : &skills[slot];
+
+      uint64_t rng = getRandomState(RNG_BATTLE);
+      ushort dmg = rollDamage(&sides[side], &sides[!side], skill, lvl, NULL);
+      uint left = (dmg >= hp[!side]) ? 0 : hp[!side] - dmg;
+      if (log) logRound(side, slot, turn, rng, dmg, left);
+
+      attacks++;
+      hp[!side] = left;
+
+      if (left == 0) {
+        if (log) logEnd(side == SIDE_PLAYER);
+        return attacks;
+      }
+    }
+  }
+}
+
+int main(int argc, str* argv) {
+  const char* path = (argc > 1) ? argv[1] : DEFAULT_LOG;
+
+  // Every kind of effect, on both sides
+  Skill skills[EQUIPPED_SKILL_COUNT + BOSS_SKILL_COUNT];
+  memset(skills, 0, sizeof(skills));
+  for (uint i = 0; i < EQUIPPED_SKILL_COUNT + BOSS_SKILL_COUNT; i++) {
+    skills[i].id = i + 1;
+    skills[i].activeEffect1 = (i % 2) ? ATK_CRIT_DMG : ATK;
+    skills[i].effect1.atk = 10 + i * 7;
+    skills[i].activeEffect2 = (effect_t) (DEF + i % 3);
+    if (skills[i].activeEffect2 == ATK_CRIT) skills[i].effect2.atk_crit = 0.25f;
+    else skills[i].effect2.def = 5 + i;
+  }
+
+  printf("Battle log (%u events kept, %zu bytes each)\n", BATTLE_LOG_EVENTS, sizeof(BattleEvent));
+
+  struct timespec start;
+  clock_gettime(CLOCK_MONOTONIC, &start);
+  for (uint i = 0; i < EVENTS; i++) logRound(i & 1, NO_SKILL, i, i, (ushort) i, i);
+  printf("  %-30s %6.2f ns\n", "logRound", elapsedNs(&start) / EVENTS);
+
+  // The same fights both times, so only the logging differs
+  double ns[2];
+  uint attacks[2];
+  for (int log = 0; log <= 1; log++) {
+    seedRandom(SEED);
+    attacks[log] = 0;
+
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    for (uint i = 0; i < FIGHTS; i++) attacks[log] += fight(skills, i % 4 == 0, log);
+    ns[log] = elapsedNs(&start) / attacks[log];
+  }
+
+  printf("  %-30s %6.2f ns\n", "attack, not logged", ns[0]);
+  printf("  %-30s %6.2f ns\n", "attack, logged", ns[1]);
+  printf("  %-30s %6.2f ns\n", "logging an attack costs", ns[1] - ns[0]);
+
+  // Only these fights make it into the file, opening the log drops the events timed before
+  openBattleLog(path, SEED);
+  seedRandom(SEED);
+
+  uint logged = 0;
+  for (uint i = 0; i < LOGGED_FIGHTS; i++) logged += fight(skills, i % 4 == 0, true);
+
+  flushBattleLog();
+  printf("  wrote %u fights, %u attacks to %s\n", LOGGED_FIGHTS, logged, path);
+
+  return (attacks[0] == attacks[1]) ? 0 : 1;
+}
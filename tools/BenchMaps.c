@@ -0,0 +1,89 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "Error.h"
+#include "Setup.h"
+#include "SaveLoad.h"
+#include "Bench.h"
+
+#ifdef __GLIBC__
+#include <malloc.h>
+#endif
+
+
+#define DEFAULT_RUNS 5
+
+// SaveLoad needs these
+SoulWorker* player = NULL;
+Maze* maze = NULL;
+
+
+/**
+ * Times loading, saving and deleting the map.
+ * Each run starts from a fresh load, so createMapState always saves a maze with nothing entered.
+ * @param filename The map
+ * @param runs How many times to go through it
+ * @return Whether every save worked
+ */
+static bool benchMap(const str filename, int runs) {
+  struct timespec start;
+  double loadMs = 0, saveMs = 0, deleteMs = 0;
+  size_t saveBytes = 0;
+  uint size = 0;
+
+  for (int i = 0; i < runs; i++) {
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    Maze* maze = initMaze(filename);
+    loadMs += elapsedMs(&start);
+
+    size = maze->rooms.len;
+
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    str mapState = createMapState(maze);
+#ifdef __GLIBC__
+    // glibc only merges the nodes the save freed on the next big free, which would be in deleteMaze
+    malloc_trim(0);
+#endif
+    saveMs += elapsedMs(&start);
+
+    if (!mapState) { deleteMaze(maze); return false; }
+
+    saveBytes = strlen(mapState);
+    cJSON_free(mapState);
+
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    deleteMaze(maze);
+    deleteMs += elapsedMs(&start);
+  }
+
+  printf("%s (%u rooms, %d runs)\n", filename, size, runs);
+  printf("  initMaze:       %10.3f ms\n", loadMs / runs);
+  printf("  createMapState: %10.3f ms (%zu bytes)\n", saveMs / runs, saveBytes);
+  printf("  deleteMaze:     %10.3f ms\n", deleteMs / runs);
+  fflush(stdout);
+
+  return true;
+}
+
+int main(int argc, str* argv) {
+  int runs = DEFAULT_RUNS;
+  bool ok = true;
+
+  if (argc > 1 && strcmp(argv[1], "-n") == 0) {
+    if (argc < 3) { printf("usage: BenchMaps [-n runs] map.json ...\n"); return 1; }
+
+    runs = atoi(argv[2]);
+    if (runs <= 0) runs = DEFAULT_RUNS;
+
+    argc -= 2;
+    argv += 2;
+  }
+
+  if (argc < 2) { printf("usage: BenchMaps [-n runs] map.json ...\n"); return 1; }
+
+  for (int i = 1; i < argc; i++) ok &= benchMap(argv[i], runs);
+
+  return ok ? 0 : 1;
+}
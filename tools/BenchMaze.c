@@ -0,0 +1,275 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <string.h>
+#include <time.h>
+
+#include "Error.h"
+#include "Colors.h"
+#include "Setup.h"
+#include "MapParser.h"
+#include "Workers.h"
+#include "Random.h"
+
+
+#define DEFAULT_RUNS 200
+#define SEED 1234 // Both loaders roll the same loot and enemies with the same seed
+
+static const char* defaultMaps[] = { "../data/maps/control_zone.json", "../data/maps/r_square.json" };
+
+typedef Maze* (*loader_f)(const str filename);
+
+
+/**
+ * Compares two strings, either of which can be NULL.
+ */
+static bool sameStr(const char* a, const char* b) {
+  if (!a || !b) return a == b;
+  return strcmp(a, b) == 0;
+}
+
+/**
+ * Compares two stats.
+ */
+static bool sameStats(Stats* a, Stats* b) {
+  return a->ATK == b->ATK && a->DEF == b->DEF && a->ACC == b->ACC &&
+    a->ATK_CRIT_DMG == b->ATK_CRIT_DMG && a->ATK_CRIT == b->ATK_CRIT;
+}
+
+/**
+ * Compares two soul weapons, either of which can be NULL.
+ */
+static bool sameWeapon(SoulWeapon* a, SoulWeapon* b) {
+  if (!a || !b) return a == b;
+  return sameStr(a->name, b->name) && a->atk == b->atk && a->acc == b->acc && a->atk_crit == b->atk_crit &&
+    a->atk_crit_dmg == b->atk_crit_dmg && a->lvl == b->lvl && a->upgrades == b->upgrades &&
+    a->durability == b->durability;
+}
+
+/**
+ * Compares two armors, either of which can be NULL.
+ */
+static bool sameArmor(Armor* a, Armor* b) {
+  if (!a || !b) return a == b;
+  return sameStr(a->name, b->name) && a->type == b->type && a->acc == b->acc && a->def == b->def && a->lvl == b->lvl;
+}
+
+/**
+ * Compares two items, either of which can be NULL.
+ */
+static bool sameItem(Item* a, Item* b) {
+  if (!a || !b) return a == b;
+  if (a->type != b->type || a->count != b->count) return false;
+
+  switch (a->type) {
+    case SOULWEAPON_T:
+      return sameWeapon((SoulWeapon*) a->_item, (SoulWeapon*) b->_item);
+    case HELMET_T:
+    case SHOULDER_GUARD_T:
+    case CHESTPLATE_T:
+    case BOOTS_T:
+      return sameArmor((Armor*) a->_item, (Armor*) b->_item);
+    case HP_KITS_T:
+      return ((HPKit*) a->_item)->type == ((HPKit*) b->_item)->type &&
+        sameStr(((HPKit*) a->_item)->desc, ((HPKit*) b->_item)->desc);
+    case WEAPON_UPGRADE_MATERIALS_T:
+    case ARMOR_UPGRADE_MATERIALS_T:
+      return ((Upgrade*) a->_item)->rank == ((Upgrade*) b->_item)->rank &&
+        ((Upgrade*) a->_item)->type == ((Upgrade*) b->_item)->type &&
+        sameStr(((Upgrade*) a->_item)->desc, ((Upgrade*) b->_item)->desc);
+    case SLIME_T:
+      return sameStr(((Slime*) a->_item)->desc, ((Slime*) b->_item)->desc);
+    default:
+      return true;
+  }
+}
+
+/**
+ * Compares the skills of two bosses.
+ */
+static bool sameSkills(Skill* a, Skill* b) {
+  for (int i = 0; i < BOSS_SKILL_COUNT; i++) {
+    Skill* x = &a[i];
+    Skill* y = &b[i];
+
+    if (!sameStr(x->name, y->name) || !sameStr(x->description, y->description) || x->lvl != y->lvl ||
+      x->cooldown != y->cooldown || x->cdTimer != y->cdTimer || x->id != y->id ||
+      x->effect1.atk != y->effect1.atk || x->effect2.atk_crit != y->effect2.atk_crit ||
+      x->activeEffect1 != y->activeEffect1 || x->activeEffect2 != y->activeEffect2) return false;
+  }
+
+  return true;
+}
+
+/**
+ * Compares two enemy templates, gear and skills included for bosses.
+ */
+static bool sameTemplate(EnemyTemplate* a, EnemyTemplate* b) {
+  if (!sameStr(a->name, b->name) || a->xpPoints != b->xpPoints || a->lvl != b->lvl) return false;
+  if (!a->boss || !b->boss) return a->boss == b->boss;
+
+  Gear* x = &a->boss->gearDrop;
+  Gear* y = &b->boss->gearDrop;
+
+  return sameWeapon(x->sw, y->sw) && sameArmor(x->helmet, y->helmet) && sameArmor(x->guard, y->guard) &&
+    sameArmor(x->chestplate, y->chestplate) && sameArmor(x->boots, y->boots) &&
+    sameSkills(a->boss->skills, b->boss->skills);
+}
+
+/**
+ * Compares two enemies (or the base of two bosses), either of which can be NULL.
+ * Each is looked up in the catalog of its own maze.
+ */
+static bool sameEnemy(Maze* ma, Enemy* a, Maze* mb, Enemy* b) {
+  if (!a || !b) return a == b;
+  return a->hp == b->hp && sameStats(&a->stats, &b->stats) &&
+    sameTemplate(getEnemyTemplate(ma, a), getEnemyTemplate(mb, b));
+}
+
+/**
+ * Compares the room in the same slot of both mazes. Both loaders add the rooms in file order,
+ * so the slots, and the exits between them, have to match as well.
+ * @param ma The first maze
+ * @param mb The second maze
+ * @param room The slot of the room
+ * @return Whether the rooms match
+ */
+static bool sameRoom(Maze* ma, Maze* mb, uint room) {
+  RoomStore* a = &ma->rooms;
+  RoomStore* b = &mb->rooms;
+
+  if (a->ids[room] != b->ids[room] || a->flags[room] != b->flags[room]) return false;
+  if (memcmp(a->exits[room], b->exits[room], sizeof(RoomExits)) != 0) return false;
+  if (a->pos[room].x != b->pos[room].x || a->pos[room].y != b->pos[room].y) return false;
+  if (roomSeen(a, room) != roomSeen(b, room)) return false;
+
+  if (!sameStr(a->info[room], b->info[room]) || !sameStr(a->storyFiles[room], b->storyFiles[room])) return false;
+  if (!sameItem(a->loot[room], b->loot[room])) return false;
+
+  // A boss starts with its base enemy, its cooldowns all start at 0
+  return sameEnemy(ma, a->enemies[room].enemy, mb, b->enemies[room].enemy);
+}
+
+/**
+ * Rolls every room, in the same order for mazes of the same map.
+ * @param maze The maze
+ */
+static void materializeAll(Maze* maze) {
+  for (uint i = 0; i < maze->rooms.len; i++) materializeRoom(maze, i);
+}
+
+/**
+ * Times the loader over the map.
+ * @param load The loader
+ * @param filename The map
+ * @param runs How many times to load it
+ * @return The average milliseconds per load
+ */
+static double timeLoader(loader_f load, const str filename, int runs) {
+  struct timespec start, end;
+
+  clock_gettime(CLOCK_MONOTONIC, &start);
+  for (int i = 0; i < runs; i++) deleteMaze(load(filename));
+  clock_gettime(CLOCK_MONOTONIC, &end);
+
+  double ms = (end.tv_sec - start.tv_sec) * 1000.0 + (end.tv_nsec - start.tv_nsec) / 1e6;
+  return ms / runs;
+}
+
+/**
+ * Loads the map and rolls every room, with the given seed.
+ * Rooms are rolled lazily, so they are all rolled before comparing.
+ * @param load The loader
+ * @param filename The map
+ * @return The maze
+ */
+static Maze* loadRolled(loader_f load, const str filename) {
+  seedRandom(SEED);
+  Maze* maze = load(filename);
+  materializeAll(maze);
+
+  return maze;
+}
+
+/**
+ * Compares two mazes room by room.
+ * @param a The first maze
+ * @param b The second maze
+ * @return Whether they are the same, both are deleted
+ */
+static bool sameMaze(Maze* a, Maze* b) {
+  bool same = sameStr(a->name, b->name) && a->rooms.len == b->rooms.len && a->entry == b->entry &&
+    memcmp(&a->layout, &b->layout, sizeof(MapLayout)) == 0;
+  for (uint i = 0; same && i < a->rooms.len; i++) same = sameRoom(a, b, i);
+
+  deleteMaze(a);
+  deleteMaze(b);
+
+  return same;
+}
+
+/**
+ * Checks that both loaders build the same maze, then compares their speed.
+ * @param filename The map
+ * @param runs How many times to load it
+ * @param workers How many workers to also split the streaming load across, 1 for none
+ * @return Whether the mazes matched
+ */
+static bool benchMap(const str filename, int runs, uint workers) {
+  setWorkerCount(1);
+
+  Maze* stream = loadRolled((loader_f) parseMaze, filename);
+  bool same = sameMaze(loadRolled(initMazeDOM, filename), stream);
+
+  printf("%s (%d runs)\n", filename, runs);
+  printf("  same maze: %s\n", same ? GREEN "yes" RESET : RED "NO" RESET);
+
+  double domMs = timeLoader(initMazeDOM, filename, runs);
+  double streamMs = timeLoader((loader_f) parseMaze, filename, runs);
+
+  printf("  cJSON DOM: %8.4f ms/load\n", domMs);
+  printf("  streaming: %8.4f ms/load (%.2fx)\n", streamMs, domMs / streamMs);
+
+  if (workers > 1) {
+    // The split load has to build the very same maze as a single pass
+    stream = loadRolled((loader_f) parseMaze, filename);
+
+    setWorkerCount(workers);
+    bool sameSplit = sameMaze(stream, loadRolled((loader_f) parseMaze, filename));
+    double splitMs = timeLoader((loader_f) parseMaze, filename, runs);
+
+    printf("  same maze with %u workers: %s\n", workers, sameSplit ? GREEN "yes" RESET : RED "NO" RESET);
+    printf("  %2u workers: %8.4f ms/load (%.2fx)\n", workers, splitMs, streamMs / splitMs);
+
+    same &= sameSplit;
+  }
+
+  return same;
+}
+
+int main(int argc, str* argv) {
+  const str usage = "usage: BenchMaze [-n runs] [-j workers] [map.json ...]\n";
+  int runs = DEFAULT_RUNS;
+  uint workers = 1;
+  bool same = true;
+
+  while (argc > 1 && (strcmp(argv[1], "-n") == 0 || strcmp(argv[1], "-j") == 0)) {
+    if (argc < 3) { printf("%s", usage); return 1; }
+
+    int value = atoi(argv[2]);
+
+    if (argv[1][1] == 'n') runs = (value > 0) ? value : DEFAULT_RUNS;
+    else workers = (value > 0) ? (uint) value : 1;
+
+    argc -= 2;
+    argv += 2;
+  }
+
+  if (argc > 1) {
+    for (int i = 1; i < argc; i++) same &= benchMap(argv[i], runs, workers);
+  } else {
+    for (size_t i = 0; i < sizeof(defaultMaps) / sizeof(defaultMaps[0]); i++) same &= benchMap((str) defaultMaps[i], runs, workers);
+  }
+
+  return same ? 0 : 1;
+}
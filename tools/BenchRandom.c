@@ -0,0 +1,93 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "Random.h"
+#include "Bench.h"
+
+
+#define DEFAULT_ROLLS 10000000
+#define SEED 1234
+#define BOUND 6 // Like rolling which of a few enemies a room holds
+
+
+/**
+ * Checks that the same seed replays the same rolls, that streams do not disturb each other,
+ * that a saved state continues the same sequence, and that the batches match single rolls.
+ * @return Whether every check passed
+ */
+static bool checkStreams() {
+  uint a[64], b[64];
+  bool ok = true;
+
+  seedRandom(SEED);
+  for (int i = 0; i < 64; i++) a[i] = randomU32(RNG_LOOT);
+
+  // Rolling in another stream in between changes nothing
+  seedRandom(SEED);
+  for (int i = 0; i < 64; i++) { randomU32(RNG_BATTLE); b[i] = randomU32(RNG_LOOT); }
+  ok &= memcmp(a, b, sizeof(a)) == 0;
+  printf("  streams are independent: %s\n", ok ? "yes" : "NO");
+
+  // A restored state rolls what would have come next
+  seedRandom(SEED);
+  for (int i = 0; i < 32; i++) randomU32(RNG_LOOT);
+  uint64_t saved = getRandomState(RNG_LOOT);
+
+  seedRandom(SEED + 1);
+  setRandomState(RNG_LOOT, saved);
+  for (int i = 32; i < 64; i++) b[i] = randomU32(RNG_LOOT);
+  bool restored = memcmp(a + 32, b + 32, 32 * sizeof(uint)) == 0;
+  printf("  restored state continues: %s\n", restored ? "yes" : "NO");
+
+  seedRandom(SEED);
+  randomFill(RNG_LOOT, b, 64);
+  bool batch = memcmp(a, b, sizeof(a)) == 0;
+
+  seedRandom(SEED);
+  for (int i = 0; i < 64; i++) a[i] = randomBelow(RNG_ENEMY, BOUND);
+  seedRandom(SEED);
+  randomFillBelow(RNG_ENEMY, b, 64, BOUND);
+  batch &= memcmp(a, b, sizeof(a)) == 0;
+  printf("  batches match single rolls: %s\n", batch ? "yes" : "NO");
+
+  return ok && restored && batch;
+}
+
+int main(int argc, str* argv) {
+  uint n = (argc > 1) ? (uint) atoi(argv[1]) : DEFAULT_ROLLS;
+  if (n == 0) n = DEFAULT_ROLLS;
+
+  uint* rolls = (uint*) malloc(n * sizeof(uint));
+  if (!rolls) { printf("Could not allocate space for the rolls!\n"); return 1; }
+
+  struct timespec start;
+  uint sum = 0;
+
+  printf("RNG streams (%u rolls)\n", n);
+  bool ok = checkStreams();
+
+  srand(SEED);
+  clock_gettime(CLOCK_MONOTONIC, &start);
+  for (uint i = 0; i < n; i++) sum += rand() % BOUND;
+  double randMs = elapsedMs(&start);
+
+  seedRandom(SEED);
+  clock_gettime(CLOCK_MONOTONIC, &start);
+  for (uint i = 0; i < n; i++) sum += randomBelow(RNG_ENEMY, BOUND);
+  double singleMs = elapsedMs(&start);
+
+  clock_gettime(CLOCK_MONOTONIC, &start);
+  randomFillBelow(RNG_ENEMY, rolls, n, BOUND);
+  for (uint i = 0; i < n; i++) sum += rolls[i];
+  double batchMs = elapsedMs(&start);
+
+  printf("  rand() %% %d:      %6.2f ns/roll\n", BOUND, randMs * 1e6 / n);
+  printf("  randomBelow:     %6.2f ns/roll\n", singleMs * 1e6 / n);
+  printf("  randomFillBelow: %6.2f ns/roll (%u)\n", batchMs * 1e6 / n, sum % 10);
+
+  free(rolls);
+
+  return ok ? 0 : 1;
+}
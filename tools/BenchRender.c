@@ -0,0 +1,165 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "Error.h"
+#include "Setup.h"
+#include "Bench.h"
+
+
+#define DEFAULT_RUNS 20
+#define VIEW_COLS 80 // The window drawn, the size of a common terminal
+#define VIEW_ROWS 22
+
+
+/**
+ * Prints the cells the way showMap used to, a printf per cell with its color and a reset around it.
+ * @param maze The maze, already drawn by renderMap
+ * @param out Where to print
+ * @return The bytes printed
+ */
+static size_t printCells(Maze* maze, FILE* out) {
+  size_t cols = 2 * (size_t) maze->layout.width - 1;
+  size_t rows = 2 * (size_t) maze->layout.height - 1;
+  size_t bytes = fprintf(out, "%s%s%s: ", PURPLE, maze->name, RESET);
+
+  for (size_t i = 0; i < rows; i++) {
+    for (size_t j = 0; j < cols; j++) {
+      char room = maze->frame.cells[i * cols + j];
+
+      if (room == 'o') bytes += fprintf(out, "%s%c%s", GREEN, room, RESET);
+      else if (room == '$') bytes += fprintf(out, "%s%c%s", YELLOW, room, RESET);
+      else if (room == '@') bytes += fprintf(out, "%s%c%s", CYAN, room, RESET);
+      else if (room == '%') bytes += fprintf(out, "%s%c%s", PURPLE, room, RESET);
+      else if (room == '!') bytes += fprintf(out, "%s%c%s", RED, room, RESET);
+      else bytes += fprintf(out, "%s%c", RESET, room);
+    }
+    putc('\n', out);
+    bytes++;
+  }
+
+  fflush(out);
+
+  return bytes;
+}
+
+/**
+ * Checks that the window shows what the whole map shows in its place, with every room seen.
+ * The last row and column are left out, since the whole map has the connections of the rooms past them there.
+ * @param maze The maze, drawn by renderMap
+ * @param view The window, drawn by renderMapView
+ * @return Whether they match
+ */
+static bool sameWindow(Maze* maze, MapView* view) {
+  MapLayout* layout = &maze->layout;
+  long long cols = 2LL * layout->width - 1, rows = 2LL * layout->height - 1;
+  long long left = 2 * ((long long) view->x - (view->cols + 1) / 4 - layout->minX);
+  long long top = 2 * ((long long) view->y - (view->rows + 1) / 4 - layout->minY);
+
+  for (long long i = 0; i + 1 < view->rows; i++) {
+    for (long long j = 0; j + 1 < view->cols; j++) {
+      long long y = top + i, x = left + j;
+      char cell = (y >= 0 && y < rows && x >= 0 && x < cols) ? maze->frame.cells[y * cols + x] : ' ';
+
+      if (view->cells[i * view->cols + j] != cell) return false;
+    }
+  }
+
+  return true;
+}
+
+/**
+ * Times drawing the map of the maze both ways, into /dev/null.
+ * @param filename The map
+ * @param runs How many times to draw it
+ */
+static void benchMap(const str filename, int runs) {
+  FILE* out = fopen("/dev/null", "w");
+  if (!out) handleError(ERR_IO, FATAL, "Could not open /dev/null!\n");
+
+  Maze* maze = initMaze(filename);
+  struct timespec start;
+
+  // The first frame allocates the buffers, which happens once per maze
+  renderMap(maze, maze->entry);
+
+  clock_gettime(CLOCK_MONOTONIC, &start);
+  size_t oldBytes = 0;
+  for (int i = 0; i < runs; i++) oldBytes = printCells(maze, out);
+  double oldMs = elapsedMs(&start) / runs;
+
+  clock_gettime(CLOCK_MONOTONIC, &start);
+  size_t newBytes = 0;
+  for (int i = 0; i < runs; i++) {
+    newBytes = renderMap(maze, maze->entry);
+    fwrite(maze->frame.bytes, 1, newBytes, out);
+    fflush(out);
+  }
+  double newMs = elapsedMs(&start) / runs;
+
+  printf("%s (%u rooms, %u x %u map, %d runs)\n", filename, maze->rooms.len, maze->layout.width, maze->layout.height, runs);
+  printf("  printf per cell: %10zu bytes %9.3f ms/frame\n", oldBytes, oldMs);
+  printf("  one buffer:      %10zu bytes %9.3f ms/frame (%.1fx fewer bytes, %.1fx faster)\n",
+    newBytes, newMs, (double) oldBytes / newBytes, oldMs / newMs);
+
+  // Out of the fog, the window shows the part of the whole map around the entry
+  for (uint i = 0; i < maze->rooms.len; i++) setRoomSeen(&maze->rooms, i);
+  renderMap(maze, maze->entry);
+
+  MapView view;
+  initMapView(maze, &view, VIEW_COLS, VIEW_ROWS);
+  centerMapView(maze, &view, maze->entry);
+
+  clock_gettime(CLOCK_MONOTONIC, &start);
+  renderMapView(maze, &view, maze->entry);
+  double indexMs = elapsedMs(&start);
+
+  clock_gettime(CLOCK_MONOTONIC, &start);
+  size_t viewBytes = 0;
+  for (int i = 0; i < runs; i++) {
+    viewBytes = renderMapView(maze, &view, maze->entry);
+    fwrite(view.bytes, 1, viewBytes, out);
+    fflush(out);
+  }
+  double viewMs = elapsedMs(&start) / runs;
+
+  // Scrolled all around, up to past the edges
+  bool same = sameWindow(maze, &view);
+  int moves[4][2] = { { 1, 0 }, { 0, 1 }, { -1, 0 }, { 0, -1 } };
+  for (int i = 0; i < 4; i++) {
+    for (int j = 0; j < 40; j++) {
+      scrollMapView(maze, &view, moves[i][0], moves[i][1]);
+      renderMapView(maze, &view, maze->entry);
+      same &= sameWindow(maze, &view);
+    }
+  }
+
+  printf("  %ux%u window:    %10zu bytes %9.3f ms/frame (first %.3f ms, with the index), same as the map: %s\n",
+    VIEW_COLS, VIEW_ROWS, viewBytes, viewMs, indexMs, same ? GREEN "yes" RESET : RED "NO" RESET);
+
+  deleteMapView(&view);
+
+  deleteMaze(maze);
+  fclose(out);
+}
+
+int main(int argc, str* argv) {
+  int runs = DEFAULT_RUNS;
+
+  if (argc > 1 && strcmp(argv[1], "-n") == 0) {
+    if (argc < 3) { printf("usage: BenchRender [-n runs] map.json ...\n"); return 1; }
+
+    runs = atoi(argv[2]);
+    if (runs <= 0) runs = DEFAULT_RUNS;
+
+    argc -= 2;
+    argv += 2;
+  }
+
+  if (argc < 2) { printf("usage: BenchRender [-n runs] map.json ...\n"); return 1; }
+
+  for (int i = 1; i < argc; i++) benchMap(argv[i], runs);
+
+  return 0;
+}
@@ -0,0 +1,391 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <time.h>
+
+#include "Error.h"
+#include "Setup.h"
+#include "Screen.h"
+#include "Bench.h"
+
+
+#define DEFAULT_FRAMES 200
+#define TERM_COLS 80 // The size the screen takes when not on a terminal
+#define TERM_ROWS 24
+#define VIEW_ROWS 22 // The map window, with a row for its title and one for the prompt
+#define TEXT_SIZE 8192 // The most text a frame of the screens here takes
+#define LINK_BITS 1e6 // A slow link, in bits per second, to tell what the bytes cost over it
+#define FRAMES_FILE "out/bench_screen.frames"
+
+
+// A cell of the terminal, as the terminal stores it
+typedef struct TermCell {
+  uint32_t glyph;
+  int style;
+} TermCell;
+
+// Just enough of a terminal to follow what the screen sends
+typedef struct Term {
+  TermCell cells[TERM_ROWS * TERM_COLS];
+  uint row, col;
+  uint savedRow, savedCol;
+  uint top, bottom; // The scroll region
+  int style;
+  bool wrap; // Whether the last column was written, so the next character goes on the next row
+} Term;
+
+// Draws frame i of a screen into text, returning its length
+typedef size_t (*draw_frame_t)(char* text, uint i, void* arg);
+
+
+/**
+ * Blanks the cells of the terminal from one to another.
+ */
+static void termErase(Term* term, size_t from, size_t to) {
+  for (size_t i = from; i < to; i++) term->cells[i] = (TermCell) { ' ', 0 };
+}
+
+/**
+ * Clears the terminal, as it is before the first frame.
+ */
+static void termReset(Term* term) {
+  termErase(term, 0, TERM_ROWS * TERM_COLS);
+  term->row = term->col = term->savedRow = term->savedCol = 0;
+  term->top = 0;
+  term->bottom = TERM_ROWS - 1;
+  term->style = 0;
+  term->wrap = false;
+}
+
+/**
+ * Moves down a row, scrolling the region at its bottom. Like a terminal printing a newline, it goes back to the first column.
+ */
+static void termNewline(Term* term) {
+  term->col = 0;
+  term->wrap = false;
+
+  if (term->row != term->bottom) { if (term->row + 1 < TERM_ROWS) term->row++; return; }
+
+  memmove(&term->cells[term->top * TERM_COLS], &term->cells[(term->top + 1) * TERM_COLS],
+    (term->bottom - term->top) * TERM_COLS * sizeof(TermCell));
+  termErase(term, term->bottom * TERM_COLS, (term->bottom + 1) * TERM_COLS);
+}
+
+/**
+ * Runs an escape sequence.
+ * @return The bytes of the sequence after the escape
+ */
+static size_t termEscape(Term* term, const char* bytes, size_t len) {
+  if (len == 0) return 0;
+  if (bytes[0] == '7') { term->savedRow = term->row; term->savedCol = term->col; return 1; }
+  if (bytes[0] == '8') { term->row = term->savedRow; term->col = term->savedCol; term->wrap = false; return 1; }
+  if (bytes[0] != '[') return 1;
+
+  uint params[2] = { 0, 0 }, n = 0;
+  size_t i = 1;
+
+  for (; i < len && (bytes[i] < '@' || bytes[i] > '~'); i++) {
+    if (bytes[i] == ';') { if (n < 1) n++; }
+    else params[n] = params[n] * 10 + (bytes[i] - '0');
+  }
+
+  size_t at = (size_t) term->row * TERM_COLS + term->col;
+
+  switch (bytes[i]) {
+    case 'H':
+      term->row = (params[0] > 0) ? params[0] - 1 : 0;
+      term->col = (params[1] > 0) ? params[1] - 1 : 0;
+      term->wrap = false;
+      break;
+    case 'C':
+      term->col += (params[0] > 0) ? params[0] : 1;
+      if (term->col >= TERM_COLS) term->col = TERM_COLS - 1;
+      term->wrap = false;
+      break;
+    case 'J':
+      if (params[0] == 2) termErase(term, 0, TERM_ROWS * TERM_COLS);
+      else termErase(term, at, TERM_ROWS * TERM_COLS);
+      break;
+    case 'K':
+      if (params[0] == 2) termErase(term, (size_t) term->row * TERM_COLS, (size_t) (term->row + 1) * TERM_COLS);
+      else termErase(term, at, (size_t) (term->row + 1) * TERM_COLS);
+      break;
+    case 'm':
+      term->style = (int) params[0];
+      break;
+    case 'r':
+      term->top = (params[0] > 0) ? params[0] - 1 : 0;
+      term->bottom = (params[1] > 0) ? params[1] - 1 : TERM_ROWS - 1;
+      term->row = term->col = 0;
+      term->wrap = false;
+      break;
+    default:
+      break;
+  }
+
+  return i + 1;
+}
+
+/**
+ * Feeds the bytes to the terminal.
+ */
+static void termWrite(Term* term, const char* bytes, size_t len) {
+  TermCell* last = NULL;
+
+  for (size_t i = 0; i < len; i++) {
+    unsigned char c = (unsigned char) bytes[i];
+
+    if (c == '\x1b') { i += termEscape(term, &bytes[i + 1], len - i - 1); continue; }
+    if (c == '\n') { termNewline(term); continue; }
+    if (c == '\r') { term->col = 0; term->wrap = false; continue; }
+
+    if ((c & 0xC0) == 0x80) {
+      if (!last) continue;
+
+      uint shift = 8;
+      while (shift < 32 && (last->glyph >> shift)) shift += 8;
+      if (shift < 32) last->glyph |= (uint32_t) c << shift;
+
+      continue;
+    }
+
+    if (term->wrap) termNewline(term);
+
+    last = &term->cells[term->row * TERM_COLS + term->col];
+    *last = (TermCell) { c, (c != ' ') ? term->style : 0 };
+
+    if (term->col + 1 == TERM_COLS) term->wrap = true;
+    else term->col++;
+  }
+}
+
+/**
+ * Checks that the terminal shows the frame at its top, and nothing below it.
+ * @param term The terminal the frames were sent to
+ * @param text The frame
+ * @param len The bytes of the frame
+ * @return Whether it does
+ */
+static bool sameFrame(Term* term, const char* text, size_t len) {
+  static Term expected;
+
+  termReset(&expected);
+  termWrite(&expected, text, len);
+
+  uint used = expected.row + (expected.col > 0 || expected.wrap);
+
+  for (size_t i = 0; i < TERM_ROWS * TERM_COLS; i++) {
+    TermCell want = (i < (size_t) used * TERM_COLS) ? expected.cells[i] : (TermCell) { ' ', 0 };
+    TermCell got = term->cells[i];
+
+    if (got.glyph != want.glyph || (got.glyph != ' ' && got.style != want.style)) return false;
+  }
+
+  return true;
+}
+
+/**
+ * Draws a skill screen like viewSkills, one skill going up a level each frame.
+ */
+static size_t drawSkills(char* text, uint i, void* arg) {
+  (void) arg;
+  char* out = text;
+
+  out += sprintf(out, "%sSkills:%s\n", CYAN, RESET);
+
+  for (uint half = 0; half < 2; half++) {
+    for (uint s = half * 5; s < half * 5 + 5; s++) out += sprintf(out, "|%s%7u%7s%s", (s <= i % 10) ? GREEN : RED, s + 1, " ", RESET);
+    out += sprintf(out, "|\n");
+    for (uint s = half * 5; s < half * 5 + 5; s++) out += sprintf(out, "| S%-2u LVL %-5u", s + 1, 1 + (i + 10 - s) / 10);
+    out += sprintf(out, "|\n");
+    for (uint s = half * 5; s < half * 5 + 5; s++) out += sprintf(out, "| CD: %-9u", 2 + s % 3);
+    out += sprintf(out, "|\n");
+    for (uint s = half * 5; s < half * 5 + 5; s++) out += sprintf(out, "| ATK: %-8u", 10 * (1 + (i + 10 - s) / 10));
+    out += sprintf(out, "|\n|");
+    memset(out, '-', 74);
+    out += 74;
+    out += sprintf(out, "|\n");
+  }
+
+  out += sprintf(out, "Active skills:\n| Skill 1        | Skill 2        | Skill 3        |\n");
+  out += sprintf(out, "Current Skill Points: %u\n", 200 - i % 200);
+
+  return out - text;
+}
+
+/**
+ * Draws the boss battle like bossBattle, both sides losing HP each frame.
+ */
+static size_t drawBattle(char* text, uint i, void* arg) {
+  (void) arg;
+  char* out = text;
+  uint bossHP = 5000 - 7 * (i % 700), hp = 900 - (i % 900);
+
+  out += sprintf(out, "%sBOSS ENCOUNTERED!! Retreat is not an option!%s\n", RED, RESET);
+  out += sprintf(out, "Wolf, LVL 4; HP %s%u%s/5000\n", (bossHP <= 2500) ? RED : GREEN, bossHP, RESET);
+  out += sprintf(out, "ATK: 3; DEF: 2; ACC: 1; ATK CRIT DMG: 2; ATK CRIT: 0.28\n");
+  out += sprintf(out, "Tester: %s%u%s/900\n\n", (hp <= 450) ? RED : GREEN, hp, RESET);
+  out += sprintf(out, "Skill activated is %s\nYou dealt 7 DMG!\nYou received 1 DMG!\n", (i % 3) ? "none" : "Slash");
+  out += sprintf(out, "\nWhat are you going to do?\n[h] Heal\n[0] Basic attack\n");
+  for (uint s = 0; s < 5; s++) out += sprintf(out, "[%u] Skill %u; CD: %u\n", s + 1, s + 1, (i + s) % 4);
+
+  return out - text;
+}
+
+// The map window and the room the player walks to next
+typedef struct MapWalk {
+  Maze* maze;
+  MapView view;
+  uint room;
+  uint seed;
+} MapWalk;
+
+/**
+ * Draws the map window around the player, who goes through a random exit each frame, like viewMap.
+ */
+static size_t drawMap(char* text, uint i, void* arg) {
+  MapWalk* walk = (MapWalk*) arg;
+  Maze* maze = walk->maze;
+
+  walk->seed = walk->seed * 1103515245 + 12345;
+  uint next = maze->rooms.exits[walk->room][(walk->seed >> 16) & 3];
+  if (next != NO_ROOM) walk->room = next;
+
+  setRoomSeen(&maze->rooms, walk->room);
+
+  // The player recenters the window now and then, as it walks off it
+  if (i % 20 == 0) centerMapView(maze, &walk->view, walk->room);
+
+  size_t len = renderMapView(maze, &walk->view, walk->room);
+  memcpy(text, walk->view.bytes, len);
+
+  return len;
+}
+
+/**
+ * Draws the frames of a screen both ways, checking that the changes sent build the same terminal as drawing it all.
+ * @param name The name of the screen
+ * @param draw Draws a frame
+ * @param arg What draw needs
+ * @param frames How many frames to draw
+ * @param reset Sets arg back to where it started, so both ways draw the same frames
+ */
+static void benchScreen(const str name, draw_frame_t draw, void* arg, uint frames, void (*reset)(void*)) {
+  static Term term;
+  char* text = (char*) malloc(TEXT_SIZE * 4);
+  if (!text) handleError(ERR_MEM, FATAL, "Could not allocate space for the frames!\n");
+
+  FILE* null = fopen("/dev/null", "w");
+  if (!null) handleError(ERR_IO, FATAL, "Could not open /dev/null!\n");
+
+  struct timespec start;
+  size_t printBytes = 0, diffBytes = 0;
+
+  // Every frame printed out in full, as before
+  if (reset) reset(arg);
+  initScreen(null, false);
+  clock_gettime(CLOCK_MONOTONIC, &start);
+  for (uint i = 0; i < frames; i++) {
+    size_t len = draw(text, i, arg);
+
+    beginScreen();
+    screenWrite(text, len);
+    printBytes += presentScreen();
+  }
+  double printMs = elapsedMs(&start) / frames;
+
+  if (reset) reset(arg);
+  initScreen(null, true);
+  clock_gettime(CLOCK_MONOTONIC, &start);
+  for (uint i = 0; i < frames; i++) {
+    size_t len = draw(text, i, arg);
+
+    beginScreen();
+    screenWrite(text, len);
+    diffBytes += presentScreen();
+  }
+  double diffMs = elapsedMs(&start) / frames;
+
+  // Again, following what reaches the terminal
+  FILE* sent = fopen(FRAMES_FILE, "w");
+  FILE* received = fopen(FRAMES_FILE, "r");
+  if (!sent || !received) handleError(ERR_IO, FATAL, "Could not open " FRAMES_FILE "!\n");
+
+  char* bytes = text + TEXT_SIZE;
+  bool same = true;
+
+  if (reset) reset(arg);
+  termReset(&term);
+  initScreen(sent, true);
+  for (uint i = 0; i < frames; i++) {
+    size_t len = draw(text, i, arg);
+
+    beginScreen();
+    screenWrite(text, len);
+    size_t sentLen = presentScreen();
+
+    if (sentLen > TEXT_SIZE * 3 || fread(bytes, 1, sentLen, received) != sentLen) { same = false; break; }
+
+    termWrite(&term, bytes, sentLen);
+    same &= sameFrame(&term, text, len);
+  }
+
+  deleteScreen();
+  fclose(sent);
+  fclose(received);
+  remove(FRAMES_FILE);
+  fclose(null);
+  free(text);
+
+  printf("  %-8s printed: %9zu bytes %8.4f ms/frame %8.2f ms/frame at %.0f kbit/s\n",
+    name, printBytes, printMs, printBytes * 8e3 / LINK_BITS / frames, LINK_BITS / 1e3);
+  printf("  %-8s diffed:  %9zu bytes %8.4f ms/frame %8.2f ms/frame (%.1fx fewer bytes), same on the terminal: %s\n",
+    "", diffBytes, diffMs, diffBytes * 8e3 / LINK_BITS / frames, (double) printBytes / diffBytes,
+    same ? GREEN "yes" RESET : RED "NO" RESET);
+}
+
+/**
+ * Puts the player back at the entry, in the fog, with the window around it.
+ */
+static void resetWalk(void* arg) {
+  MapWalk* walk = (MapWalk*) arg;
+  RoomStore* rooms = &walk->maze->rooms;
+
+  memset(rooms->seen, 0, (rooms->len + 63) / 64 * sizeof(uint64_t));
+
+  walk->room = walk->maze->entry;
+  walk->seed = 1;
+  centerMapView(walk->maze, &walk->view, walk->room);
+}
+
+int main(int argc, str* argv) {
+  uint frames = DEFAULT_FRAMES;
+
+  if (argc > 1 && strcmp(argv[1], "-n") == 0) {
+    if (argc < 3) { printf("usage: BenchScreen [-n frames] [map.json]\n"); return 1; }
+
+    frames = (uint) atoi(argv[2]);
+    if (frames == 0) frames = DEFAULT_FRAMES;
+
+    argc -= 2;
+    argv += 2;
+  }
+
+  printf("Screen frames (%ux%u terminal, %u frames each)\n", TERM_COLS, TERM_ROWS, frames);
+
+  benchScreen("skills", drawSkills, NULL, frames, NULL);
+  benchScreen("battle", drawBattle, NULL, frames, NULL);
+
+  if (argc > 1) {
+    MapWalk walk = { initMaze(argv[1]), { 0 }, 0, 1 };
+    initMapView(walk.maze, &walk.view, TERM_COLS, VIEW_ROWS);
+
+    benchScreen("map", drawMap, &walk, frames, resetWalk);
+
+    deleteMapView(&walk.view);
+    deleteMaze(walk.maze);
+  }
+
+  return 0;
+}
@@ -0,0 +1,73 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "Error.h"
+#include "Maze.h"
+#include "Bench.h"
+
+
+#define DEFAULT_RUNS 5
+#define MAX_ROOMS 1000000 // The biggest table to time
+#define SPARSE_STEP 2047 // How far apart the ids of a sparse map are, MAX_ROOMS of them still fit MAX_ROOM_ID
+
+
+/**
+ * Times putting and looking up n rooms, in the order a map lists them.
+ * @param n The number of rooms
+ * @param step How far apart their ids are
+ * @param presized Whether the table is sized for the rooms up front, like the loaders that count them do
+ * @param runs How many times to build the table
+ * @return Whether every room was found again
+ */
+static bool benchTable(uint n, uint step, bool presized, int runs) {
+  struct timespec start;
+  double putMs = 0, lookupMs = 0;
+  bool found = true;
+
+  for (int r = 0; r < runs; r++) {
+    clock_gettime(CLOCK_MONOTONIC, &start);
+
+    Table* table = presized ? initTableL(n, (n - 1) * step) : initTable();
+    if (!table) handleError(ERR_MEM, FATAL, "Could not allocate space for the table!\n");
+
+    for (uint i = 0; i < n; i++) putRoom(table, i * step, i, false);
+
+    putMs += elapsedMs(&start);
+
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    for (uint i = 0; i < n; i++) found &= lookupRoom(table, i * step) == i;
+    lookupMs += elapsedMs(&start);
+
+    deleteTable(table);
+  }
+
+  printf("  %7u rooms %-6s %-8s put: %7.2f ns/room  lookup: %6.2f ns/room\n", n,
+    (step == 1) ? "dense" : "sparse", presized ? "presized" : "grown",
+    putMs * 1e6 / runs / n, lookupMs * 1e6 / runs / n);
+  fflush(stdout);
+
+  return found;
+}
+
+int main(int argc, str* argv) {
+  int runs = (argc > 1) ? atoi(argv[1]) : DEFAULT_RUNS;
+  if (runs <= 0) runs = DEFAULT_RUNS;
+
+  bool found = true;
+
+  printf("Room table (%d runs)\n", runs);
+
+  // The cost per room stays flat as the table grows
+  for (uint n = 1000; n <= MAX_ROOMS; n *= 10) {
+    found &= benchTable(n, 1, false, runs);
+    found &= benchTable(n, 1, true, runs);
+    found &= benchTable(n, SPARSE_STEP, false, runs);
+    found &= benchTable(n, SPARSE_STEP, true, runs);
+  }
+
+  if (!found) printf("Some rooms were not found again!\n");
+
+  return found ? 0 : 1;
+}
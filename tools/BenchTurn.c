@@ -0,0 +1,192 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <pthread.h>
+
+#include "Damage.h"
+#include "Random.h"
+#include "SoulWorker.h"
+#include "Workers.h"
+#include "Bench.h"
+
+
+#define DEFAULT_TURNS 20000
+#define SEED 1234
+#define PLAYER_LVL 10
+
+// Cooldowns of the skills of both sides, like the skills.dat and boss skills
+static const byte cooldowns[EQUIPPED_SKILL_COUNT + BOSS_SKILL_COUNT] = { 2, 3, 4, 5, 6, 3, 4, 5, 6, 7 };
+
+// The timers as bossBattle kept them before they were packed
+typedef struct OldTimers {
+  char player[EQUIPPED_SKILL_COUNT];
+  char boss[BOSS_SKILL_COUNT];
+} OldTimers;
+
+static Stats playerStats = { 40, 20, 30, 150, 0.3f };
+static Stats bossStats = { 30, 25, 30, 120, 0.2f };
+
+
+static int compareDoubles(const void* a, const void* b) {
+  double x = *(const double*) a, y = *(const double*) b;
+  return (x > y) - (x < y);
+}
+
+/**
+ * Prints the mean, median, 99th percentile and worst of the turn times.
+ */
+static void report(const char* name, double* ns, uint n) {
+  double sum = 0;
+  for (uint i = 0; i < n; i++) sum += ns[i];
+
+  qsort(ns, n, sizeof(double), compareDoubles);
+
+  printf("  %-28s mean %9.0f ns  p50 %9.0f ns  p99 %9.0f ns  max %10.0f ns\n", name, sum / n, ns[n / 2], ns[n * 99 / 100], ns[n - 1]);
+}
+
+/**
+ * The old decreaseCD, one side's timers per thread.
+ */
+static void* decreaseOld(void* _timers) {
+  char* timers = (char*) _timers;
+
+  for (int i = 0; i < 5; i++) {
+    if (timers[i] > 0) timers[i]--;
+  }
+
+  return NULL;
+}
+
+/**
+ * Ticks the old timers the way bossBattle did: a thread for each side, started and joined every turn.
+ */
+static void tickThreads(OldTimers* t) {
+  pthread_t playerThread, bossThread;
+
+  pthread_create(&playerThread, NULL, decreaseOld, t->player);
+  pthread_create(&bossThread, NULL, decreaseOld, t->boss);
+
+  pthread_join(playerThread, NULL);
+  pthread_join(bossThread, NULL);
+}
+
+static void decreaseTask(void* timers) {
+  decreaseOld(timers);
+}
+
+/**
+ * Ticks the old timers with a task for each side, on the pool that is already running.
+ */
+static void tickPool(OldTimers* t) {
+  TaskGroup group = { 0 };
+
+  submitTask(&group, decreaseTask, t->player);
+  submitTask(&group, decreaseTask, t->boss);
+
+  waitTasks(&group);
+}
+
+/**
+ * Plays the turns of a boss battle, without the prompts and pauses, timing each.
+ * @param how 0 ticks with two threads, 1 with two pool tasks, 2 with tickCooldowns
+ * @param ns Where to store the time of each turn
+ * @param n The number of turns
+ * @param timers Where to store the timers left at the end
+ */
+static void playTurns(int how, double* ns, uint n, char timers[EQUIPPED_SKILL_COUNT + BOSS_SKILL_COUNT]) {
+  OldTimers old;
+  Cooldowns cd;
+  memset(&old, 0, sizeof(old));
+  memset(&cd, 0, sizeof(cd));
+
+  seedRandom(SEED);
+
+  struct timespec start;
+
+  for (uint i = 0; i < n; i++) {
+    clock_gettime(CLOCK_MONOTONIC, &start);
+
+    // The player cycles through its skills, the boss picks like in the game
+    uint slot = i % EQUIPPED_SKILL_COUNT;
+    char* playerTimer = (how == 2) ? &cd.timers[PLAYER_CD + slot] : &old.player[slot];
+    bool ready = *playerTimer == 0;
+
+    rollDamage(&playerStats, &bossStats, NULL, PLAYER_LVL, NULL);
+    if (ready) {
+      if (how == 2) startCooldown(&cd, PLAYER_CD + slot, cooldowns[slot]);
+      else *playerTimer = cooldowns[slot] + 1;
+    }
+
+    int bossSkill = chooseBossSkill((how == 2) ? cd.timers + BOSS_CD : old.boss);
+    rollDamage(&bossStats, &playerStats, NULL, PLAYER_LVL, NULL);
+    if (bossSkill != -1) {
+      if (how == 2) startCooldown(&cd, BOSS_CD + bossSkill, cooldowns[EQUIPPED_SKILL_COUNT + bossSkill]);
+      else old.boss[bossSkill] = cooldowns[EQUIPPED_SKILL_COUNT + bossSkill] + 1;
+    }
+
+    if (how == 0) tickThreads(&old);
+    else if (how == 1) tickPool(&old);
+    else tickCooldowns(&cd);
+
+    ns[i] = elapsedNs(&start);
+  }
+
+  if (how == 2) memcpy(timers, cd.timers, EQUIPPED_SKILL_COUNT + BOSS_SKILL_COUNT);
+  else {
+    memcpy(timers, old.player, EQUIPPED_SKILL_COUNT);
+    memcpy(timers + EQUIPPED_SKILL_COUNT, old.boss, BOSS_SKILL_COUNT);
+  }
+}
+
+/**
+ * Checks that the packed tick takes one off every running timer and leaves the stopped ones, for every value.
+ * @return Whether it did
+ */
+static bool checkTick() {
+  for (int v = 0; v <= MAX_CD; v++) {
+    Cooldowns cd;
+    for (int i = 0; i < 16; i++) cd.timers[i] = (char) ((v + i * 37) % (MAX_CD + 1));
+
+    Cooldowns next = cd;
+    tickCooldowns(&next);
+
+    for (int i = 0; i < 16; i++) {
+      if (next.timers[i] != ((cd.timers[i] > 0) ? cd.timers[i] - 1 : 0)) return false;
+    }
+  }
+
+  return true;
+}
+
+int main(int argc, str* argv) {
+  uint n = (argc > 1) ? (uint) atoi(argv[1]) : DEFAULT_TURNS;
+  if (n == 0) n = DEFAULT_TURNS;
+
+  double* ns = (double*) malloc(n * sizeof(double));
+  if (!ns) { printf("Could not allocate space for the times!\n"); return 1; }
+
+  printf("Boss battle turns, without prompts or pauses (%u turns, pool of %u threads)\n", n, poolSize());
+
+  bool tick = checkTick();
+  printf("  packed tick matches per timer: %s\n", tick ? "yes" : "NO");
+
+  char threads[EQUIPPED_SKILL_COUNT + BOSS_SKILL_COUNT], pool[EQUIPPED_SKILL_COUNT + BOSS_SKILL_COUNT];
+  char packed[EQUIPPED_SKILL_COUNT + BOSS_SKILL_COUNT];
+
+  playTurns(0, ns, n, threads);
+  report("2 threads per turn (before)", ns, n);
+
+  playTurns(1, ns, n, pool);
+  report("2 pool tasks per turn", ns, n);
+
+  playTurns(2, ns, n, packed);
+  report("packed tick (now)", ns, n);
+
+  bool same = memcmp(threads, pool, sizeof(pool)) == 0 && memcmp(threads, packed, sizeof(packed)) == 0;
+  printf("  same cooldowns every way: %s\n", same ? "yes" : "NO");
+
+  free(ns);
+
+  return (tick && same) ? 0 : 1;
+}
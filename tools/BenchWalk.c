@@ -0,0 +1,103 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "Error.h"
+#include "Setup.h"
+#include "RoomWalk.h"
+#include "Bench.h"
+
+
+#define DEFAULT_RUNS 20
+#define MOVES_PER_ROOM 10 // How many moves to make per room of the map
+
+
+/**
+ * Counts a room reached by the walk.
+ */
+static walk_action_t countStep(WalkStep* step, void* count) {
+  (void) step;
+  (*(uint*) count)++;
+
+  return WALK_CONTINUE;
+}
+
+/**
+ * Moves through the maze like a player would, through a random open exit each time,
+ * looking at what each room holds on the way.
+ * @param maze The maze
+ * @param moves How many exits to try
+ * @return What was seen, so the moves are not optimized away
+ */
+static uint wander(Maze* maze, uint moves) {
+  RoomStore* rooms = &maze->rooms;
+  uint room = maze->entry;
+  uint seen = 0;
+  uint seed = 1;
+
+  for (uint i = 0; i < moves; i++) {
+    seed = seed * 1103515245 + 12345;
+    uint next = rooms->exits[room][(seed >> 16) & 3];
+    if (next == NO_ROOM) continue;
+
+    room = next;
+    seen += (rooms->flags[room] & ROOM_BOSS) + (rooms->loot[room] != NULL) + (rooms->tables[room] != NULL);
+  }
+
+  return seen;
+}
+
+/**
+ * Times walking the whole map both ways, and moving through it.
+ * @param filename The map
+ * @param runs How many times to go through it
+ */
+static void benchMap(const str filename, int runs) {
+  Maze* maze = initMaze(filename);
+  struct timespec start;
+  uint count = 0;
+
+  clock_gettime(CLOCK_MONOTONIC, &start);
+  for (int i = 0; i < runs; i++) walkRooms(maze, maze->entry, WALK_BFS, countStep, &count);
+  double bfsMs = elapsedMs(&start) / runs;
+
+  clock_gettime(CLOCK_MONOTONIC, &start);
+  for (int i = 0; i < runs; i++) walkRooms(maze, maze->entry, WALK_DFS, countStep, &count);
+  double dfsMs = elapsedMs(&start) / runs;
+
+  uint moves = MOVES_PER_ROOM * maze->rooms.len;
+  uint seen = 0;
+
+  clock_gettime(CLOCK_MONOTONIC, &start);
+  for (int i = 0; i < runs; i++) seen += wander(maze, moves);
+  double wanderMs = elapsedMs(&start) / runs;
+
+  printf("%s (%u rooms, %d runs)\n", filename, maze->rooms.len, runs);
+  printf("  BFS walk: %10.3f ms (%u rooms reached)\n", bfsMs, count / (2 * runs));
+  printf("  DFS walk: %10.3f ms\n", dfsMs);
+  printf("  wander:   %10.3f ms (%u moves, %u seen)\n", wanderMs, moves, seen / runs);
+  fflush(stdout);
+
+  deleteMaze(maze);
+}
+
+int main(int argc, str* argv) {
+  int runs = DEFAULT_RUNS;
+
+  if (argc > 1 && strcmp(argv[1], "-n") == 0) {
+    if (argc < 3) { printf("usage: BenchWalk [-n runs] map.json ...\n"); return 1; }
+
+    runs = atoi(argv[2]);
+    if (runs <= 0) runs = DEFAULT_RUNS;
+
+    argc -= 2;
+    argv += 2;
+  }
+
+  if (argc < 2) { printf("usage: BenchWalk [-n runs] map.json ...\n"); return 1; }
+
+  for (int i = 1; i < argc; i++) benchMap(argv[i], runs);
+
+  return 0;
+}
@@ -0,0 +1,335 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <string.h>
+#include <time.h>
+
+#include "Error.h"
+#include "Colors.h"
+#include "Setup.h"
+#include "SaveLoad.h"
+#include "RoomWalk.h"
+#include "Random.h"
+#include "Bench.h"
+
+
+#define DEFAULT_ROOMS 1000000
+#define DEFAULT_MAP "big_maze.json"
+#define DEFAULT_SAVE "big_maze_save.json"
+#define ENEMY_EVERY 8 // Every nth room has an enemy table
+#define LOOT_EVERY 5 // Every nth room has a loot table
+#define SEED 1234
+
+// SaveLoad needs these
+SoulWorker* player = NULL;
+Maze* maze = NULL;
+
+static const char* enemyTable =
+  "[{\"name\":\"Wolf\",\"xpPoints\":5,\"hp\":[5,8],\"lvl\":4,"
+  "\"stats\":{\"ATK\":[1,3],\"ACC\":[1],\"ATK_CRIT\":[0.2,0.3],\"ATK_CRIT_DMG\":[1,2],\"DEF\":[2,3]}}]";
+
+static const char* lootTable = "[{\"count\":2,\"type\":6,\"item\":{\"type\":0,\"description\":\"Heals for 15.\"}}]";
+
+
+/**
+ * Gets the exit of a room of the generated maze.
+ * The rooms form a binary tree so every room is reachable without long chains:
+ * room i leads east to 2i+1 and south to 2i+2, which lead back west and north.
+ * @param id The room id
+ * @param dir The direction (0 north, 1 east, 2 south, 3 west)
+ * @param rooms The number of rooms
+ * @return The id of the exit, or -1 if there is none
+ */
+static long long exitOf(uint id, int dir, uint rooms) {
+  long long child = 2LL * id + dir;
+
+  switch (dir) {
+    case 0: return (id != 0 && id % 2 == 0) ? (long long) (id - 2) / 2 : -1;
+    case 3: return (id % 2 == 1) ? (long long) (id - 1) / 2 : -1;
+    default: return (child < rooms) ? child : -1;
+  }
+}
+
+/**
+ * Writes the generated map.
+ * @param filename The map to write
+ * @param rooms The number of rooms
+ */
+static void writeMap(const char* filename, uint rooms) {
+  FILE* file = fopen(filename, "w");
+  if (!file) handleError(ERR_IO, FATAL, "Could not create %s!\n", filename);
+
+  fprintf(file, "{\"name\":\"big_maze\"");
+
+  for (uint i = 0; i < rooms; i++) {
+    fprintf(file, ",\n\"%u\":{\"isEntry\":%d,\"storyfile\":\"\",\"info\":\"Room %u.\",\"hasBoss\":0,\"exits\":[%lld,%lld,%lld,%lld],",
+      i, i == 0, i, exitOf(i, 0, rooms), exitOf(i, 1, rooms), exitOf(i, 2, rooms), exitOf(i, 3, rooms));
+    fprintf(file, "\"loot\":%s,\"enemy\":%s}", (i % LOOT_EVERY == 1) ? lootTable : "[]", (i % ENEMY_EVERY == 7) ? enemyTable : "[]");
+  }
+
+  fprintf(file, "\n}\n");
+
+  if (fclose(file) != 0) handleError(ERR_IO, FATAL, "Could not write %s!\n", filename);
+}
+
+/**
+ * Counts a room reached from the entry.
+ */
+static walk_action_t countStep(WalkStep* step, void* count) {
+  (void) step;
+  (*(uint*) count)++;
+
+  return WALK_CONTINUE;
+}
+
+/**
+ * Gets the id of an exit, -1 if there is none.
+ */
+static long long exitId(Maze* maze, uint room, int dir) {
+  uint exit = maze->rooms.exits[room][dir];
+  if (exit == NO_ROOM) return -1;
+  return maze->rooms.ids[exit];
+}
+
+/**
+ * Checks that the maze is the generated one.
+ * @param maze The maze
+ * @param rooms The number of rooms it was generated with
+ * @return Whether it matches
+ */
+static bool checkMaze(Maze* maze, uint rooms) {
+  if (maze->rooms.len != rooms) {
+    printf("  %u rooms, expected %u\n", maze->rooms.len, rooms);
+    return false;
+  }
+
+  uint reached = 0;
+  walkRooms(maze, maze->entry, WALK_BFS, countStep, &reached);
+
+  bool same = reached == rooms;
+  if (!same) printf("  %u rooms reached, expected %u\n", reached, rooms);
+
+  char info[32];
+
+  for (uint i = 0; same && i < rooms; i++) {
+    uint room = getRoom(maze, i);
+    if (room == NO_ROOM) { printf("  room %u is missing\n", i); same = false; break; }
+
+    sprintf(info, "Room %u.", i);
+    if (strcmp(maze->rooms.info[room], info) != 0) { printf("  room %u has the wrong info\n", i); same = false; }
+
+    for (int j = 0; j < 4; j++) {
+      if (exitId(maze, room, j) != exitOf(i, j, rooms)) { printf("  room %u has the wrong exits\n", i); same = false; break; }
+    }
+
+    // Nothing was entered, so both keep their whole tables
+    uint enemies = (i % ENEMY_EVERY == 7) ? 1 : 0;
+    uint loot = (i % LOOT_EVERY == 1) ? 1 : 0;
+    RoomTables* tables = maze->rooms.tables[room];
+    if (!tables || tables->enemyCount != enemies || tables->lootCount != loot) {
+      printf("  room %u has the wrong tables\n", i);
+      same = false;
+    }
+  }
+
+  return same;
+}
+
+/**
+ * Keeps where every room of the maze is drawn, by id.
+ * @param maze The maze
+ * @param rooms The number of rooms it was generated with
+ * @return The positions
+ */
+static RoomPos* copyLayout(Maze* maze, uint rooms) {
+  RoomPos* pos = (RoomPos*) malloc(rooms * sizeof(RoomPos));
+  if (!pos) handleError(ERR_MEM, FATAL, "Could not allocate space for the layout!\n");
+
+  for (uint i = 0; i < rooms; i++) pos[i] = maze->rooms.pos[getRoom(maze, i)];
+
+  return pos;
+}
+
+/**
+ * Checks that the reloaded maze is drawn where it was before saving.
+ * @param maze The reloaded maze
+ * @param layout The bounding box before saving
+ * @param pos The positions before saving, by id
+ * @param rooms The number of rooms
+ * @return Whether it matches
+ */
+static bool checkLayout(Maze* maze, MapLayout* layout, RoomPos* pos, uint rooms) {
+  if (memcmp(&maze->layout, layout, sizeof(MapLayout)) != 0) { printf("  the map has moved\n"); return false; }
+
+  for (uint i = 0; i < rooms; i++) {
+    RoomPos p = maze->rooms.pos[getRoom(maze, i)];
+    if (p.x != pos[i].x || p.y != pos[i].y) { printf("  room %u has moved\n", i); return false; }
+  }
+
+  return true;
+}
+
+/**
+ * Counts the rooms not rolled yet, and the loot and enemies left in their tables.
+ * @param maze The maze
+ * @param counts Where to store the rooms, loot and enemies
+ */
+static void countTables(Maze* maze, uint counts[3]) {
+  counts[0] = counts[1] = counts[2] = 0;
+
+  for (uint i = 0; i < maze->rooms.len; i++) {
+    RoomTables* tables = maze->rooms.tables[i];
+    if (!tables) continue;
+
+    counts[0]++;
+    counts[1] += tables->lootCount;
+    counts[2] += tables->enemyCount;
+  }
+}
+
+/**
+ * Saves the game on a compiled maze and loads it back, from ./data/saves like the game does.
+ * Saving writes the tables of the rooms not entered yet as they are, so it must not roll anything:
+ * the RNG state is the same after saving, the load puts it back, and the loaded maze still has every table.
+ * @param mapFile The map, compiled with CreateMaze -c
+ * @return Whether nothing was rolled and the load continues from the saved state
+ */
+static bool checkSaveRandom(const char* mapFile) {
+  seedRandom(SEED);
+
+  maze = initMaze((str) mapFile);
+  if (maze->tablesType != TABLES_MZB) {
+    printf("  %s has not been compiled, run CreateMaze -c on it\n", mapFile);
+    return false;
+  }
+
+  char* name = (char*) malloc(sizeof("BigMaze"));
+  if (!name) handleError(ERR_MEM, FATAL, "Could not allocate space for the player name!\n");
+  strcpy(name, "BigMaze");
+
+  player = initSoulWorker(name);
+  player->room = maze->entry;
+
+  uint64_t before[RNG_STREAMS], saved[RNG_STREAMS];
+  uint tablesBefore[3], tablesSaved[3], tablesLoaded[3];
+
+  for (int i = 0; i < RNG_STREAMS; i++) before[i] = getRandomState(i);
+  countTables(maze, tablesBefore);
+
+  saveGame();
+  for (int i = 0; i < RNG_STREAMS; i++) saved[i] = getRandomState(i);
+  countTables(maze, tablesSaved);
+
+  deleteSoulWorker(player);
+  deleteMaze(maze);
+
+  // Anything but the saved state, so only the load can put it back
+  seedRandom(SEED + 1);
+  loadGame();
+  countTables(maze, tablesLoaded);
+
+  bool kept = memcmp(before, saved, sizeof(saved)) == 0 && memcmp(tablesBefore, tablesSaved, sizeof(tablesSaved)) == 0;
+  bool same = true;
+  for (int i = 0; i < RNG_STREAMS; i++) {
+    if (getRandomState(i) != saved[i]) { printf("  %s is not where the save left it\n", randomStreamName(i)); same = false; }
+  }
+
+  bool tables = memcmp(tablesBefore, tablesLoaded, sizeof(tablesLoaded)) == 0;
+  if (!tables) {
+    printf("  %u rooms with %u loot and %u enemies to roll, loaded %u rooms with %u loot and %u enemies\n",
+      tablesBefore[0], tablesBefore[1], tablesBefore[2], tablesLoaded[0], tablesLoaded[1], tablesLoaded[2]);
+  }
+
+  printf("  the save rolled nothing: %s\n", kept ? GREEN "yes" RESET : RED "NO" RESET);
+  printf("  loaded rng continues: %s\n", same ? GREEN "yes" RESET : RED "NO" RESET);
+  printf("  loaded tables kept: %s\n", tables ? GREEN "yes" RESET : RED "NO" RESET);
+
+  deleteSoulWorker(player);
+  deleteMaze(maze);
+  player = NULL;
+  maze = NULL;
+
+  return kept && same && tables;
+}
+
+int main(int argc, str* argv) {
+  uint rooms = DEFAULT_ROOMS;
+  const char* mapFile = DEFAULT_MAP;
+  const char* saveFile = DEFAULT_SAVE;
+
+  if (argc > 1 && strcmp(argv[1], "-c") == 0) {
+    if (argc < 3) { printf("usage: BigMaze -c compiled_map.json\n"); return 1; }
+
+    printf("Save and load on %s\n", argv[2]);
+    return checkSaveRandom(argv[2]) ? 0 : 1;
+  }
+
+  if (argc > 1 && strcmp(argv[1], "-n") == 0) {
+    if (argc < 3) { printf("usage: BigMaze [-n rooms] [map.json save.json] | -c compiled_map.json\n"); return 1; }
+
+    long long n = atoll(argv[2]);
+    if (n > 0 && n <= (long long) MAX_ROOM_ID + 1) rooms = (uint) n;
+
+    argc -= 2;
+    argv += 2;
+  }
+
+  if (argc > 2) {
+    mapFile = argv[1];
+    saveFile = argv[2];
+  }
+
+  struct timespec start;
+  bool same = true;
+
+  printf("%u rooms\n", rooms);
+
+  clock_gettime(CLOCK_MONOTONIC, &start);
+  writeMap(mapFile, rooms);
+  printf("  generate: %10.1f ms (%s)\n", elapsedMs(&start), mapFile);
+
+  clock_gettime(CLOCK_MONOTONIC, &start);
+  maze = initMaze((str) mapFile);
+  printf("  load:     %10.1f ms\n", elapsedMs(&start));
+
+  same &= checkMaze(maze, rooms);
+
+  // Rooms of the tree run into each other, so only some of them are drawn
+  MapLayout layout = maze->layout;
+  RoomPos* pos = copyLayout(maze, rooms);
+
+  uint placed = 0;
+  for (uint i = 0; i < rooms; i++) placed += pos[i].x != NO_POS;
+  printf("  layout:   %u rooms drawn, %u x %u\n", placed, layout.width, layout.height);
+
+  clock_gettime(CLOCK_MONOTONIC, &start);
+  str mapState = createMapState(maze);
+  if (!mapState) handleError(ERR_DATA, FATAL, "Could not create map state!\n");
+
+  FILE* file = fopen(saveFile, "w");
+  if (!file) handleError(ERR_IO, FATAL, "Could not create %s!\n", saveFile);
+  fputs(mapState, file);
+  if (fclose(file) != 0) handleError(ERR_IO, FATAL, "Could not write %s!\n", saveFile);
+
+  cJSON_free(mapState);
+  printf("  save:     %10.1f ms (%s)\n", elapsedMs(&start), saveFile);
+
+  clock_gettime(CLOCK_MONOTONIC, &start);
+  deleteMaze(maze);
+  printf("  delete:   %10.1f ms\n", elapsedMs(&start));
+
+  clock_gettime(CLOCK_MONOTONIC, &start);
+  maze = initMaze((str) saveFile);
+  printf("  reload:   %10.1f ms\n", elapsedMs(&start));
+
+  same &= checkMaze(maze, rooms);
+  same &= checkLayout(maze, &layout, pos, rooms);
+
+  free(pos);
+  deleteMaze(maze);
+  maze = NULL;
+
+  printf("  same maze: %s\n", same ? GREEN "yes" RESET : RED "NO" RESET);
+
+  return same ? 0 : 1;
+}
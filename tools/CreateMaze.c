@@ -2,6 +2,7 @@
 #include <stdlib.h>
 #include <stdbool.h>
 #include <string.h>
+#include <stdint.h>
 #include <dirent.h>
 #include <unistd.h>
 #include <time.h>
@@ -9,6 +10,7 @@
 #include "../headers/Error.h"
 #include "../headers/Colors.h"
 #include "../headers/cJSON.h"
+#include "../headers/MazeBin.h"
 
 // Needs to match up with Misc.h!!!
 
@@ -791,7 +793,7 @@ static void createRoom(cJSON* root, int id, FILE* room) {
   }
   ungetc(c, room);
 
-  char buffer[2];
+  char buffer[12];
 
   printf("%sCreating room %d....%s\n", PURPLE, id, RESET);
 
@@ -940,6 +942,423 @@ static void createRoom(cJSON* root, int id, FILE* room) {
   if (line != NULL) free(line);
 }
 
+// A growable buffer for building a section of the compiled maze
+typedef struct Section {
+  char* data;
+  size_t len;
+  size_t cap;
+} Section;
+
+/**
+ * Appends size bytes to the section, growing it when needed.
+ * @param section The section
+ * @param data The bytes to append
+ * @param size The amount of bytes
+ * @return The offset the bytes were written at
+ */
+static uint32_t sectionAppend(Section* section, const void* data, size_t size) {
+  if (section->len + size > section->cap) {
+    size_t cap = (section->cap == 0) ? 256 : section->cap * 2;
+    while (cap < section->len + size) cap *= 2;
+
+    char* _data = realloc(section->data, cap);
+    if (!_data) handleError(ERR_MEM, FATAL, "Could not grow section of compiled maze!\n");
+
+    section->data = _data;
+    section->cap = cap;
+  }
+
+  uint32_t offset = (uint32_t) section->len;
+  memcpy(section->data + section->len, data, size);
+  section->len += size;
+
+  return offset;
+}
+
+/**
+ * Adds a string to the string section.
+ * @param strs The string section
+ * @param s The string
+ * @return The string offset
+ */
+static uint32_t addString(Section* strs, const str s) {
+  return sectionAppend(strs, s, strlen(s) + 1);
+}
+
+/**
+ * Gets a member of a JSON object, exiting when it is missing.
+ * @param obj The JSON object
+ * @param key The member
+ * @return The member
+ */
+static cJSON* getMember(cJSON* obj, const str key) {
+  cJSON* member = cJSON_GetObjectItemCaseSensitive(obj, key);
+  if (!member) handleError(ERR_DATA, FATAL, "Could not find %s of %s!\n", key, obj->string ? obj->string : "object");
+
+  return member;
+}
+
+/**
+ * Fills a [min, max] pair from a JSON array of one or two numbers.
+ * @param arr The JSON array
+ * @param lo The lower limit
+ * @param hi The upper limit
+ * @return Whether it is a range or not
+ */
+static bool binRange(cJSON* arr, double* lo, double* hi) {
+  int len = cJSON_GetArraySize(arr);
+  if (len == 0) handleError(ERR_DATA, FATAL, "Empty stat array %s!\n", arr->string);
+
+  *lo = cJSON_GetArrayItem(arr, 0)->valuedouble;
+  *hi = (len > 1) ? cJSON_GetArrayItem(arr, 1)->valuedouble : *lo;
+
+  return len > 1;
+}
+
+/**
+ * Fills the item record with the data of a gear piece.
+ * @param obj The JSON gear piece
+ * @param type The item type
+ * @param rec The item record
+ * @param strs The string section
+ */
+static void binGear(cJSON* obj, item_t type, MzbItem* rec, Section* strs) {
+  rec->type = type;
+  rec->text = addString(strs, getMember(obj, "name")->valuestring);
+  rec->acc = getMember(obj, "acc")->valueint;
+  rec->lvl = getMember(obj, "lvl")->valueint;
+
+  if (type == SOULWEAPON_T) {
+    rec->atk = getMember(obj, "atk")->valueint;
+    rec->atkCrit = (float) getMember(obj, "atk_crit")->valuedouble;
+    rec->atkCritDmg = getMember(obj, "atk_crit_dmg")->valueint;
+    rec->upgrades = getMember(obj, "upgrades")->valueint;
+    rec->durability = getMember(obj, "durability")->valueint;
+  } else {
+    rec->kind = getMember(obj, "type")->valueint;
+    rec->def = getMember(obj, "def")->valueint;
+  }
+}
+
+/**
+ * Creates the item record of a loot object.
+ * @param loot The JSON loot object
+ * @param items The item section
+ * @param strs The string section
+ */
+static void binLoot(cJSON* loot, Section* items, Section* strs) {
+  MzbItem rec = { 0 };
+
+  cJSON* obj = getMember(loot, "item");
+  item_t type = getMember(loot, "type")->valueint;
+
+  rec.type = type;
+  rec.count = getMember(loot, "count")->valueint;
+
+  switch (type) {
+    case SOULWEAPON_T:
+    case HELMET_T:
+    case SHOULDER_GUARD_T:
+    case CHESTPLATE_T:
+    case BOOTS_T:
+      binGear(obj, type, &rec, strs);
+      break;
+    case HP_KITS_T:
+      rec.kind = getMember(obj, "type")->valueint;
+      rec.text = addString(strs, getMember(obj, "description")->valuestring);
+      break;
+    case WEAPON_UPGRADE_MATERIALS_T:
+    case ARMOR_UPGRADE_MATERIALS_T:
+      rec.rank = getMember(obj, "rank")->valueint;
+      rec.kind = getMember(obj, "type")->valueint;
+      rec.text = addString(strs, getMember(obj, "description")->valuestring);
+      break;
+    case SLIME_T:
+      rec.text = addString(strs, getMember(obj, "description")->valuestring);
+      break;
+    default:
+      handleError(ERR_DATA, FATAL, "Unknown loot type %d!\n", type);
+  }
+
+  sectionAppend(items, &rec, sizeof(MzbItem));
+}
+
+/**
+ * Creates the enemy record of an enemy object, along with its gear and skills if a boss.
+ * @param obj The JSON enemy object
+ * @param isBoss Whether the enemy is a boss or not
+ * @param items The item section
+ * @param enemies The enemy section
+ * @param skills The skill section
+ * @param strs The string section
+ */
+static void binEnemy(cJSON* obj, bool isBoss, Section* items, Section* enemies, Section* skills, Section* strs) {
+  MzbEnemy rec = { 0 };
+  double lo, hi;
+
+  rec.name = addString(strs, getMember(obj, "name")->valuestring);
+  rec.xpPoints = getMember(obj, "xpPoints")->valueint;
+  rec.lvl = getMember(obj, "lvl")->valueint;
+  rec.gear = MZB_NONE;
+
+  if (binRange(getMember(obj, "hp"), &lo, &hi)) rec.ranged |= MZB_RANGED_HP;
+  rec.hp[0] = lo; rec.hp[1] = hi;
+
+  cJSON* stats = getMember(obj, "stats");
+
+  if (binRange(getMember(stats, "ATK"), &lo, &hi)) rec.ranged |= MZB_RANGED_ATK;
+  rec.atk[0] = lo; rec.atk[1] = hi;
+
+  if (binRange(getMember(stats, "DEF"), &lo, &hi)) rec.ranged |= MZB_RANGED_DEF;
+  rec.def[0] = lo; rec.def[1] = hi;
+
+  if (binRange(getMember(stats, "ACC"), &lo, &hi)) rec.ranged |= MZB_RANGED_ACC;
+  rec.acc[0] = lo; rec.acc[1] = hi;
+
+  if (binRange(getMember(stats, "ATK_CRIT_DMG"), &lo, &hi)) rec.ranged |= MZB_RANGED_CRIT_DMG;
+  rec.atkCritDmg[0] = lo; rec.atkCritDmg[1] = hi;
+
+  if (binRange(getMember(stats, "ATK_CRIT"), &lo, &hi)) rec.ranged |= MZB_RANGED_CRIT;
+  rec.atkCrit[0] = lo; rec.atkCrit[1] = hi;
+
+  if (isBoss) {
+    cJSON* gear = getMember(obj, "gear");
+
+    // In the order of the game's Gear structure
+    const str pieces[5] = { "soulweapon", "helmet", "shoulder_guard", "chestplate", "boots" };
+    const item_t types[5] = { SOULWEAPON_T, HELMET_T, SHOULDER_GUARD_T, CHESTPLATE_T, BOOTS_T };
+
+    rec.gear = items->len / sizeof(MzbItem);
+
+    for (int i = 0; i < 5; i++) {
+      MzbItem piece = { 0 };
+      piece.count = 1;
+      binGear(getMember(gear, pieces[i]), types[i], &piece, strs);
+      sectionAppend(items, &piece, sizeof(MzbItem));
+    }
+
+    cJSON* _skills = getMember(obj, "skills");
+
+    rec.skillStart = skills->len / sizeof(MzbSkill);
+    rec.skillCount = cJSON_GetArraySize(_skills);
+
+    cJSON* s = NULL;
+    cJSON_ArrayForEach(s, _skills) {
+      MzbSkill skill = { 0 };
+
+      skill.name = addString(strs, getMember(s, "name")->valuestring);
+      skill.description = addString(strs, getMember(s, "description")->valuestring);
+      skill.lvl = getMember(s, "lvl")->valueint;
+      skill.cooldown = getMember(s, "cooldown")->valueint;
+      skill.id = getMember(s, "id")->valueint;
+      skill.effect1 = getMember(s, "effect1")->valueint;
+      skill.effect2 = (float) getMember(s, "effect2")->valuedouble;
+      skill.activeEffect1 = getMember(s, "activeEffect1")->valueint;
+      skill.activeEffect2 = getMember(s, "activeEffect2")->valueint;
+
+      sectionAppend(skills, &skill, sizeof(MzbSkill));
+    }
+  }
+
+  sectionAppend(enemies, &rec, sizeof(MzbEnemy));
+}
+
+// Maps a room id to its index in the room table
+typedef struct RoomIndex {
+  int id;
+  uint32_t index;
+} RoomIndex;
+
+/**
+ * Used by qsort and bsearch to compare room indices by id
+ * @param a Room index a
+ * @param b Room index b
+ * @return Difference of the ids
+ */
+static int compareRoomIds(const void* a, const void* b) {
+  int idA = ((const RoomIndex*) a)->id;
+  int idB = ((const RoomIndex*) b)->id;
+
+  return (idA > idB) - (idA < idB);
+}
+
+/**
+ * Compiles the maze JSON into the binary maze format and writes it to filename.
+ * @param root The root JSON object of the maze
+ * @param filename The .mzb file to write
+ */
+static void saveMazeBin(cJSON* root, const str filename) {
+  Section rooms = { 0 }, items = { 0 }, enemies = { 0 }, skills = { 0 }, strs = { 0 };
+
+  MzbHeader header = { 0 };
+  memcpy(header.magic, MZB_MAGIC, 4);
+  header.version = MZB_VERSION;
+  header.entry = MZB_NONE;
+
+  cJSON* name = getMember(root, "name");
+  header.name = addString(&strs, name->valuestring);
+
+  // Every member other than the name (and a schema, if any) is a room
+  int roomCount = 0;
+  cJSON* room = NULL;
+  cJSON_ArrayForEach(room, root) if (cJSON_IsObject(room)) roomCount++;
+
+  if (roomCount == 0) handleError(ERR_DATA, FATAL, "Maze has no rooms!\n");
+
+  RoomIndex* indices = malloc(roomCount * sizeof(RoomIndex));
+  if (!indices) handleError(ERR_MEM, FATAL, "Could not allocate space for room indices!\n");
+
+  uint32_t i = 0;
+  cJSON_ArrayForEach(room, root) {
+    if (!cJSON_IsObject(room)) continue;
+
+    indices[i].id = atoi(room->string);
+    indices[i].index = i;
+    i++;
+  }
+
+  qsort(indices, roomCount, sizeof(RoomIndex), compareRoomIds);
+
+  i = 0;
+  cJSON_ArrayForEach(room, root) {
+    if (!cJSON_IsObject(room)) continue;
+
+    MzbRoom rec = { 0 };
+    rec.id = atoi(room->string);
+    rec.hasBoss = getMember(room, "hasBoss")->valueint;
+    rec.info = addString(&strs, getMember(room, "info")->valuestring);
+
+    // A room w/o storyfile stores an empty string
+    str storyfile = getMember(room, "storyfile")->valuestring;
+    rec.storyFile = (strlen(storyfile) != 0) ? addString(&strs, storyfile) : MZB_NONE;
+
+    if (getMember(room, "isEntry")->valueint == 1) header.entry = i;
+
+    int j = 0;
+    cJSON* e = NULL;
+    cJSON_ArrayForEach(e, getMember(room, "exits")) {
+      if (j == 4) break;
+
+      if (e->valueint == -1) { rec.exits[j++] = MZB_NONE; continue; }
+
+      RoomIndex key = { e->valueint, 0 };
+      RoomIndex* found = bsearch(&key, indices, roomCount, sizeof(RoomIndex), compareRoomIds);
+      if (!found) handleError(ERR_DATA, FATAL, "Room %u: exit to missing room %d!\n", rec.id, e->valueint);
+
+      rec.exits[j++] = found->index;
+    }
+    while (j < 4) rec.exits[j++] = MZB_NONE;
+
+    cJSON* loot = getMember(room, "loot");
+    rec.lootStart = items.len / sizeof(MzbItem);
+    rec.lootCount = cJSON_GetArraySize(loot);
+
+    cJSON_ArrayForEach(e, loot) binLoot(e, &items, &strs);
+
+    cJSON* enemy = getMember(room, "enemy");
+    rec.enemyStart = enemies.len / sizeof(MzbEnemy);
+    rec.enemyCount = cJSON_GetArraySize(enemy);
+
+    cJSON_ArrayForEach(e, enemy) binEnemy(e, rec.hasBoss, &items, &enemies, &skills, &strs);
+
+    // Boss gear follows the enemy in the item table, so the loot count is its own
+    sectionAppend(&rooms, &rec, sizeof(MzbRoom));
+    i++;
+  }
+
+  free(indices);
+
+  if (header.entry == MZB_NONE) handleError(ERR_DATA, FATAL, "Maze has no entry room!\n");
+
+  // Every record is a multiple of 4 bytes, so the sections stay aligned back to back
+  header.roomCount = roomCount;
+  header.roomOffset = sizeof(MzbHeader);
+  header.itemOffset = header.roomOffset + rooms.len;
+  header.itemCount = items.len / sizeof(MzbItem);
+  header.enemyOffset = header.itemOffset + items.len;
+  header.enemyCount = enemies.len / sizeof(MzbEnemy);
+  header.skillOffset = header.enemyOffset + enemies.len;
+  header.skillCount = skills.len / sizeof(MzbSkill);
+  header.strOffset = header.skillOffset + skills.len;
+  header.strSize = strs.len;
+  header.fileSize = header.strOffset + strs.len;
+
+  FILE* file = fopen(filename, "wb");
+  if (!file) handleError(ERR_IO, FATAL, "Could not create file!\n");
+
+  fwrite(&header, sizeof(MzbHeader), 1, file);
+  fwrite(rooms.data, 1, rooms.len, file);
+  fwrite(items.data, 1, items.len, file);
+  fwrite(enemies.data, 1, enemies.len, file);
+  fwrite(skills.data, 1, skills.len, file);
+  fwrite(strs.data, 1, strs.len, file);
+
+  if (ferror(file)) handleError(ERR_IO, FATAL, "Could not save compiled maze!\n");
+
+  printf("%sCompiled to %s (%u bytes)!%s\n", GREEN, filename, header.fileSize, RESET);
+
+  fclose(file);
+
+  free(rooms.data);
+  free(items.data);
+  free(enemies.data);
+  free(skills.data);
+  free(strs.data);
+}
+
+/**
+ * Gets the .mzb filename for the given .json filename.
+ * @param filename The .json filename
+ * @return The .mzb filename
+ */
+static str binFilename(const str filename) {
+  size_t len = strlen(filename);
+
+  // Replace the extension if there is one, otherwise add it
+  size_t nameLen = (len > 5 && strcmp(filename + len - 5, ".json") == 0) ? len - 5 : len;
+
+  str binFile = malloc(nameLen + 5);
+  if (!binFile) handleError(ERR_MEM, FATAL, "Could not allocate memory for compiled maze filename!\n");
+
+  memcpy(binFile, filename, nameLen);
+  strcpy(binFile + nameLen, ".mzb");
+
+  return binFile;
+}
+
+/**
+ * Compiles an existing maze JSON file into the binary maze format beside it.
+ * @param filename The maze .json file
+ * @return The exit code
+ */
+static int compileMaze(const str filename) {
+  FILE* file = fopen(filename, "rb");
+  if (!file) handleError(ERR_IO, FATAL, "Could not open %s!\n", filename);
+
+  fseek(file, 0, SEEK_END);
+  long size = ftell(file);
+  rewind(file);
+
+  str data = malloc(size + 1);
+  if (!data) handleError(ERR_MEM, FATAL, "Could not allocate memory for %s!\n", filename);
+
+  if (fread(data, 1, size, file) != (size_t) size) handleError(ERR_IO, FATAL, "Could not read %s!\n", filename);
+  data[size] = '\0';
+  fclose(file);
+
+  cJSON* root = cJSON_Parse(data);
+  if (!root) handleError(ERR_DATA, FATAL, "Could not parse %s!\n", filename);
+  free(data);
+
+  str binFile = binFilename(filename);
+  saveMazeBin(root, binFile);
+
+  free(binFile);
+  cJSON_Delete(root);
+
+  return 0;
+}
+
 /**
  * Saves a copy of the output JSON (string) to archive, added with a timestamp
  * @param maze The JSON string for the maze
@@ -990,16 +1409,28 @@ void saveCopy(str maze, str filename) {
 
 
 int main(int argc, char const* argv[]) {
-  if (argc < 2 || argc > 3) {
-    fprintf(stderr, "usage: CreateMaze name_of_maze [archive (-a)]\n");
+  if (argc < 2 || argc > 4) {
+    fprintf(stderr, "usage: CreateMaze name_of_maze [archive (-a)] [compile (-b)]\n");
+    fprintf(stderr, "       CreateMaze -c maze.json\n");
     return 1;
   }
 
+  // Only compile an already created maze
+  if (strncmp(argv[1], "-c", 2) == 0) {
+    if (argc != 3) {
+      fprintf(stderr, "usage: CreateMaze -c maze.json\n");
+      return 1;
+    }
+
+    return compileMaze((str) argv[2]);
+  }
+
   bool archive = false;
+  bool compile = false;
 
-  if (argc == 3) {
-    str _archive = argv[2];
-    if (strncmp(_archive, "-a", 2) == 0) archive = true;
+  for (int i = 2; i < argc; i++) {
+    if (strncmp(argv[i], "-a", 2) == 0) archive = true;
+    else if (strncmp(argv[i], "-b", 2) == 0) compile = true;
   }
 
   str _mazeName = argv[1];
@@ -1020,7 +1451,6 @@ int main(int argc, char const* argv[]) {
 
   str maze = cJSON_Print(root);
   if (!maze) handleError(ERR_MEM, FATAL, "Could not create json string!\n");
-  cJSON_Delete(root);
 
   int mazeNameLength = strlen(_mazeName);
   str filename = (str) malloc(6 + mazeNameLength);
@@ -1036,6 +1466,14 @@ int main(int argc, char const* argv[]) {
 
   fclose(file);
 
+  // Compiled after the JSON is written so it is not older than it
+  if (compile) {
+    str binFile = binFilename(filename);
+    saveMazeBin(root, binFile);
+    free(binFile);
+  }
+  cJSON_Delete(root);
+
   // Have a copy be saved to history
   if (archive) saveCopy(maze, filename);
 
@@ -29,7 +29,7 @@ int main(int argc UNUSED, char const* argv[] UNUSED) {
 
   FILE* room;
   str filename = NULL;
-  char buffer[3];
+  char buffer[12];
   str line = NULL;
   size_t n;
 
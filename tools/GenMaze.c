@@ -0,0 +1,385 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "Error.h"
+#include "Colors.h"
+
+
+#ifndef _STR_
+#define str char*
+#endif
+#define uint unsigned int
+
+#define DEFAULT_ROOMS 1000
+#define DEFAULT_BRANCHING 2
+#define DEFAULT_LOOT 0.2
+#define DEFAULT_ENEMIES 0.15
+#define DEFAULT_BOSSES 1
+#define DEFAULT_SEED 1
+#define DEFAULT_OUT "generated.json"
+
+#define NO_ROOM -1
+#define MAX_ROOMS 0x7FFFFFFF // Same as MAX_ROOM_ID
+
+// The order of the exits in a map, the opposite of d is (d+2)%4
+static const int dx[4] = { 0, 1, 0, -1 };
+static const int dy[4] = { -1, 0, 1, 0 };
+
+static const char* infos[] = {
+  "A narrow corridor.", "A collapsed storage room.", "A quiet hall, lit by a broken sign.",
+  "A flooded stairwell.", "An empty plaza.", "A maintenance tunnel.", "A room full of crates.",
+  "A burnt out office."
+};
+
+static const char* loots[] = {
+  "{\"count\":2,\"type\":6,\"item\":{\"type\":0,\"description\":\"Heals for 15.\"}}",
+  "{\"count\":1,\"type\":6,\"item\":{\"type\":1,\"description\":\"Heals for 40.\"}}",
+  "{\"count\":3,\"type\":7,\"item\":{\"rank\":1,\"type\":0,\"description\":\"Weapon upgrade material.\"}}",
+  "{\"count\":3,\"type\":8,\"item\":{\"rank\":1,\"type\":0,\"description\":\"Armor upgrade material.\"}}",
+  "{\"count\":5,\"type\":9,\"item\":{\"description\":\"Slime.\"}}"
+};
+
+static const char* enemies[] = {
+  "{\"name\":\"Wolf\",\"xpPoints\":5,\"hp\":[5,8],\"lvl\":4,"
+  "\"stats\":{\"ATK\":[1,3],\"ACC\":[1],\"ATK_CRIT\":[0.2,0.3],\"ATK_CRIT_DMG\":[1,2],\"DEF\":[2,3]}}",
+  "{\"name\":\"Rat\",\"xpPoints\":2,\"hp\":[3],\"lvl\":2,"
+  "\"stats\":{\"ATK\":[1,2],\"ACC\":[1],\"ATK_CRIT\":[0.1],\"ATK_CRIT_DMG\":[1],\"DEF\":[1]}}",
+  "{\"name\":\"Guard\",\"xpPoints\":12,\"hp\":[12,20],\"lvl\":7,"
+  "\"stats\":{\"ATK\":[3,5],\"ACC\":[2,3],\"ATK_CRIT\":[0.2,0.4],\"ATK_CRIT_DMG\":[2,3],\"DEF\":[3,5]}}"
+};
+
+static const char* boss =
+  "{\"name\":\"Warden\",\"xpPoints\":50,\"hp\":[40,60],\"lvl\":10,"
+  "\"stats\":{\"ATK\":[5,8],\"ACC\":[3],\"ATK_CRIT\":[0.3,0.4],\"ATK_CRIT_DMG\":[2,4],\"DEF\":[4,6]},"
+  "\"gear\":{"
+  "\"soulweapon\":{\"name\":\"SoulWeapon A\",\"atk\":5,\"acc\":3,\"atk_crit\":0.5,\"atk_crit_dmg\":4,\"lvl\":4,\"upgrades\":0,\"durability\":100},"
+  "\"helmet\":{\"name\":\"Helmet A\",\"type\":0,\"acc\":1,\"def\":2,\"lvl\":5},"
+  "\"shoulder_guard\":{\"name\":\"Shoulder Guard A\",\"type\":1,\"acc\":1,\"def\":1,\"lvl\":5},"
+  "\"chestplate\":{\"name\":\"ChestPlate A\",\"type\":2,\"acc\":1,\"def\":3,\"lvl\":5},"
+  "\"boots\":{\"name\":\"Boots A\",\"type\":3,\"acc\":0,\"def\":2,\"lvl\":5}},"
+  "\"skills\":["
+  "{\"name\":\"Skill 1\",\"description\":\"Skill 1 desc\",\"lvl\":0,\"cooldown\":1,\"id\":1,\"activeEffect1\":0,\"activeEffect2\":4,\"effect1\":3,\"effect2\":3.2},"
+  "{\"name\":\"Skill 2\",\"description\":\"Skill 2 desc\",\"lvl\":0,\"cooldown\":1,\"id\":2,\"activeEffect1\":1,\"activeEffect2\":2,\"effect1\":4,\"effect2\":3},"
+  "{\"name\":\"Skill 3\",\"description\":\"Skill 3 desc\",\"lvl\":0,\"cooldown\":1,\"id\":3,\"activeEffect1\":0,\"activeEffect2\":2,\"effect1\":3,\"effect2\":3},"
+  "{\"name\":\"Skill 4\",\"description\":\"Skill 4 desc\",\"lvl\":0,\"cooldown\":1,\"id\":4,\"activeEffect1\":0,\"activeEffect2\":2,\"effect1\":3,\"effect2\":2},"
+  "{\"name\":\"Skill 5\",\"description\":\"Skill 5 desc\",\"lvl\":0,\"cooldown\":1,\"id\":5,\"activeEffect1\":0,\"activeEffect2\":2,\"effect1\":3,\"effect2\":4}]}";
+
+#define COUNT(arr) (sizeof(arr) / sizeof((arr)[0]))
+
+// The settings of the maze to generate
+typedef struct GenOptions {
+  uint rooms; // Number of rooms
+  int branching; // Most new exits a room opens, 1 makes corridors
+  double loot; // Chance of a room having a loot table
+  double enemies; // Chance of a room having an enemy table
+  uint bosses; // Number of boss rooms, placed the furthest from the entry
+  uint seed; // Seed of rand()
+  const char* out; // The map to write
+} GenOptions;
+
+// A generated room, before it is written
+typedef struct GenRoom {
+  int x, y; // Its cell on the grid
+  int exits[4]; // Ids of the rooms it leads to, NO_ROOM if none
+  uint depth; // Steps from the entry
+  bool hasBoss;
+} GenRoom;
+
+// The cells of the grid that are taken, an open addressing hash of cell -> room id
+typedef struct Grid {
+  uint64_t* cells; // The cell of each slot
+  int* ids; // The room in each slot, NO_ROOM when empty
+  uint64_t mask; // Number of slots - 1, a power of two - 1
+} Grid;
+
+
+/**
+ * Gets a random number in [0, 1).
+ */
+static double chance() {
+  return rand() / ((double) RAND_MAX + 1);
+}
+
+/**
+ * Packs the cell into a key.
+ */
+static uint64_t cellKey(int x, int y) {
+  return ((uint64_t) (uint32_t) x << 32) | (uint32_t) y;
+}
+
+/**
+ * Gets the slot of the cell, either the one holding it or the empty one it goes in.
+ */
+static uint64_t gridSlot(Grid* grid, int x, int y) {
+  uint64_t key = cellKey(x, y);
+  uint64_t slot = (key * 0x9E3779B97F4A7C15ull) >> 20 & grid->mask;
+
+  while (grid->ids[slot] != NO_ROOM && grid->cells[slot] != key) slot = (slot + 1) & grid->mask;
+
+  return slot;
+}
+
+/**
+ * Creates a grid with room for the given number of rooms.
+ */
+static void initGrid(Grid* grid, uint rooms) {
+  uint64_t cap = 16;
+  while (cap < (uint64_t) rooms * 2) cap *= 2;
+
+  grid->cells = (uint64_t*) malloc(cap * sizeof(uint64_t));
+  grid->ids = (int*) malloc(cap * sizeof(int));
+  if (!grid->cells || !grid->ids) handleError(ERR_MEM, FATAL, "Could not allocate space for the grid!\n");
+
+  for (uint64_t i = 0; i < cap; i++) grid->ids[i] = NO_ROOM;
+  grid->mask = cap - 1;
+}
+
+/**
+ * Adds a room next to the given one.
+ * @return The id of the new room
+ */
+static int addRoom(GenRoom* rooms, uint* count, Grid* grid, int from, int dir) {
+  int id = (int) (*count)++;
+  GenRoom* room = &rooms[id];
+
+  room->x = rooms[from].x + dx[dir];
+  room->y = rooms[from].y + dy[dir];
+  room->depth = rooms[from].depth + 1;
+  room->hasBoss = false;
+  for (int i = 0; i < 4; i++) room->exits[i] = NO_ROOM;
+
+  room->exits[(dir + 2) % 4] = from;
+  rooms[from].exits[dir] = id;
+
+  uint64_t slot = gridSlot(grid, room->x, room->y);
+  grid->cells[slot] = cellKey(room->x, room->y);
+  grid->ids[slot] = id;
+
+  return id;
+}
+
+/**
+ * Gets the directions of the room that lead to a free cell, in random order.
+ * @return The number of directions
+ */
+static int freeDirs(GenRoom* room, Grid* grid, int* dirs) {
+  int n = 0;
+
+  for (int d = 0; d < 4; d++) {
+    if (grid->ids[gridSlot(grid, room->x + dx[d], room->y + dy[d])] == NO_ROOM) dirs[n++] = d;
+  }
+
+  for (int i = n - 1; i > 0; i--) {
+    int j = rand() % (i + 1);
+    int tmp = dirs[i]; dirs[i] = dirs[j]; dirs[j] = tmp;
+  }
+
+  return n;
+}
+
+/**
+ * Grows the maze outwards from the entry, each room opening 1 to branching new exits.
+ * @param opts The options
+ * @return The rooms
+ */
+static GenRoom* growMaze(GenOptions* opts) {
+  GenRoom* rooms = (GenRoom*) malloc(opts->rooms * sizeof(GenRoom));
+  int* queue = (int*) malloc(opts->rooms * sizeof(int));
+  if (!rooms || !queue) handleError(ERR_MEM, FATAL, "Could not allocate space for the rooms!\n");
+
+  Grid grid;
+  initGrid(&grid, opts->rooms);
+
+  GenRoom* entry = &rooms[0];
+  entry->x = entry->y = 0;
+  entry->depth = 0;
+  entry->hasBoss = false;
+  for (int i = 0; i < 4; i++) entry->exits[i] = NO_ROOM;
+  grid.cells[gridSlot(&grid, 0, 0)] = cellKey(0, 0);
+  grid.ids[gridSlot(&grid, 0, 0)] = 0;
+
+  uint count = 1, head = 0, tail = 0;
+  uint stuck = 0; // Every room before this one is boxed in
+  queue[tail++] = 0;
+
+  int dirs[4];
+
+  while (count < opts->rooms) {
+    if (head == tail) {
+      // Every open room was boxed in, carry on from the oldest one that is not
+      while (freeDirs(&rooms[stuck], &grid, dirs) == 0) stuck++;
+      queue[tail++] = stuck;
+    }
+
+    int from = queue[head++];
+    int n = freeDirs(&rooms[from], &grid, dirs);
+    int want = 1 + rand() % opts->branching;
+
+    for (int i = 0; i < n && i < want && count < opts->rooms; i++) {
+      queue[tail++] = addRoom(rooms, &count, &grid, from, dirs[i]);
+    }
+
+    // The queue never holds more than the rooms, so it can restart once drained
+    if (head == tail) head = tail = 0;
+  }
+
+  free(queue);
+  free(grid.cells);
+  free(grid.ids);
+
+  return rooms;
+}
+
+/**
+ * Used by qsort to order room ids from the deepest.
+ */
+static GenRoom* sortRooms;
+static int compareDepth(const void* a, const void* b) {
+  uint da = sortRooms[*(const int*) a].depth;
+  uint db = sortRooms[*(const int*) b].depth;
+
+  if (da != db) return (da < db) ? 1 : -1;
+  return *(const int*) a - *(const int*) b;
+}
+
+/**
+ * Puts the bosses in the rooms furthest from the entry.
+ */
+static void placeBosses(GenRoom* rooms, GenOptions* opts) {
+  if (opts->bosses == 0) return;
+
+  int* order = (int*) malloc(opts->rooms * sizeof(int));
+  if (!order) handleError(ERR_MEM, FATAL, "Could not allocate space for the boss order!\n");
+
+  for (uint i = 0; i < opts->rooms; i++) order[i] = i;
+
+  sortRooms = rooms;
+  qsort(order, opts->rooms, sizeof(int), compareDepth);
+
+  // The entry never gets one
+  for (uint i = 0, placed = 0; i < opts->rooms && placed < opts->bosses; i++) {
+    if (order[i] == 0) continue;
+
+    rooms[order[i]].hasBoss = true;
+    placed++;
+  }
+
+  free(order);
+}
+
+/**
+ * Writes a table of 1 to most entries picked from the pool.
+ */
+static void writeTable(FILE* file, const char** pool, int poolSize, int most) {
+  int n = 1 + rand() % most;
+
+  fputc('[', file);
+  for (int i = 0; i < n; i++) fprintf(file, "%s%s", (i == 0) ? "" : ",", pool[rand() % poolSize]);
+  fputc(']', file);
+}
+
+/**
+ * Writes the maze as a map.
+ * The loot and enemy tables are rolled while writing, in room order, so the seed fixes them too.
+ */
+static void writeMaze(GenRoom* rooms, GenOptions* opts, const char* name) {
+  FILE* file = fopen(opts->out, "w");
+  if (!file) handleError(ERR_IO, FATAL, "Could not create %s!\n", opts->out);
+
+  fprintf(file, "{\"name\":\"%s\"", name);
+
+  for (uint i = 0; i < opts->rooms; i++) {
+    GenRoom* room = &rooms[i];
+
+    fprintf(file, ",\n\"%u\":{\"isEntry\":%d,\"storyfile\":\"\",\"info\":\"%s\",\"hasBoss\":%d,\"exits\":[%d,%d,%d,%d],\"loot\":",
+      i, i == 0, infos[rand() % COUNT(infos)], room->hasBoss, room->exits[0], room->exits[1], room->exits[2], room->exits[3]);
+
+    if (!room->hasBoss && chance() < opts->loot) writeTable(file, loots, COUNT(loots), 3);
+    else fputs("[]", file);
+
+    fputs(",\"enemy\":", file);
+
+    if (room->hasBoss) fprintf(file, "[%s]", boss);
+    else if (i != 0 && chance() < opts->enemies) writeTable(file, enemies, COUNT(enemies), 2);
+    else fputs("[]", file);
+
+    fputc('}', file);
+  }
+
+  fputs("\n}\n", file);
+
+  if (fclose(file) != 0) handleError(ERR_IO, FATAL, "Could not write %s!\n", opts->out);
+}
+
+/**
+ * Gets the maze name from the map filename, its base name without the extension.
+ * @return The name (to be freed)
+ */
+static str mazeName(const char* filename) {
+  const char* base = strrchr(filename, '/');
+  base = base ? base + 1 : filename;
+
+  size_t len = strcspn(base, ".");
+
+  str name = (str) malloc(len + 1);
+  if (!name) handleError(ERR_MEM, FATAL, "Could not allocate space for the maze name!\n");
+
+  memcpy(name, base, len);
+  name[len] = '\0';
+
+  return name;
+}
+
+static void usage() {
+  printf("usage: GenMaze [-n rooms] [-b branching] [-l loot] [-e enemies] [-B bosses] [-s seed] [-o out.json]\n");
+  printf("  -n  Number of rooms (default %d)\n", DEFAULT_ROOMS);
+  printf("  -b  Most new exits a room opens, 1 to 3 (default %d)\n", DEFAULT_BRANCHING);
+  printf("  -l  Chance of a room having loot, 0 to 1 (default %.2f)\n", DEFAULT_LOOT);
+  printf("  -e  Chance of a room having enemies, 0 to 1 (default %.2f)\n", DEFAULT_ENEMIES);
+  printf("  -B  Number of bosses, put the furthest from the entry (default %d)\n", DEFAULT_BOSSES);
+  printf("  -s  Seed, the same seed gives the same map (default %d)\n", DEFAULT_SEED);
+  printf("  -o  The map to write (default %s)\n", DEFAULT_OUT);
+}
+
+int main(int argc, str* argv) {
+  GenOptions opts = { DEFAULT_ROOMS, DEFAULT_BRANCHING, DEFAULT_LOOT, DEFAULT_ENEMIES, DEFAULT_BOSSES, DEFAULT_SEED, DEFAULT_OUT };
+
+  for (int i = 1; i < argc; i++) {
+    if (argv[i][0] != '-' || argv[i][1] == '\0' || argv[i][2] != '\0' || i + 1 == argc) { usage(); return 1; }
+
+    str value = argv[++i];
+
+    switch (argv[i - 1][1]) {
+      case 'n': opts.rooms = (uint) strtoul(value, NULL, 10); break;
+      case 'b': opts.branching = atoi(value); break;
+      case 'l': opts.loot = atof(value); break;
+      case 'e': opts.enemies = atof(value); break;
+      case 'B': opts.bosses = (uint) strtoul(value, NULL, 10); break;
+      case 's': opts.seed = (uint) strtoul(value, NULL, 10); break;
+      case 'o': opts.out = value; break;
+      default: usage(); return 1;
+    }
+  }
+
+  if (opts.rooms == 0 || opts.rooms > MAX_ROOMS) handleError(ERR_DATA, FATAL, "The rooms must be from 1 to %d!\n", MAX_ROOMS);
+  if (opts.branching < 1 || opts.branching > 3) handleError(ERR_DATA, FATAL, "The branching must be from 1 to 3!\n");
+  if (opts.bosses >= opts.rooms) opts.bosses = opts.rooms - 1;
+
+  srand(opts.seed);
+
+  GenRoom* rooms = growMaze(&opts);
+  placeBosses(rooms, &opts);
+
+  str name = mazeName(opts.out);
+  writeMaze(rooms, &opts, name);
+
+  printf("%sGenerated %s: %u rooms, %u bosses (seed %u)%s\n", GREEN, opts.out, opts.rooms, opts.bosses, opts.seed, RESET);
+
+  free(name);
+  free(rooms);
+
+  return 0;
+}
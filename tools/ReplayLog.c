@@ -0,0 +1,179 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "BattleLog.h"
+#include "Damage.h"
+#include "Random.h"
+#include "SoulWorker.h"
+
+
+#define SKILL_SLOTS 16 // As many as Cooldowns has timers
+
+static const char* sideNames[2] = { "player", "enemy" };
+
+// What a battle of the log is, as its events describe it
+typedef struct Replay {
+  bool started; // Whether the start of the battle is in the log, older ones may be written over
+  bool boss;
+  uint battle; // The battles seen so far
+  Stats stats[2]; // Of each side, with the gear on
+  uint playerLvl;
+  Skill skills[SKILL_SLOTS]; // By their slot, as in Cooldowns
+  bool hasSkill[SKILL_SLOTS];
+} Replay;
+
+
+static void usage() {
+  printf("usage: ReplayLog [-q] battle.log\n");
+  printf("  Runs every attack of the log through rollDamage again, from the rolls it had.\n");
+  printf("  -q  Only print what did not replay the same, and the totals\n");
+  exit(2);
+}
+
+/**
+ * Replays an attack: puts RNG_BATTLE back to where it was and rolls it again.
+ * @param replay The battle
+ * @param e The attack
+ * @param hitRoll Where to store the hit roll
+ * @param critRoll Where to store the crit roll, which only counts on a hit
+ * @return The damage
+ */
+static ushort replayRound(Replay* replay, const BattleEvent* e, float* hitRoll, float* critRoll) {
+  setRandomState(RNG_BATTLE, e->round.rng);
+  *hitRoll = randomFloat(RNG_BATTLE);
+  *critRoll = randomFloat(RNG_BATTLE);
+
+  const Skill* skill = (e->skill != NO_SKILL && e->skill < SKILL_SLOTS && replay->hasSkill[e->skill]) ? &replay->skills[e->skill] : NULL;
+
+  setRandomState(RNG_BATTLE, e->round.rng);
+
+  return rollDamage(&replay->stats[e->side], &replay->stats[!e->side], skill, replay->playerLvl, NULL);
+}
+
+int main(int argc, str* argv) {
+  bool quiet = false;
+  const char* path = NULL;
+
+  for (int i = 1; i < argc; i++) {
+    if (strcmp(argv[i], "-q") == 0) quiet = true;
+    else if (argv[i][0] == '-' || path) usage();
+    else path = argv[i];
+  }
+
+  if (!path) usage();
+
+  FILE* in = fopen(path, "rb");
+  if (!in) { printf("Could not open %s!\n", path); return 2; }
+
+  BattleLogHeader header;
+  if (fread(&header, sizeof(header), 1, in) != 1 || memcmp(header.magic, BATTLE_LOG_MAGIC, sizeof(header.magic)) != 0) {
+    printf("%s is not a battle log!\n", path);
+    return 2;
+  }
+
+  if (header.version != BATTLE_LOG_VERSION) {
+    printf("%s is a version %u log, this replays version %u!\n", path, header.version, BATTLE_LOG_VERSION);
+    return 2;
+  }
+
+  BattleEvent* events = (BattleEvent*) malloc((header.count ? header.count : 1) * sizeof(BattleEvent));
+  if (!events) { printf("Could not allocate space for the events!\n"); return 2; }
+
+  if (fread(events, sizeof(BattleEvent), header.count, in) != header.count) {
+    printf("%s ends before its %u events!\n", path, header.count);
+    return 2;
+  }
+  fclose(in);
+
+  printf("%s: seed %llu, %u events (%llu older ones written over)\n", path,
+         (unsigned long long) header.seed, header.count, (unsigned long long) header.dropped);
+
+  Replay replay;
+  memset(&replay, 0, sizeof(replay));
+
+  uint rounds = 0, skipped = 0, wrong = 0, won = 0, lost = 0;
+
+  for (uint i = 0; i < header.count; i++) {
+    const BattleEvent* e = &events[i];
+
+    if (e->side > SIDE_ENEMY) {
+      printf("Event %u has an unknown side %u!\n", i, e->side);
+      wrong++;
+      continue;
+    }
+
+    switch (e->type) {
+      case LOG_BEGIN:
+        memset(&replay.hasSkill, 0, sizeof(replay.hasSkill));
+        replay.started = true;
+        replay.boss = e->value;
+        replay.battle++;
+
+        if (!quiet) printf("Battle %u%s\n", replay.battle, replay.boss ? ", against a boss" : "");
+        break;
+
+      case LOG_SIDE:
+        replay.stats[e->side] = e->start.stats;
+        if (e->side == SIDE_PLAYER) replay.playerLvl = e->value;
+
+        if (!quiet) {
+          const Stats* s = &e->start.stats;
+          printf("  %-6s LVL %u, HP %u; ATK: %d; DEF: %d; ACC: %d; ATK CRIT DMG: %d; ATK CRIT: %3.2f\n", sideNames[e->side],
+                 e->value, e->start.hp, s->ATK, s->DEF, s->ACC, s->ATK_CRIT_DMG, s->ATK_CRIT);
+        }
+        break;
+
+      case LOG_SKILL:
+        if (e->skill >= SKILL_SLOTS) break;
+
+        memset(&replay.skills[e->skill], 0, sizeof(Skill));
+        memcpy(&replay.skills[e->skill].effect1, e->effects, SKILL_EFFECTS_SIZE);
+        replay.skills[e->skill].id = e->value;
+        replay.hasSkill[e->skill] = true;
+        break;
+
+      case LOG_ROUND: {
+        // The battle started before the oldest event kept, so its stats are gone
+        if (!replay.started) { skipped++; break; }
+
+        float hitRoll, critRoll;
+        ushort dmg = replayRound(&replay, e, &hitRoll, &critRoll);
+        bool same = dmg == e->round.dmg;
+
+        rounds++;
+        if (!same) wrong++;
+
+        if (!quiet || !same) {
+          printf("  turn %u: %-6s", e->value, sideNames[e->side]);
+          if (e->skill != NO_SKILL) printf(" skill %u", e->skill);
+          printf(" hit roll %.4f crit roll %.4f -> %u DMG, HP left %u", hitRoll, critRoll, dmg, e->round.hpAfter);
+          if (!same) printf("; battle %u logged %u DMG!", replay.battle, e->round.dmg);
+          printf("\n");
+        }
+        break;
+      }
+
+      case LOG_END:
+        // The battle started before the oldest event kept, so it is not one of the battles counted
+        if (!replay.started) break;
+
+        if (e->value) won++;
+        else lost++;
+
+        if (!quiet) printf("  %s\n", e->value ? "The player won" : "The player lost");
+        break;
+
+      default:
+        printf("Event %u has an unknown type %u!\n", i, e->type);
+        wrong++;
+    }
+  }
+
+  printf("%u battles (%u won, %u lost), %u attacks replayed, %u skipped, %u not the same\n",
+         replay.battle, won, lost, rounds, skipped, wrong);
+
+  free(events);
+
+  return wrong ? 1 : 0;
+}